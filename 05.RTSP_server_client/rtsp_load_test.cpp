@@ -0,0 +1,565 @@
+#include <gst/gst.h>
+#include <gst/rtsp/gstrtsptransport.h>
+#include <gst/rtsp-server/rtsp-server.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Load test for RTSP servers: ramps up lightweight rtspsrc ! fakesink
+// clients inside one process and reports how the server copes. Without
+// --url it forks a loopback server with the rtsp_cam_server encoder
+// settings and a videotestsrc source, so its CPU is measured on its own.
+
+struct LoadTestOptions {
+    std::string url;                // Target (empty = built-in server)
+    pid_t server_pid = 0;           // Process whose CPU is reported
+    int max_clients = 100;          // Ramp up to this many clients
+    int step = 10;                  // Clients added per step
+    int step_seconds = 10;          // Step length
+    std::string protocol = "udp";   // udp, tcp or mixed
+    int latency = 200;              // rtspsrc jitterbuffer latency (ms)
+    std::string csv;                // Per-client report (empty = none)
+
+    // Built-in server
+    int port = 8555;
+    int width = 640;
+    int height = 480;
+    int fps = 30;
+    int bitrate = 1000;             // kbps
+    bool shared = true;             // One encoder for all clients
+};
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nearest-rank percentile (p in 0..100) of unsorted values.
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+    return values[std::min(rank, values.size() - 1)];
+}
+
+// CPU time of a process in seconds (user + system), -1 if unknown.
+static double processCpuSeconds(pid_t pid) {
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (!std::getline(stat, line)) {
+        return -1.0;
+    }
+    // Fields after the command name, which may contain spaces: state is field 3
+    size_t close = line.rfind(')');
+    if (close == std::string::npos) {
+        return -1.0;
+    }
+    std::istringstream fields(line.substr(close + 2));
+    std::string field;
+    unsigned long long utime = 0, stime = 0;
+    for (int index = 3; fields >> field; ++index) {
+        if (index == 14) utime = std::stoull(field);
+        if (index == 15) {
+            stime = std::stoull(field);
+            break;
+        }
+    }
+    return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+// CPU time of this process in seconds.
+static double selfCpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// The built-in server: videotestsrc with the rtsp_cam_server encoder settings.
+static void runBuiltInServer(const LoadTestOptions& options) {
+    gst_init(nullptr, nullptr);
+
+    GstRTSPServer *server = gst_rtsp_server_new();
+    g_object_set(server,
+        "address", "127.0.0.1",
+        "service", std::to_string(options.port).c_str(),
+        "backlog", 1024,
+        nullptr);
+
+    std::string launch =
+        "( videotestsrc is-live=true pattern=ball ! "
+        "video/x-raw,width=" + std::to_string(options.width) +
+        ",height=" + std::to_string(options.height) +
+        ",framerate=" + std::to_string(options.fps) + "/1 ! "
+        "videoconvert ! "
+        "x264enc tune=zerolatency speed-preset=ultrafast key-int-max=15 "
+        "bitrate=" + std::to_string(options.bitrate) + " ! "
+        "video/x-h264,profile=baseline ! "
+        "rtph264pay name=pay0 config-interval=1 pt=96 )";
+
+    GstRTSPMediaFactory *factory = gst_rtsp_media_factory_new();
+    gst_rtsp_media_factory_set_launch(factory, launch.c_str());
+    gst_rtsp_media_factory_set_shared(factory, options.shared ? TRUE : FALSE);
+    gst_rtsp_media_factory_set_latency(factory, 0);
+
+    GstRTSPMountPoints *mounts = gst_rtsp_server_get_mount_points(server);
+    gst_rtsp_mount_points_add_factory(mounts, "/camera", factory);
+    g_object_unref(mounts);
+
+    if (gst_rtsp_server_attach(server, nullptr) == 0) {
+        std::cerr << "Failed to attach the built-in RTSP server" << std::endl;
+        _exit(1);
+    }
+
+    GMainLoop *loop = g_main_loop_new(nullptr, FALSE);
+    g_main_loop_run(loop);
+    _exit(0);
+}
+
+// Waits until something accepts TCP connections on 127.0.0.1:port.
+static bool waitForPort(int port, int timeout_ms) {
+    auto start = std::chrono::steady_clock::now();
+    while (msSince(start) < timeout_ms) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool connected = connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        close(fd);
+        if (connected) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+}
+
+// One simulated viewer: rtspsrc ! fakesink with receive statistics.
+class LoadClient {
+public:
+    LoadClient(int id, const std::string& url, const std::string& protocol, int latency)
+        : id_(id), protocol_(protocol) {
+        pipeline_ = gst_pipeline_new(nullptr);
+        GstElement *source = gst_element_factory_make("rtspsrc", nullptr);
+        sink_ = gst_element_factory_make("fakesink", nullptr);
+
+        g_object_set(source,
+            "location", url.c_str(),
+            "latency", static_cast<guint>(latency),
+            "protocols", protocol == "tcp" ? GST_RTSP_LOWER_TRANS_TCP : GST_RTSP_LOWER_TRANS_UDP,
+            nullptr);
+        // Never waits for a clock or a preroll: only counts what arrives
+        g_object_set(sink_, "sync", FALSE, "async", FALSE, nullptr);
+
+        gst_bin_add_many(GST_BIN(pipeline_), source, sink_, nullptr);
+        g_signal_connect(source, "pad-added", G_CALLBACK(onPadAdded), this);
+        g_signal_connect(source, "new-manager", G_CALLBACK(onNewManager), this);
+
+        GstPad *pad = gst_element_get_static_pad(sink_, "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, onBuffer, this, nullptr);
+        gst_object_unref(pad);
+
+        GstBus *bus = gst_element_get_bus(pipeline_);
+        gst_bus_set_sync_handler(bus, onBusSync, this, nullptr);
+        gst_object_unref(bus);
+    }
+
+    ~LoadClient() {
+        gst_element_set_state(pipeline_, GST_STATE_NULL);
+        GstBus *bus = gst_element_get_bus(pipeline_);
+        gst_bus_set_sync_handler(bus, nullptr, nullptr, nullptr);
+        gst_object_unref(bus);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jitterbuffer_) {
+            gst_object_unref(jitterbuffer_);
+        }
+        gst_object_unref(pipeline_);
+    }
+
+    void start() {
+        started_ = std::chrono::steady_clock::now();
+        if (gst_element_set_state(pipeline_, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+            fail("failed to start");
+        }
+    }
+
+    // Picks up errors posted since the last call.
+    void pollBus() {
+        GstBus *bus = gst_element_get_bus(pipeline_);
+        while (GstMessage *msg = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR)) {
+            GError *err = nullptr;
+            gst_message_parse_error(msg, &err, nullptr);
+            fail(err ? err->message : "error");
+            if (err) {
+                g_error_free(err);
+            }
+            gst_message_unref(msg);
+        }
+        gst_object_unref(bus);
+    }
+
+    // Packets pushed and lost by the jitterbuffer (lost = never arrived).
+    void packetStats(guint64& pushed, guint64& lost) const {
+        pushed = lost = 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!jitterbuffer_) {
+            return;
+        }
+        GstStructure *stats = nullptr;
+        g_object_get(jitterbuffer_, "stats", &stats, nullptr);
+        if (stats) {
+            gst_structure_get_uint64(stats, "num-pushed", &pushed);
+            gst_structure_get_uint64(stats, "num-lost", &lost);
+            gst_structure_free(stats);
+        }
+    }
+
+    int id() const { return id_; }
+    const std::string& protocol() const { return protocol_; }
+    guint64 bytes() const { return bytes_.load(); }
+    guint64 frames() const { return frames_.load(); }
+    double setupMs() const { return setup_us_.load() / 1000.0; }
+    double firstFrameMs() const { return first_frame_us_.load() / 1000.0; }
+    bool setUp() const { return setup_us_.load() >= 0; }
+    bool receiving() const { return first_frame_us_.load() >= 0; }
+    bool failed() const { return failed_.load(); }
+
+    std::string error() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return error_;
+    }
+
+private:
+    void fail(const std::string& message) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!failed_.exchange(true)) {
+            error_ = message;
+        }
+    }
+
+    gint64 elapsedUs() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started_).count();
+    }
+
+    // Runs on the posting thread, so progress is timed when rtspsrc posts it
+    // rather than when the bus is next polled. Progress is consumed here.
+    static GstBusSyncReply onBusSync(GstBus *, GstMessage *msg, gpointer data) {
+        if (GST_MESSAGE_TYPE(msg) != GST_MESSAGE_PROGRESS) {
+            return GST_BUS_PASS;
+        }
+        static_cast<LoadClient*>(data)->onProgress(msg);
+        return GST_BUS_DROP;
+    }
+
+    // rtspsrc posts COMPLETE for the "request" progress once the server has
+    // answered PLAY.
+    void onProgress(GstMessage *msg) {
+        GstProgressType type;
+        gchar *code = nullptr;
+        gchar *text = nullptr;
+        gst_message_parse_progress(msg, &type, &code, &text);
+        if (type == GST_PROGRESS_TYPE_COMPLETE && code && std::strcmp(code, "request") == 0 &&
+            text && std::strstr(text, "PLAY")) {
+            gint64 unset = -1;
+            setup_us_.compare_exchange_strong(unset, elapsedUs());
+        }
+        g_free(code);
+        g_free(text);
+    }
+
+    // First stream pad: link it to the sink.
+    static void onPadAdded(GstElement *, GstPad *pad, gpointer data) {
+        LoadClient *client = static_cast<LoadClient*>(data);
+        GstPad *sink_pad = gst_element_get_static_pad(client->sink_, "sink");
+        if (!gst_pad_is_linked(sink_pad)) {
+            gst_pad_link(pad, sink_pad);
+        }
+        gst_object_unref(sink_pad);
+    }
+
+    static void onNewManager(GstElement *, GstElement *manager, gpointer data) {
+        g_signal_connect(manager, "new-jitterbuffer", G_CALLBACK(onNewJitterbuffer), data);
+    }
+
+    static void onNewJitterbuffer(GstElement *, GstElement *jitterbuffer, guint, guint, gpointer data) {
+        LoadClient *client = static_cast<LoadClient*>(data);
+        std::lock_guard<std::mutex> lock(client->mutex_);
+        if (!client->jitterbuffer_) {
+            client->jitterbuffer_ = GST_ELEMENT(gst_object_ref(jitterbuffer));
+        }
+    }
+
+    // RTP packets; the marker bit ends a frame.
+    static GstPadProbeReturn onBuffer(GstPad *, GstPadProbeInfo *info, gpointer data) {
+        LoadClient *client = static_cast<LoadClient*>(data);
+        GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+        client->bytes_ += gst_buffer_get_size(buffer);
+
+        guint8 header[2] = {0, 0};
+        if (gst_buffer_extract(buffer, 0, header, 2) == 2 && (header[1] & 0x80)) {
+            if (client->frames_++ == 0) {
+                client->first_frame_us_ = client->elapsedUs();
+            }
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    int id_;
+    std::string protocol_;
+    GstElement *pipeline_ = nullptr;
+    GstElement *sink_ = nullptr;
+    GstElement *jitterbuffer_ = nullptr;
+    std::chrono::steady_clock::time_point started_;
+
+    std::atomic<gint64> setup_us_{-1};
+    std::atomic<gint64> first_frame_us_{-1};
+    std::atomic<guint64> bytes_{0};
+    std::atomic<guint64> frames_{0};
+    std::atomic<bool> failed_{false};
+    std::string error_;
+    mutable std::mutex mutex_;
+};
+
+// Ramps clients up step by step and prints one line per step.
+class LoadTest {
+public:
+    explicit LoadTest(const LoadTestOptions& options) : options_(options) {}
+
+    void run() {
+        std::cout << "Target: " << options_.url << " (" << options_.protocol << ", latency "
+                  << options_.latency << " ms)" << std::endl;
+        if (options_.server_pid == 0) {
+            std::cout << "Server CPU: not measured (no --server-pid)" << std::endl;
+        }
+        std::cout << std::endl;
+        std::cout << "clients  srv_cpu%  own_cpu%  kbps_p50  kbps_p5  loss%    setup_ms p50/p90/p99"
+                  << "    ttff_ms p50/p90/p99  failed" << std::endl;
+
+        while (static_cast<int>(clients_.size()) < options_.max_clients) {
+            size_t first = clients_.size();
+            int count = std::min(options_.step, options_.max_clients - static_cast<int>(first));
+            for (int i = 0; i < count; ++i) {
+                int id = static_cast<int>(clients_.size());
+                std::string protocol = options_.protocol;
+                if (protocol == "mixed") {
+                    protocol = id % 2 ? "tcp" : "udp";
+                }
+                clients_.push_back(std::unique_ptr<LoadClient>(
+                    new LoadClient(id, options_.url, protocol, options_.latency)));
+                clients_.back()->start();
+            }
+
+            // First half: clients connect and settle; second half is measured
+            int half_ms = options_.step_seconds * 500;
+            std::this_thread::sleep_for(std::chrono::milliseconds(half_ms));
+            measureStep(first, half_ms);
+        }
+    }
+
+    void writeCsv(const std::string& path) const {
+        std::ofstream csv(path);
+        csv << "client,protocol,setup_ms,first_frame_ms,bytes,frames,packets,lost,failed,error\n";
+        for (const auto& client : clients_) {
+            guint64 pushed = 0, lost = 0;
+            client->packetStats(pushed, lost);
+            csv << client->id() << "," << client->protocol() << ","
+                << (client->setUp() ? client->setupMs() : -1.0) << ","
+                << (client->receiving() ? client->firstFrameMs() : -1.0) << ","
+                << client->bytes() << "," << client->frames() << ","
+                << pushed << "," << lost << "," << (client->failed() ? 1 : 0) << ","
+                << "\"" << client->error() << "\"\n";
+        }
+        std::cout << "\nPer-client report saved to " << path << std::endl;
+    }
+
+private:
+    void measureStep(size_t first_new, int window_ms) {
+        std::vector<guint64> bytes_before;
+        for (const auto& client : clients_) {
+            bytes_before.push_back(client->bytes());
+        }
+        double server_before = options_.server_pid ? processCpuSeconds(options_.server_pid) : -1.0;
+        double self_before = selfCpuSeconds();
+        auto window_start = std::chrono::steady_clock::now();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(window_ms));
+
+        double window_s = msSince(window_start) / 1000.0;
+        double server_after = options_.server_pid ? processCpuSeconds(options_.server_pid) : -1.0;
+        double self_cpu = (selfCpuSeconds() - self_before) / window_s * 100.0;
+        double server_cpu = server_before >= 0.0 && server_after >= 0.0
+            ? (server_after - server_before) / window_s * 100.0 : -1.0;
+
+        // Receive rate and loss over every live client
+        std::vector<double> kbps;
+        guint64 pushed_total = 0, lost_total = 0;
+        int failed = 0;
+        for (size_t i = 0; i < clients_.size(); ++i) {
+            LoadClient& client = *clients_[i];
+            client.pollBus();
+            if (client.failed()) {
+                ++failed;
+                continue;
+            }
+            kbps.push_back((client.bytes() - bytes_before[i]) * 8.0 / 1000.0 / window_s);
+            guint64 pushed = 0, lost = 0;
+            client.packetStats(pushed, lost);
+            pushed_total += pushed;
+            lost_total += lost;
+        }
+        double loss = pushed_total + lost_total
+            ? 100.0 * lost_total / (pushed_total + lost_total) : 0.0;
+
+        // Setup and first-frame times of the clients added in this step
+        std::vector<double> setup, first_frame;
+        size_t waiting = 0;
+        for (size_t i = first_new; i < clients_.size(); ++i) {
+            if (clients_[i]->setUp()) setup.push_back(clients_[i]->setupMs());
+            if (clients_[i]->receiving()) first_frame.push_back(clients_[i]->firstFrameMs());
+            else if (!clients_[i]->failed()) ++waiting;
+        }
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(7) << clients_.size()
+                  << std::setw(10);
+        if (server_cpu >= 0.0) {
+            std::cout << server_cpu;
+        } else {
+            std::cout << "-";
+        }
+        std::cout << std::setw(10) << self_cpu
+                  << std::setprecision(0)
+                  << std::setw(10) << percentile(kbps, 50)
+                  << std::setw(9) << percentile(kbps, 5)
+                  << std::setprecision(2) << std::setw(7) << loss
+                  << std::setprecision(0)
+                  << std::setw(10) << percentile(setup, 50) << " / " << std::setw(4) << percentile(setup, 90)
+                  << " / " << std::setw(4) << percentile(setup, 99)
+                  << std::setw(10) << percentile(first_frame, 50) << " / " << std::setw(4)
+                  << percentile(first_frame, 90) << " / " << std::setw(4) << percentile(first_frame, 99)
+                  << std::setw(8) << failed;
+        if (waiting > 0) {
+            std::cout << "  (" << waiting << " new clients without a frame)";
+        }
+        std::cout << std::endl;
+    }
+
+    LoadTestOptions options_;
+    std::vector<std::unique_ptr<LoadClient>> clients_;
+};
+
+static void printUsage(const char *program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --url <rtsp-url>       Server to test (default: built-in loopback server)\n"
+              << "  --server-pid <pid>     Report this process's CPU (set for the built-in server)\n"
+              << "  --clients <n>          Ramp up to n clients (default: 100)\n"
+              << "  --step <n>             Clients added per step (default: 10)\n"
+              << "  --step-seconds <s>     Step length, second half measured (default: 10)\n"
+              << "  --protocol <p>         udp, tcp (interleaved) or mixed (default: udp)\n"
+              << "  --latency <ms>         Client jitterbuffer latency (default: 200)\n"
+              << "  --csv <file>           Write per-client statistics\n"
+              << "Built-in server:\n"
+              << "  --port <port>          RTSP port (default: 8555)\n"
+              << "  --size <w>x<h>         Video size (default: 640x480)\n"
+              << "  --fps <fps>            Frame rate (default: 30)\n"
+              << "  --bitrate <kbps>       x264enc bitrate (default: 1000)\n"
+              << "  --unshared             One encoder per client instead of one shared\n";
+}
+
+int main(int argc, char *argv[]) {
+    LoadTestOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--url" && has_value) options.url = argv[++i];
+        else if (arg == "--server-pid" && has_value) options.server_pid = std::stoi(argv[++i]);
+        else if (arg == "--clients" && has_value) options.max_clients = std::stoi(argv[++i]);
+        else if (arg == "--step" && has_value) options.step = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--step-seconds" && has_value) options.step_seconds = std::max(2, std::stoi(argv[++i]));
+        else if (arg == "--protocol" && has_value) options.protocol = argv[++i];
+        else if (arg == "--latency" && has_value) options.latency = std::stoi(argv[++i]);
+        else if (arg == "--csv" && has_value) options.csv = argv[++i];
+        else if (arg == "--port" && has_value) options.port = std::stoi(argv[++i]);
+        else if (arg == "--size" && has_value) {
+            std::string size = argv[++i];
+            size_t x = size.find('x');
+            if (x != std::string::npos) {
+                options.width = std::stoi(size.substr(0, x));
+                options.height = std::stoi(size.substr(x + 1));
+            }
+        }
+        else if (arg == "--fps" && has_value) options.fps = std::stoi(argv[++i]);
+        else if (arg == "--bitrate" && has_value) options.bitrate = std::stoi(argv[++i]);
+        else if (arg == "--unshared") options.shared = false;
+        else {
+            printUsage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+    if (options.protocol != "udp" && options.protocol != "tcp" && options.protocol != "mixed") {
+        std::cerr << "Unknown protocol: " << options.protocol << std::endl;
+        return 1;
+    }
+
+    // The built-in server runs in its own process (forked before gst_init)
+    // so its CPU time is not mixed with the clients'
+    pid_t server = 0;
+    if (options.url.empty()) {
+        server = fork();
+        if (server < 0) {
+            std::cerr << "fork failed" << std::endl;
+            return 1;
+        }
+        if (server == 0) {
+            runBuiltInServer(options);
+        }
+        options.server_pid = server;
+        options.url = "rtsp://127.0.0.1:" + std::to_string(options.port) + "/camera";
+        if (!waitForPort(options.port, 5000)) {
+            std::cerr << "Built-in server did not start on port " << options.port << std::endl;
+            kill(server, SIGTERM);
+            waitpid(server, nullptr, 0);
+            return 1;
+        }
+        std::cout << "Built-in server (pid " << server << "): " << options.width << "x"
+                  << options.height << "@" << options.fps << " x264enc " << options.bitrate
+                  << " kbps, " << (options.shared ? "shared" : "one encoder per client")
+                  << std::endl;
+    }
+
+    gst_init(&argc, &argv);
+    {
+        LoadTest test(options);
+        test.run();
+        if (!options.csv.empty()) {
+            test.writeCsv(options.csv);
+        }
+    }
+
+    if (server > 0) {
+        kill(server, SIGTERM);
+        waitpid(server, nullptr, 0);
+    }
+    return 0;
+}
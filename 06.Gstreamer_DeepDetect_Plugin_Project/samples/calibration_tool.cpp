@@ -10,6 +10,15 @@
 #include <fstream>
 #include <memory>
 #include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 class Logger : public nvinfer1::ILogger {
 public:
@@ -20,22 +29,60 @@ public:
     }
 } gLogger;
 
+// Preprocessed calibration set, memory-mapped from <calib_cache>.shard:
+//   ShardHeader, then uint8 CHW samples [count][3][640][640] at data_offset.
+// The header records the image list it was built from, so a changed
+// calibration directory rebuilds it instead of silently reusing it.
+struct ShardHeader {
+    char     magic[8];       // "YOLOCAL\0"
+    uint32_t version;
+    uint32_t count;          // Samples stored (unreadable images dropped)
+    uint32_t source_count;   // Images listed when it was built
+    uint32_t width;
+    uint32_t height;
+    uint32_t rgb;            // Channel order: 1 = RGB, 0 = BGR
+    uint64_t list_hash;      // image_list_hash() of the listed images
+    uint64_t data_offset;
+};
+
+static const char kShardMagic[8] = {'Y', 'O', 'L', 'O', 'C', 'A', 'L', '\0'};
+static const uint32_t kShardVersion = 1;
+
+// FNV-1a over file name + size of every image, in order.
+static uint64_t image_list_hash(const std::vector<std::string>& paths) {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* p, size_t len) {
+        const uint8_t* b = static_cast<const uint8_t*>(p);
+        for (size_t i = 0; i < len; i++) { h ^= b[i]; h *= 1099511628211ull; }
+    };
+    for (const auto& path : paths) {
+        std::error_code ec;
+        std::string name = std::filesystem::path(path).filename().string();
+        uint64_t size = std::filesystem::file_size(path, ec);
+        if (ec) size = 0;
+        mix(name.c_str(), name.size() + 1);
+        mix(&size, sizeof(size));
+    }
+    return h;
+}
+
 class Int8Calibrator : public nvinfer1::IInt8Calibrator {
 public:
     Int8Calibrator(const std::vector<std::string> &image_paths, 
                    const std::string &cache_file,
                    int batch_size = 1) 
-        : image_paths_(image_paths), cache_file_(cache_file), 
-          batch_size_(batch_size), current_index_(0) {
+        : image_paths_(image_paths), cache_file_(cache_file),
+          shard_file_(cache_file + ".shard"), batch_size_(batch_size), current_index_(0) {
         
-        input_size_ = 3 * 640 * 640 * sizeof(float); // YOLOv8 input size
-        cudaMalloc(&device_input_, input_size_);
+        input_elems_ = 3 * kInputH * kInputW; // YOLOv8 input size
+        cudaMalloc(&device_input_, batch_size_ * input_elems_ * sizeof(float));
     }
     
     ~Int8Calibrator() {
         if (device_input_) {
             cudaFree(device_input_);
         }
+        close_shard();
     }
     
     int getBatchSize() const noexcept override {
@@ -43,48 +90,33 @@ public:
     }
     
     bool getBatch(void* bindings[], const char* names[], int nbBindings) noexcept override {
-        if (current_index_ >= image_paths_.size()) {
+        // Only reached when TensorRT has no usable calibration cache
+        if (!shard_ && !open_shard() && !(build_shard() && open_shard())) {
+            std::cerr << "Calibration shard unavailable: " << shard_file_ << std::endl;
             return false;
         }
-        
-        // Load and preprocess image
-        cv::Mat image = cv::imread(image_paths_[current_index_]);
-        if (image.empty()) {
-            std::cerr << "Failed to load image: " << image_paths_[current_index_] << std::endl;
-            current_index_++;
-            return getBatch(bindings, names, nbBindings);
+        if (current_index_ + batch_size_ > num_samples_) {
+            return false;
         }
         
-        // Resize to model input size
-        cv::Mat resized;
-        cv::resize(image, resized, cv::Size(640, 640));
-        
-        // Convert to float and normalize
-        cv::Mat float_image;
-        resized.convertTo(float_image, CV_32F, 1.0/255.0);
-        
-        // Convert HWC to CHW format
-        std::vector<cv::Mat> channels(3);
-        cv::split(float_image, channels);
-        
-        std::vector<float> input_data;
-        for (int c = 0; c < 3; c++) {
-            for (int h = 0; h < 640; h++) {
-                for (int w = 0; w < 640; w++) {
-                    input_data.push_back(channels[c].at<float>(h, w));
-                }
-            }
+        // Samples are preprocessed and contiguous in the mapping; only
+        // expand uint8 -> float [0,1] for this batch.
+        const uint8_t* src = samples_ + current_index_ * input_elems_;
+        staging_.resize(batch_size_ * input_elems_);
+        for (size_t i = 0; i < staging_.size(); i++) {
+            staging_[i] = src[i] * (1.0f / 255.0f);
         }
         
         // Copy to device
-        cudaMemcpy(device_input_, input_data.data(), input_size_, cudaMemcpyHostToDevice);
+        cudaMemcpy(device_input_, staging_.data(), staging_.size() * sizeof(float),
+                   cudaMemcpyHostToDevice);
         bindings[0] = device_input_;
         
-        std::cout << "Calibrating with image " << current_index_ + 1 
-                  << "/" << image_paths_.size() << ": " 
-                  << image_paths_[current_index_] << std::endl;
-        
-        current_index_++;
+        current_index_ += batch_size_;
+        if (current_index_ % 50 == 0 || current_index_ == num_samples_) {
+            std::cout << "Calibrated " << current_index_ << "/" << num_samples_
+                      << " images" << std::endl;
+        }
         return true;
     }
     
@@ -110,11 +142,188 @@ public:
     }
 
 private:
+    static constexpr int kInputW = 640;
+    static constexpr int kInputH = 640;
+    // YoloEngine::preprocess() in src/yolo_engine.cc converts frames to
+    // NVBUF_COLOR_FORMAT_RGB with a plain (stretching) resize, then scales
+    // to [0,1]. Calibration has to see the same pixels, so it is RGB too.
+    static constexpr bool kRgb = true;
+
+    // Maps the shard if it was built from this image list at this size.
+    bool open_shard() {
+        int fd = ::open(shard_file_.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShardHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+        
+        const ShardHeader* hdr = static_cast<const ShardHeader*>(map);
+        bool valid = std::memcmp(hdr->magic, kShardMagic, sizeof(kShardMagic)) == 0 &&
+                     hdr->version == kShardVersion &&
+                     hdr->data_offset + uint64_t(hdr->count) * input_elems_ <= size;
+        bool matches = valid &&
+                       hdr->width == kInputW && hdr->height == kInputH &&
+                       hdr->rgb == (kRgb ? 1u : 0u) &&
+                       hdr->source_count == image_paths_.size() &&
+                       hdr->list_hash == image_list_hash(image_paths_);
+        if (!matches) {
+            std::cout << "Calibration shard " << shard_file_
+                      << (valid ? " was built from other images or settings" : " is not a valid shard")
+                      << ", rebuilding" << std::endl;
+            ::munmap(map, size);
+            return false;
+        }
+        
+        ::madvise(map, size, MADV_SEQUENTIAL);
+        shard_ = map;
+        shard_size_ = size;
+        samples_ = static_cast<const uint8_t*>(map) + hdr->data_offset;
+        num_samples_ = hdr->count;
+        std::cout << "Calibration shard: " << num_samples_ << " samples from " << shard_file_
+                  << " (" << (kRgb ? "RGB" : "BGR") << ", " << kInputW << "x" << kInputH << ")"
+                  << std::endl;
+        return true;
+    }
+    
+    void close_shard() {
+        if (shard_) {
+            ::munmap(shard_, shard_size_);
+        }
+        shard_ = nullptr;
+        samples_ = nullptr;
+        num_samples_ = 0;
+    }
+
+    // Decode + resize + RGB + CHW for the whole set on all cores, written
+    // straight into a memory-mapped file (1.2 MB/image as uint8 instead of
+    // 4.9 MB as float). Built under a temporary name and renamed, so an
+    // interrupted run never leaves a shard that looks complete.
+    bool build_shard() {
+        const size_t n = image_paths_.size();
+        const uint64_t data_offset = (sizeof(ShardHeader) + 63) & ~uint64_t(63);
+        const uint64_t total = data_offset + uint64_t(n) * input_elems_;
+        const std::string tmp = shard_file_ + ".tmp";
+        
+        int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "Cannot create " << tmp << std::endl;
+            return false;
+        }
+        if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+            std::cerr << "Cannot size " << tmp << " (disk full?)" << std::endl;
+            ::close(fd);
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        void* map = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            std::cerr << "Cannot map " << tmp << std::endl;
+            ::close(fd);
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        uint8_t* data = static_cast<uint8_t*>(map) + data_offset;
+        
+        std::cout << "Preprocessing " << n << " calibration images: stretch resize to "
+                  << kInputW << "x" << kInputH << ", " << (kRgb ? "RGB" : "BGR")
+                  << " CHW, as YoloEngine::preprocess()" << std::endl;
+        std::vector<uint8_t> ok(n, 0);
+        std::atomic<size_t> next{0};
+        
+        auto worker = [&]() {
+            cv::Mat resized;
+            for (size_t i = next++; i < n; i = next++) {
+                cv::Mat image = cv::imread(image_paths_[i]);
+                if (image.empty()) {
+                    std::cerr << "Failed to load image: " << image_paths_[i] << std::endl;
+                    continue;
+                }
+                cv::resize(image, resized, cv::Size(kInputW, kInputH));
+                
+                // BGR HWC -> CHW in a single pass
+                const size_t plane = kInputW * kInputH;
+                const int first = kRgb ? 2 : 0;
+                uint8_t* dst = data + i * input_elems_;
+                for (int h = 0; h < kInputH; h++) {
+                    const uint8_t* p = resized.ptr<uint8_t>(h);
+                    for (int w = 0; w < kInputW; w++, p += 3) {
+                        const size_t o = h * kInputW + w;
+                        dst[o]             = p[first];
+                        dst[plane + o]     = p[1];
+                        dst[2 * plane + o] = p[2 - first];
+                    }
+                }
+                ok[i] = 1;
+            }
+        };
+        
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; t++) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto& t : pool) {
+            t.join();
+        }
+        
+        // Drop unreadable images so batches stay contiguous
+        size_t kept = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (!ok[i]) continue;
+            if (kept != i) {
+                std::memmove(data + kept * input_elems_, data + i * input_elems_, input_elems_);
+            }
+            kept++;
+        }
+        
+        ShardHeader hdr{};
+        std::memcpy(hdr.magic, kShardMagic, sizeof(kShardMagic));
+        hdr.version = kShardVersion;
+        hdr.count = static_cast<uint32_t>(kept);
+        hdr.source_count = static_cast<uint32_t>(n);
+        hdr.width = kInputW;
+        hdr.height = kInputH;
+        hdr.rgb = kRgb ? 1 : 0;
+        hdr.list_hash = image_list_hash(image_paths_);
+        hdr.data_offset = data_offset;
+        std::memcpy(map, &hdr, sizeof(hdr));
+        
+        ::msync(map, total, MS_SYNC);
+        ::munmap(map, total);
+        bool good = kept > 0 && ::ftruncate(fd, static_cast<off_t>(data_offset + kept * input_elems_)) == 0;
+        ::close(fd);
+        if (!good || std::rename(tmp.c_str(), shard_file_.c_str()) != 0) {
+            std::cerr << "Failed to write calibration shard " << shard_file_ << std::endl;
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        std::cout << "Preprocessed " << kept << "/" << n << " calibration images on "
+                  << threads << " threads -> " << shard_file_ << std::endl;
+        return true;
+    }
+
     std::vector<std::string> image_paths_;
     std::string cache_file_;
+    std::string shard_file_;
     int batch_size_;
     size_t current_index_;
-    size_t input_size_;
+    size_t num_samples_ = 0;
+    size_t input_elems_;
+    void* shard_ = nullptr;             // Read-only mapping of shard_file_
+    size_t shard_size_ = 0;
+    const uint8_t* samples_ = nullptr;  // [num_samples_][3][640][640] in the mapping
+    std::vector<float> staging_;
     void* device_input_;
     std::vector<char> calibration_cache_;
 };
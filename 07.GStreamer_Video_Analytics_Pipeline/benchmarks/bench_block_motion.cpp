@@ -0,0 +1,142 @@
+/**
+ * @file bench_block_motion.cpp
+ * @brief Block motion estimation versus dense optical flow
+ *
+ * Pans a smooth random texture by a known per-frame displacement and
+ * measures BlockMotionEstimator (one thread and all cores) against OpenCV's
+ * Farneback and DIS dense flow. Accuracy is the fraction of interior blocks
+ * whose vector (block estimator) or mean flow (dense) rounds to the true
+ * displacement.
+ *
+ * Usage: bench_block_motion [width] [height] [frames] [dx] [dy]
+ */
+
+#include "block_motion.h"
+#include <opencv2/opencv.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+struct Result {
+    double ms_per_frame = 0.0;
+    double accuracy = 0.0;
+};
+
+std::vector<cv::Mat> makePan(int width, int height, int frames, int dx, int dy) {
+    int margin = (std::abs(dx) + std::abs(dy)) * frames + 32;
+    cv::Mat texture(height + 2 * margin, width + 2 * margin, CV_8UC1);
+    cv::randu(texture, 0, 256);
+    cv::GaussianBlur(texture, texture, cv::Size(0, 0), 3.0);
+    cv::normalize(texture, texture, 0, 255, cv::NORM_MINMAX);
+
+    std::vector<cv::Mat> sequence;
+    for (int i = 0; i < frames; ++i) {
+        // Content moves by (dx, dy) per frame
+        cv::Rect window(margin - dx * i, margin - dy * i, width, height);
+        sequence.push_back(texture(window).clone());
+    }
+    return sequence;
+}
+
+Result runBlocks(const std::vector<cv::Mat>& frames, int threads, int dx, int dy) {
+    BlockMotionEstimator estimator;
+    estimator.configure(frames[0].cols, frames[0].rows, 16, threads);
+    estimator.estimate(frames[0].data, frames[0].step[0]);
+
+    size_t total = 0, correct = 0;
+    double elapsed = 0.0;
+    for (size_t i = 1; i < frames.size(); ++i) {
+        auto start = std::chrono::steady_clock::now();
+        estimator.estimate(frames[i].data, frames[i].step[0]);
+        elapsed += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        const auto& field = estimator.field();
+        for (int by = 1; by + 1 < estimator.blocksY(); ++by) {
+            for (int bx = 1; bx + 1 < estimator.blocksX(); ++bx) {
+                const MotionVector& v = field[static_cast<size_t>(by) * estimator.blocksX() + bx];
+                ++total;
+                correct += (v.dx == dx && v.dy == dy);
+            }
+        }
+    }
+
+    Result result;
+    result.ms_per_frame = elapsed / (frames.size() - 1);
+    result.accuracy = total ? static_cast<double>(correct) / total : 0.0;
+    return result;
+}
+
+template <typename Flow>
+Result runDense(const std::vector<cv::Mat>& frames, Flow flow, int dx, int dy) {
+    const int block = BlockMotionEstimator::kBlockSize;
+    size_t total = 0, correct = 0;
+    cv::Mat field;
+    double elapsed = 0.0;
+    for (size_t i = 1; i < frames.size(); ++i) {
+        auto start = std::chrono::steady_clock::now();
+        flow(frames[i - 1], frames[i], field);
+        elapsed += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        for (int y = block; y + 2 * block <= field.rows; y += block) {
+            for (int x = block; x + 2 * block <= field.cols; x += block) {
+                cv::Scalar mean = cv::mean(field(cv::Rect(x, y, block, block)));
+                ++total;
+                correct += (cvRound(mean[0]) == dx && cvRound(mean[1]) == dy);
+            }
+        }
+    }
+    Result result;
+    result.ms_per_frame = elapsed / (frames.size() - 1);
+    result.accuracy = total ? static_cast<double>(correct) / total : 0.0;
+    return result;
+}
+
+void print(const std::string& name, const Result& result, double reference_ms) {
+    std::cout << std::left << std::setw(16) << name
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << result.ms_per_frame
+              << std::setw(12) << reference_ms / result.ms_per_frame
+              << std::setw(10) << result.accuracy << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int width = argc > 1 ? std::stoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::stoi(argv[2]) : 1080;
+    const int frames = argc > 3 ? std::stoi(argv[3]) : 30;
+    const int dx = argc > 4 ? std::stoi(argv[4]) : 3;
+    const int dy = argc > 5 ? std::stoi(argv[5]) : -2;
+
+    std::vector<cv::Mat> sequence = makePan(width, height, frames, dx, dy);
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::cout << width << "x" << height << ", " << frames << " frames, pan ("
+              << dx << ", " << dy << ") px/frame\n\n"
+              << std::left << std::setw(16) << "method"
+              << std::right << std::setw(12) << "ms/frame"
+              << std::setw(12) << "vs Farneback"
+              << std::setw(10) << "accuracy" << "\n";
+
+    Result farneback = runDense(sequence, [](const cv::Mat& prev, const cv::Mat& next, cv::Mat& flow) {
+        cv::calcOpticalFlowFarneback(prev, next, flow, 0.5, 3, 15, 3, 5, 1.2, 0);
+    }, dx, dy);
+    cv::Ptr<cv::DISOpticalFlow> dis = cv::DISOpticalFlow::create(cv::DISOpticalFlow::PRESET_FAST);
+    Result dis_result = runDense(sequence, [&](const cv::Mat& prev, const cv::Mat& next, cv::Mat& flow) {
+        dis->calc(prev, next, flow);
+    }, dx, dy);
+
+    print("Farneback", farneback, farneback.ms_per_frame);
+    print("DIS (fast)", dis_result, farneback.ms_per_frame);
+    print("blocks x1", runBlocks(sequence, 1, dx, dy), farneback.ms_per_frame);
+    print("blocks x" + std::to_string(cores), runBlocks(sequence, 0, dx, dy), farneback.ms_per_frame);
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file bench_color_adjust.cpp
+ * @brief ColorAdjuster versus the former per-pixel brightness/contrast loop
+ *
+ * The reference is the previous VideoProcessor path: floating-point math and
+ * CLAMP per luma pixel, no saturation or hue. ColorAdjuster applies all four
+ * controls (luma table plus chroma rotation) on one thread and on all cores.
+ *
+ * Usage: bench_color_adjust [width] [height] [frames]
+ */
+
+#include "color_adjust.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+namespace {
+
+struct Frame {
+    int width;
+    int height;
+    std::vector<uint8_t> y, u, v;
+};
+
+Frame makeFrame(int width, int height) {
+    Frame frame{width, height, {}, {}, {}};
+    std::mt19937 rng(7);
+    frame.y.resize(static_cast<size_t>(width) * height);
+    frame.u.resize(static_cast<size_t>(width / 2) * (height / 2));
+    frame.v.resize(frame.u.size());
+    for (auto& p : frame.y) p = static_cast<uint8_t>(rng());
+    for (auto& p : frame.u) p = static_cast<uint8_t>(rng());
+    for (auto& p : frame.v) p = static_cast<uint8_t>(rng());
+    return frame;
+}
+
+// Former adjustBrightnessContrast (Y plane only)
+void legacyAdjust(Frame& frame, double brightness, double contrast) {
+    for (int y = 0; y < frame.height; y++) {
+        uint8_t* row = frame.y.data() + static_cast<size_t>(y) * frame.width;
+        for (int x = 0; x < frame.width; x++) {
+            int pixel = row[x];
+            pixel = (int)((pixel - 128) * contrast + 128);
+            pixel += brightness;
+            row[x] = static_cast<uint8_t>(std::min(255, std::max(0, pixel)));
+        }
+    }
+}
+
+template <typename Fn>
+double timeFrames(int frames, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+        fn();
+    }
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int width = argc > 1 ? std::stoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::stoi(argv[2]) : 1080;
+    const int frames = argc > 3 ? std::stoi(argv[3]) : 200;
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    Frame frame = makeFrame(width, height);
+
+    std::cout << width << "x" << height << " I420, " << frames << " frames\n\n"
+              << std::left << std::setw(26) << "path"
+              << std::right << std::setw(12) << "ms/frame"
+              << std::setw(12) << "speed-up" << "\n";
+
+    double legacy = timeFrames(frames, [&] { legacyAdjust(frame, 20.0, 1.2); });
+    auto print = [&](const std::string& name, double ms) {
+        std::cout << std::left << std::setw(26) << name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << ms
+                  << std::setw(12) << legacy / ms << "\n";
+    };
+    print("legacy Y only", legacy);
+
+    std::vector<int> thread_counts = {1};
+    if (cores > 1) {
+        thread_counts.push_back(cores);
+    }
+    for (int threads : thread_counts) {
+        ColorAdjuster adjuster;
+        adjuster.setThreads(threads);
+
+        adjuster.setParams(20.0, 1.2, 1.0, 0.0);
+        print("LUT Y only x" + std::to_string(threads), timeFrames(frames, [&] {
+            adjuster.applyPlanar(frame.y.data(), width, frame.u.data(), width / 2,
+                                 frame.v.data(), width / 2, width, height);
+        }));
+
+        adjuster.setParams(20.0, 1.2, 1.3, 15.0);
+        print("LUT Y+UV x" + std::to_string(threads), timeFrames(frames, [&] {
+            adjuster.applyPlanar(frame.y.data(), width, frame.u.data(), width / 2,
+                                 frame.v.data(), width / 2, width, height);
+        }));
+    }
+    return 0;
+}
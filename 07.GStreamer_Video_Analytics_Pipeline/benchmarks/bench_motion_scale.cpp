@@ -0,0 +1,163 @@
+/**
+ * @file bench_motion_scale.cpp
+ * @brief Motion detection throughput versus recall across analysis scales
+ *
+ * Decodes a recorded clip once, keeps the luma of every frame in memory and
+ * replays it through MotionDetector at analysis_scale 1, 1/2, 1/4 and 1/8.
+ * Full-resolution detections are the reference: a reference region counts as
+ * recalled when a region at the tested scale overlaps it with IoU >= 0.3.
+ *
+ * Usage: bench_motion_scale <clip> [algorithm] [max_frames]
+ *        algorithm: FRAME_DIFF, BACKGROUND_SUB, OPTICAL_FLOW, MOG2 (default), KNN,
+ *                   RUNNING_AVG
+ */
+
+#include "motion_detector.h"
+#include <opencv2/videoio.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace {
+
+const char* const kAlgorithmNames =
+    "FRAME_DIFF, BACKGROUND_SUB, OPTICAL_FLOW, MOG2, KNN, RUNNING_AVG";
+
+bool parseAlgorithm(const std::string& name, MotionAlgorithm& algorithm) {
+    if (name == "FRAME_DIFF") algorithm = MotionAlgorithm::FRAME_DIFF;
+    else if (name == "BACKGROUND_SUB") algorithm = MotionAlgorithm::BACKGROUND_SUB;
+    else if (name == "OPTICAL_FLOW") algorithm = MotionAlgorithm::OPTICAL_FLOW;
+    else if (name == "MOG2") algorithm = MotionAlgorithm::MOG2;
+    else if (name == "KNN") algorithm = MotionAlgorithm::KNN;
+    else if (name == "RUNNING_AVG") algorithm = MotionAlgorithm::RUNNING_AVG;
+    else return false;
+    return true;
+}
+
+double iou(const MotionRegion& a, const MotionRegion& b) {
+    int x0 = std::max(a.x, b.x);
+    int y0 = std::max(a.y, b.y);
+    int x1 = std::min(a.x + a.width, b.x + b.width);
+    int y1 = std::min(a.y + a.height, b.y + b.height);
+    if (x1 <= x0 || y1 <= y0) {
+        return 0.0;
+    }
+    double inter = static_cast<double>(x1 - x0) * (y1 - y0);
+    double uni = static_cast<double>(a.width) * a.height +
+                 static_cast<double>(b.width) * b.height - inter;
+    return inter / uni;
+}
+
+using FrameRegions = std::vector<std::vector<MotionRegion>>;
+
+struct RunResult {
+    double ms_per_frame = 0.0;
+    FrameRegions regions;
+};
+
+RunResult run(const std::vector<cv::Mat>& frames, MotionAlgorithm algorithm, double scale) {
+    MotionDetector detector;
+    MotionDetectionParams params = detector.getParameters();
+    params.algorithm = algorithm;
+    params.analysis_scale = scale;
+    params.enable_alerts = false;
+    params.draw_motion_regions = false;
+    detector.setParameters(params);
+
+    RunResult result;
+    result.regions.reserve(frames.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& frame : frames) {
+        result.regions.push_back(detector.process(frame));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    result.ms_per_frame =
+        std::chrono::duration<double, std::milli>(end - start).count() / frames.size();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <clip> [algorithm] [max_frames]" << std::endl;
+        return 1;
+    }
+    const std::string clip = argv[1];
+    const std::string algorithm_name = argc > 2 ? argv[2] : "MOG2";
+    const size_t max_frames = argc > 3 ? std::stoul(argv[3]) : 300;
+    MotionAlgorithm algorithm;
+    if (!parseAlgorithm(algorithm_name, algorithm)) {
+        std::cerr << "Unknown algorithm: " << algorithm_name
+                  << " (valid: " << kAlgorithmNames << ")" << std::endl;
+        return 1;
+    }
+
+    cv::VideoCapture cap(clip);
+    if (!cap.isOpened()) {
+        std::cerr << "Cannot open clip: " << clip << std::endl;
+        return 1;
+    }
+
+    // The pipeline analyses the Y plane, so replay grayscale frames
+    std::vector<cv::Mat> frames;
+    cv::Mat bgr;
+    while (frames.size() < max_frames && cap.read(bgr)) {
+        cv::Mat gray;
+        cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+        frames.push_back(gray);
+    }
+    if (frames.empty()) {
+        std::cerr << "No frames decoded from " << clip << std::endl;
+        return 1;
+    }
+
+    std::cout << "Clip: " << clip << " (" << frames.size() << " frames, "
+              << frames[0].cols << "x" << frames[0].rows << "), algorithm "
+              << algorithm_name << "\n\n";
+
+    const double scales[] = {1.0, 0.5, 0.25, 0.125};
+    RunResult reference;
+
+    std::cout << std::left << std::setw(8) << "scale"
+              << std::right << std::setw(12) << "ms/frame"
+              << std::setw(10) << "fps"
+              << std::setw(10) << "speedup"
+              << std::setw(12) << "regions"
+              << std::setw(10) << "recall" << "\n";
+
+    for (double scale : scales) {
+        RunResult result = run(frames, algorithm, scale);
+        if (scale == 1.0) {
+            reference = result;
+        }
+
+        size_t total = 0, found = 0, produced = 0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            produced += result.regions[i].size();
+            for (const auto& ref : reference.regions[i]) {
+                ++total;
+                for (const auto& cand : result.regions[i]) {
+                    if (iou(ref, cand) >= 0.3) {
+                        ++found;
+                        break;
+                    }
+                }
+            }
+        }
+        double recall = total ? static_cast<double>(found) / total : 1.0;
+
+        std::cout << std::left << std::setw(8) << ("1/" + std::to_string(static_cast<int>(1.0 / scale)))
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << result.ms_per_frame
+                  << std::setw(10) << 1000.0 / result.ms_per_frame
+                  << std::setw(10) << reference.ms_per_frame / result.ms_per_frame
+                  << std::setw(12) << produced
+                  << std::setw(10) << recall << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file bench_stream_host.cpp
+ * @brief StreamHost scale-out: 1-64 live videotestsrc streams on a shared pool
+ *
+ * Every stream is a live "ball" pattern at 30 fps with motion detection, so
+ * each one offers a fixed load. For each stream count the host runs once
+ * with the shared pool (default: one worker per core) and once with one
+ * worker per stream, which behaves like a thread per stream. Reports the
+ * analysed frame rate (total and slowest stream), the share of frames
+ * dropped by the per-stream queues, the analysis time per frame and the
+ * number of stolen stream turns. A host keeps up while the slowest stream
+ * stays near 30 fps and drops stay near zero.
+ *
+ * Usage: bench_stream_host [threads] [seconds] [width] [height] [max_streams]
+ */
+
+#include "stream_host.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct Result {
+    double total_fps = 0.0;     // Analysed frames per second, all streams
+    double min_fps = 0.0;       // Slowest stream
+    double drop_percent = 0.0;  // Dropped / delivered frames
+    double ms_per_frame = 0.0;  // Analysis time per frame
+    guint64 steals = 0;         // Stream turns taken from another worker
+};
+
+/**
+ * @brief Runs N streams for a while and measures the second half
+ */
+Result run(int streams, int threads, int seconds, int width, int height) {
+    StreamHostConfig config;
+    config.thread_count = threads;
+    config.format.width = width;
+    config.format.height = height;
+    config.format.framerate = 30;
+    config.enable_motion_detection = true;
+    config.motion.algorithm = MotionAlgorithm::RUNNING_AVG;
+
+    StreamHost host(config);
+    host.start();
+    for (int i = 0; i < streams; ++i) {
+        host.addStream("s" + std::to_string(i), "ball", SourceType::TEST);
+    }
+
+    // Warm-up: pipelines pre-roll and the background models settle
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::map<std::string, StreamStats> before;
+    for (const auto& stats : host.getStats()) {
+        before[stats.id] = stats;
+    }
+    guint64 steals_before = host.getPool().steals();
+    auto start = std::chrono::steady_clock::now();
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Result result;
+    result.min_fps = 1e9;
+    guint64 input = 0;
+    guint64 dropped = 0;
+    guint64 processed = 0;
+    double busy_ms = 0.0;
+    for (const auto& stats : host.getStats()) {
+        const StreamStats& old = before[stats.id];
+        guint64 stream_processed = stats.processed_frames - old.processed_frames;
+        input += stats.input_frames - old.input_frames;
+        dropped += stats.dropped_frames - old.dropped_frames;
+        processed += stream_processed;
+        busy_ms += stats.avg_processing_ms * stats.processed_frames -
+                   old.avg_processing_ms * old.processed_frames;
+        result.min_fps = std::min(result.min_fps, stream_processed / elapsed);
+    }
+    result.total_fps = processed / elapsed;
+    result.drop_percent = input ? 100.0 * dropped / input : 0.0;
+    result.ms_per_frame = processed ? busy_ms / processed : 0.0;
+    result.steals = host.getPool().steals() - steals_before;
+
+    host.stop();
+    return result;
+}
+
+void print(const std::string& mode, int streams, int threads, const Result& r) {
+    std::cout << std::left << std::setw(12) << mode
+              << std::right << std::setw(8) << streams
+              << std::setw(9) << threads << std::fixed << std::setprecision(1)
+              << std::setw(11) << r.total_fps
+              << std::setw(10) << r.min_fps
+              << std::setw(9) << r.drop_percent
+              << std::setprecision(2) << std::setw(10) << r.ms_per_frame
+              << std::setw(10) << r.steals << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    gst_init(&argc, &argv);
+
+    const int threads = argc > 1 ? std::stoi(argv[1]) : 0;
+    const int seconds = argc > 2 ? std::stoi(argv[2]) : 5;
+    const int width = argc > 3 ? std::stoi(argv[3]) : 640;
+    const int height = argc > 4 ? std::stoi(argv[4]) : 360;
+    const int max_streams = argc > 5 ? std::stoi(argv[5]) : 64;
+
+    const int pool_threads = threads > 0 ? threads
+                                         : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << width << "x" << height << "@30 ball, RUNNING_AVG motion, "
+              << seconds << " s per run\n\n"
+              << std::left << std::setw(12) << "mode"
+              << std::right << std::setw(8) << "streams"
+              << std::setw(9) << "workers"
+              << std::setw(11) << "total fps"
+              << std::setw(10) << "min fps"
+              << std::setw(9) << "drop %"
+              << std::setw(10) << "ms/frame"
+              << std::setw(10) << "steals" << "\n";
+
+    for (int streams = 1; streams <= max_streams; streams *= 2) {
+        print("shared", streams, pool_threads, run(streams, pool_threads, seconds, width, height));
+        if (streams != pool_threads) {
+            print("per-stream", streams, streams, run(streams, streams, seconds, width, height));
+        }
+    }
+    return 0;
+}
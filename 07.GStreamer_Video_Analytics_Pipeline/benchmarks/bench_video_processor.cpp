@@ -0,0 +1,174 @@
+/**
+ * @file bench_video_processor.cpp
+ * @brief VideoProcessor transform modes: throughput and output buffers
+ *
+ * Runs videotestsrc -> VideoProcessor -> fakesink (not synced to the clock)
+ * for several filters and one cropping filter chain, and reports the
+ * processor's own ms/frame, the pipeline rate, the headroom against 30 fps,
+ * how many frames left the element in the buffer they arrived in
+ * (passthrough / in place) and how many distinct
+ * output memories reached the sink. Out-of-place filters should cycle through
+ * a few pooled buffers rather than one new buffer per frame.
+ *
+ * Usage: bench_video_processor [width] [height] [frames] [format]
+ */
+
+#include "video_processor.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <set>
+#include <vector>
+#include <chrono>
+
+namespace {
+
+struct Probe {
+    GstBuffer* last_input = nullptr;    // Buffer entering the element
+    guint64 frames = 0;                 // Buffers leaving the element
+    guint64 forwarded = 0;              // Left in the buffer they arrived in
+    std::set<GstMemory*> memories;      // Distinct output memories
+};
+
+GstPadProbeReturn onInput(GstPad*, GstPadProbeInfo* info, gpointer data) {
+    static_cast<Probe*>(data)->last_input = GST_PAD_PROBE_INFO_BUFFER(info);
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn onOutput(GstPad*, GstPadProbeInfo* info, gpointer data) {
+    Probe* probe = static_cast<Probe*>(data);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    probe->frames++;
+    probe->forwarded += buffer == probe->last_input;
+    probe->memories.insert(gst_buffer_peek_memory(buffer, 0));
+    return GST_PAD_PROBE_OK;
+}
+
+struct Result {
+    double element_ms = 0.0;
+    double fps = 0.0;
+    Probe probe;
+};
+
+bool run(const std::string& caps_string, int frames, const ProcessingParams& params, Result& result) {
+    VideoProcessor processor;
+    processor.setParameters(params);
+
+    GstElement* pipeline = gst_pipeline_new("bench");
+    GstElement* source = gst_element_factory_make("videotestsrc", nullptr);
+    GstElement* capsfilter = gst_element_factory_make("capsfilter", nullptr);
+    GstElement* sink = gst_element_factory_make("fakesink", nullptr);
+    GstElement* element = processor.createElement();
+    if (!pipeline || !source || !capsfilter || !sink || !element) {
+        return false;
+    }
+    // The processor keeps its own reference and releases it in its destructor
+    gst_object_ref(element);
+
+    g_object_set(source, "num-buffers", frames, nullptr);
+    GstCaps* caps = gst_caps_from_string(caps_string.c_str());
+    g_object_set(capsfilter, "caps", caps, nullptr);
+    gst_caps_unref(caps);
+    g_object_set(sink, "sync", FALSE, nullptr);
+
+    gst_bin_add_many(GST_BIN(pipeline), source, capsfilter, element, sink, nullptr);
+    if (!gst_element_link_many(source, capsfilter, element, sink, nullptr)) {
+        gst_object_unref(pipeline);
+        return false;
+    }
+
+    GstPad* sink_pad = gst_element_get_static_pad(element, "sink");
+    GstPad* src_pad = gst_element_get_static_pad(element, "src");
+    gst_pad_add_probe(sink_pad, GST_PAD_PROBE_TYPE_BUFFER, onInput, &result.probe, nullptr);
+    gst_pad_add_probe(src_pad, GST_PAD_PROBE_TYPE_BUFFER, onOutput, &result.probe, nullptr);
+    gst_object_unref(sink_pad);
+    gst_object_unref(src_pad);
+
+    auto start = std::chrono::steady_clock::now();
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    GstBus* bus = gst_element_get_bus(pipeline);
+    GstMessage* message = gst_bus_timed_pop_filtered(
+        bus, GST_CLOCK_TIME_NONE, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    auto end = std::chrono::steady_clock::now();
+
+    bool ok = message && GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+    if (message) {
+        gst_message_unref(message);
+    }
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    result.fps = seconds > 0 ? result.probe.frames / seconds : 0.0;
+    result.element_ms = processor.getStats().avg_processing_time;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    gst_init(&argc, &argv);
+
+    const int width = argc > 1 ? std::stoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::stoi(argv[2]) : 1080;
+    const int frames = argc > 3 ? std::stoi(argv[3]) : 300;
+    const std::string format = argc > 4 ? argv[4] : "I420";
+
+    const std::string caps = "video/x-raw,format=" + format +
+                             ",width=" + std::to_string(width) +
+                             ",height=" + std::to_string(height) + ",framerate=30/1";
+
+    struct Case {
+        std::string name;
+        FilterType filter;
+        int rotation;
+        std::vector<FilterStage> chain;
+    };
+    const Case cases[] = {
+        {"NONE", FilterType::NONE, 0},
+        {"GRAYSCALE", FilterType::GRAYSCALE, 0},
+        {"BRIGHTNESS", FilterType::BRIGHTNESS, 0},
+        {"GRAYSCALE+rot180", FilterType::GRAYSCALE, 180},
+        {"BLUR", FilterType::BLUR, 0},
+        {"SHARPEN", FilterType::SHARPEN, 0},
+        {"CHAIN", FilterType::CHAIN, 10,
+         {FilterStage::CROP, FilterStage::ROTATE, FilterStage::SHARPEN, FilterStage::COLOR_ADJUST}},
+    };
+
+    std::cout << caps << ", " << frames << " frames\n\n"
+              << std::left << std::setw(18) << "filter"
+              << std::right << std::setw(12) << "element ms"
+              << std::setw(10) << "fps"
+              << std::setw(10) << "x30fps"
+              << std::setw(12) << "forwarded"
+              << std::setw(12) << "out bufs" << "\n";
+
+    for (const auto& c : cases) {
+        ProcessingParams params;
+        params.filter_type = c.filter;
+        params.rotation = c.rotation;
+        params.brightness = 20.0;
+        params.contrast = 1.2;
+        params.filter_chain = c.chain;
+        // Chain: crop the central half
+        params.crop_x = width / 4;
+        params.crop_y = height / 4;
+        params.crop_width = width / 2;
+        params.crop_height = height / 2;
+
+        Result result;
+        if (!run(caps, frames, params, result)) {
+            std::cerr << c.name << ": pipeline failed" << std::endl;
+            continue;
+        }
+        std::cout << std::left << std::setw(18) << c.name
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << result.element_ms
+                  << std::setw(10) << result.fps
+                  << std::setw(10) << result.fps / 30.0
+                  << std::setw(12) << result.probe.forwarded
+                  << std::setw(12) << result.probe.memories.size() << "\n";
+    }
+    return 0;
+}
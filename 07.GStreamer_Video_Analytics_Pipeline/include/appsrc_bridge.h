@@ -0,0 +1,121 @@
+/**
+ * @file appsrc_bridge.h
+ * @brief Hands the processed frames of one pipeline to appsrc elements of others
+ *
+ * The analytics pipeline ends its output branch in an appsink; every RTSP
+ * media that serves it starts with an appsrc. The bridge forwards each
+ * sample to all attached appsrcs without copying pixels (a metadata copy
+ * shares the frame memory), sets the caps of each appsrc from the samples,
+ * and rebases timestamps so every media starts at zero. Each appsrc is a
+ * small leaky queue: when a media falls behind its oldest frames are
+ * dropped, the analytics branch is never blocked.
+ */
+
+#ifndef APPSRC_BRIDGE_H
+#define APPSRC_BRIDGE_H
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "metrics_registry.h"
+
+/**
+ * @brief Forwards appsink samples to any number of appsrc elements
+ */
+class AppSrcBridge {
+public:
+    /**
+     * @brief Constructor
+     * @param max_buffers Frames an appsrc holds before it drops the oldest
+     */
+    explicit AppSrcBridge(guint max_buffers = 4);
+
+    /**
+     * @brief Destructor (releases the attached appsrcs)
+     */
+    ~AppSrcBridge();
+
+    AppSrcBridge(const AppSrcBridge&) = delete;
+    AppSrcBridge& operator=(const AppSrcBridge&) = delete;
+
+    /**
+     * @brief Takes the samples of an appsink (installs its callbacks)
+     * @param appsink appsink at the end of the producing branch
+     */
+    void attachSink(GstElement* appsink);
+
+    /**
+     * @brief Starts feeding an appsrc
+     *
+     * Configures it as a live, leaky TIME source; caps are set from the
+     * first sample it receives.
+     * @param appsrc appsrc of the consuming pipeline
+     */
+    void addTarget(GstElement* appsrc);
+
+    /**
+     * @brief Stops feeding an appsrc
+     * @param appsrc appsrc passed to addTarget()
+     * @return false if it was not attached
+     */
+    bool removeTarget(GstElement* appsrc);
+
+    /**
+     * @brief Returns the number of attached appsrcs
+     */
+    size_t targetCount() const;
+
+    /**
+     * @brief Returns the samples received from the appsink
+     */
+    guint64 samples() const { return samples_metric_.value(); }
+
+    /**
+     * @brief Returns the buffers pushed into appsrcs (all targets)
+     */
+    guint64 pushed() const { return pushed_metric_.value(); }
+
+    /**
+     * @brief Exports the bridge metrics
+     * @param registry Registry (must not outlive this object)
+     * @param prefix Metric name prefix, e.g. "rtsp_bridge"
+     */
+    void registerMetrics(MetricsRegistry& registry, const std::string& prefix);
+
+private:
+    /**
+     * @brief One attached appsrc
+     */
+    struct Target {
+        GstElement* appsrc;         // Owned reference
+        GstCaps* caps;              // Caps last set on it (owned, may be null)
+        GstClockTime base;          // Running time of its first frame
+    };
+
+    /**
+     * @brief appsink new-sample callback (producer streaming thread)
+     * @param sink appsink
+     * @param user_data This pointer
+     * @return GST_FLOW_OK, or GST_FLOW_EOS when no sample is left
+     */
+    static GstFlowReturn onNewSample(GstAppSink* sink, gpointer user_data);
+
+    /**
+     * @brief Pushes one sample to every target
+     * @param sample Sample from the appsink
+     */
+    void forward(GstSample* sample);
+
+    guint max_buffers_;                 // appsrc queue limit (frames)
+    std::vector<Target> targets_;       // Attached appsrcs
+    mutable std::mutex mutex_;          // Guards targets_
+
+    Counter samples_metric_;            // Samples from the appsink
+    Counter pushed_metric_;             // Buffers pushed into appsrcs
+};
+
+#endif // APPSRC_BRIDGE_H
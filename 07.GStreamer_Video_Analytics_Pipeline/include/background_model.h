@@ -0,0 +1,94 @@
+/**
+ * @file background_model.h
+ * @brief Fixed-point running-average background model
+ *
+ * Single-plane background model for MotionAlgorithm::RUNNING_AVG. Each pixel
+ * keeps an 8.8 fixed-point average; classification (|frame - background| >
+ * threshold) and the update run in one SSE2 pass. Pixels classified as
+ * foreground are updated with a separate, slower rate so moving objects are
+ * not absorbed into the background. Large planes are split into row bands
+ * processed by a RowBandPool.
+ */
+
+#ifndef BACKGROUND_MODEL_H
+#define BACKGROUND_MODEL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "row_band_pool.h"
+
+/**
+ * @brief 8.8 fixed-point running average with selective update
+ */
+class FixedPointBackground {
+public:
+    /**
+     * @brief Allocates the model for a plane size (drops the current model)
+     * @param width Plane width
+     * @param height Plane height
+     * @param threads Row bands processed in parallel (0 = hardware concurrency)
+     */
+    void configure(int width, int height, int threads = 1);
+
+    /**
+     * @brief Returns the configured width
+     */
+    int width() const { return width_; }
+
+    /**
+     * @brief Returns the configured height
+     */
+    int height() const { return height_; }
+
+    /**
+     * @brief Sets the update rates
+     * @param background_rate Rate for pixels classified as background (max 0.25)
+     * @param foreground_rate Rate for pixels classified as foreground (max 0.25)
+     */
+    void setLearningRates(double background_rate, double foreground_rate);
+
+    /**
+     * @brief Classifies a frame and updates the model
+     * @param frame 8-bit plane
+     * @param stride Row stride of frame in bytes
+     * @param threshold Pixels differing from the background by more than this are foreground
+     * @param mask Output 0/255 mask (height rows of width bytes)
+     * @param mask_stride Row stride of mask in bytes
+     * @return false on the first frame (model primed, mask cleared)
+     */
+    bool apply(const uint8_t* frame, size_t stride, int threshold,
+               uint8_t* mask, size_t mask_stride);
+
+    /**
+     * @brief Writes the rounded background image
+     * @param dst Destination buffer (height rows of width bytes)
+     * @param stride Row stride of dst in bytes
+     */
+    void background(uint8_t* dst, size_t stride) const;
+
+private:
+    /**
+     * @brief Classifies and updates rows [y0, y1)
+     */
+    void processRows(int y0, int y1);
+
+    int width_ = 0;                       // Plane width
+    int height_ = 0;                      // Plane height
+    bool primed_ = false;                 // Model holds a frame
+    int16_t background_mul_ = 0;          // Background rate as a mulhi multiplier
+    int16_t foreground_mul_ = 0;          // Foreground rate as a mulhi multiplier
+    std::vector<uint16_t> model_;         // 8.8 fixed-point background
+
+    // Current job (valid while a frame is being processed)
+    const uint8_t* job_frame_ = nullptr;
+    size_t job_stride_ = 0;
+    uint8_t* job_mask_ = nullptr;
+    size_t job_mask_stride_ = 0;
+    int job_threshold_ = 0;
+
+    RowBandPool pool_;                    // Row-band workers
+};
+
+#endif // BACKGROUND_MODEL_H
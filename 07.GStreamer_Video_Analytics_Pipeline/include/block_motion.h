@@ -0,0 +1,137 @@
+/**
+ * @file block_motion.h
+ * @brief Block-matching motion estimation on a luma plane
+ *
+ * Backs MotionAlgorithm::OPTICAL_FLOW. The plane is divided into 16x16
+ * macroblocks; each block is matched against the previous frame with SSE2
+ * SAD, starting from predictor vectors (left neighbour in the current field,
+ * co-located and adjacent blocks of the previous field) and refined with a
+ * large/small diamond search. Block rows are independent, so they are
+ * distributed over a RowBandPool.
+ */
+
+#ifndef BLOCK_MOTION_H
+#define BLOCK_MOTION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "row_band_pool.h"
+
+/**
+ * @brief Motion of one macroblock
+ */
+struct MotionVector {
+    int16_t dx = 0;         // Horizontal motion (pixels per frame)
+    int16_t dy = 0;         // Vertical motion (pixels per frame)
+    uint16_t sad = 0;       // SAD at the chosen vector
+    uint16_t zero_sad = 0;  // SAD without displacement (temporal change)
+};
+
+/**
+ * @brief Block motion field in input coordinates
+ */
+struct MotionVectorField {
+    int blocks_x = 0;                   // Blocks per row
+    int blocks_y = 0;                   // Block rows
+    int block_size = 0;                 // Block edge in input pixels
+    std::vector<MotionVector> vectors;  // Row-major, dx/dy in input pixels
+};
+
+/**
+ * @brief 16x16 block-matching motion estimator
+ */
+class BlockMotionEstimator {
+public:
+    static constexpr int kBlockSize = 16;
+
+    /**
+     * @brief Allocates the estimator for a plane size (drops the previous frame)
+     * @param width Plane width
+     * @param height Plane height
+     * @param search_range Maximum displacement in pixels
+     * @param threads Block-row bands processed in parallel (0 = hardware concurrency)
+     */
+    void configure(int width, int height, int search_range = 16, int threads = 1);
+
+    /**
+     * @brief Returns the configured width
+     */
+    int width() const { return width_; }
+
+    /**
+     * @brief Returns the configured height
+     */
+    int height() const { return height_; }
+
+    /**
+     * @brief Returns the number of blocks per row (partial blocks are ignored)
+     */
+    int blocksX() const { return blocks_x_; }
+
+    /**
+     * @brief Returns the number of block rows
+     */
+    int blocksY() const { return blocks_y_; }
+
+    /**
+     * @brief Estimates the field for a frame against the previous one
+     * @param frame 8-bit luma plane
+     * @param stride Row stride of frame in bytes
+     * @return false on the first frame (field cleared)
+     */
+    bool estimate(const uint8_t* frame, size_t stride);
+
+    /**
+     * @brief Returns the current field (row-major, blocksX() x blocksY())
+     */
+    const std::vector<MotionVector>& field() const { return field_; }
+
+    /**
+     * @brief Writes a block-level motion mask
+     * @param sad_threshold Blocks whose zero-displacement SAD exceeds this are set
+     * @param dst Destination (blocksY() rows of blocksX() bytes, 0/255)
+     * @param stride Row stride of dst in bytes
+     * @return Number of moving blocks
+     */
+    int blockMask(int sad_threshold, uint8_t* dst, size_t stride) const;
+
+private:
+    /**
+     * @brief Estimates block rows [by0, by1)
+     */
+    void estimateRows(int by0, int by1);
+
+    /**
+     * @brief Predictor-seeded diamond search for one block
+     */
+    MotionVector searchBlock(int bx, int by) const;
+
+    /**
+     * @brief SAD of the current block at (x, y) against the previous frame at (x - vx, y - vy)
+     */
+    uint32_t blockSad(int x, int y, int vx, int vy) const;
+
+    /**
+     * @brief Checks the search range and that the reference block is inside the frame
+     */
+    bool validVector(int x, int y, int vx, int vy) const;
+
+    int width_ = 0;                          // Plane width
+    int height_ = 0;                         // Plane height
+    int blocks_x_ = 0;                       // Blocks per row
+    int blocks_y_ = 0;                       // Block rows
+    int range_ = 16;                         // Search range
+    bool primed_ = false;                    // previous_ holds a frame
+
+    const uint8_t* frame_ = nullptr;         // Current frame (during estimate)
+    size_t stride_ = 0;                      // Current frame stride
+    std::vector<uint8_t> previous_;          // Previous frame (width_ stride)
+    std::vector<MotionVector> field_;        // Current field
+    std::vector<MotionVector> previous_field_; // Field of the previous frame
+
+    RowBandPool pool_;                       // Block-row workers
+};
+
+#endif // BLOCK_MOTION_H
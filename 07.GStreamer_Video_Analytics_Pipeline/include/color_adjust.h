@@ -0,0 +1,134 @@
+/**
+ * @file color_adjust.h
+ * @brief LUT-based brightness, contrast, saturation and hue adjustment
+ *
+ * Brightness and contrast become a 256-entry luma table. Saturation and hue
+ * are a scale and rotation of the (U, V) vector around 128, applied as a
+ * Q12 fixed-point 2x2 matrix with one _mm_madd_epi16 per output. Tables are
+ * rebuilt on parameter changes and published through an atomic shared_ptr,
+ * so the streaming thread never takes a lock to read them. Frames are split
+ * into row bands processed by a RowBandPool.
+ */
+
+#ifndef COLOR_ADJUST_H
+#define COLOR_ADJUST_H
+
+#include <cstdint>
+#include <memory>
+#include <atomic>
+
+#include "row_band_pool.h"
+
+/**
+ * @brief Precomputed adjustment tables
+ */
+struct ColorTables {
+    uint8_t luma[256];          // Y' = luma[Y]
+    int16_t uv_scale;           // saturation * cos(hue), Q12
+    int16_t uv_rotate;          // saturation * sin(hue), Q12
+    bool luma_identity;         // luma[] is the identity
+    bool chroma_identity;       // Saturation 1, hue 0
+};
+
+/**
+ * @brief Colour adjustment engine for YUV planes
+ */
+class ColorAdjuster {
+public:
+    static constexpr int kChromaShift = 12;  // Fixed-point bits of uv_scale/uv_rotate
+
+    /**
+     * @brief Constructor (identity tables)
+     */
+    ColorAdjuster();
+
+    /**
+     * @brief Rebuilds and publishes the tables (any thread)
+     * @param brightness Offset added to luma (-100 to 100)
+     * @param contrast Luma gain around 128 (0.5 to 3.0)
+     * @param saturation Chroma gain (0.0 to 2.0)
+     * @param hue Chroma rotation in degrees (-180 to 180)
+     */
+    void setParams(double brightness, double contrast, double saturation, double hue);
+
+    /**
+     * @brief Sets the number of row bands (any thread, applied on the next frame)
+     * @param threads Row bands (0 = hardware concurrency)
+     */
+    void setThreads(int threads) { threads_ = threads; }
+
+    /**
+     * @brief Returns the current tables
+     */
+    std::shared_ptr<const ColorTables> tables() const { return std::atomic_load(&tables_); }
+
+    /**
+     * @brief Returns true if the current tables change nothing
+     */
+    bool isIdentity() const;
+
+    /**
+     * @brief Adjusts a planar 4:2:0 frame (I420/YV12) in place
+     * @param y Luma plane
+     * @param y_stride Luma stride
+     * @param u U plane
+     * @param u_stride U stride
+     * @param v V plane
+     * @param v_stride V stride
+     * @param width Frame width
+     * @param height Frame height
+     */
+    void applyPlanar(uint8_t* y, int y_stride, uint8_t* u, int u_stride,
+                     uint8_t* v, int v_stride, int width, int height);
+
+    /**
+     * @brief Adjusts a semi-planar 4:2:0 frame (NV12/NV21) in place
+     * @param y Luma plane
+     * @param y_stride Luma stride
+     * @param uv Interleaved chroma plane
+     * @param uv_stride Chroma stride
+     * @param width Frame width
+     * @param height Frame height
+     * @param vu_order true for NV21 (V first)
+     */
+    void applySemiPlanar(uint8_t* y, int y_stride, uint8_t* uv, int uv_stride,
+                         int width, int height, bool vu_order = false);
+
+    /**
+     * @brief Applies the luma table to every byte (packed RGB/BGR brightness/contrast)
+     * @param data First row
+     * @param stride Row stride
+     * @param row_bytes Bytes per row to map
+     * @param height Rows
+     */
+    void applyPacked(uint8_t* data, int stride, int row_bytes, int height);
+
+    /**
+     * @brief Maps one row through the luma table
+     */
+    static void mapLuma(const uint8_t* lut, uint8_t* row, int width);
+
+    /**
+     * @brief Rotates/scales one row of planar chroma
+     */
+    static void rotatePlanar(int scale, int rotate, uint8_t* u, uint8_t* v, int width);
+
+    /**
+     * @brief Rotates/scales one row of interleaved chroma
+     * @param pairs Number of (U, V) pairs
+     */
+    static void rotateInterleaved(int scale, int rotate, uint8_t* uv, int pairs);
+
+private:
+    /**
+     * @brief Restarts the band pool if the requested thread count changed
+     */
+    void syncThreads();
+
+    std::shared_ptr<const ColorTables> tables_;  // Published tables (atomic access)
+    std::atomic<int> threads_{1};                // Requested row bands
+    int pool_threads_ = 1;                       // Row bands the pool was started with
+    RowBandPool pool_;                           // Band workers (streaming thread only)
+};
+
+#endif // COLOR_ADJUST_H
@@ -0,0 +1,206 @@
+/**
+ * @file event_recorder.h
+ * @brief Motion-triggered recording with pre-roll from an encoded GOP ring
+ *
+ * Terminates an always-running encode branch with an appsink. Encoded H.264
+ * access units are kept in a GopRing (last pre-roll seconds, byte budget).
+ * A trigger starts a file: the ring is taken as its first units and a
+ * finisher thread builds the writer pipeline (appsrc ! mp4mux ! filesink),
+ * so the encode branch never waits for a file to be created. Units keep
+ * being forwarded until the last trigger plus the post-roll has passed; the
+ * file is closed on the next keyframe so the ring starts cleanly again, and
+ * finalised on the same thread. Nothing is decoded or re-encoded.
+ */
+
+#ifndef EVENT_RECORDER_H
+#define EVENT_RECORDER_H
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gop_ring.h"
+#include "metrics_registry.h"
+
+/**
+ * @brief Event recording parameters
+ */
+struct EventRecordingParams {
+    double pre_roll = 10.0;                 // Seconds kept before a trigger
+    double post_roll = 10.0;                // Seconds recorded after the last trigger
+    size_t ring_byte_budget = 64u << 20;    // Ring memory limit (bytes)
+    std::string location_pattern = "recordings/event_%Y%m%d_%H%M%S.mp4"; // strftime pattern
+};
+
+/**
+ * @brief Event recorder statistics
+ */
+struct EventRecorderStats {
+    guint64 events = 0;             // Files started
+    guint64 units_written = 0;      // Access units written to files
+    guint64 bytes_written = 0;      // Bytes written to files
+    guint64 units_dropped = 0;      // Units the writer dropped (disk too slow)
+    guint64 budget_evictions = 0;   // GOPs dropped from the ring for memory
+    size_t ring_bytes = 0;          // Bytes currently held
+    double ring_seconds = 0.0;      // Pre-roll currently held
+    bool recording = false;         // A file is open
+    std::string current_file;       // File being written
+};
+
+/**
+ * @brief Keeps encoded pre-roll in memory and writes it out on motion
+ */
+class EventRecorder {
+public:
+    /**
+     * @brief Constructor
+     * @param params Recording parameters
+     */
+    explicit EventRecorder(const EventRecordingParams& params = EventRecordingParams());
+
+    /**
+     * @brief Destructor (closes an open file)
+     */
+    ~EventRecorder();
+
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+
+    /**
+     * @brief Creates the appsink that ends the encode branch
+     *
+     * Expects H.264 in stream-format=avc, alignment=au (h264parse output).
+     * @return appsink element (owned by the pipeline once added)
+     */
+    GstElement* createSink();
+
+    /**
+     * @brief Starts or extends a recording (any thread, lock-free)
+     * @param timestamp PTS of the frame with motion (GST_CLOCK_TIME_NONE = latest)
+     */
+    void trigger(guint64 timestamp);
+
+    /**
+     * @brief Closes an open file (blocks until it is finalised)
+     */
+    void flush();
+
+    /**
+     * @brief Returns statistics
+     */
+    EventRecorderStats getStats() const;
+
+    /**
+     * @brief Exports the recorder metrics
+     * @param registry Registry (must not outlive this object)
+     */
+    void registerMetrics(MetricsRegistry& registry);
+
+private:
+    /**
+     * @brief One event file (fields guarded by mutex_)
+     */
+    struct EventFile {
+        std::string location;                       // File path
+        GstCaps* caps = nullptr;                    // Stream caps (ref held until opened)
+        GstElement* pipeline = nullptr;             // appsrc ! mp4mux ! filesink
+        GstElement* src = nullptr;                  // appsrc
+        std::vector<EncodedUnit> pending;           // Units queued while the pipeline starts
+        GstClockTime base = GST_CLOCK_TIME_NONE;    // Time mapped to 0 (first unit's DTS)
+        guint64 dropped = 0;                        // appsrc "dropped" already counted
+        bool open = false;                          // Pipeline playing, units go to src
+        bool closed = false;                        // No more units; EOS once open
+    };
+
+    /**
+     * @brief appsink new-sample callback (encode branch streaming thread)
+     */
+    static GstFlowReturn onNewSample(GstAppSink* sink, gpointer user_data);
+
+    /**
+     * @brief Routes one unit to the ring and/or the open file
+     */
+    void handleUnit(EncodedUnit unit, GstCaps* caps);
+
+    /**
+     * @brief Starts a file with the ring as pre-roll; opened on the finisher thread (mutex_ held)
+     */
+    void startFile(GstCaps* caps);
+
+    /**
+     * @brief Builds and starts the writer pipeline, then pushes the queued units (finisher thread)
+     */
+    void openFile(const std::shared_ptr<EventFile>& file);
+
+    /**
+     * @brief Queues or pushes one unit to the current file (mutex_ held)
+     */
+    void writeUnit(const EncodedUnit& unit);
+
+    /**
+     * @brief Pushes one unit to an open file with rebased timestamps (mutex_ held)
+     */
+    void pushUnit(EventFile& file, const EncodedUnit& unit);
+
+    /**
+     * @brief Ends the current file; EOS and finalising happen on the finisher thread (mutex_ held)
+     */
+    void closeWriter();
+
+    /**
+     * @brief Waits for the writer's EOS and tears it down (finisher thread)
+     */
+    static void finishFile(EventFile& file);
+
+    /**
+     * @brief Queues a task for the finisher thread (starts it if needed)
+     */
+    void post(std::function<void()> task);
+
+    /**
+     * @brief Finisher thread: runs queued tasks in order
+     */
+    void finisherLoop();
+
+    /**
+     * @brief Runs the queued tasks to the end and joins the finisher thread
+     */
+    void joinFinisher();
+
+    EventRecordingParams params_;                   // Parameters
+    GopRing ring_;                                  // Encoded pre-roll
+    mutable std::mutex mutex_;                      // Guards ring_ and file_
+    std::shared_ptr<EventFile> file_;               // File being recorded (null = none)
+    GstClockTime stop_after_ = 0;                   // Close on the first keyframe past this PTS
+
+    // Finisher: opens and finalises writer pipelines off the streaming thread
+    std::thread finisher_;                          // Started on demand
+    std::mutex finisher_mutex_;                     // Guards the fields below
+    std::condition_variable finisher_cv_;           // Signalled on post() and stop
+    std::deque<std::function<void()>> finisher_tasks_; // Pending open/finish tasks
+    bool finisher_stop_ = false;                    // Exit once the queue is empty
+
+    // Trigger (written by the motion detector thread)
+    std::atomic<guint64> trigger_pts_{GST_CLOCK_TIME_NONE}; // Latest trigger PTS
+    std::atomic<bool> triggered_{false};            // Trigger not yet consumed
+
+    // Statistics (lock-free, see metrics_registry.h)
+    Counter events_metric_;                         // Files started
+    Counter units_metric_;                          // Units written
+    Counter bytes_metric_;                          // Bytes written
+    Counter dropped_metric_;                        // Units leaked by the writer appsrc
+    Gauge ring_bytes_metric_;                       // Ring bytes
+    Gauge ring_seconds_metric_;                     // Ring span
+    Gauge recording_metric_;                        // 1 while a file is open
+    std::atomic<uint64_t> budget_evictions_{0};     // Mirrors ring_.budgetEvictions()
+};
+
+#endif // EVENT_RECORDER_H
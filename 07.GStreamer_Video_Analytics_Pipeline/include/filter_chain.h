@@ -0,0 +1,204 @@
+/**
+ * @file filter_chain.h
+ * @brief Ordered filter chain with stage fusion and tiled parallel execution
+ *
+ * A chain such as crop -> rotate -> denoise -> sharpen -> colour adjust is
+ * compiled into a short list of operations: consecutive geometric stages
+ * (crop, rotate, flip, scale) become one affine resampling, consecutive
+ * per-pixel stages (grayscale, colour adjust) become one 3x4 colour matrix.
+ * The frame is then cut into cache-sized output tiles; for each tile the
+ * input region it depends on is derived backwards through the operations
+ * (halo of each neighbourhood filter, inverse mapping of each warp), and the
+ * whole chain runs on that region while it is still in cache. Tiles are
+ * spread over a RowBandPool. Edge detection needs the whole frame (hysteresis)
+ * and splits the chain into separately tiled segments.
+ */
+
+#ifndef FILTER_CHAIN_H
+#define FILTER_CHAIN_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#ifdef HAVE_OPENCV
+#include <opencv2/opencv.hpp>
+#endif
+
+#include "row_band_pool.h"
+
+struct ProcessingParams;
+
+/**
+ * @brief Filter chain stages (parameters are read from ProcessingParams)
+ */
+enum class FilterStage {
+    CROP,           // crop_x, crop_y, crop_width, crop_height
+    ROTATE,         // rotation (degrees, around the centre)
+    FLIP,           // flip_horizontal, flip_vertical
+    SCALE,          // scale_width x scale_height
+    BLUR,           // blur_kernel_size
+    SHARPEN,        // sharpen_strength
+    DENOISE,        // denoise_strength
+    EDGE_DETECT,    // edge_threshold1, edge_threshold2 (whole frame)
+    GRAYSCALE,      // Grayscale
+    COLOR_ADJUST    // brightness, contrast, saturation, hue
+};
+
+/**
+ * @brief Timing of one compiled chain operation
+ */
+struct StageTiming {
+    std::string name;           // Stage name; fused stages are joined with '+'
+    double avg_time = 0.0;      // Average time per frame (ms, summed over threads)
+};
+
+/**
+ * @brief Returns the name of a stage
+ */
+const char* filterStageName(FilterStage stage);
+
+/**
+ * @brief Computes the frame size a chain produces
+ *
+ * Crop and scale sizes are rounded down to even values so 4:2:0 output
+ * stays valid.
+ * @param params Parameters with the chain
+ * @param width Input width
+ * @param height Input height
+ * @param out_width Output width
+ * @param out_height Output height
+ */
+void filterChainOutputSize(const ProcessingParams& params, int width, int height,
+                           int& out_width, int& out_height);
+
+#ifdef HAVE_OPENCV
+/**
+ * @brief Compiled filter chain (streaming thread only)
+ */
+class FilterChain {
+public:
+    static constexpr int kTileWidth = 256;   // Output tile width
+    static constexpr int kTileHeight = 64;   // Output tile height
+
+    /**
+     * @brief Compiles params.filter_chain for an input size
+     *
+     * Resets the timings.
+     * @param params Parameters with the chain
+     * @param input_size Input frame size
+     */
+    void configure(const ProcessingParams& params, cv::Size input_size);
+
+    /**
+     * @brief Sets the number of tile bands (applied on the next run)
+     * @param threads Bands (0 = hardware concurrency)
+     */
+    void setThreads(int threads);
+
+    /**
+     * @brief Returns the input size the chain was compiled for
+     */
+    cv::Size inputSize() const { return input_size_; }
+
+    /**
+     * @brief Returns the output size
+     */
+    cv::Size outputSize() const { return output_size_; }
+
+    /**
+     * @brief Runs the chain
+     * @param src BGR input of inputSize()
+     * @param dst BGR output of outputSize() (written in place, not reallocated)
+     */
+    void run(const cv::Mat& src, cv::Mat& dst);
+
+    /**
+     * @brief Returns the average time per compiled operation
+     *
+     * Safe to call from any thread while the chain runs.
+     */
+    std::vector<StageTiming> timings() const;
+
+private:
+    /**
+     * @brief Compiled operation
+     */
+    struct Op {
+        enum class Kind { WARP, COLOR, NEIGHBOURHOOD, FRAME };
+
+        Kind kind;
+        std::string name;               // For timings
+        cv::Size in_size;               // Input frame size
+        cv::Size out_size;              // Output frame size
+        double warp[6];                 // WARP: input -> output affine (2x3, row major)
+        double inverse[6];              // WARP: output -> input
+        bool integer_shift;             // WARP: pure integer translation (ROI copy)
+        cv::Rect window;                // WARP: input region samples may come from (crop)
+        int border;                     // WARP: BORDER_CONSTANT if a rotation starts the warp, else BORDER_REPLICATE
+        float color[12];                // COLOR: BGR 3x4 matrix
+        FilterStage filter;             // NEIGHBOURHOOD / FRAME
+        int halo;                       // NEIGHBOURHOOD: border rows/columns read
+    };
+
+    /**
+     * @brief Runs ops [begin, end) over the whole frame in tiles
+     */
+    void runTiled(size_t begin, size_t end, const cv::Mat& src, cv::Mat& dst);
+
+    /**
+     * @brief Runs ops [begin, end) for one output tile
+     * @param scratch Per-band buffers (one per op)
+     */
+    void runTile(size_t begin, size_t end, const cv::Mat& src, cv::Mat& dst,
+                 const cv::Rect& tile, std::vector<cv::Mat>& scratch);
+
+    /**
+     * @brief Input rectangle an op needs to produce an output rectangle
+     */
+    cv::Rect inputRect(const Op& op, const cv::Rect& out) const;
+
+    /**
+     * @brief Applies a neighbourhood or whole-frame filter
+     */
+    void applyFilter(const Op& op, const cv::Mat& src, cv::Mat& dst);
+
+    /**
+     * @brief Adds elapsed time to an op's counter
+     */
+    void addTime(size_t op, int64_t ns);
+
+    std::vector<Op> ops_;                       // Compiled operations
+    cv::Size input_size_;                       // Input frame size
+    cv::Size output_size_;                      // Output frame size
+
+    // Stage parameters
+    int blur_kernel_ = 5;
+    double sharpen_strength_ = 1.0;
+    double denoise_strength_ = 10.0;
+    double edge_threshold1_ = 100.0;
+    double edge_threshold2_ = 200.0;
+
+    /**
+     * @brief Timing counters of one configuration
+     */
+    struct Timings {
+        std::vector<std::string> names;                  // Op names
+        std::unique_ptr<std::atomic<int64_t>[]> op_ns;   // Time per op (ns, all threads)
+        std::atomic<uint64_t> frames{0};                 // Runs since configure()
+    };
+
+    std::shared_ptr<Timings> timings_;               // Replaced by configure() (atomic access)
+    std::vector<cv::Mat> segment_buffers_;           // Frames between tiled segments
+    cv::Mat gray_;                                   // Edge detection intermediate
+    cv::Mat edges_;                                  // Edge mask
+
+    RowBandPool pool_;                          // Tile workers
+    int threads_ = 1;                           // Requested bands
+    int pool_threads_ = 1;                      // Bands the pool was started with
+};
+#endif // HAVE_OPENCV
+
+#endif // FILTER_CHAIN_H
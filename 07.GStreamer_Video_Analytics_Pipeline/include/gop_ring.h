@@ -0,0 +1,117 @@
+/**
+ * @file gop_ring.h
+ * @brief Bounded in-memory ring of encoded access units, aligned to keyframes
+ *
+ * Holds the most recent encoded video (pre-roll) so an event recording can
+ * start before its trigger without re-encoding. Units are grouped into GOPs
+ * (keyframe plus the delta frames that depend on it) and only whole GOPs are
+ * evicted, so the ring always starts at a keyframe and its contents can be
+ * muxed as-is. Not thread-safe; the owner serialises access.
+ */
+
+#ifndef GOP_RING_H
+#define GOP_RING_H
+
+#include <gst/gst.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief One encoded access unit
+ */
+struct EncodedUnit {
+    std::shared_ptr<GstBuffer> buffer;         // Encoded data (shared, never copied)
+    GstClockTime pts = GST_CLOCK_TIME_NONE;    // Presentation time
+    size_t size = 0;                           // Bytes
+    bool keyframe = false;                     // Starts a GOP
+};
+
+/**
+ * @brief Keyframe-aligned ring bounded by duration and bytes
+ */
+class GopRing {
+public:
+    /**
+     * @brief Constructor
+     * @param window Pre-roll to keep (ns)
+     * @param byte_budget Memory limit (bytes)
+     */
+    GopRing(GstClockTime window, size_t byte_budget);
+
+    /**
+     * @brief Changes the limits (applied on the next push)
+     */
+    void setLimits(GstClockTime window, size_t byte_budget);
+
+    /**
+     * @brief Appends a unit and evicts old GOPs
+     *
+     * Units before the first keyframe are discarded. The oldest GOP is kept
+     * while the next one starts less than window before the newest unit, so
+     * at least window of video precedes a trigger once the ring has filled.
+     * A single GOP larger than the budget is discarded up to the next
+     * keyframe.
+     * @param unit Encoded unit
+     */
+    void push(EncodedUnit unit);
+
+    /**
+     * @brief Removes and returns every unit (first one is a keyframe)
+     */
+    std::vector<EncodedUnit> drain();
+
+    /**
+     * @brief Removes every unit
+     */
+    void clear();
+
+    /**
+     * @brief Returns the bytes held
+     */
+    size_t bytes() const { return bytes_; }
+
+    /**
+     * @brief Returns the units held
+     */
+    size_t size() const { return units_.size(); }
+
+    /**
+     * @brief Returns the number of GOPs held
+     */
+    size_t gops() const { return gops_.size(); }
+
+    /**
+     * @brief Returns the time span held (first to last PTS, ns)
+     */
+    GstClockTime duration() const;
+
+    /**
+     * @brief Returns the GOPs evicted because of the byte budget
+     */
+    uint64_t budgetEvictions() const { return budget_evictions_; }
+
+private:
+    struct Gop {
+        size_t units;              // Units in the GOP
+        size_t bytes;              // Bytes in the GOP
+        GstClockTime start;        // Keyframe PTS
+    };
+
+    /**
+     * @brief Drops the oldest GOP
+     */
+    void popGop();
+
+    std::deque<EncodedUnit> units_;     // Units, oldest first
+    std::deque<Gop> gops_;              // GOP boundaries over units_
+    size_t bytes_ = 0;                  // Bytes held
+    GstClockTime window_;               // Pre-roll to keep
+    size_t byte_budget_;                // Memory limit
+    bool skip_to_keyframe_ = true;      // Discard units until the next keyframe
+    uint64_t budget_evictions_ = 0;     // GOPs dropped for memory
+};
+
+#endif // GOP_RING_H
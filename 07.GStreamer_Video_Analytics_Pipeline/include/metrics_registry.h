@@ -0,0 +1,262 @@
+/**
+ * @file metrics_registry.h
+ * @brief Lock-free counters, gauges and histograms with a Prometheus renderer
+ *
+ * Components own their instruments and update them on the streaming thread
+ * with relaxed atomics only: counters and histogram buckets are split into
+ * per-thread shards so concurrent writers do not share a cache line, and
+ * nothing on the recording path allocates or locks. The registry only keeps
+ * pointers to the instruments (plus scrape-time collectors for values that
+ * are polled, e.g. queue levels) and renders them in the Prometheus text
+ * exposition format. Registration and rendering take the registry mutex;
+ * recording never does.
+ */
+
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Metric label set, e.g. {{"branch", "recording"}}
+ */
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief Prometheus metric types
+ */
+enum class MetricType {
+    COUNTER,    // Monotonic total
+    GAUGE,      // Current value
+    HISTOGRAM   // Bucketed observations with sum and count
+};
+
+/**
+ * @brief Number of shards per counter/histogram (power of two)
+ */
+constexpr int kMetricShards = 16;
+
+/**
+ * @brief Returns the shard of the calling thread
+ *
+ * Threads are assigned shards round-robin on first use.
+ */
+int metricShard();
+
+/**
+ * @brief Lowers an atomic to a value if it is smaller (lock-free)
+ */
+inline void atomicMin(std::atomic<double>& target, double value) {
+    double current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Raises an atomic to a value if it is larger (lock-free)
+ */
+inline void atomicMax(std::atomic<double>& target, double value) {
+    double current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Adds to an atomic double (lock-free)
+ */
+inline void atomicAdd(std::atomic<double>& target, double value) {
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Monotonic counter sharded per thread
+ */
+class Counter {
+public:
+    /**
+     * @brief Adds to the counter
+     * @param n Increment
+     */
+    void inc(uint64_t n = 1) {
+        shards_[metricShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the sum over all shards
+     */
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    Shard shards_[kMetricShards];
+};
+
+/**
+ * @brief Gauge holding the last value set (not sharded: last writer wins)
+ */
+class Gauge {
+public:
+    /**
+     * @brief Sets the value
+     */
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+
+    /**
+     * @brief Adds to the value
+     */
+    void add(double delta) { atomicAdd(value_, delta); }
+
+    /**
+     * @brief Returns the value
+     */
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+/**
+ * @brief Histogram with fixed upper bounds, sharded per thread
+ */
+class Histogram {
+public:
+    /**
+     * @brief Observation totals at one point in time
+     */
+    struct Snapshot {
+        std::vector<double> bounds;      // Bucket upper bounds (without +Inf)
+        std::vector<uint64_t> buckets;   // Cumulative counts, bounds.size() + 1 (last = +Inf)
+        uint64_t count = 0;              // Observations
+        double sum = 0.0;                // Sum of observed values
+    };
+
+    /**
+     * @brief Constructor
+     * @param bounds Ascending bucket upper bounds
+     */
+    explicit Histogram(std::vector<double> bounds);
+
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    /**
+     * @brief Records one observation
+     */
+    void observe(double value);
+
+    /**
+     * @brief Returns the merged shards
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * @brief Returns exponentially spaced bounds (start, start*factor, ...)
+     */
+    static std::vector<double> exponentialBounds(double start, double factor, int count);
+
+private:
+    struct alignas(64) Shard {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;  // Per bucket (not cumulative), last = +Inf
+        std::atomic<double> sum{0.0};                      // Sum of observed values
+    };
+
+    std::vector<double> bounds_;                 // Bucket upper bounds
+    std::unique_ptr<Shard[]> shards_;            // kMetricShards shards
+};
+
+/**
+ * @brief One sample produced by a scrape-time collector
+ */
+struct MetricSample {
+    MetricLabels labels;    // Series labels
+    double value = 0.0;     // Value
+};
+
+/**
+ * @brief Named set of instruments rendered in Prometheus text format
+ *
+ * Instruments are not owned and must outlive every render() call.
+ */
+class MetricsRegistry {
+public:
+    using Collector = std::function<void(std::vector<MetricSample>&)>;
+
+    /**
+     * @brief Registers a counter series
+     * @param name Metric name (should end in _total)
+     * @param help Help text
+     * @param counter Instrument
+     * @param labels Series labels
+     */
+    void addCounter(const std::string& name, const std::string& help,
+                    const Counter& counter, const MetricLabels& labels = {});
+
+    /**
+     * @brief Registers a gauge series
+     */
+    void addGauge(const std::string& name, const std::string& help,
+                  const Gauge& gauge, const MetricLabels& labels = {});
+
+    /**
+     * @brief Registers a histogram series
+     */
+    void addHistogram(const std::string& name, const std::string& help,
+                      const Histogram& histogram, const MetricLabels& labels = {});
+
+    /**
+     * @brief Registers a collector polled on every render()
+     *
+     * For values that are cheaper to read on demand than to push (queue
+     * levels, per-stage timings). Runs on the scraping thread.
+     * @param name Metric name
+     * @param help Help text
+     * @param type COUNTER or GAUGE
+     * @param collector Appends the current samples
+     */
+    void addCollector(const std::string& name, const std::string& help,
+                      MetricType type, Collector collector);
+
+    /**
+     * @brief Renders every metric in Prometheus text format (version 0.0.4)
+     */
+    std::string render() const;
+
+private:
+    struct Series {
+        MetricLabels labels;
+        const Counter* counter = nullptr;
+        const Gauge* gauge = nullptr;
+        const Histogram* histogram = nullptr;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        MetricType type;
+        std::vector<Series> series;
+        std::vector<Collector> collectors;
+    };
+
+    /**
+     * @brief Returns the family of a name, creating it if needed
+     */
+    Family& family(const std::string& name, const std::string& help, MetricType type);
+
+    std::vector<Family> families_;      // In registration order
+    mutable std::mutex mutex_;          // Guards families_ (registration and render only)
+};
+
+#endif // METRICS_REGISTRY_H
@@ -0,0 +1,80 @@
+/**
+ * @file metrics_server.h
+ * @brief Minimal HTTP endpoint serving a MetricsRegistry to Prometheus
+ *
+ * One thread accepts connections, answers GET /metrics with the rendered
+ * registry and closes the connection. It is meant for a scraper polling
+ * every few seconds, not for general HTTP traffic.
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+class MetricsRegistry;
+
+/**
+ * @brief Blocking single-threaded /metrics HTTP server
+ */
+class MetricsServer {
+public:
+    /**
+     * @brief Constructor
+     * @param registry Registry to render (must outlive the server)
+     */
+    explicit MetricsServer(const MetricsRegistry& registry);
+
+    /**
+     * @brief Destructor (stops the server)
+     */
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @brief Binds the port and starts the server thread
+     * @param port TCP port (0 = pick a free port, see port())
+     * @param address Listen address
+     * @return true if successful
+     */
+    bool start(int port, const std::string& address = "0.0.0.0");
+
+    /**
+     * @brief Stops and joins the server thread
+     */
+    void stop();
+
+    /**
+     * @brief Returns the bound port (after start())
+     */
+    int port() const { return port_; }
+
+    /**
+     * @brief Checks if the server is running
+     */
+    bool isRunning() const { return running_.load(); }
+
+private:
+    /**
+     * @brief Accept loop
+     */
+    void serve();
+
+    /**
+     * @brief Reads one request and writes the response
+     * @param client Connected socket
+     */
+    void handleClient(int client);
+
+    const MetricsRegistry& registry_;      // Rendered registry
+    int listen_fd_ = -1;                   // Listening socket
+    int port_ = 0;                         // Bound port
+    std::atomic<bool> running_{false};     // Server thread state
+    std::thread thread_;                   // Accept loop
+};
+
+#endif // METRICS_SERVER_H
@@ -0,0 +1,142 @@
+/**
+ * @file motion_bitmask.h
+ * @brief Bit-packed frame difference, morphology and labelling
+ *
+ * Fused kernel for the FRAME_DIFF hot path. Absolute difference, threshold
+ * and the previous-frame update happen in one SSE2 pass that packs the result
+ * into one bit per pixel. The frame is split into 64x16 tiles; tiles without
+ * changed pixels are skipped by morphology and labelling, and tiles outside
+ * the ROI (or fully inside an exclusion zone) are never read at all.
+ */
+
+#ifndef MOTION_BITMASK_H
+#define MOTION_BITMASK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Axis-aligned rectangle in mask coordinates
+ */
+struct BitmaskRect {
+    int x = 0;          // Top-left corner X coordinate
+    int y = 0;          // Top-left corner Y coordinate
+    int width = 0;      // Width
+    int height = 0;     // Height
+};
+
+/**
+ * @brief Connected component found in the bitmask
+ */
+struct BitmaskBlob {
+    int x = 0;          // Bounding box X
+    int y = 0;          // Bounding box Y
+    int width = 0;      // Bounding box width
+    int height = 0;     // Bounding box height
+    int area = 0;       // Number of set pixels
+};
+
+/**
+ * @brief Packed binary motion mask with tile occupancy
+ */
+class MotionBitmask {
+public:
+    static constexpr int kTileWidth = 64;   // One 64-bit word per tile row
+    static constexpr int kTileHeight = 16;  // Rows per tile (max morphology radius)
+
+    /**
+     * @brief Allocates the mask for a frame size (drops the previous frame)
+     * @param width Frame width
+     * @param height Frame height
+     */
+    void configure(int width, int height);
+
+    /**
+     * @brief Returns the configured width
+     */
+    int width() const { return width_; }
+
+    /**
+     * @brief Returns the configured height
+     */
+    int height() const { return height_; }
+
+    /**
+     * @brief Precomputes the static ROI/exclusion mask (re-primes the kernel)
+     * @param roi Region of interest (nullptr = whole frame)
+     * @param exclusions Exclusion zones
+     */
+    void setStaticMask(const BitmaskRect* roi, const std::vector<BitmaskRect>& exclusions);
+
+    /**
+     * @brief Fused |frame - previous| > threshold, packing and previous update
+     * @param frame 8-bit luma plane
+     * @param stride Row stride of frame in bytes
+     * @param threshold Pixels whose difference exceeds this are set
+     * @return Number of tiles with at least one set pixel (0 on the first frame)
+     */
+    int diffThreshold(const uint8_t* frame, size_t stride, int threshold);
+
+    /**
+     * @brief Binary erosion with a (2r+1) square structuring element
+     * @param radius Element radius (clamped to kTileHeight - 1)
+     */
+    void erode(int radius);
+
+    /**
+     * @brief Binary dilation with a (2r+1) square structuring element
+     * @param radius Element radius (clamped to kTileHeight - 1)
+     */
+    void dilate(int radius);
+
+    /**
+     * @brief Returns the number of tiles with set pixels
+     */
+    int activeTiles() const { return active_count_; }
+
+    /**
+     * @brief 8-connected components (run-based union-find)
+     * @return Blobs with bounding boxes and pixel counts
+     */
+    std::vector<BitmaskBlob> label() const;
+
+    /**
+     * @brief Expands the mask to 0/255 bytes
+     * @param dst Destination buffer (height rows of width bytes)
+     * @param stride Row stride of dst in bytes
+     */
+    void unpack(uint8_t* dst, size_t stride) const;
+
+private:
+    /**
+     * @brief Shared implementation of erode/dilate
+     */
+    void morph(int radius, bool erode);
+
+    /**
+     * @brief Recomputes tile occupancy for the tiles in work
+     */
+    void refreshActive(const std::vector<uint8_t>& work);
+
+    uint64_t* row(int y) { return bits_.data() + static_cast<size_t>(y) * words_; }
+    const uint64_t* row(int y) const { return bits_.data() + static_cast<size_t>(y) * words_; }
+
+    int width_ = 0;                      // Frame width
+    int height_ = 0;                     // Frame height
+    int words_ = 0;                      // 64-bit words per row (= tile columns)
+    int tile_rows_ = 0;                  // Tile rows
+    uint64_t tail_mask_ = ~0ull;         // Valid bits of the last word in a row
+    bool primed_ = false;                // previous_ holds a frame
+
+    std::vector<uint64_t> bits_;         // Current mask
+    std::vector<uint64_t> scratch_;      // Morphology intermediate
+    std::vector<uint64_t> static_bits_;  // ROI minus exclusion zones
+    std::vector<uint8_t> tile_static_;   // Tile has allowed pixels
+    std::vector<uint8_t> tile_active_;   // Tile has set pixels
+    std::vector<uint8_t> tile_work_;     // Morphology work set
+    int active_count_ = 0;               // Active tile count
+    std::vector<uint8_t> previous_;      // Previous frame (width_ stride)
+};
+
+#endif // MOTION_BITMASK_H
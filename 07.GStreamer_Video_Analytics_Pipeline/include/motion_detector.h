@@ -17,6 +17,15 @@
 #include <mutex>
 #include <chrono>
 #include <deque>
+#include <thread>
+#include <condition_variable>
+
+#include "motion_bitmask.h"
+#include "background_model.h"
+#include "block_motion.h"
+#include "motion_region.h"
+#include "motion_tracker.h"
+#include "metrics_registry.h"
 
 #ifdef HAVE_OPENCV
 #include <opencv2/opencv.hpp>
@@ -31,19 +40,8 @@ enum class MotionAlgorithm {
     BACKGROUND_SUB,     // Background subtraction
     OPTICAL_FLOW,       // Optical flow
     MOG2,              // Mixture of Gaussians v2
-    KNN                // K-Nearest Neighbors
-};
-
-/**
- * @brief Motion region information
- */
-struct MotionRegion {
-    int x;              // Top-left corner X coordinate
-    int y;              // Top-left corner Y coordinate
-    int width;          // Width
-    int height;         // Height
-    double intensity;   // Motion intensity (0.0 - 1.0)
-    guint64 timestamp;  // Detection time
+    KNN,               // K-Nearest Neighbors
+    RUNNING_AVG        // Fixed-point running average on luma
 };
 
 /**
@@ -56,11 +54,21 @@ struct MotionDetectionParams {
     // Sensitivity settings
     double sensitivity = 0.5;           // 0.0 (low) - 1.0 (high)
     double threshold = 25.0;            // Pixel change threshold
+    bool use_bitmask_kernel = true;     // FRAME_DIFF on luma via the packed SIMD kernel
+
+    // Analysis resolution
+    double analysis_scale = 1.0;        // 1, 1/2, 1/4 or 1/8 of the input resolution
 
     // Background subtraction parameters
     int history_length = 500;           // Background history length
     double learning_rate = 0.005;       // Learning rate
     bool detect_shadows = true;         // Shadow detection
+    bool subtractor_color_input = false; // Feed MOG2/KNN with BGR (forces the YUV->BGR path)
+    int subtractor_downscale = 1;       // MOG2/KNN input decimation factor (1 = full size)
+    double foreground_learning_rate = 0.0005; // RUNNING_AVG rate for pixels under motion
+
+    // Block motion (OPTICAL_FLOW)
+    int block_search_range = 16;        // Maximum displacement (analysis pixels)
 
     // Morphological operations
     int erosion_size = 2;              // Erosion kernel size
@@ -75,12 +83,18 @@ struct MotionDetectionParams {
     // Motion tracking
     bool enable_tracking = true;        // Object tracking
     int max_tracked_objects = 10;       // Maximum tracked objects
+    MotionTrackerParams tracking;       // Track IDs, hysteresis and event rate
 
     // Visualization
     bool draw_motion_regions = true;    // Draw motion regions
     bool draw_motion_vectors = false;   // Draw motion vectors
     bool show_debug_view = false;       // Debug view
 
+    // Threading
+    bool async_analysis = false;        // Analyse on a worker thread; results are
+                                        // attached to later buffers as metadata
+    int analysis_threads = 1;           // RUNNING_AVG/OPTICAL_FLOW row bands (0 = hardware concurrency)
+
     // Alert settings
     bool enable_alerts = true;          // Motion alerts
     double alert_threshold = 0.1;       // Alert threshold (total area percentage)
@@ -97,6 +111,16 @@ struct MotionStats {
     double max_motion_area = 0.0;       // Maximum motion area
     guint64 total_regions = 0;         // Total motion regions
     std::chrono::time_point<std::chrono::steady_clock> last_motion_time;
+
+    // Asynchronous analysis
+    guint64 analyzed_frames = 0;       // Frames analysed by the worker
+    guint64 dropped_frames = 0;        // Frames replaced before the worker took them
+    guint64 analysis_lag_frames = 0;   // Frames between analysed and annotated buffer
+    guint64 max_analysis_lag_frames = 0; // Largest observed lag
+
+    // Region tracking
+    guint64 track_events = 0;          // Enter/update/exit events queued
+    guint64 dropped_track_events = 0;  // Events dropped by the bounded queue
 };
 
 /**
@@ -108,6 +132,12 @@ struct MotionStats {
 using MotionEventCallback = std::function<void(
     const std::vector<MotionRegion>&, guint64, double)>;
 
+/**
+ * @brief Motion activity callback type (every frame above alert_threshold)
+ * @param timestamp Buffer PTS of the frame
+ */
+using MotionActivityCallback = std::function<void(guint64)>;
+
 /**
  * @brief Motion detection class
  */
@@ -159,6 +189,22 @@ public:
      */
     void setMotionEventCallback(MotionEventCallback callback);
 
+    /**
+     * @brief Sets the motion activity callback
+     *
+     * Unlike the event callback it is not rate-limited by alert_cooldown_ms,
+     * so it tells how long motion lasts (used by event recording). Runs on
+     * the analysing thread and must not block.
+     * @param callback Activity function
+     */
+    void setMotionActivityCallback(MotionActivityCallback callback);
+
+    /**
+     * @brief Sets the track event callback (runs on the dispatcher thread)
+     * @param callback Enter/update/exit event function
+     */
+    void setTrackEventCallback(MotionTrackCallback callback);
+
     /**
      * @brief Returns statistics
      * @return Motion statistics
@@ -167,15 +213,30 @@ public:
 
     /**
      * @brief Resets statistics
+     *
+     * Only the values returned by getStats() restart; exported metrics stay
+     * monotonic.
      */
     void resetStats();
 
+    /**
+     * @brief Exports the detection metrics
+     * @param registry Registry (must not outlive this object)
+     */
+    void registerMetrics(MetricsRegistry& registry);
+
     /**
      * @brief Returns current motion regions
      * @return List of motion regions
      */
     std::vector<MotionRegion> getCurrentMotions() const;
 
+    /**
+     * @brief Returns the latest block motion field (OPTICAL_FLOW)
+     * @return Vector field in input coordinates (empty for other algorithms)
+     */
+    MotionVectorField getMotionVectorField() const;
+
     /**
      * @brief Starts/stops motion detection
      * @param enable true to start
@@ -216,10 +277,30 @@ public:
      */
     void clearExclusionZones();
 
+    /**
+     * @brief Processes a video frame (called from the streaming thread)
+     * @param buffer GStreamer buffer (writable)
+     * @param info Video information cached from caps negotiation
+     * @return Processed buffer
+     */
+    GstBuffer* processFrame(GstBuffer* buffer, const GstVideoInfo* info);
+
+    /**
+     * @brief Stops the asynchronous analysis worker (if running)
+     */
+    void stopAnalysisWorker();
+
 #ifdef HAVE_OPENCV
+    /**
+     * @brief Runs motion detection on a single frame outside the pipeline
+     * @param frame BGR or grayscale frame
+     * @return Motion regions in frame coordinates
+     */
+    std::vector<MotionRegion> process(const cv::Mat& frame);
+
     /**
      * @brief Returns the OpenCV-based motion mask
-     * @return Motion mask (binary image)
+     * @return Motion mask (binary image, at analysis resolution)
      */
     cv::Mat getMotionMask() const;
 
@@ -231,21 +312,65 @@ public:
 #endif
 
 private:
+#ifdef HAVE_OPENCV
     /**
-     * @brief Processes a video frame
+     * @brief Hands the frame's luma to the worker and annotates the buffer
+     * @param buffer GStreamer buffer
+     * @param info Video information
+     */
+    void processFrameAsync(GstBuffer* buffer, const GstVideoInfo* info);
+
+    /**
+     * @brief Worker thread loop (latest frame wins)
+     */
+    void analysisWorker();
+
+    /**
+     * @brief Builds the overlay composition for a set of regions
+     * @param regions Motion regions
+     * @return New composition (caller owns the reference), nullptr if empty
+     */
+    GstVideoOverlayComposition* buildOverlay(const std::vector<MotionRegion>& regions);
+
+    /**
+     * @brief Processes a frame through a BGR copy (packed formats, debug view)
      * @param buffer GStreamer buffer
      * @param info Video information
      * @return Processed buffer
      */
-    GstBuffer* processFrame(GstBuffer* buffer, const GstVideoInfo* info);
+    GstBuffer* processFrameBGR(GstBuffer* buffer, const GstVideoInfo* info);
+
+    /**
+     * @brief Draw motion regions directly on the planes of a YUV/gray frame
+     * @param frame Mapped video frame (writable)
+     * @param regions Motion regions
+     */
+    void drawMotionRegionsPlanar(GstVideoFrame* frame, const std::vector<MotionRegion>& regions);
 
-#ifdef HAVE_OPENCV
     /**
      * @brief Detect motion with OpenCV
      * @param frame Current frame
+     * @param prescaled true if the frame is already at analysis resolution
      * @return Detected motion regions
      */
-    std::vector<MotionRegion> detectMotion(const cv::Mat& frame);
+    std::vector<MotionRegion> detectMotion(const cv::Mat& frame, bool prescaled = false);
+
+    /**
+     * @brief Frame difference through the bit-packed kernel
+     * @param frame Grayscale frame at analysis resolution
+     * @param factor Analysis decimation factor
+     * @return Filtered motion regions in input coordinates
+     */
+    std::vector<MotionRegion> detectMotionBitmask(const cv::Mat& frame, int factor);
+
+    /**
+     * @brief Returns a cached elliptic structuring element
+     * @param kernel Cache slot
+     * @param cached_radius Radius the slot was built for
+     * @param radius Requested radius
+     * @return Structuring element of size (2 * radius + 1)
+     */
+    static const cv::Mat& cachedKernel(cv::Mat& kernel, int& cached_radius, int radius);
 
     /**
      * @brief Frame difference algorithm
@@ -262,24 +387,47 @@ private:
     cv::Mat backgroundSubtraction(const cv::Mat& frame);
 
     /**
-     * @brief Optical flow algorithm
+     * @brief Fixed-point running-average background model
      * @param frame Current frame
-     * @return Motion vectors
+     * @return Motion mask
      */
-    std::vector<cv::Point2f> opticalFlow(const cv::Mat& frame);
+    cv::Mat runningAverage(const cv::Mat& frame);
+
+    /**
+     * @brief Block-matching optical flow
+     * @param frame Current frame
+     * @param factor Analysis decimation factor (for the published field)
+     * @return Motion mask (moving blocks)
+     */
+    cv::Mat opticalFlow(const cv::Mat& frame, int factor);
+
+    /**
+     * @brief Sets region directions from the block motion field
+     * @param regions Regions in input coordinates
+     * @param factor Analysis decimation factor
+     */
+    void assignRegionMotion(std::vector<MotionRegion>& regions, int factor) const;
 
     /**
      * @brief Apply morphological operations
      * @param mask Binary motion mask
+     * @param factor Analysis decimation factor (kernels shrink with it)
      */
-    void applyMorphology(cv::Mat& mask);
+    void applyMorphology(cv::Mat& mask, int factor = 1);
 
     /**
      * @brief Find motion regions
      * @param mask Binary motion mask
-     * @return Motion regions
+     * @param factor Analysis decimation factor (regions are scaled back by it)
+     * @return Motion regions in input coordinates
      */
-    std::vector<MotionRegion> findMotionRegions(const cv::Mat& mask);
+    std::vector<MotionRegion> findMotionRegions(const cv::Mat& mask, int factor = 1);
+
+    /**
+     * @brief Returns the analysis decimation factor (1, 2, 4 or 8)
+     * @return Integer divisor derived from analysis_scale
+     */
+    int analysisFactor() const;
 
     /**
      * @brief Filter motion regions
@@ -297,41 +445,85 @@ private:
 #endif
 
     /**
-     * @brief Transform callback
+     * @brief Attaches the latest results as ROI and overlay metadata
+     * @param buffer Buffer to annotate (writable)
+     * @param frame_no Sequence number of the buffer
+     */
+    void attachMotionMeta(GstBuffer* buffer, guint64 frame_no);
+
+    /**
+     * @brief Stores regions, updates statistics and raises alerts
+     * @param regions Detected motion regions
+     * @param width Frame width
+     * @param height Frame height
+     * @param timestamp Buffer timestamp
+     * @param params Parameters the frame was analysed with
      */
-    static GstFlowReturn transformCallback(GstBaseTransform* trans,
-                                         GstBuffer* inbuf,
-                                         GstBuffer* outbuf);
+    void updateMotionState(const std::vector<MotionRegion>& regions,
+                           int width, int height, guint64 timestamp,
+                           const MotionDetectionParams& params);
 
     /**
      * @brief Trigger motion event
      * @param regions Motion regions
      * @param timestamp Event time
+     * @param motion_percentage Motion percentage of total area
+     * @param params Parameters the frame was analysed with
      */
-    void triggerMotionEvent(const std::vector<MotionRegion>& regions, guint64 timestamp);
+    void triggerMotionEvent(const std::vector<MotionRegion>& regions, guint64 timestamp,
+                            double motion_percentage, const MotionDetectionParams& params);
 
     // Member variables
     GstElement* element_ = nullptr;              // GStreamer element
     MotionDetectionParams params_;               // Detection parameters
-    MotionStats stats_;                         // Statistics
     mutable std::mutex params_mutex_;           // Parameter mutex
-    mutable std::mutex stats_mutex_;            // Statistics mutex
+
+    // Statistics (lock-free, see metrics_registry.h)
+    Counter frames_metric_;                     // Frames seen
+    Counter motion_frames_metric_;              // Frames with motion
+    Counter regions_metric_;                    // Motion regions
+    Counter analyzed_metric_;                   // Frames analysed by the worker
+    Counter dropped_metric_;                    // Frames replaced before analysis
+    Counter track_events_metric_;               // Track events queued
+    Counter dropped_track_events_metric_;       // Track events dropped
+    Histogram motion_area_metric_{{1, 2, 5, 10, 20, 50, 100}}; // Motion area (% of frame)
+    Gauge lag_metric_;                          // Current analysis lag (frames)
+    std::atomic<double> max_motion_area_{0.0};  // Since resetStats() (%)
+    std::atomic<double> max_lag_{0.0};         // Since resetStats() (frames)
+    std::atomic<int64_t> last_motion_ns_{0};    // steady_clock time of the last motion
+    MotionStats stats_base_;                    // Counter values at resetStats()
+    double area_sum_base_ = 0.0;                // Area sum at resetStats()
+    mutable std::mutex stats_mutex_;            // Guards the bases (getStats/resetStats only)
 
     bool enabled_ = true;                       // Detection state
     MotionEventCallback motion_callback_;       // Motion event callback
+    MotionActivityCallback activity_callback_;  // Motion activity callback
+    MotionTracker tracker_;                     // Region tracker (enable_tracking)
+    TrackEventDispatcher track_dispatcher_;     // Delivers track events off the streaming thread
 
 #ifdef HAVE_OPENCV
     // OpenCV variables
     cv::Mat previous_frame_;                    // Previous frame
     cv::Mat background_model_;                  // Background model
     cv::Mat motion_mask_;                       // Motion mask
+    cv::Mat analysis_frame_;                    // Decimated analysis input
+    cv::Mat subtractor_input_;                  // Decimated MOG2/KNN input
+    cv::Mat subtractor_mask_;                   // Decimated MOG2/KNN output
+    cv::Mat luma_input_;                        // Luma of BGR input for RUNNING_AVG/OPTICAL_FLOW
+    cv::Mat block_mask_;                        // Block-level OPTICAL_FLOW mask
+    cv::Mat static_mask_;                       // ROI minus exclusion zones (analysis grid)
+    int static_mask_factor_ = 0;                // Factor static_mask_ was built for
+
+    // Structuring elements (rebuilt only when the radius changes)
+    cv::Mat erosion_kernel_;
+    cv::Mat dilation_kernel_;
+    cv::Mat open_kernel_;
+    int erosion_radius_ = -1;
+    int dilation_radius_ = -1;
+    int open_radius_ = -1;
 
     // Background subtractors
     cv::Ptr<cv::BackgroundSubtractor> bg_subtractor_;
-
-    // For optical flow
-    cv::Mat previous_gray_;                     // Previous grayscale frame
-    std::vector<cv::Point2f> previous_points_;  // Previous feature points
 #endif
 
     // Motion regions
@@ -342,11 +534,48 @@ private:
     cv::Rect roi_;                              // Region of interest
     bool has_roi_ = false;                      // ROI defined
     std::vector<cv::Rect> exclusion_zones_;     // Exclusion zones
+    bool static_mask_dirty_ = true;             // Zones changed since static_mask_ was built
+    bool bitmask_zones_dirty_ = true;           // Zones changed since the bitmask was configured
+
+    // Bit-packed FRAME_DIFF kernel
+    MotionBitmask bitmask_;                     // Packed mask and previous frame
+    int bitmask_factor_ = 0;                    // Factor the bitmask zones were built for
+    bool bitmask_mask_ = false;                 // Last mask lives in bitmask_
+
+    // Fixed-point running-average background (RUNNING_AVG)
+    FixedPointBackground running_avg_;          // 8.8 background and band workers
+    int running_avg_threads_ = -1;              // Thread setting running_avg_ was built with
+
+    // Block motion estimation (OPTICAL_FLOW)
+    BlockMotionEstimator block_motion_;         // Estimator and block-row workers
+    int block_motion_threads_ = -1;             // Thread setting block_motion_ was built with
+    int block_motion_range_ = -1;               // Search range block_motion_ was built with
+    MotionVectorField motion_field_;            // Published field (guarded by motions_mutex_)
 
     // Alert management
     std::chrono::time_point<std::chrono::steady_clock> last_alert_time_;
     bool in_cooldown_ = false;                  // Alert cooldown state
 
+    // Asynchronous analysis (latest frame wins)
+    std::thread worker_thread_;                 // Analysis worker
+    std::mutex slot_mutex_;                     // Guards the hand-over slot
+    std::condition_variable slot_cv_;           // Signals a filled slot
+    bool slot_full_ = false;                    // Slot holds an unanalysed frame
+    bool worker_running_ = false;               // Worker started
+    bool worker_stop_ = false;                  // Worker stop request
+    guint64 frame_counter_ = 0;                 // Buffers seen (streaming thread)
+    guint64 slot_frame_no_ = 0;                 // Sequence number of the slot frame
+    guint64 slot_pts_ = 0;                      // PTS of the slot frame
+    int slot_width_ = 0;                        // Full-resolution width of the slot frame
+    int slot_height_ = 0;                       // Full-resolution height of the slot frame
+    guint64 analyzed_frame_no_ = 0;             // Frame the current results belong to
+    GstVideoOverlayComposition* overlay_ = nullptr; // Overlay for the current results
+#ifdef HAVE_OPENCV
+    cv::Mat slot_frame_;                        // Frame waiting for the worker
+    cv::Mat staging_frame_;                     // Streaming-thread scratch frame
+    cv::Mat work_frame_;                        // Frame being analysed
+#endif
+
     // Motion history (for tracking)
     std::deque<std::vector<MotionRegion>> motion_history_;
     const size_t max_history_size_ = 30;        // 1 second history (30fps)
@@ -0,0 +1,25 @@
+/**
+ * @file motion_region.h
+ * @brief Motion region shared by the detector and the tracker
+ */
+
+#ifndef MOTION_REGION_H
+#define MOTION_REGION_H
+
+#include <glib.h>
+
+/**
+ * @brief Motion region information
+ */
+struct MotionRegion {
+    int x;              // Top-left corner X coordinate
+    int y;              // Top-left corner Y coordinate
+    int width;          // Width
+    int height;         // Height
+    double intensity;   // Motion intensity (0.0 - 1.0)
+    guint64 timestamp;  // Detection time
+    double dx = 0.0;    // Mean motion X (pixels per frame, OPTICAL_FLOW only)
+    double dy = 0.0;    // Mean motion Y (pixels per frame, OPTICAL_FLOW only)
+};
+
+#endif // MOTION_REGION_H
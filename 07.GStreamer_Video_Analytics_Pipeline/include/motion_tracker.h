@@ -0,0 +1,178 @@
+/**
+ * @file motion_tracker.h
+ * @brief Motion region tracker with enter/update/exit events
+ *
+ * MotionTracker associates the regions of consecutive frames (IoU first,
+ * centroid distance as fallback) and keeps stable track IDs. A track is
+ * announced with ENTER only after several consecutive hits and closed with
+ * EXIT only after several missed frames, so flicker does not produce events.
+ * UPDATE is rate-limited per track. TrackEventDispatcher delivers the events
+ * from a bounded queue on its own thread, off the streaming thread.
+ */
+
+#ifndef MOTION_TRACKER_H
+#define MOTION_TRACKER_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "motion_region.h"
+
+/**
+ * @brief Track event types
+ */
+enum class MotionEventType {
+    ENTER,              // Track confirmed
+    UPDATE,             // Confirmed track moved or update interval elapsed
+    EXIT                // Track lost
+};
+
+/**
+ * @brief Track event
+ */
+struct MotionTrackEvent {
+    MotionEventType type;   // Event type
+    int track_id;           // Stable track ID
+    MotionRegion region;    // Last matched region
+    guint64 timestamp;      // Frame timestamp
+    int age;                // Frames since the track was created
+};
+
+/**
+ * @brief Tracker parameters
+ */
+struct MotionTrackerParams {
+    double iou_threshold = 0.2;         // Minimum IoU for an IoU match
+    double max_centroid_distance = 64.0; // Centroid fallback radius (pixels)
+    int confirm_frames = 3;             // Consecutive hits before ENTER
+    int max_missed_frames = 10;         // Missed frames before EXIT
+    int update_interval = 15;           // Frames between UPDATE events (0 = never periodic)
+    double update_distance = 32.0;      // Centroid shift that forces an UPDATE (pixels)
+};
+
+/**
+ * @brief Track event callback type
+ * @param event Track event
+ */
+using MotionTrackCallback = std::function<void(const MotionTrackEvent&)>;
+
+/**
+ * @brief IoU/centroid tracker over motion regions
+ */
+class MotionTracker {
+public:
+    /**
+     * @brief Constructor
+     * @param params Tracker parameters
+     */
+    explicit MotionTracker(const MotionTrackerParams& params = MotionTrackerParams());
+
+    /**
+     * @brief Sets tracker parameters (existing tracks are kept)
+     * @param params Tracker parameters
+     */
+    void setParams(const MotionTrackerParams& params) { params_ = params; }
+
+    /**
+     * @brief Associates a frame's regions with the tracks
+     * @param regions Regions of the frame (may be empty)
+     * @param timestamp Frame timestamp
+     * @return Events produced by this frame
+     */
+    std::vector<MotionTrackEvent> update(const std::vector<MotionRegion>& regions,
+                                         guint64 timestamp);
+
+    /**
+     * @brief Returns the number of confirmed tracks
+     */
+    size_t confirmedTracks() const;
+
+    /**
+     * @brief Drops all tracks without emitting EXIT
+     */
+    void reset();
+
+private:
+    struct Track {
+        int id;                     // Track ID
+        MotionRegion region;        // Last matched region
+        MotionRegion reported;      // Region of the last ENTER/UPDATE
+        int hits = 0;               // Consecutive matched frames
+        int missed = 0;             // Consecutive missed frames
+        int age = 0;                // Frames since creation
+        int since_report = 0;       // Frames since the last ENTER/UPDATE
+        bool confirmed = false;     // ENTER emitted
+    };
+
+    /**
+     * @brief Builds an event for a track
+     */
+    static MotionTrackEvent makeEvent(MotionEventType type, const Track& track, guint64 timestamp);
+
+    MotionTrackerParams params_;    // Parameters
+    std::vector<Track> tracks_;     // Live tracks
+    int next_id_ = 1;               // Next track ID
+};
+
+/**
+ * @brief Bounded event queue drained by a dispatcher thread
+ */
+class TrackEventDispatcher {
+public:
+    /**
+     * @brief Constructor
+     * @param capacity Maximum queued events (oldest are dropped beyond it)
+     */
+    explicit TrackEventDispatcher(size_t capacity = 256);
+
+    /**
+     * @brief Destructor (delivers queued events, then joins)
+     */
+    ~TrackEventDispatcher();
+
+    TrackEventDispatcher(const TrackEventDispatcher&) = delete;
+    TrackEventDispatcher& operator=(const TrackEventDispatcher&) = delete;
+
+    /**
+     * @brief Sets the callback (starts the dispatcher thread on first use)
+     * @param callback Event function (nullptr disables delivery)
+     */
+    void setCallback(MotionTrackCallback callback);
+
+    /**
+     * @brief Returns true if a callback is set
+     */
+    bool hasCallback() const;
+
+    /**
+     * @brief Queues events without blocking
+     * @param events Events to queue
+     * @return Number of queued events that had to be dropped
+     */
+    size_t push(const std::vector<MotionTrackEvent>& events);
+
+    /**
+     * @brief Delivers queued events and stops the thread
+     */
+    void stop();
+
+private:
+    /**
+     * @brief Dispatcher thread loop
+     */
+    void run();
+
+    size_t capacity_;                       // Queue bound
+    std::deque<MotionTrackEvent> queue_;    // Pending events
+    MotionTrackCallback callback_;          // Event function
+    mutable std::mutex mutex_;              // Guards queue_, callback_, stop_
+    std::condition_variable cv_;            // Signals new events or stop
+    std::thread thread_;                    // Dispatcher thread
+    bool stop_ = false;                     // Stop request
+};
+
+#endif // MOTION_TRACKER_H
@@ -19,23 +19,19 @@
 #include <atomic>
 #include <thread>
 #include <map>
+#include <mutex>
+#include <vector>
+
+#include "metrics_registry.h"
+#include "metrics_server.h"
+#include "event_recorder.h"
+#include "source_switcher.h"
 
 // Forward declarations
 class VideoProcessor;
 class MotionDetector;
 class RTSPStreamer;
 
-/**
- * @brief Defines video source types
- */
-enum class SourceType {
-    FILE,        // Video file
-    WEBCAM,      // USB/V4L2 camera
-    RTSP,        // RTSP stream
-    HTTP,        // HTTP stream
-    APPSRC       // Application source
-};
-
 /**
  * @brief Defines output target types
  */
@@ -46,6 +42,14 @@ enum class SinkType {
     APPSINK      // Application sink
 };
 
+/**
+ * @brief Defines recording modes
+ */
+enum class RecordingMode {
+    CONTINUOUS,  // Encode and write everything to record_location
+    EVENT        // Keep encoded pre-roll in memory, write a file per motion event
+};
+
 /**
  * @brief Pipeline configuration parameters
  */
@@ -53,6 +57,9 @@ struct PipelineConfig {
     // Input parameters
     SourceType source_type = SourceType::FILE;
     std::string source_location = "";
+    SourceType standby_type = SourceType::FILE;
+    std::string standby_location = "";         // Pre-rolled failover input (empty = none)
+    int source_stall_timeout_ms = 5000;        // Fail over after this long without frames (0 = never)
 
     // Video parameters
     int width = 1920;
@@ -69,6 +76,8 @@ struct PipelineConfig {
     bool enable_gpu_acceleration = false;
     bool enable_recording = false;
     std::string record_location = "";
+    RecordingMode recording_mode = RecordingMode::CONTINUOUS;
+    EventRecordingParams event_recording;      // RecordingMode::EVENT
 
     // Codec settings
     std::string encoder = "x264enc";
@@ -77,6 +86,17 @@ struct PipelineConfig {
     // RTSP server settings
     std::string rtsp_mount_point = "/live";
     int rtsp_port = 8554;
+    std::vector<std::string> rtsp_simulcast;   // Extra rungs (low, medium, high, ultra) at <mount>/<name>
+    std::string rtsp_multicast_address;        // Multicast group offered to clients (empty = unicast only)
+    int rtsp_multicast_port = 5000;            // First port of the multicast range
+
+    // Metrics
+    int metrics_port = 0; // Prometheus /metrics HTTP port (0 = disabled)
+
+    // Multi-stream mode (StreamHost, replaces the single pipeline when set)
+    std::vector<std::pair<std::string, std::string>> streams; // Stream id -> input (--stream)
+    int thread_count = 0;                      // Shared analysis workers (0 = hardware concurrency)
+    int stream_queue_depth = 2;                // Frames queued per stream before the oldest is dropped
 };
 
 /**
@@ -120,7 +140,13 @@ public:
      * @brief Returns the current FPS value
      * @return Frames per second
      */
-    double getCurrentFPS() const { return current_fps_; }
+    double getCurrentFPS() const { return fps_metric_.value(); }
+
+    /**
+     * @brief Returns the metrics registry (all components, queue levels)
+     * @return Registry rendered by the /metrics endpoint
+     */
+    const MetricsRegistry& getMetrics() const { return metrics_; }
 
     /**
      * @brief Returns the video processor object
@@ -140,6 +166,18 @@ public:
      */
     RTSPStreamer* getRTSPStreamer() { return rtsp_streamer_.get(); }
 
+    /**
+     * @brief Returns the event recorder (RecordingMode::EVENT only)
+     * @return EventRecorder pointer, nullptr in other modes
+     */
+    EventRecorder* getEventRecorder() { return event_recorder_.get(); }
+
+    /**
+     * @brief Returns the input switcher (active and standby sources)
+     * @return SourceSwitcher pointer
+     */
+    SourceSwitcher* getSourceSwitcher() { return source_switcher_.get(); }
+
     /**
      * @brief Adds a new element to the pipeline
      * @param element GStreamer element to add
@@ -156,10 +194,14 @@ public:
     bool removeElement(const std::string& name);
 
     /**
-     * @brief Changes the video source at runtime
+     * @brief Changes the video source at runtime without rebuilding the pipeline
+     *
+     * A warm standby with the same location is switched to at once; any
+     * other input is pre-rolled first (up to 5 s) while the current one
+     * keeps playing.
      * @param new_source New source location
      * @param type New source type
-     * @return true if successful
+     * @return true if the new source is active
      */
     bool changeSource(const std::string& new_source, SourceType type);
 
@@ -200,12 +242,6 @@ private:
      */
     bool createPipeline();
 
-    /**
-     * @brief Creates the video source
-     * @return Created source element
-     */
-    GstElement* createSource();
-
     /**
      * @brief Creates the video sink
      * @return Created sink element
@@ -218,6 +254,14 @@ private:
      */
     GstElement* createEncoder();
 
+    /**
+     * @brief Returns true if continuous recording taps the RTSP encoder
+     *
+     * An RTSP output already encodes the processed frames; recording them
+     * again would run a second encoder on the same frames.
+     */
+    bool recordsRTSPStream() const;
+
     /**
      * @brief Handles bus messages
      * @param bus GStreamer bus
@@ -227,14 +271,6 @@ private:
      */
     static gboolean busCallback(GstBus* bus, GstMessage* msg, gpointer user_data);
 
-    /**
-     * @brief Handles pad-added signal
-     * @param src Source element
-     * @param new_pad New pad
-     * @param data User data
-     */
-    static void onPadAdded(GstElement* src, GstPad* new_pad, gpointer data);
-
     /**
      * @brief Main event loop thread function
      */
@@ -245,6 +281,11 @@ private:
      */
     void calculateFPS();
 
+    /**
+     * @brief Registers the pipeline and component metrics
+     */
+    void registerMetrics();
+
     /**
      * @brief Cleans up the pipeline
      */
@@ -255,7 +296,7 @@ private:
 
     // GStreamer elements
     GstElement* pipeline_ = nullptr;                           // Main pipeline
-    GstElement* source_ = nullptr;                             // Video source
+    GstElement* selector_ = nullptr;                           // Input selector (source branches)
     GstElement* sink_ = nullptr;                               // Video sink
     GstElement* tee_ = nullptr;                                // For splitting the stream
     std::map<std::string, GstElement*> elements_;             // All elements
@@ -264,6 +305,8 @@ private:
     std::unique_ptr<VideoProcessor> video_processor_;          // Video processor
     std::unique_ptr<MotionDetector> motion_detector_;          // Motion detector
     std::unique_ptr<RTSPStreamer> rtsp_streamer_;             // RTSP streamer
+    std::unique_ptr<EventRecorder> event_recorder_;           // Event recording (RecordingMode::EVENT)
+    std::unique_ptr<SourceSwitcher> source_switcher_;         // Active and standby inputs
 
     // Thread and synchronization
     std::unique_ptr<std::thread> main_loop_thread_;           // Main loop thread
@@ -271,7 +314,6 @@ private:
     std::atomic<bool> is_running_{false};                      // Running state
 
     // Performance metrics
-    double current_fps_ = 0.0;                                 // Current FPS
     guint64 frame_count_ = 0;                                 // Total frame count
     GstClockTime last_fps_time_ = 0;                          // Last FPS calculation time
 
@@ -283,4 +325,13 @@ private:
     GstElement* recording_queue_ = nullptr;                    // Recording queue
     GstElement* recording_sink_ = nullptr;                     // Recording sink
     bool is_recording_ = false;                                // Recording state
+
+    // Metrics (declared last: the server stops before the components go away)
+    Gauge fps_metric_;                                         // Current FPS
+    std::vector<std::pair<std::string, GstElement*>> branch_queues_; // Queue per tee branch (ref held)
+    std::mutex branch_queues_mutex_;                           // Guards branch_queues_ (scrape vs. cleanup)
+    MetricsRegistry metrics_;                                  // Every exported metric
+    std::unique_ptr<MetricsServer> metrics_server_;            // /metrics endpoint
 };
+
+#endif // PIPELINE_MANAGER_H
@@ -0,0 +1,223 @@
+/**
+ * @file pipeline_trace_stats.h
+ * @brief Per-element timing and queue occupancy collected by the pipeline tracer
+ *
+ * The tracer (pipeline_tracer.cpp) turns pad push hooks into a few
+ * observations per frame and element: processing time (frame in to frame
+ * out on the same thread), latency since the source pushed the frame, and
+ * for queues the fill level and the time a frame waited.
+ * Recording uses the sharded histograms of metrics_registry.h and a short
+ * lock for the per-queue FIFO only, so the tracer can stay enabled at
+ * 1080p30. Reports are rendered as log lines and as JSON.
+ */
+
+#ifndef PIPELINE_TRACE_STATS_H
+#define PIPELINE_TRACE_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "metrics_registry.h"
+
+/**
+ * @brief Summary of one histogram (milliseconds)
+ */
+struct TraceSummary {
+    uint64_t count = 0;         // Observations
+    double mean = 0.0;          // Mean
+    double p50 = 0.0;           // Median (bucket upper bound)
+    double p95 = 0.0;           // 95th percentile (bucket upper bound)
+    double p99 = 0.0;           // 99th percentile (bucket upper bound)
+    double max = 0.0;           // Largest observation
+};
+
+/**
+ * @brief Observations of one element
+ */
+class ElementTrace {
+public:
+    /**
+     * @brief Constructor
+     * @param path Element path, e.g. /GstPipeline:pipeline0/GstQueue:queue0
+     * @param factory Factory name
+     * @param is_queue Element is a thread boundary (queue, queue2)
+     */
+    ElementTrace(std::string path, std::string factory, bool is_queue);
+
+    ElementTrace(const ElementTrace&) = delete;
+    ElementTrace& operator=(const ElementTrace&) = delete;
+
+    /**
+     * @brief Records the time from a frame entering to leaving the element
+     * @param ns Duration in nanoseconds
+     */
+    void recordProcessing(uint64_t ns);
+
+    /**
+     * @brief Records the time since the source pushed the frame
+     * @param ns Duration in nanoseconds
+     */
+    void recordLatency(uint64_t ns);
+
+    /**
+     * @brief A frame entered the queue (queues only)
+     * @param buffer Buffer identity
+     * @param bytes Buffer size
+     * @param ts Entry time (ns)
+     * @param origin Time the source pushed it (ns, 0 = unknown)
+     */
+    void enqueue(const void* buffer, uint64_t bytes, uint64_t ts, uint64_t origin);
+
+    /**
+     * @brief A frame left the queue (queues only)
+     *
+     * Entries queued before it that never left were dropped (leaky queue,
+     * flush) and are discarded.
+     * @param buffer Buffer identity
+     * @param ts Exit time (ns)
+     * @param origin Receives the origin passed to enqueue()
+     * @return false if the frame was not seen entering
+     */
+    bool dequeue(const void* buffer, uint64_t ts, uint64_t& origin);
+
+    /**
+     * @brief Returns the element path
+     */
+    const std::string& path() const { return path_; }
+
+    /**
+     * @brief Returns the factory name
+     */
+    const std::string& factory() const { return factory_; }
+
+    /**
+     * @brief Returns true for queues
+     */
+    bool isQueue() const { return is_queue_; }
+
+    /**
+     * @brief Returns the processing time summary
+     */
+    TraceSummary processing() const;
+
+    /**
+     * @brief Returns the latency-from-source summary
+     */
+    TraceSummary latency() const;
+
+    /**
+     * @brief Returns the queue wait summary
+     */
+    TraceSummary queueWait() const;
+
+    /**
+     * @brief Returns the current queue fill level
+     * @param buffers Frames waiting
+     * @param bytes Bytes waiting
+     */
+    void queueLevel(uint64_t& buffers, uint64_t& bytes) const;
+
+    /**
+     * @brief Returns the largest queue fill level seen (frames)
+     */
+    uint64_t maxQueueLevel() const { return max_level_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the queue fill level distribution (frames)
+     */
+    Histogram::Snapshot queueLevelHistogram() const { return level_.snapshot(); }
+
+private:
+    std::string path_;                          // Element path
+    std::string factory_;                       // Factory name
+    bool is_queue_;                             // Thread boundary
+
+    Histogram processing_;                      // Processing time (ms)
+    Histogram latency_;                         // Latency since the source (ms)
+    Histogram wait_;                            // Time in the queue (ms)
+    Histogram level_;                           // Frames queued, sampled on entry
+    std::atomic<double> max_processing_{0.0};   // Largest processing time (ms)
+    std::atomic<double> max_latency_{0.0};      // Largest latency (ms)
+    std::atomic<double> max_wait_{0.0};         // Largest queue wait (ms)
+    std::atomic<uint64_t> max_level_{0};        // Largest fill level (frames)
+
+    struct QueuedFrame {
+        const void* buffer;                     // Buffer identity
+        uint64_t bytes;                         // Buffer size
+        uint64_t entered;                       // Entry time (ns)
+        uint64_t origin;                        // Source push time (ns)
+    };
+
+    mutable std::mutex queue_mutex_;            // Guards the FIFO
+    std::deque<QueuedFrame> fifo_;              // Frames in the queue, oldest first
+    uint64_t queued_bytes_ = 0;                 // Sum of their sizes
+};
+
+/**
+ * @brief All element traces of a process plus the source timestamps
+ */
+class PipelineTraceStats {
+public:
+    /**
+     * @brief Returns the trace of an element, creating it on first use
+     * @param path Element path (unique key)
+     * @param factory Factory name
+     * @param is_queue Element is a queue
+     * @return Trace (valid for the lifetime of this object)
+     */
+    ElementTrace* element(const std::string& path, const std::string& factory, bool is_queue);
+
+    /**
+     * @brief Remembers when a source pushed the frame with a PTS
+     *
+     * Used for frames that reach an element on a thread the tracer did not
+     * follow (e.g. an element with its own task that is not a queue).
+     * @param pts Buffer PTS
+     * @param ts Push time (ns)
+     */
+    void recordSource(uint64_t pts, uint64_t ts);
+
+    /**
+     * @brief Looks up when a source pushed the frame with a PTS
+     * @param pts Buffer PTS
+     * @param ts Push time (ns)
+     * @return false if the PTS is unknown (or too old)
+     */
+    bool sourceTime(uint64_t pts, uint64_t& ts) const;
+
+    /**
+     * @brief Renders one log line per element
+     */
+    std::vector<std::string> summaryLines() const;
+
+    /**
+     * @brief Renders the full report as JSON
+     */
+    std::string toJson() const;
+
+    /**
+     * @brief Writes toJson() to a file
+     * @param path Output file
+     * @return true if successful
+     */
+    bool writeJson(const std::string& path) const;
+
+private:
+    static constexpr size_t kSourceHistory = 256;   // Remembered source PTS values
+
+    mutable std::mutex mutex_;                              // Guards elements_
+    std::vector<std::unique_ptr<ElementTrace>> elements_;   // In order of first use
+    std::unordered_map<std::string, ElementTrace*> by_path_; // Lookup by path
+
+    mutable std::mutex source_mutex_;                       // Guards the source history
+    std::unordered_map<uint64_t, uint64_t> source_times_;   // PTS -> push time
+    std::deque<uint64_t> source_order_;                     // PTS values, oldest first
+};
+
+#endif // PIPELINE_TRACE_STATS_H
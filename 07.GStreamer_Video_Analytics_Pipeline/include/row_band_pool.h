@@ -0,0 +1,85 @@
+/**
+ * @file row_band_pool.h
+ * @brief Persistent workers that split a row range into bands
+ *
+ * Used by the per-frame analysis engines (background model, block motion)
+ * to process one frame on several cores without creating threads per frame.
+ * The calling thread always runs the first band itself.
+ */
+
+#ifndef ROW_BAND_POOL_H
+#define ROW_BAND_POOL_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @brief Fixed set of band workers driven by run()
+ */
+class RowBandPool {
+public:
+    using BandJob = std::function<void(int, int)>;
+
+    /**
+     * @brief Constructor
+     */
+    RowBandPool() = default;
+
+    /**
+     * @brief Destructor (joins the workers)
+     */
+    ~RowBandPool();
+
+    RowBandPool(const RowBandPool&) = delete;
+    RowBandPool& operator=(const RowBandPool&) = delete;
+
+    /**
+     * @brief Restarts the pool with a number of bands
+     * @param bands Bands per run (0 = hardware concurrency, 1 = caller only)
+     */
+    void start(int bands);
+
+    /**
+     * @brief Returns the number of bands per run
+     */
+    int bands() const { return bands_; }
+
+    /**
+     * @brief Splits [0, rows) into bands and runs job(begin, end) on each
+     *
+     * Blocks until every band has finished.
+     * @param rows Number of rows
+     * @param job Band callback
+     */
+    void run(int rows, const BandJob& job);
+
+    /**
+     * @brief Stops and joins the workers (bands() becomes 1)
+     */
+    void stop();
+
+private:
+    /**
+     * @brief Worker loop
+     * @param band Band index (1-based; band 0 runs on the caller)
+     * @param seen Job generation at start-up
+     */
+    void worker(int band, uint64_t seen);
+
+    int bands_ = 1;                       // Bands per run
+    std::vector<std::thread> workers_;    // Workers for bands 1..bands_-1
+    std::mutex mutex_;                    // Guards the job fields below
+    std::condition_variable start_cv_;    // New job published
+    std::condition_variable done_cv_;     // A band finished
+    const BandJob* job_ = nullptr;        // Current job
+    int rows_ = 0;                        // Rows of the current job
+    uint64_t generation_ = 0;             // Job sequence number
+    int pending_ = 0;                     // Bands still running
+    bool stop_ = false;                   // Worker stop request
+};
+
+#endif // ROW_BAND_POOL_H
@@ -18,6 +18,12 @@
 #include <mutex>
 #include <thread>
 #include <map>
+#include <deque>
+#include <set>
+
+#include "appsrc_bridge.h"
+#include "metrics_registry.h"
+#include "stream_recorder.h"
 
 /**
  * @brief RTSP stream quality profiles
@@ -40,6 +46,16 @@ enum class SecurityType {
     TOKEN_AUTH      // Token-based
 };
 
+/**
+ * @brief One rung of the simulcast ladder
+ */
+struct SimulcastRung {
+    std::string name = "medium";            // Mount suffix: <mount_point>/<name>
+    int width = 1280;                       // Encoded width
+    int height = 720;                       // Encoded height
+    int bitrate = 2500000;                  // Encoded bitrate (bps)
+};
+
 /**
  * @brief RTSP stream configuration
  */
@@ -74,6 +90,8 @@ struct RTSPConfig {
     int max_clients = 10;                   // Maximum client count
     int buffer_size = 200;                  // Buffer size (frames)
     int latency = 200;                      // Target latency (ms)
+    int bridge_max_buffers = 4;             // Processed frames a media may lag (oldest dropped)
+    std::vector<SimulcastRung> simulcast;   // Extra mounts encoded from the same frames
     bool enable_rtcp = true;                // RTCP enabled
 
     // Multicast settings
@@ -81,11 +99,12 @@ struct RTSPConfig {
     std::string multicast_address = "224.1.1.1";
     int multicast_port = 5000;
     int multicast_ttl = 1;
+    std::string multicast_iface = "";       // Interface to send on (empty = routing table)
 
-    // Recording settings
-    bool enable_recording = false;
+    // Recording settings (taps the encoded main stream, no second encode)
+    bool enable_recording = false;          // Record from start() (video source must be running)
     std::string record_path = "/tmp/rtsp_recordings";
-    int max_record_duration = 3600;         // Maximum recording duration (seconds)
+    int max_record_duration = 3600;         // Seconds per file before rotation
 };
 
 /**
@@ -111,9 +130,25 @@ struct RTSPStats {
     guint64 total_frames_sent = 0;          // Total frames sent
     double average_bandwidth = 0.0;         // Average bandwidth
     int total_connections = 0;              // Total connection count
+    guint64 udp_bytes_sent = 0;             // RTP/RTCP bytes sent over UDP (unicast and multicast)
     std::chrono::duration<double> uptime;   // Uptime
 };
 
+/**
+ * @brief Simulcast rung statistics
+ */
+struct RungStats {
+    std::string name;                       // Rung name
+    std::string mount;                      // Mount point
+    int width = 0;                          // Encoded width
+    int height = 0;                         // Encoded height
+    int bitrate = 0;                        // Encoded bitrate (bps)
+    int subscribers = 0;                    // Clients playing this rung
+    bool encoding = false;                  // Encoder running (media prepared)
+    guint64 encoded_frames = 0;             // Frames encoded since start
+    double avg_encode_ms = 0.0;             // Mean encode time per frame
+};
+
 /**
  * @brief Client connection callback
  * @param client_info Client information
@@ -156,7 +191,11 @@ public:
 
     /**
      * @brief Sets the video source element
-     * @param source Source element
+     *
+     * The appsink ending the processed branch of the analytics pipeline.
+     * Its frames are bridged into the appsrc of the (shared) media, so one
+     * encode serves all clients and slow clients never block the analytics.
+     * @param source appsink element
      */
     void setVideoSource(GstElement* source);
 
@@ -203,6 +242,26 @@ public:
      */
     RTSPStats getStats() const;
 
+    /**
+     * @brief Exports the server metrics
+     * @param registry Registry (must not outlive this object)
+     */
+    void registerMetrics(MetricsRegistry& registry);
+
+    /**
+     * @brief Returns the statistics of every simulcast rung
+     * @return One entry per RTSPConfig::simulcast rung
+     */
+    std::vector<RungStats> getRungStats() const;
+
+    /**
+     * @brief Returns the ladder rung of a quality profile
+     * @param profile LOW, MEDIUM, HIGH or ULTRA
+     * @param config Size and bitrate used for CUSTOM
+     * @return Rung named after the profile ("low", "medium", ...)
+     */
+    static SimulcastRung profileRung(StreamProfile profile, const RTSPConfig& config);
+
     /**
      * @brief Sets the client callback
      * @param callback For connection/disconnection events
@@ -242,12 +301,21 @@ public:
 
     /**
      * @brief Record the stream
-     * @param enable true: start recording, false: stop
-     * @param filename Recording file name
+     *
+     * Records the encoded main mount through a tee after its parser, so no
+     * second encoder runs. While recording, the main media is kept prepared
+     * even without clients. Files rotate every max_record_duration seconds.
+     * @param enable true: start recording, false: stop (waits for the last file)
+     * @param filename strftime file pattern (default: <record_path>/rtsp_%Y%m%d_%H%M%S.mp4)
      * @return true if successful
      */
     bool recordStream(bool enable, const std::string& filename = "");
 
+    /**
+     * @brief Returns recording statistics
+     */
+    StreamRecorderStats getRecordingStats() const;
+
     /**
      * @brief Take a snapshot
      * @param filename File name
@@ -264,15 +332,17 @@ private:
 
     /**
      * @brief Creates the media factory
+     * @param rung Simulcast rung (nullptr: main mount)
      * @return Media factory pointer
      */
-    GstRTSPMediaFactory* createMediaFactory();
+    GstRTSPMediaFactory* createMediaFactory(const SimulcastRung* rung = nullptr);
 
     /**
      * @brief Builds the pipeline string
+     * @param rung Simulcast rung (nullptr: main mount)
      * @return GStreamer pipeline definition
      */
-    std::string buildPipelineString();
+    std::string buildPipelineString(const SimulcastRung* rung = nullptr);
 
     /**
      * @brief Applies security settings
@@ -290,15 +360,29 @@ private:
                                   gpointer user_data);
 
     /**
-     * @brief Client disconnected callback
-     * @param server RTSP server
+     * @brief Client disconnected callback ("closed" signal of the client)
      * @param client Client object
      * @param user_data User data
      */
-    static void onClientDisconnected(GstRTSPServer* server,
-                                    GstRTSPClient* client,
+    static void onClientDisconnected(GstRTSPClient* client,
                                     gpointer user_data);
 
+    /**
+     * @brief PLAY request callback (counts rung subscribers)
+     * @param client Client object
+     * @param ctx Request context
+     * @param user_data User data (this pointer)
+     */
+    static void onPlayRequest(GstRTSPClient* client, GstRTSPContext* ctx, gpointer user_data);
+
+    /**
+     * @brief TEARDOWN request callback (counts rung subscribers)
+     * @param client Client object
+     * @param ctx Request context
+     * @param user_data User data (this pointer)
+     */
+    static void onTeardownRequest(GstRTSPClient* client, GstRTSPContext* ctx, gpointer user_data);
+
     /**
      * @brief Media configuration callback
      * @param factory Media factory
@@ -309,6 +393,53 @@ private:
                                 GstRTSPMedia* media,
                                 gpointer user_data);
 
+    /**
+     * @brief Media unprepared callback (stops feeding its appsrc)
+     * @param media Media object
+     * @param user_data User data (this pointer)
+     */
+    static void onMediaUnprepared(GstRTSPMedia* media, gpointer user_data);
+
+    /**
+     * @brief Returns the bytes the UDP sinks of a media have sent
+     * @param media Prepared media
+     * @return Sum of bytes-served over its multiudpsinks (unicast and multicast)
+     */
+    static guint64 mediaUdpBytes(GstRTSPMedia* media);
+
+    /**
+     * @brief Returns the UDP bytes sent by all media since start
+     */
+    guint64 udpBytesSent() const;
+
+    /**
+     * @brief Notes when a frame enters a rung encoder (streaming thread)
+     * @param pad Encoder sink pad
+     * @param info Probe info
+     * @param user_data Rung
+     * @return GST_PAD_PROBE_OK
+     */
+    static GstPadProbeReturn onEncoderInput(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+    /**
+     * @brief Measures the encode time of a frame leaving a rung encoder
+     * @param pad Encoder source pad
+     * @param info Probe info
+     * @param user_data Rung
+     * @return GST_PAD_PROBE_OK
+     */
+    static GstPadProbeReturn onEncoderOutput(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+    /**
+     * @brief Counts encoded frames entering the payloader (streaming thread)
+     * @param pad Payloader sink pad
+     * @param info Probe info
+     * @param user_data User data (this pointer)
+     * @return GST_PAD_PROBE_OK
+     */
+    static GstPadProbeReturn onPayloadBuffer(GstPad* pad, GstPadProbeInfo* info,
+                                             gpointer user_data);
+
     /**
      * @brief Stream state changed callback
      * @param media Media object
@@ -336,8 +467,37 @@ private:
      */
     void updateStats();
 
+    /**
+     * @brief Keeps the shared main media prepared and playing (for recording)
+     * @return Held media or nullptr
+     */
+    GstRTSPMedia* holdMainMedia();
+
+    /**
+     * @brief One simulcast rung: its mount, factory and statistics
+     */
+    struct Rung {
+        SimulcastRung config;                   // Size and bitrate
+        std::string mount;                      // Mount point
+        GstRTSPMediaFactory* factory = nullptr; // Shared media factory
+        Gauge subscribers;                      // Clients playing the rung
+        Gauge encoding;                         // Prepared media (0 or 1)
+        Counter frames;                         // Encoded frames
+        Histogram encode_seconds{Histogram::exponentialBounds(0.0005, 2.0, 12)}; // Encode time
+        std::mutex timing_mutex;                // Guards in_flight
+        std::deque<std::pair<GstClockTime, gint64>> in_flight; // PTS -> encoder entry (monotonic us)
+    };
+
+    /**
+     * @brief Returns the rung a request URL path belongs to
+     * @param path Absolute path, e.g. /live/low or /live/low/stream=0
+     * @return Rung or nullptr (main mount, unknown path)
+     */
+    Rung* findRung(const std::string& path) const;
+
     // Member variables
     RTSPConfig config_;                         // Server configuration
+    std::vector<std::unique_ptr<Rung>> rungs_;  // Simulcast ladder (fixed at construction)
 
     // RTSP Server objects
     GstRTSPServer* server_ = nullptr;           // Main server
@@ -349,6 +509,7 @@ private:
     // Video/Audio sources
     GstElement* video_source_ = nullptr;        // Video source
     GstElement* audio_source_ = nullptr;        // Audio source
+    std::unique_ptr<AppSrcBridge> video_bridge_; // Processed frames -> media appsrc
 
     // Thread and synchronization
     std::unique_ptr<std::thread> server_thread_; // Server thread
@@ -357,21 +518,31 @@ private:
 
     // Client management
     std::map<std::string, ClientInfo> clients_; // Active clients
+    std::map<GstRTSPClient*, std::string> client_ids_;    // Client object -> ID
+    std::map<GstRTSPClient*, std::set<Rung*>> client_rungs_; // Rungs each client plays
     mutable std::mutex clients_mutex_;          // Client mutex
     ClientCallback client_callback_;            // Client callback
 
-    // Statistics
-    RTSPStats stats_;                          // Server statistics
-    mutable std::mutex stats_mutex_;           // Statistics mutex
+    // Statistics (lock-free, see metrics_registry.h)
+    Gauge active_clients_metric_;              // Active clients
+    Counter connections_metric_;               // Connections since start
+    Counter bytes_metric_;                     // Encoded bytes handed to the payloaders
+    Counter frames_metric_;                    // Encoded frames handed to the payloaders
+    Gauge bandwidth_metric_;                   // Average bandwidth per playing client (Mbps)
     std::chrono::time_point<std::chrono::steady_clock> start_time_;
 
     // For recording
-    GstElement* recording_bin_ = nullptr;       // Recording element
-    bool is_recording_ = false;                 // Recording state
-    std::string record_filename_;               // Recording file name
+    std::unique_ptr<StreamRecorder> recorder_;  // Tee branch after the main encoder
+    GstRTSPMedia* record_media_ = nullptr;      // Main media held prepared while recording
+    std::mutex record_mutex_;                   // Serialises recordStream()
 
     // Multicast group
     GstRTSPAddressPool* address_pool_ = nullptr; // Address pool
+
+    // UDP egress: prepared media and the bytes last read from them
+    mutable std::map<GstRTSPMedia*, guint64> medias_; // Owned references
+    mutable guint64 retired_udp_bytes_ = 0;     // Bytes of media already unprepared
+    mutable std::mutex media_mutex_;            // Guards medias_ and retired_udp_bytes_
 };
 
 #endif // RTSP_STREAMER_H
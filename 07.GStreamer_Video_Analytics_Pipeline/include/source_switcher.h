@@ -0,0 +1,282 @@
+/**
+ * @file source_switcher.h
+ * @brief Hot input switching with a warm standby in front of the pipeline
+ *
+ * Every input is a self-contained branch bin (source -> decode -> convert ->
+ * scale -> rate -> capsfilter) that already produces the pipeline format,
+ * linked to a request pad of an input-selector. A standby branch is built
+ * and pre-rolled while the active one plays: live inputs keep running and
+ * the selector drops their frames, file inputs block on their first decoded
+ * frame. Switching only changes the selector's active pad, after shifting
+ * the standby's running time (pad offset) so output timestamps continue
+ * without a jump. Old branches are queued to a reaper thread that stops and
+ * removes them, so the switch never waits for a source to shut down.
+ *
+ * A watchdog (checkStall) fails over to the standby when the active live
+ * input stops delivering frames for longer than the stall timeout.
+ */
+
+#ifndef SOURCE_SWITCHER_H
+#define SOURCE_SWITCHER_H
+
+#include <gst/gst.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "metrics_registry.h"
+
+/**
+ * @brief Defines video source types
+ */
+enum class SourceType {
+    FILE,        // Video file
+    WEBCAM,      // USB/V4L2 camera
+    RTSP,        // RTSP stream
+    HTTP,        // HTTP stream
+    APPSRC,      // Application source
+    TEST         // videotestsrc (location = pattern name, live)
+};
+
+/**
+ * @brief Raw format every input branch is converted to
+ */
+struct SourceFormat {
+    int width = 1920;                   // Frame width
+    int height = 1080;                  // Frame height
+    int framerate = 30;                 // Frames per second
+    std::string video_format = "I420";  // Raw video format
+};
+
+/**
+ * @brief Source switching statistics
+ */
+struct SourceSwitchStats {
+    guint64 switches = 0;               // Active input changes (including failovers)
+    guint64 failovers = 0;              // Switches caused by a stalled or failed input
+    double last_gap_ms = 0.0;           // Wall time between the last old and first new frame
+    double last_pts_gap_ms = 0.0;       // Running-time step across the last switch
+    std::string active_location;        // Active input
+    std::string standby_location;       // Standby input (empty = none)
+    bool standby_ready = false;         // Standby has decoded a frame
+};
+
+/**
+ * @brief Owns the input branches and the input-selector that picks one
+ */
+class SourceSwitcher {
+public:
+    /**
+     * @brief Constructor
+     * @param format Format every branch is converted to
+     */
+    explicit SourceSwitcher(const SourceFormat& format);
+
+    /**
+     * @brief Destructor (call release() first if the pipeline is still playing)
+     */
+    ~SourceSwitcher();
+
+    SourceSwitcher(const SourceSwitcher&) = delete;
+    SourceSwitcher& operator=(const SourceSwitcher&) = delete;
+
+    /**
+     * @brief Creates the input-selector inside the pipeline
+     * @param pipeline Pipeline the branches are added to
+     * @return input-selector element (owned by the pipeline; link its src pad)
+     */
+    GstElement* createElement(GstElement* pipeline);
+
+    /**
+     * @brief Drops every branch (pipeline already in NULL state)
+     */
+    void release();
+
+    /**
+     * @brief Adds the first input and makes it active
+     * @param location File path, device, URI or test pattern
+     * @param type Source type
+     * @return true if successful
+     */
+    bool setPrimary(const std::string& location, SourceType type);
+
+    /**
+     * @brief Builds and pre-rolls a standby input (replaces an existing one)
+     * @param location File path, device, URI or test pattern
+     * @param type Source type
+     * @return true if the branch was created
+     */
+    bool prepareStandby(const std::string& location, SourceType type);
+
+    /**
+     * @brief Waits until the standby has decoded its first frame
+     * @param timeout Maximum wait (ns)
+     * @return true if the standby is ready
+     */
+    bool waitForStandby(GstClockTime timeout);
+
+    /**
+     * @brief Makes the standby active; the old input is torn down asynchronously
+     * @return false if there is no ready standby
+     */
+    bool switchToStandby();
+
+    /**
+     * @brief Switches to an input, reusing a matching warm standby
+     * @param location File path, device, URI or test pattern
+     * @param type Source type
+     * @param timeout Maximum pre-roll wait for a new input (ns)
+     * @return true if the input is active
+     */
+    bool changeSource(const std::string& location, SourceType type, GstClockTime timeout);
+
+    /**
+     * @brief Sets how long a live input may go without frames (0 = no failover)
+     * @param timeout_ms Stall timeout in milliseconds
+     */
+    void setStallTimeout(int timeout_ms) { stall_timeout_ms_ = timeout_ms; }
+
+    /**
+     * @brief Fails over to the standby if the active live input has stalled
+     *
+     * Called periodically from the application main loop.
+     * @return true if a failover happened
+     */
+    bool checkStall();
+
+    /**
+     * @brief Handles an error posted by an input branch
+     *
+     * A failing active input fails over to a ready standby, a failing
+     * standby is dropped.
+     * @param source Message source
+     * @return true if handled (the pipeline can keep running)
+     */
+    bool handleError(GstObject* source);
+
+    /**
+     * @brief Returns statistics
+     */
+    SourceSwitchStats getStats() const;
+
+    /**
+     * @brief Exports the switching metrics
+     * @param registry Registry (must not outlive this object)
+     */
+    void registerMetrics(MetricsRegistry& registry);
+
+private:
+    /**
+     * @brief One input branch
+     */
+    struct Branch {
+        SourceSwitcher* owner = nullptr;            // For the pad probes
+        std::string location;                       // Input location
+        SourceType type = SourceType::FILE;         // Input type
+        bool live = true;                           // Produces frames in real time
+        GstElement* bin = nullptr;                  // Branch bin (owned by the pipeline)
+        GstPad* ghost_pad = nullptr;                // Bin src pad (owned by the bin)
+        GstPad* selector_pad = nullptr;             // Selector request pad (ref held)
+        gulong block_probe = 0;                     // Pre-roll block (non-live standby)
+        std::atomic<bool> standby{false};           // Waiting behind the active input
+        std::atomic<bool> has_data{false};          // A frame reached the selector
+        std::atomic<gint64> last_frame_us{0};       // Monotonic time of the last frame
+        std::atomic<guint64> last_pts{GST_CLOCK_TIME_NONE};      // Last frame PTS
+        std::atomic<guint64> last_duration{GST_CLOCK_TIME_NONE}; // Last frame duration
+    };
+
+    /**
+     * @brief Builds a branch bin and links it to a new selector pad
+     */
+    std::unique_ptr<Branch> createBranch(const std::string& location, SourceType type);
+
+    /**
+     * @brief Creates the source part of a branch, linked to its converter
+     */
+    bool createSourceElements(Branch& branch, GstElement* convert);
+
+    /**
+     * @brief Makes the standby active (mutex_ held)
+     */
+    bool switchLocked(bool failover);
+
+    /**
+     * @brief Queues a branch for the reaper thread (may be called with mutex_ held)
+     */
+    void retire(std::unique_ptr<Branch> branch);
+
+    /**
+     * @brief Reaper thread: stops and removes queued branches
+     */
+    void reaperLoop();
+
+    /**
+     * @brief Drains the reaper queue and joins the thread (never with mutex_ held)
+     */
+    void joinReaper();
+
+    /**
+     * @brief Returns the running time the branch's next frame would have
+     */
+    GstClockTime nextRunningTime(Branch& branch) const;
+
+    /**
+     * @brief Returns the pipeline running time (GST_CLOCK_TIME_NONE without a clock)
+     */
+    GstClockTime pipelineRunningTime() const;
+
+    /**
+     * @brief Branch output probe: frame bookkeeping (and pre-roll block)
+     */
+    static GstPadProbeReturn onBranchBuffer(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+    /**
+     * @brief Selector output probe: switch gap and output running time
+     */
+    static GstPadProbeReturn onOutputBuffer(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+    /**
+     * @brief Links a dynamic video pad to the element's sink pad
+     */
+    static void onPadAdded(GstElement* src, GstPad* new_pad, gpointer data);
+
+    SourceFormat format_;                           // Branch output format
+    GstElement* pipeline_ = nullptr;                // Pipeline (not owned)
+    GstElement* selector_ = nullptr;                // input-selector (owned by the pipeline)
+    GstPad* output_pad_ = nullptr;                  // Selector src pad (ref held)
+    gulong output_probe_ = 0;                       // onOutputBuffer probe id
+    guint branch_counter_ = 0;                      // Unique branch names
+
+    mutable std::mutex mutex_;                      // Guards active_, standby_ and the selector
+    std::unique_ptr<Branch> active_;                // Input on the selector output
+    std::unique_ptr<Branch> standby_;               // Pre-rolled input
+    std::mutex ready_mutex_;                        // With ready_cv_
+    std::condition_variable ready_cv_;              // Signalled on a branch's first frame
+    std::thread reaper_;                            // Tears down retired branches (started on demand)
+    std::mutex reaper_mutex_;                       // Guards retired_ and reaper_stop_
+    std::condition_variable reaper_cv_;             // Signalled on retire() and stop
+    std::deque<std::unique_ptr<Branch>> retired_;   // Branches waiting for teardown
+    bool reaper_stop_ = false;                      // Exit once retired_ is empty
+    std::atomic<int> stall_timeout_ms_{5000};       // Failover threshold
+
+    // Switch gap (written on switch, read by the output probe)
+    std::atomic<bool> switch_pending_{false};       // Next output frame comes from the new input
+    std::atomic<gint64> switch_from_us_{0};         // Time of the last frame before the switch
+    std::atomic<guint64> switch_from_rt_{GST_CLOCK_TIME_NONE}; // Its end running time
+    std::atomic<gint64> last_output_us_{0};         // Time of the last output frame
+    std::atomic<guint64> last_output_end_{GST_CLOCK_TIME_NONE}; // Its end running time
+
+    // Statistics (lock-free, see metrics_registry.h)
+    Counter switches_metric_;                       // Switches
+    Counter failovers_metric_;                      // Failovers
+    Histogram gap_metric_{{0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2, 5, 10}}; // Switch gap (s)
+    Gauge last_gap_metric_;                         // Last switch gap (s)
+    Gauge last_pts_gap_metric_;                     // Last running-time step (s)
+    Gauge standby_ready_metric_;                    // 1 while a ready standby exists
+};
+
+#endif // SOURCE_SWITCHER_H
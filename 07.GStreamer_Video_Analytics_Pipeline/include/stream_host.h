@@ -0,0 +1,235 @@
+/**
+ * @file stream_host.h
+ * @brief Runs many source pipelines in one process on a shared worker pool
+ *
+ * Every stream is a small pipeline (input branch -> appsink) whose streaming
+ * thread only hands decoded frames to the stream's lane of one shared
+ * WorkStealingPool. The pool workers run the stream's VideoProcessor and
+ * MotionDetector, so the analysis cost of N streams is spread over a fixed
+ * number of threads instead of N streaming threads. Lanes are bounded and
+ * drop their oldest frame under overload, and busy streams take turns.
+ *
+ * All bus watches and the FPS timer run on one GLib main loop owned by the
+ * host. Streams can be added and removed while the others keep running.
+ */
+
+#ifndef STREAM_HOST_H
+#define STREAM_HOST_H
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/video/video.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics_registry.h"
+#include "motion_detector.h"
+#include "source_switcher.h"
+#include "video_processor.h"
+#include "work_stealing_pool.h"
+
+/**
+ * @brief Stream host configuration
+ */
+struct StreamHostConfig {
+    int thread_count = 0;               // Shared workers (0 = hardware concurrency)
+    int queue_depth = 2;                // Frames queued per stream before the oldest is dropped
+    SourceFormat format;                // Format every stream is converted to
+    ProcessingParams processing;        // Per-stream VideoProcessor settings
+    bool enable_motion_detection = false;
+    MotionDetectionParams motion;       // Per-stream MotionDetector settings
+};
+
+/**
+ * @brief Statistics of one stream
+ */
+struct StreamStats {
+    std::string id;                     // Stream id
+    std::string location;               // Input location
+    double fps = 0.0;                   // Frames analysed per second (last second)
+    guint64 input_frames = 0;           // Frames delivered by the pipeline
+    guint64 processed_frames = 0;       // Frames analysed by the pool
+    guint64 dropped_frames = 0;         // Frames discarded because the lane was full
+    double avg_processing_ms = 0.0;     // Average analysis time per frame
+    guint64 motion_frames = 0;          // Frames with motion (motion detection only)
+    bool finished = false;              // End of stream reached
+    bool failed = false;                // Pipeline posted an error
+};
+
+/**
+ * @brief Motion event callback of a hosted stream
+ * @param id Stream id
+ * @param regions Detected motion regions
+ * @param timestamp Event time
+ * @param motion_percentage Motion percentage of total area
+ */
+using StreamMotionCallback = std::function<void(
+    const std::string&, const std::vector<MotionRegion>&, guint64, double)>;
+
+/**
+ * @brief Owns the stream pipelines, the shared pool and their main loop
+ */
+class StreamHost {
+public:
+    /**
+     * @brief Constructor (starts the pool workers)
+     * @param config Host configuration
+     */
+    explicit StreamHost(const StreamHostConfig& config);
+
+    /**
+     * @brief Destructor (stops every stream)
+     */
+    ~StreamHost();
+
+    StreamHost(const StreamHost&) = delete;
+    StreamHost& operator=(const StreamHost&) = delete;
+
+    /**
+     * @brief Starts the main loop thread (bus watches, FPS timer)
+     * @return true if successful
+     */
+    bool start();
+
+    /**
+     * @brief Removes every stream and stops the main loop
+     */
+    void stop();
+
+    /**
+     * @brief Checks if the host is running
+     */
+    bool isRunning() const { return is_running_.load(); }
+
+    /**
+     * @brief Builds a stream pipeline and starts it
+     * @param id Unique stream id (metric label)
+     * @param location File path, device, URI or test pattern
+     * @param type Source type
+     * @return true if the pipeline is playing
+     */
+    bool addStream(const std::string& id, const std::string& location, SourceType type);
+
+    /**
+     * @brief Stops a stream; its queued frames are discarded
+     * @param id Stream id
+     * @return false if the stream does not exist
+     */
+    bool removeStream(const std::string& id);
+
+    /**
+     * @brief Returns the number of streams (including finished and failed ones)
+     */
+    size_t streamCount() const;
+
+    /**
+     * @brief Returns per-stream statistics, ordered by id
+     */
+    std::vector<StreamStats> getStats() const;
+
+    /**
+     * @brief Sets the motion event callback (applies to streams added afterwards)
+     * @param callback Callback function (runs on a pool worker)
+     */
+    void setMotionEventCallback(StreamMotionCallback callback);
+
+    /**
+     * @brief Returns the shared worker pool
+     */
+    const WorkStealingPool& getPool() const { return pool_; }
+
+    /**
+     * @brief Returns the metrics registry (per-stream series and pool counters)
+     */
+    const MetricsRegistry& getMetrics() const { return metrics_; }
+
+private:
+    /**
+     * @brief One hosted stream
+     */
+    struct Stream {
+        StreamHost* host = nullptr;                 // Owning host
+        std::string id;                             // Stream id
+        std::string location;                       // Input location
+        GstElement* pipeline = nullptr;             // Stream pipeline (owned)
+        GSource* bus_watch = nullptr;               // Bus watch on the host context
+        std::unique_ptr<SourceSwitcher> switcher;   // Input branch and selector
+        std::unique_ptr<VideoProcessor> processor;  // Per-stream filters
+        std::unique_ptr<MotionDetector> detector;   // Per-stream motion detection
+        std::shared_ptr<WorkLane> lane;             // Pool lane (frames in order)
+        GstCaps* caps = nullptr;                    // Caps info was parsed from (ref held)
+        GstVideoInfo info;                          // Negotiated format (streaming thread)
+        bool info_valid = false;                    // caps parsed as raw video
+        std::atomic<guint64> busy_ns{0};            // Total analysis time
+        std::atomic<bool> finished{false};          // EOS reached
+        std::atomic<bool> failed{false};            // Error posted
+        guint64 fps_frames = 0;                     // Processed frames at the last FPS update
+        Gauge fps_metric;                           // Analysed frames per second
+    };
+
+    /**
+     * @brief Creates the pipeline of a stream (not yet playing)
+     */
+    bool buildStream(Stream& stream, SourceType type);
+
+    /**
+     * @brief Stops a stream and frees its pipeline
+     */
+    void destroyStream(Stream& stream);
+
+    /**
+     * @brief Runs the stream's analysis on one frame (pool worker)
+     * @param stream Stream
+     * @param buffer Frame (reference taken over)
+     * @param info Frame format
+     */
+    void analyse(Stream& stream, GstBuffer* buffer, const GstVideoInfo& info);
+
+    /**
+     * @brief Updates the per-stream FPS (main loop, once a second)
+     */
+    void updateFPS();
+
+    /**
+     * @brief Registers the per-stream and pool metrics
+     */
+    void registerMetrics();
+
+    /**
+     * @brief Main loop thread function
+     */
+    void mainLoopThread();
+
+    /**
+     * @brief appsink new-sample callback (stream streaming thread)
+     */
+    static GstFlowReturn onNewSample(GstAppSink* sink, gpointer user_data);
+
+    /**
+     * @brief Bus callback of a stream (host main loop)
+     */
+    static gboolean busCallback(GstBus* bus, GstMessage* message, gpointer user_data);
+
+    StreamHostConfig config_;                               // Host configuration
+    WorkStealingPool pool_;                                 // Shared analysis workers
+
+    mutable std::mutex mutex_;                              // Guards streams_
+    std::map<std::string, std::unique_ptr<Stream>> streams_; // Streams by id
+    StreamMotionCallback motion_callback_;                  // Motion events of all streams
+
+    GMainContext* context_ = nullptr;                       // Context of the bus watches
+    GMainLoop* main_loop_ = nullptr;                        // Runs context_
+    std::thread main_loop_thread_;                          // Runs main_loop_
+    std::atomic<bool> is_running_{false};                   // start() called
+    gint64 last_fps_us_ = 0;                                // Monotonic time of the last FPS update
+
+    MetricsRegistry metrics_;                               // Per-stream series via collectors
+};
+
+#endif // STREAM_HOST_H
@@ -0,0 +1,131 @@
+/**
+ * @file stream_recorder.h
+ * @brief Records an already-encoded stream from a tee into rotating files
+ *
+ * Adds a queue ! parser ! splitmuxsink branch to a tee that sits after the
+ * encoder and parser of a running pipeline, so recording costs no second
+ * encode. The branch is linked behind a blocked tee pad and removed from an
+ * idle one, so the other tee branches never see a gap. Each file starts on
+ * a keyframe (one is requested from the encoder) and files rotate at the
+ * configured duration.
+ */
+
+#ifndef STREAM_RECORDER_H
+#define STREAM_RECORDER_H
+
+#include <gst/gst.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include "metrics_registry.h"
+
+/**
+ * @brief Stream recorder statistics
+ */
+struct StreamRecorderStats {
+    bool recording = false;         // Branch attached
+    guint64 files = 0;              // Files started (all recordings)
+    guint64 bytes = 0;              // Encoded bytes handed to the branch
+    std::string current_file;       // File being written
+};
+
+/**
+ * @brief Tee branch writing the encoded stream with splitmuxsink
+ */
+class StreamRecorder {
+public:
+    /**
+     * @brief Constructor
+     * @param parser Parser matching the stream, e.g. "h264parse"
+     * @param max_duration Seconds per file (0 = one file)
+     */
+    StreamRecorder(const std::string& parser, int max_duration);
+
+    /**
+     * @brief Destructor (detaches an attached branch)
+     */
+    ~StreamRecorder();
+
+    StreamRecorder(const StreamRecorder&) = delete;
+    StreamRecorder& operator=(const StreamRecorder&) = delete;
+
+    /**
+     * @brief Adds the recording branch to a tee of a playing pipeline
+     * @param tee tee after the encoder and parser
+     * @param location_pattern strftime file pattern, expanded per file
+     * @return false if already attached or the branch cannot be built
+     */
+    bool attach(GstElement* tee, const std::string& location_pattern);
+
+    /**
+     * @brief Removes the branch (blocks until the last file is finalised)
+     */
+    void detach();
+
+    /**
+     * @brief Returns true while the branch is attached
+     */
+    bool isRecording() const { return recording_metric_.value() > 0; }
+
+    /**
+     * @brief Returns statistics
+     */
+    StreamRecorderStats getStats() const;
+
+    /**
+     * @brief Exports the recorder metrics
+     * @param registry Registry (must not outlive this object)
+     * @param prefix Metric name prefix, e.g. "rtsp_recording"
+     */
+    void registerMetrics(MetricsRegistry& registry, const std::string& prefix);
+
+private:
+    /**
+     * @brief Drops frames until the first keyframe, counts bytes (tee pad)
+     */
+    static GstPadProbeReturn onTeeBuffer(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+    /**
+     * @brief Holds the new tee pad until the branch is linked and running
+     */
+    static GstPadProbeReturn onTeeBlocked(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+    /**
+     * @brief Unlinks the idle tee pad and sends EOS into the branch
+     */
+    static GstPadProbeReturn onTeeIdle(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+    /**
+     * @brief Notes EOS at the file sink (the last file is complete)
+     */
+    static GstPadProbeReturn onSinkEvent(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+
+    /**
+     * @brief splitmuxsink format-location handler
+     * @return File name of the next fragment (g_free'd by splitmuxsink)
+     */
+    static gchar* onFormatLocation(GstElement* splitmux, guint fragment_id, gpointer user_data);
+
+    std::string parser_;                        // Parser element name
+    int max_duration_;                          // Seconds per file
+
+    // Branch (set while attached)
+    GstElement* tee_ = nullptr;                 // Tee (owned reference)
+    GstElement* bin_ = nullptr;                 // queue ! parser ! splitmuxsink
+    GstPad* tee_pad_ = nullptr;                 // Requested tee pad
+    std::string pattern_;                       // strftime file pattern
+    std::string last_file_;                     // Previous file name
+    bool keyframe_seen_ = false;                // Branch started on a keyframe
+    bool stopping_ = false;                     // EOS sent into the branch
+    bool finished_ = false;                     // EOS reached the file sink
+    mutable std::mutex mutex_;                  // Guards the branch fields
+    std::condition_variable finished_cv_;       // Signals finished_
+
+    // Statistics (lock-free, see metrics_registry.h)
+    Counter files_metric_;                      // Files started
+    Counter bytes_metric_;                      // Bytes handed to the branch
+    Gauge recording_metric_;                    // 1 while attached
+};
+
+#endif // STREAM_RECORDER_H
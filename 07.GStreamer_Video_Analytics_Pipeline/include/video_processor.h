@@ -16,11 +16,19 @@
 #include <vector>
 #include <functional>
 #include <mutex>
+#include <atomic>
+#include <map>
+#include <string>
+#include <chrono>
 
 #ifdef HAVE_OPENCV
 #include <opencv2/opencv.hpp>
 #endif
 
+#include "color_adjust.h"
+#include "filter_chain.h"
+#include "metrics_registry.h"
+
 /**
  * @brief Video filter types
  */
@@ -33,6 +41,8 @@ enum class FilterType {
     DENOISE,        // Noise reduction
     BRIGHTNESS,     // Brightness adjustment
     CONTRAST,       // Contrast adjustment
+    COLOR_ADJUST,   // Brightness, contrast, saturation and hue
+    CHAIN,          // Ordered filter_chain stages
     CUSTOM          // Custom filter
 };
 
@@ -47,7 +57,7 @@ struct ProcessingParams {
     double brightness = 0.0;    // -100 to 100
     double contrast = 1.0;      // 0.5 to 3.0
     double saturation = 1.0;    // 0.0 to 2.0
-    double hue = 0.0;          // -180 to 180
+    double hue = 0.0;          // -180 to 180 (saturation and hue: YUV formats)
 
     // Blur parameters
     int blur_kernel_size = 5;   // Must be odd
@@ -77,6 +87,12 @@ struct ProcessingParams {
     bool enable_scaling = false;
     int scale_width = 0;
     int scale_height = 0;
+
+    // Filter chain (FilterType::CHAIN): run in order, crop and scale change the output size
+    std::vector<FilterStage> filter_chain;
+
+    // Threading
+    int processing_threads = 1; // Row bands for colour adjustment, tile bands for the chain (0 = hardware concurrency)
 };
 
 /**
@@ -88,6 +104,7 @@ struct ProcessingStats {
     double min_processing_time = 999999.0;
     double max_processing_time = 0.0;
     guint64 dropped_frames = 0;        // Dropped frame count
+    std::vector<StageTiming> stage_timings; // Filter chain operations (FilterType::CHAIN)
 };
 
 /**
@@ -152,9 +169,18 @@ public:
 
     /**
      * @brief Resets statistics
+     *
+     * Only the values returned by getStats() restart; exported metrics stay
+     * monotonic.
      */
     void resetStats();
 
+    /**
+     * @brief Exports the processing metrics
+     * @param registry Registry (must not outlive this object)
+     */
+    void registerMetrics(MetricsRegistry& registry);
+
     /**
      * @brief Enables/disables GPU acceleration
      * @param enable true to enable
@@ -175,127 +201,215 @@ public:
      */
     void addMetadata(const std::string& key, const std::string& value);
 
+    /**
+     * @brief Returns true if the filter chain may change the frame size
+     */
+    bool resizesFrames() const;
+
+    /**
+     * @brief Returns the output size for an input size (the filter chain may crop or scale)
+     * @param width Input width
+     * @param height Input height
+     * @param out_width Output width
+     * @param out_height Output height
+     */
+    void outputSize(int width, int height, int& out_width, int& out_height) const;
+
+    /**
+     * @brief Filters a frame in place (per-pixel filters, streaming thread)
+     * @param buffer Writable buffer
+     * @param info Video information cached from caps negotiation
+     * @return Flow status
+     */
+    GstFlowReturn processFrameInPlace(GstBuffer* buffer, const GstVideoInfo* info);
+
+    /**
+     * @brief Filters a frame into an output buffer (streaming thread)
+     * @param inbuf Input buffer (read only)
+     * @param outbuf Output buffer from the negotiated pool
+     * @param in_info Input video information cached from caps negotiation
+     * @param out_info Output video information (differs in size after crop/scale)
+     * @return Flow status
+     */
+    GstFlowReturn processFrame(GstBuffer* inbuf, GstBuffer* outbuf,
+                               const GstVideoInfo* in_info, const GstVideoInfo* out_info);
+
 #ifdef HAVE_OPENCV
     /**
-     * @brief Converts to OpenCV Mat object
-     * @param buffer GStreamer buffer
-     * @param info Video information
-     * @return OpenCV Mat object
+     * @brief Converts a mapped frame to BGR
+     * @param frame Mapped video frame (I420, YV12, NV12, NV21, RGB or BGR)
+     * @param mat Destination (reallocated only when the size changes)
+     * @return true if the format is supported
      */
-    cv::Mat bufferToMat(GstBuffer* buffer, const GstVideoInfo* info);
+    bool frameToMat(const GstVideoFrame* frame, cv::Mat& mat);
 
     /**
-     * @brief Creates buffer from OpenCV Mat object
-     * @param mat OpenCV Mat object
-     * @param info Video information
-     * @return GStreamer buffer
+     * @brief Writes a BGR image into a mapped frame
+     * @param mat BGR image of the frame size
+     * @param frame Mapped video frame (I420, YV12, NV12, NV21, RGB or BGR)
+     * @return true if the format is supported
      */
-    GstBuffer* matToBuffer(const cv::Mat& mat, const GstVideoInfo* info);
+    bool matToFrame(const cv::Mat& mat, GstVideoFrame* frame);
 #endif
 
 private:
     /**
-     * @brief Processes a video frame
-     * @param buffer Buffer to process
-     * @param info Video information
-     * @return Processed buffer
+     * @brief Publishes params_ to the streaming thread and colour tables (params_mutex_ held)
+     */
+    void publishParameters();
+
+    /**
+     * @brief Selects passthrough, in-place or pooled transform (params_mutex_ held)
+     */
+    void updateTransformMode();
+
+    /**
+     * @brief Applies per-pixel filters in place
+     * @param frame Mapped video frame
+     * @param params Parameter snapshot
      */
-    GstBuffer* processFrame(GstBuffer* buffer, const GstVideoInfo* info);
+    void applyPixelFilter(GstVideoFrame* frame, const ProcessingParams& params);
 
     /**
      * @brief Applies grayscale filter
-     * @param data Video data
-     * @param info Video information
+     * @param frame Mapped video frame
+     */
+    void applyGrayscale(GstVideoFrame* frame);
+
+    /**
+     * @brief Applies the colour tables (brightness, contrast, saturation, hue)
+     * @param frame Mapped video frame
      */
-    void applyGrayscale(guint8* data, const GstVideoInfo* info);
+    void applyColorAdjust(GstVideoFrame* frame);
 
     /**
-     * @brief Adjusts brightness/contrast
-     * @param data Video data
+     * @brief Runs the custom callback and keeps its result in the buffer
+     * @param buffer Writable buffer
      * @param info Video information
      */
-    void adjustBrightnessContrast(guint8* data, const GstVideoInfo* info);
+    void applyCustom(GstBuffer* buffer, const GstVideoInfo* info);
+
+    /**
+     * @brief Saves the frame if a snapshot was requested
+     * @param frame Mapped video frame
+     */
+    void saveSnapshotIfRequested(const GstVideoFrame* frame);
+
+    /**
+     * @brief Updates timing statistics for one frame
+     * @param start_time Processing start time
+     */
+    void recordFrame(std::chrono::high_resolution_clock::time_point start_time);
 
 #ifdef HAVE_OPENCV
     /**
-     * @brief Applies OpenCV-based filter
-     * @param mat OpenCV Mat object
-     * @param type Filter type
+     * @brief Filters a mapped frame into another (OpenCV)
+     * @param in Input frame
+     * @param out Output frame
+     * @param params Parameter snapshot
+     * @return false if the format is not supported
      */
-    void applyOpenCVFilter(cv::Mat& mat, FilterType type);
+    bool filterFrame(const GstVideoFrame* in, GstVideoFrame* out, const ProcessingParams& params);
 
     /**
-     * @brief Blur filter (OpenCV)
-     * @param mat Image matrix
+     * @brief Recompiles the filter chain after a parameter or size change
+     * @param params Parameter snapshot
+     * @param input_size Input frame size
      */
-    void applyBlur(cv::Mat& mat);
+    void prepareChain(const std::shared_ptr<const ProcessingParams>& params, cv::Size input_size);
 
     /**
-     * @brief Sharpening filter (OpenCV)
-     * @param mat Image matrix
+     * @brief Applies OpenCV-based filter and geometry
+     * @param src BGR input
+     * @param dst BGR output (written in place, not reallocated)
+     * @param params Parameter snapshot
      */
-    void applySharpen(cv::Mat& mat);
+    void applyOpenCVFilter(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params);
 
     /**
-     * @brief Edge detection filter (OpenCV)
-     * @param mat Image matrix
+     * @brief Applies rotation and flips in one resampling pass (OpenCV)
+     * @param src Source image
+     * @param dst Destination image
+     * @param params Parameter snapshot
      */
-    void applyEdgeDetection(cv::Mat& mat);
+    void applyGeometry(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params);
 
     /**
-     * @brief Noise reduction filter (OpenCV)
-     * @param mat Image matrix
+     * @brief Blur filter (OpenCV)
+     * @param src Source image
+     * @param dst Destination image
+     * @param params Parameter snapshot
      */
-    void applyDenoise(cv::Mat& mat);
-#endif
+    void applyBlur(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params);
 
     /**
-     * @brief Transform callback (GStreamer)
-     * @param trans Transform element
-     * @param inbuf Input buffer
-     * @param outbuf Output buffer
-     * @return Flow status
+     * @brief Sharpening filter (OpenCV)
+     * @param src Source image
+     * @param dst Destination image
+     * @param params Parameter snapshot
+     */
+    void applySharpen(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params);
+
+    /**
+     * @brief Edge detection filter (OpenCV)
+     * @param src Source image
+     * @param dst Destination image
+     * @param params Parameter snapshot
      */
-    static GstFlowReturn transformCallback(GstBaseTransform* trans,
-                                         GstBuffer* inbuf,
-                                         GstBuffer* outbuf);
+    void applyEdgeDetection(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params);
 
     /**
-     * @brief Caps setting callback
-     * @param trans Transform element
-     * @param incaps Input caps
-     * @param outcaps Output caps
-     * @return TRUE if successful
+     * @brief Noise reduction filter (OpenCV)
+     * @param src Source image
+     * @param dst Destination image
+     * @param params Parameter snapshot
      */
-    static gboolean setCapsCallback(GstBaseTransform* trans,
-                                  GstCaps* incaps,
-                                  GstCaps* outcaps);
+    void applyDenoise(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params);
+#endif
 
     // Member variables
     GstElement* element_ = nullptr;                    // GStreamer element
     ProcessingParams params_;                          // Processing parameters
-    ProcessingStats stats_;                            // Statistics
+    std::shared_ptr<const ProcessingParams> active_params_; // Copy read by the streaming thread (atomic access)
+    ColorAdjuster color_adjuster_;                     // Colour tables
     mutable std::mutex params_mutex_;                  // Parameter access mutex
-    mutable std::mutex stats_mutex_;                   // Statistics access mutex
+    bool resizing_ = false;                            // Published chain changes the frame size
 
     ProcessingCallback custom_processor_;              // Custom processing callback
     bool gpu_enabled_ = false;                         // GPU acceleration state
 
-    GstVideoInfo video_info_;                          // Video format information
-    bool video_info_valid_ = false;                    // Video info valid flag
-
     // For snapshots
     std::mutex snapshot_mutex_;                        // Snapshot mutex
-    bool take_snapshot_ = false;                       // Snapshot flag
+    std::atomic<bool> take_snapshot_{false};           // Snapshot flag
     std::string snapshot_filename_;                    // Snapshot file name
 
     // Metadata storage
     std::map<std::string, std::string> metadata_;      // Metadata
     std::mutex metadata_mutex_;                        // Metadata mutex
 
-    // For performance measurement
+    // For performance measurement (lock-free, see metrics_registry.h)
     GstClockTime last_timestamp_ = 0;                  // Last timestamp
-    guint64 processing_time_sum_ = 0;                  // Total processing time
+    Histogram frame_time_metric_{Histogram::exponentialBounds(0.0005, 2.0, 12)}; // Processing time (s)
+    Counter dropped_metric_;                           // Dropped frames
+    std::atomic<double> min_processing_time_{0.0};     // Since resetStats() (ms)
+    std::atomic<double> max_processing_time_{0.0};     // Since resetStats() (ms)
+    std::atomic<uint64_t> frames_base_{0};             // Frame count at resetStats()
+    std::atomic<uint64_t> dropped_base_{0};            // Dropped count at resetStats()
+    std::atomic<double> time_base_{0.0};               // Time sum at resetStats() (s)
+
+#ifdef HAVE_OPENCV
+    // Scratch images, reused across frames (streaming thread only)
+    cv::Mat bgr_input_;                                // Input converted to BGR
+    cv::Mat bgr_output_;                               // Filter output before conversion
+    cv::Mat yuv_scratch_;                              // Packed 4:2:0 for padded frames
+    cv::Mat geometry_scratch_;                         // Filter output before rotation/flip
+    cv::Mat gray_;                                     // Grayscale intermediate
+    cv::Mat edges_;                                    // Edge mask
+
+    // Filter chain (streaming thread only)
+    FilterChain chain_;                                // Compiled chain
+    std::shared_ptr<const ProcessingParams> chain_params_; // Parameters chain_ was compiled from
+#endif
 };
 
 #endif // VIDEO_PROCESSOR_H
@@ -0,0 +1,184 @@
+/**
+ * @file work_stealing_pool.h
+ * @brief Shared workers for many streams: per-stream lanes, fair turns, drop-oldest
+ *
+ * Each stream submits into its own lane, a bounded FIFO whose tasks run one
+ * at a time and in order, so per-stream state needs no extra locking. A lane
+ * with work is a token on one worker's deque. After one task the worker puts
+ * the lane at the back of its own deque, so busy streams take turns instead
+ * of one stream draining its backlog first. Idle workers steal tokens from
+ * the back of the other deques. A full lane discards its oldest task: under
+ * overload a stream keeps analysing its newest frames.
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool;
+
+/**
+ * @brief Bounded, serial task queue of one stream
+ */
+class WorkLane : public std::enable_shared_from_this<WorkLane> {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Queues a task (any thread)
+     *
+     * A full lane drops its oldest queued task first.
+     * @param task Task to run on a pool worker
+     * @return false if a task was dropped or the lane is closed
+     */
+    bool submit(Task task);
+
+    /**
+     * @brief Returns the queued (not yet running) tasks
+     */
+    size_t pending() const;
+
+    /**
+     * @brief Returns the queue limit
+     */
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Returns the tasks accepted by submit()
+     */
+    uint64_t submitted() const { return submitted_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the tasks that have run
+     */
+    uint64_t executed() const { return executed_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the tasks discarded because the lane was full
+     */
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    friend class WorkStealingPool;
+
+    /**
+     * @brief Constructor (see WorkStealingPool::createLane)
+     */
+    WorkLane(WorkStealingPool* pool, size_t capacity, size_t home);
+
+    WorkStealingPool* pool_;                    // Owning pool
+    size_t capacity_;                           // Queue limit
+    size_t home_;                               // Worker deque new work is queued on
+    mutable std::mutex mutex_;                  // Guards the fields below
+    std::condition_variable idle_cv_;           // A task finished (closeLane waits)
+    std::deque<Task> tasks_;                    // Queued tasks, oldest first
+    bool scheduled_ = false;                    // Token queued or a task running
+    bool running_ = false;                      // A worker runs a task
+    bool closed_ = false;                       // No more tasks accepted
+    std::atomic<uint64_t> submitted_{0};        // Accepted tasks
+    std::atomic<uint64_t> executed_{0};         // Finished tasks
+    std::atomic<uint64_t> dropped_{0};          // Discarded oldest tasks
+};
+
+/**
+ * @brief Fixed set of workers shared by every lane
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @brief Constructor (starts the workers)
+     * @param threads Worker count (0 = hardware concurrency)
+     */
+    explicit WorkStealingPool(int threads = 0);
+
+    /**
+     * @brief Destructor (joins the workers; close every lane first)
+     */
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Creates a lane; lanes are spread over the worker deques
+     * @param capacity Queued tasks before the oldest is dropped (at least 1)
+     * @return New lane
+     */
+    std::shared_ptr<WorkLane> createLane(size_t capacity);
+
+    /**
+     * @brief Closes a lane: queued tasks are discarded, a running one finishes
+     *
+     * Blocks until no task of the lane runs. Must not be called from a task.
+     * @param lane Lane to close
+     */
+    void closeLane(WorkLane& lane);
+
+    /**
+     * @brief Returns the worker count
+     */
+    int threads() const { return static_cast<int>(count_); }
+
+    /**
+     * @brief Returns the tasks run by all workers
+     */
+    uint64_t executed() const { return executed_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the lane tokens taken from another worker's deque
+     */
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    friend class WorkLane;
+
+    /**
+     * @brief Deque of runnable lanes owned by one worker
+     */
+    struct alignas(64) Deque {
+        std::mutex mutex;                                // Guards lanes
+        std::deque<std::shared_ptr<WorkLane>> lanes;     // Runnable lanes, next first
+    };
+
+    /**
+     * @brief Queues a runnable lane on a worker's deque
+     */
+    void schedule(std::shared_ptr<WorkLane> lane, size_t worker);
+
+    /**
+     * @brief Takes a lane from the own deque (front) or steals one (back)
+     */
+    std::shared_ptr<WorkLane> take(size_t self);
+
+    /**
+     * @brief Runs one task of a lane and re-queues it if more are waiting
+     */
+    void runLane(size_t self, const std::shared_ptr<WorkLane>& lane);
+
+    /**
+     * @brief Worker loop
+     */
+    void worker(size_t self);
+
+    size_t count_;                              // Worker count (fixed before the workers start)
+    std::unique_ptr<Deque[]> deques_;           // One per worker
+    std::vector<std::thread> workers_;          // Workers
+    std::mutex sleep_mutex_;                    // With sleep_cv_
+    std::condition_variable sleep_cv_;          // Work queued or stop
+    std::atomic<size_t> queued_{0};             // Lane tokens in all deques
+    bool stop_ = false;                         // Stop request (sleep_mutex_)
+    std::atomic<size_t> next_home_{0};          // Round-robin lane placement
+    std::atomic<uint64_t> executed_{0};         // Tasks run
+    std::atomic<uint64_t> steals_{0};           // Tokens stolen
+};
+
+#endif // WORK_STEALING_POOL_H
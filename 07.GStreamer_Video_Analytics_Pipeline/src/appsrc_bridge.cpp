@@ -0,0 +1,152 @@
+/**
+ * @file appsrc_bridge.cpp
+ * @brief appsink to appsrc bridge implementation
+ */
+
+#include "appsrc_bridge.h"
+#include <algorithm>
+
+/**
+ * @brief Constructor
+ */
+AppSrcBridge::AppSrcBridge(guint max_buffers)
+    : max_buffers_(std::max(1u, max_buffers)) {
+}
+
+/**
+ * @brief Destructor
+ */
+AppSrcBridge::~AppSrcBridge() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Target& target : targets_) {
+        if (target.caps) {
+            gst_caps_unref(target.caps);
+        }
+        gst_object_unref(target.appsrc);
+    }
+    targets_.clear();
+}
+
+/**
+ * @brief Takes the samples of an appsink
+ */
+void AppSrcBridge::attachSink(GstElement* appsink) {
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = onNewSample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(appsink), &callbacks, this, nullptr);
+}
+
+/**
+ * @brief Starts feeding an appsrc
+ */
+void AppSrcBridge::addTarget(GstElement* appsrc) {
+    g_object_set(appsrc,
+        "stream-type", GST_APP_STREAM_TYPE_STREAM,
+        "format", GST_FORMAT_TIME,
+        "is-live", TRUE,
+        "block", FALSE,
+        "max-buffers", static_cast<guint64>(max_buffers_),
+        "max-bytes", static_cast<guint64>(0),      // Frame count only
+        "max-time", static_cast<guint64>(0),
+        "leaky-type", GST_APP_LEAKY_TYPE_DOWNSTREAM, // Drop the oldest frame
+        nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    targets_.push_back({GST_ELEMENT(gst_object_ref(appsrc)), nullptr, GST_CLOCK_TIME_NONE});
+}
+
+/**
+ * @brief Stops feeding an appsrc
+ */
+bool AppSrcBridge::removeTarget(GstElement* appsrc) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(targets_.begin(), targets_.end(),
+                           [appsrc](const Target& target) { return target.appsrc == appsrc; });
+    if (it == targets_.end()) {
+        return false;
+    }
+    if (it->caps) {
+        gst_caps_unref(it->caps);
+    }
+    gst_object_unref(it->appsrc);
+    targets_.erase(it);
+    return true;
+}
+
+/**
+ * @brief Returns the number of attached appsrcs
+ */
+size_t AppSrcBridge::targetCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return targets_.size();
+}
+
+/**
+ * @brief Exports the bridge metrics
+ */
+void AppSrcBridge::registerMetrics(MetricsRegistry& registry, const std::string& prefix) {
+    registry.addCounter(prefix + "_frames_total", "Processed frames received by the bridge", samples_metric_);
+    registry.addCounter(prefix + "_pushed_frames_total", "Frames handed to media appsrcs (all media)",
+                        pushed_metric_);
+    registry.addCollector(prefix + "_media", "Media fed by the bridge", MetricType::GAUGE,
+                          [this](std::vector<MetricSample>& samples) {
+                              samples.push_back({{}, static_cast<double>(targetCount())});
+                          });
+}
+
+/**
+ * @brief appsink new-sample callback
+ */
+GstFlowReturn AppSrcBridge::onNewSample(GstAppSink* sink, gpointer user_data) {
+    AppSrcBridge* bridge = static_cast<AppSrcBridge*>(user_data);
+
+    GstSample* sample = gst_app_sink_pull_sample(sink);
+    if (!sample) {
+        return GST_FLOW_EOS;
+    }
+    bridge->forward(sample);
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+/**
+ * @brief Pushes one sample to every target
+ */
+void AppSrcBridge::forward(GstSample* sample) {
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    if (!buffer) {
+        return;
+    }
+    samples_metric_.inc();
+
+    // Running time survives segment changes upstream (e.g. a source switch)
+    GstClockTime time = GST_BUFFER_PTS(buffer);
+    const GstSegment* segment = gst_sample_get_segment(sample);
+    if (segment && segment->format == GST_FORMAT_TIME && GST_CLOCK_TIME_IS_VALID(time)) {
+        time = gst_segment_to_running_time(segment, GST_FORMAT_TIME, time);
+    }
+    GstCaps* caps = gst_sample_get_caps(sample);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Target& target : targets_) {
+        // Caps follow the producer (size changes from crop/scale included)
+        if (caps && (!target.caps || !gst_caps_is_equal(caps, target.caps))) {
+            gst_caps_replace(&target.caps, caps);
+            gst_app_src_set_caps(GST_APP_SRC(target.appsrc), caps);
+        }
+        if (!GST_CLOCK_TIME_IS_VALID(target.base)) {
+            target.base = time;
+        }
+
+        // Metadata copy only; the frame memory is shared with the producer
+        GstBuffer* out = gst_buffer_copy(buffer);
+        if (GST_CLOCK_TIME_IS_VALID(time) && GST_CLOCK_TIME_IS_VALID(target.base)) {
+            GST_BUFFER_PTS(out) = time > target.base ? time - target.base : 0;
+        }
+        GST_BUFFER_DTS(out) = GST_CLOCK_TIME_NONE;
+
+        // Never blocks: a full appsrc drops its oldest frame
+        gst_app_src_push_buffer(GST_APP_SRC(target.appsrc), out);
+        pushed_metric_.inc();
+    }
+}
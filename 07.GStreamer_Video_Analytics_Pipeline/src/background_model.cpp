@@ -0,0 +1,170 @@
+/**
+ * @file background_model.cpp
+ * @brief Fixed-point running-average background model implementation
+ *
+ * Per pixel, with B the 8.8 background and p the 8-bit input:
+ *
+ *   foreground = |p - round(B / 256)| > threshold
+ *   B += ((p << 7) - (B >> 1)) * m >> 16,   m = 2 * rate * 65536
+ *
+ * Halving both terms keeps the difference inside int16, so the update is a
+ * single _mm_mulhi_epi16 per eight pixels. m is taken from the background or
+ * foreground rate according to the classification of the same pixel.
+ */
+
+#include "background_model.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BACKGROUND_MODEL_SSE2 1
+#endif
+
+namespace {
+
+/**
+ * @brief Converts a learning rate to the mulhi multiplier used by the update
+ */
+int16_t rateMultiplier(double rate) {
+    double m = std::round(std::clamp(rate, 0.0, 0.25) * 131072.0);
+    return static_cast<int16_t>(std::min(m, 32767.0));
+}
+
+/**
+ * @brief Scalar classification and update of one pixel
+ */
+inline uint8_t updatePixel(uint8_t p, uint16_t& b, int threshold, int bg_mul, int fg_mul) {
+    int bg8 = (b + 128) >> 8;
+    bool fg = std::abs(p - bg8) > threshold;
+    int delta = (p << 7) - (b >> 1);
+    int mul = fg ? fg_mul : bg_mul;
+    b = static_cast<uint16_t>(b + ((delta * mul) >> 16));
+    return fg ? 255 : 0;
+}
+
+} // namespace
+
+/**
+ * @brief Allocates the model and starts the band workers
+ *
+ * Bands are at least 16 rows tall so small planes stay single-threaded.
+ */
+void FixedPointBackground::configure(int width, int height, int threads) {
+    width_ = std::max(0, width);
+    height_ = std::max(0, height);
+    model_.assign(static_cast<size_t>(width_) * height_, 0);
+    primed_ = false;
+
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    pool_.start(std::max(1, std::min(threads, height_ / 16)));
+}
+
+/**
+ * @brief Sets the update rates
+ */
+void FixedPointBackground::setLearningRates(double background_rate, double foreground_rate) {
+    background_mul_ = rateMultiplier(background_rate);
+    foreground_mul_ = rateMultiplier(foreground_rate);
+}
+
+/**
+ * @brief Classifies a frame and updates the model
+ */
+bool FixedPointBackground::apply(const uint8_t* frame, size_t stride, int threshold,
+                                 uint8_t* mask, size_t mask_stride) {
+    if (!primed_) {
+        for (int y = 0; y < height_; ++y) {
+            const uint8_t* src = frame + y * stride;
+            uint16_t* dst = model_.data() + static_cast<size_t>(y) * width_;
+            for (int x = 0; x < width_; ++x) {
+                dst[x] = static_cast<uint16_t>(src[x] << 8);
+            }
+            std::memset(mask + y * mask_stride, 0, width_);
+        }
+        primed_ = true;
+        return false;
+    }
+
+    job_frame_ = frame;
+    job_stride_ = stride;
+    job_mask_ = mask;
+    job_mask_stride_ = mask_stride;
+    job_threshold_ = std::clamp(threshold, 0, 255);
+
+    pool_.run(height_, [this](int y0, int y1) { processRows(y0, y1); });
+    return true;
+}
+
+/**
+ * @brief Writes the rounded background image
+ */
+void FixedPointBackground::background(uint8_t* dst, size_t stride) const {
+    for (int y = 0; y < height_; ++y) {
+        const uint16_t* src = model_.data() + static_cast<size_t>(y) * width_;
+        uint8_t* out = dst + y * stride;
+        for (int x = 0; x < width_; ++x) {
+            out[x] = static_cast<uint8_t>((src[x] + 128) >> 8);
+        }
+    }
+}
+
+/**
+ * @brief Classifies and updates rows [y0, y1)
+ */
+void FixedPointBackground::processRows(int y0, int y1) {
+    const int threshold = job_threshold_;
+    const int bg_mul = background_mul_;
+    const int fg_mul = foreground_mul_;
+
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* src = job_frame_ + y * job_stride_;
+        uint8_t* out = job_mask_ + y * job_mask_stride_;
+        uint16_t* model = model_.data() + static_cast<size_t>(y) * width_;
+        int x = 0;
+
+#ifdef BACKGROUND_MODEL_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i half = _mm_set1_epi16(128);
+        const __m128i thr = _mm_set1_epi8(static_cast<char>(threshold));
+        const __m128i bgm = _mm_set1_epi16(static_cast<int16_t>(bg_mul));
+        const __m128i fgm = _mm_set1_epi16(static_cast<int16_t>(fg_mul));
+
+        for (; x + 16 <= width_; x += 16) {
+            __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+            __m128i b_lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(model + x));
+            __m128i b_hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(model + x + 8));
+
+            // Classification against the rounded 8-bit background
+            __m128i b8 = _mm_packus_epi16(_mm_srli_epi16(_mm_adds_epu16(b_lo, half), 8),
+                                          _mm_srli_epi16(_mm_adds_epu16(b_hi, half), 8));
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(px, b8), _mm_subs_epu8(b8, px));
+            __m128i fg = _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(diff, thr), zero),
+                                       _mm_set1_epi8(-1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), fg);
+
+            // Selective update: per-pixel multiplier from the classification
+            __m128i fg_lo = _mm_unpacklo_epi8(fg, fg);
+            __m128i fg_hi = _mm_unpackhi_epi8(fg, fg);
+            __m128i m_lo = _mm_or_si128(_mm_and_si128(fg_lo, fgm), _mm_andnot_si128(fg_lo, bgm));
+            __m128i m_hi = _mm_or_si128(_mm_and_si128(fg_hi, fgm), _mm_andnot_si128(fg_hi, bgm));
+
+            __m128i d_lo = _mm_sub_epi16(_mm_slli_epi16(_mm_unpacklo_epi8(px, zero), 7),
+                                         _mm_srli_epi16(b_lo, 1));
+            __m128i d_hi = _mm_sub_epi16(_mm_slli_epi16(_mm_unpackhi_epi8(px, zero), 7),
+                                         _mm_srli_epi16(b_hi, 1));
+            b_lo = _mm_add_epi16(b_lo, _mm_mulhi_epi16(d_lo, m_lo));
+            b_hi = _mm_add_epi16(b_hi, _mm_mulhi_epi16(d_hi, m_hi));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(model + x), b_lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(model + x + 8), b_hi);
+        }
+#endif
+
+        for (; x < width_; ++x) {
+            out[x] = updatePixel(src[x], model[x], threshold, bg_mul, fg_mul);
+        }
+    }
+}
@@ -0,0 +1,208 @@
+/**
+ * @file block_motion.cpp
+ * @brief Block-matching motion estimation implementation
+ */
+
+#include "block_motion.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLOCK_MOTION_SSE2 1
+#endif
+
+namespace {
+
+// Blocks whose zero-displacement SAD is at most this (mean difference of 2)
+// are treated as static without searching
+constexpr uint32_t kStaticSad = 2 * 16 * 16;
+
+// Large diamond (LDSP) and small diamond (SDSP) search patterns
+constexpr int kLargeDiamond[8][2] = {
+    {0, -2}, {1, -1}, {2, 0}, {1, 1}, {0, 2}, {-1, 1}, {-2, 0}, {-1, -1}
+};
+constexpr int kSmallDiamond[4][2] = {
+    {0, -1}, {1, 0}, {0, 1}, {-1, 0}
+};
+
+} // namespace
+
+/**
+ * @brief Allocates the estimator and starts the block-row workers
+ */
+void BlockMotionEstimator::configure(int width, int height, int search_range, int threads) {
+    width_ = std::max(0, width);
+    height_ = std::max(0, height);
+    blocks_x_ = width_ / kBlockSize;
+    blocks_y_ = height_ / kBlockSize;
+    range_ = std::clamp(search_range, 1, 64);
+    primed_ = false;
+
+    previous_.assign(static_cast<size_t>(width_) * height_, 0);
+    field_.assign(static_cast<size_t>(blocks_x_) * blocks_y_, MotionVector());
+    previous_field_ = field_;
+
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    pool_.start(std::max(1, std::min(threads, blocks_y_)));
+}
+
+/**
+ * @brief Estimates the field for a frame against the previous one
+ */
+bool BlockMotionEstimator::estimate(const uint8_t* frame, size_t stride) {
+    bool estimated = primed_;
+    if (primed_) {
+        frame_ = frame;
+        stride_ = stride;
+        std::swap(field_, previous_field_);
+        pool_.run(blocks_y_, [this](int by0, int by1) { estimateRows(by0, by1); });
+        frame_ = nullptr;
+    } else {
+        std::fill(field_.begin(), field_.end(), MotionVector());
+        std::fill(previous_field_.begin(), previous_field_.end(), MotionVector());
+    }
+
+    for (int y = 0; y < height_; ++y) {
+        std::memcpy(previous_.data() + static_cast<size_t>(y) * width_, frame + y * stride, width_);
+    }
+    primed_ = true;
+    return estimated;
+}
+
+/**
+ * @brief Writes a block-level motion mask
+ */
+int BlockMotionEstimator::blockMask(int sad_threshold, uint8_t* dst, size_t stride) const {
+    int moving = 0;
+    for (int by = 0; by < blocks_y_; ++by) {
+        const MotionVector* row = field_.data() + static_cast<size_t>(by) * blocks_x_;
+        uint8_t* out = dst + by * stride;
+        for (int bx = 0; bx < blocks_x_; ++bx) {
+            bool set = row[bx].zero_sad > sad_threshold;
+            out[bx] = set ? 255 : 0;
+            moving += set;
+        }
+    }
+    return moving;
+}
+
+/**
+ * @brief Estimates block rows [by0, by1)
+ */
+void BlockMotionEstimator::estimateRows(int by0, int by1) {
+    for (int by = by0; by < by1; ++by) {
+        for (int bx = 0; bx < blocks_x_; ++bx) {
+            field_[static_cast<size_t>(by) * blocks_x_ + bx] = searchBlock(bx, by);
+        }
+    }
+}
+
+/**
+ * @brief Predictor-seeded diamond search for one block
+ *
+ * Predictors are limited to the left neighbour of the current field and the
+ * previous field so that block rows can be estimated independently.
+ */
+MotionVector BlockMotionEstimator::searchBlock(int bx, int by) const {
+    const int x = bx * kBlockSize;
+    const int y = by * kBlockSize;
+
+    MotionVector best;
+    best.zero_sad = static_cast<uint16_t>(blockSad(x, y, 0, 0));
+    best.sad = best.zero_sad;
+    if (best.zero_sad <= kStaticSad) {
+        return best;
+    }
+
+    auto tryVector = [&](int vx, int vy) {
+        if ((vx == best.dx && vy == best.dy) || !validVector(x, y, vx, vy)) {
+            return false;
+        }
+        uint32_t sad = blockSad(x, y, vx, vy);
+        if (sad < best.sad) {
+            best.dx = static_cast<int16_t>(vx);
+            best.dy = static_cast<int16_t>(vy);
+            best.sad = static_cast<uint16_t>(sad);
+            return true;
+        }
+        return false;
+    };
+
+    // Predictors
+    auto previousAt = [&](int px, int py) -> const MotionVector* {
+        if (px < 0 || py < 0 || px >= blocks_x_ || py >= blocks_y_) {
+            return nullptr;
+        }
+        return &previous_field_[static_cast<size_t>(py) * blocks_x_ + px];
+    };
+    if (bx > 0) {
+        const MotionVector& left = field_[static_cast<size_t>(by) * blocks_x_ + bx - 1];
+        tryVector(left.dx, left.dy);
+    }
+    const int neighbours[5][2] = {{0, 0}, {0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+    for (const auto& offset : neighbours) {
+        if (const MotionVector* p = previousAt(bx + offset[0], by + offset[1])) {
+            tryVector(p->dx, p->dy);
+        }
+    }
+
+    // Large diamond until the centre wins, then one small diamond step
+    for (int step = 0; step < range_; ++step) {
+        int cx = best.dx, cy = best.dy;
+        bool moved = false;
+        for (const auto& d : kLargeDiamond) {
+            moved |= tryVector(cx + d[0], cy + d[1]);
+        }
+        if (!moved) {
+            break;
+        }
+    }
+    int cx = best.dx, cy = best.dy;
+    for (const auto& d : kSmallDiamond) {
+        tryVector(cx + d[0], cy + d[1]);
+    }
+    return best;
+}
+
+/**
+ * @brief SAD of a 16x16 block against the displaced previous block
+ */
+uint32_t BlockMotionEstimator::blockSad(int x, int y, int vx, int vy) const {
+    const uint8_t* cur = frame_ + y * stride_ + x;
+    const uint8_t* ref = previous_.data() + static_cast<size_t>(y - vy) * width_ + (x - vx);
+
+#ifdef BLOCK_MOTION_SSE2
+    __m128i acc = _mm_setzero_si128();
+    for (int r = 0; r < kBlockSize; ++r) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + r * stride_));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ref + r * width_));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(a, b));
+    }
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(acc) +
+                                 _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#else
+    uint32_t sad = 0;
+    for (int r = 0; r < kBlockSize; ++r) {
+        for (int c = 0; c < kBlockSize; ++c) {
+            sad += std::abs(cur[r * stride_ + c] - ref[r * width_ + c]);
+        }
+    }
+    return sad;
+#endif
+}
+
+/**
+ * @brief Checks the search range and that the reference block is inside the frame
+ */
+bool BlockMotionEstimator::validVector(int x, int y, int vx, int vy) const {
+    if (std::abs(vx) > range_ || std::abs(vy) > range_) {
+        return false;
+    }
+    int rx = x - vx;
+    int ry = y - vy;
+    return rx >= 0 && ry >= 0 && rx + kBlockSize <= width_ && ry + kBlockSize <= height_;
+}
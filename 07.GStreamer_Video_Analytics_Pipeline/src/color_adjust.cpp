@@ -0,0 +1,276 @@
+/**
+ * @file color_adjust.cpp
+ * @brief LUT-based colour adjustment implementation
+ *
+ * With du = U - 128, dv = V - 128, s the saturation and h the hue:
+ *
+ *   U' = 128 + (a * du - b * dv + 2048) >> 12
+ *   V' = 128 + (b * du + a * dv + 2048) >> 12,   a = s cos h, b = s sin h (Q12)
+ *
+ * (du, dv) pairs are interleaved into 16-bit lanes so each output is a
+ * single _mm_madd_epi16; the SSE2 and scalar paths are bit-exact.
+ */
+
+#include "color_adjust.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COLOR_ADJUST_SSE2 1
+#endif
+
+namespace {
+
+constexpr int kRound = 1 << (ColorAdjuster::kChromaShift - 1);
+
+inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(std::min(255, std::max(0, value)));
+}
+
+/**
+ * @brief Scalar chroma transform of one (U, V) pair
+ */
+inline void rotatePair(int scale, int rotate, uint8_t& u, uint8_t& v) {
+    int du = u - 128;
+    int dv = v - 128;
+    u = clampByte(128 + ((scale * du - rotate * dv + kRound) >> ColorAdjuster::kChromaShift));
+    v = clampByte(128 + ((rotate * du + scale * dv + kRound) >> ColorAdjuster::kChromaShift));
+}
+
+#ifdef COLOR_ADJUST_SSE2
+/**
+ * @brief Transforms four interleaved (du, dv) pairs into 32-bit U' and V'
+ */
+inline void rotateLanes(__m128i pairs, __m128i coef_u, __m128i coef_v,
+                        __m128i& u, __m128i& v) {
+    const __m128i round = _mm_set1_epi32(kRound);
+    u = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(pairs, coef_u), round), ColorAdjuster::kChromaShift);
+    v = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(pairs, coef_v), round), ColorAdjuster::kChromaShift);
+}
+#endif
+
+} // namespace
+
+/**
+ * @brief Constructor
+ */
+ColorAdjuster::ColorAdjuster() {
+    setParams(0.0, 1.0, 1.0, 0.0);
+}
+
+/**
+ * @brief Rebuilds and publishes the tables
+ */
+void ColorAdjuster::setParams(double brightness, double contrast, double saturation, double hue) {
+    auto tables = std::make_shared<ColorTables>();
+
+    tables->luma_identity = true;
+    for (int i = 0; i < 256; ++i) {
+        long value = std::lround((i - 128) * contrast + 128.0 + brightness);
+        tables->luma[i] = static_cast<uint8_t>(std::clamp(value, 0L, 255L));
+        tables->luma_identity = tables->luma_identity && tables->luma[i] == i;
+    }
+
+    // Q12 coefficients stay inside int16 and the madd sums inside int32
+    double s = std::clamp(saturation, 0.0, 4.0);
+    double radians = hue * M_PI / 180.0;
+    tables->uv_scale = static_cast<int16_t>(std::lround(s * std::cos(radians) * (1 << kChromaShift)));
+    tables->uv_rotate = static_cast<int16_t>(std::lround(s * std::sin(radians) * (1 << kChromaShift)));
+    tables->chroma_identity = tables->uv_scale == (1 << kChromaShift) && tables->uv_rotate == 0;
+
+    std::atomic_store(&tables_, std::shared_ptr<const ColorTables>(std::move(tables)));
+}
+
+/**
+ * @brief Returns true if the current tables change nothing
+ */
+bool ColorAdjuster::isIdentity() const {
+    auto current = tables();
+    return current->luma_identity && current->chroma_identity;
+}
+
+/**
+ * @brief Restarts the band pool if the requested thread count changed
+ */
+void ColorAdjuster::syncThreads() {
+    int threads = threads_.load(std::memory_order_relaxed);
+    if (threads != pool_threads_) {
+        pool_.start(threads);
+        pool_threads_ = threads;
+    }
+}
+
+/**
+ * @brief Adjusts a planar 4:2:0 frame in place
+ *
+ * Bands are cut on chroma rows; each band also maps the two luma rows that
+ * share them, so every row is touched once while it is in cache.
+ */
+void ColorAdjuster::applyPlanar(uint8_t* y, int y_stride, uint8_t* u, int u_stride,
+                                uint8_t* v, int v_stride, int width, int height) {
+    auto current = tables();
+    if (current->luma_identity && current->chroma_identity) {
+        return;
+    }
+    syncThreads();
+
+    const ColorTables& t = *current;
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_rows = (height + 1) / 2;
+
+    pool_.run(chroma_rows, [&](int begin, int end) {
+        for (int row = begin; row < end; ++row) {
+            if (!t.luma_identity) {
+                int last = std::min(2 * row + 2, height);
+                for (int luma_row = 2 * row; luma_row < last; ++luma_row) {
+                    mapLuma(t.luma, y + static_cast<size_t>(luma_row) * y_stride, width);
+                }
+            }
+            if (!t.chroma_identity) {
+                rotatePlanar(t.uv_scale, t.uv_rotate,
+                             u + static_cast<size_t>(row) * u_stride,
+                             v + static_cast<size_t>(row) * v_stride, chroma_width);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Adjusts a semi-planar 4:2:0 frame in place
+ */
+void ColorAdjuster::applySemiPlanar(uint8_t* y, int y_stride, uint8_t* uv, int uv_stride,
+                                    int width, int height, bool vu_order) {
+    auto current = tables();
+    if (current->luma_identity && current->chroma_identity) {
+        return;
+    }
+    syncThreads();
+
+    const ColorTables& t = *current;
+    const int pairs = (width + 1) / 2;
+    const int chroma_rows = (height + 1) / 2;
+    // With V first, rotating by -hue gives the same result as swapping lanes
+    const int rotate = vu_order ? -t.uv_rotate : t.uv_rotate;
+
+    pool_.run(chroma_rows, [&](int begin, int end) {
+        for (int row = begin; row < end; ++row) {
+            if (!t.luma_identity) {
+                int last = std::min(2 * row + 2, height);
+                for (int luma_row = 2 * row; luma_row < last; ++luma_row) {
+                    mapLuma(t.luma, y + static_cast<size_t>(luma_row) * y_stride, width);
+                }
+            }
+            if (!t.chroma_identity) {
+                rotateInterleaved(t.uv_scale, rotate, uv + static_cast<size_t>(row) * uv_stride, pairs);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Applies the luma table to every byte of a packed frame
+ */
+void ColorAdjuster::applyPacked(uint8_t* data, int stride, int row_bytes, int height) {
+    auto current = tables();
+    if (current->luma_identity) {
+        return;
+    }
+    syncThreads();
+
+    const uint8_t* lut = current->luma;
+    pool_.run(height, [&](int begin, int end) {
+        for (int row = begin; row < end; ++row) {
+            mapLuma(lut, data + static_cast<size_t>(row) * stride, row_bytes);
+        }
+    });
+}
+
+/**
+ * @brief Maps one row through the luma table
+ */
+void ColorAdjuster::mapLuma(const uint8_t* lut, uint8_t* row, int width) {
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        uint8_t p0 = lut[row[x]];
+        uint8_t p1 = lut[row[x + 1]];
+        uint8_t p2 = lut[row[x + 2]];
+        uint8_t p3 = lut[row[x + 3]];
+        row[x] = p0;
+        row[x + 1] = p1;
+        row[x + 2] = p2;
+        row[x + 3] = p3;
+    }
+    for (; x < width; ++x) {
+        row[x] = lut[row[x]];
+    }
+}
+
+/**
+ * @brief Rotates/scales one row of planar chroma
+ */
+void ColorAdjuster::rotatePlanar(int scale, int rotate, uint8_t* u, uint8_t* v, int width) {
+    int x = 0;
+#ifdef COLOR_ADJUST_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    // Lanes hold (du, dv) pairs: U' = a*du - b*dv, V' = b*du + a*dv
+    const __m128i coef_u = _mm_set_epi16(-rotate, scale, -rotate, scale, -rotate, scale, -rotate, scale);
+    const __m128i coef_v = _mm_set_epi16(scale, rotate, scale, rotate, scale, rotate, scale, rotate);
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i u8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+        __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x));
+        __m128i u16[2];
+        __m128i v16[2];
+        for (int half = 0; half < 2; ++half) {
+            __m128i du = half ? _mm_unpackhi_epi8(u8, zero) : _mm_unpacklo_epi8(u8, zero);
+            __m128i dv = half ? _mm_unpackhi_epi8(v8, zero) : _mm_unpacklo_epi8(v8, zero);
+            du = _mm_sub_epi16(du, bias);
+            dv = _mm_sub_epi16(dv, bias);
+            __m128i u_lo, v_lo, u_hi, v_hi;
+            rotateLanes(_mm_unpacklo_epi16(du, dv), coef_u, coef_v, u_lo, v_lo);
+            rotateLanes(_mm_unpackhi_epi16(du, dv), coef_u, coef_v, u_hi, v_hi);
+            u16[half] = _mm_add_epi16(_mm_packs_epi32(u_lo, u_hi), bias);
+            v16[half] = _mm_add_epi16(_mm_packs_epi32(v_lo, v_hi), bias);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(u + x), _mm_packus_epi16(u16[0], u16[1]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x), _mm_packus_epi16(v16[0], v16[1]));
+    }
+#endif
+    for (; x < width; ++x) {
+        rotatePair(scale, rotate, u[x], v[x]);
+    }
+}
+
+/**
+ * @brief Rotates/scales one row of interleaved chroma
+ */
+void ColorAdjuster::rotateInterleaved(int scale, int rotate, uint8_t* uv, int pairs) {
+    int i = 0;
+#ifdef COLOR_ADJUST_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i coef_u = _mm_set_epi16(-rotate, scale, -rotate, scale, -rotate, scale, -rotate, scale);
+    const __m128i coef_v = _mm_set_epi16(scale, rotate, scale, rotate, scale, rotate, scale, rotate);
+
+    for (; i + 8 <= pairs; i += 8) {
+        __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + 2 * i));
+        __m128i out16[2];
+        for (int half = 0; half < 2; ++half) {
+            // Already (du, dv) interleaved after widening
+            __m128i lanes = half ? _mm_unpackhi_epi8(src, zero) : _mm_unpacklo_epi8(src, zero);
+            lanes = _mm_sub_epi16(lanes, bias);
+            __m128i u32, v32;
+            rotateLanes(lanes, coef_u, coef_v, u32, v32);
+            __m128i first = _mm_unpacklo_epi32(u32, v32);
+            __m128i second = _mm_unpackhi_epi32(u32, v32);
+            out16[half] = _mm_add_epi16(_mm_packs_epi32(first, second), bias);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * i), _mm_packus_epi16(out16[0], out16[1]));
+    }
+#endif
+    for (; i < pairs; ++i) {
+        rotatePair(scale, rotate, uv[2 * i], uv[2 * i + 1]);
+    }
+}
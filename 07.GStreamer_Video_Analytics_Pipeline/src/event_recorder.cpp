@@ -0,0 +1,429 @@
+/**
+ * @file event_recorder.cpp
+ * @brief Motion-triggered pre-event recording implementation
+ */
+
+#include "event_recorder.h"
+#include <gst/app/gstappsrc.h>
+#include <iostream>
+#include <ctime>
+
+namespace {
+
+/**
+ * @brief Expands the strftime pattern with the local time
+ */
+std::string eventFileName(const std::string& pattern) {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char name[512];
+    if (std::strftime(name, sizeof(name), pattern.c_str(), &local) == 0) {
+        return pattern;
+    }
+    return name;
+}
+
+/**
+ * @brief Converts seconds to GstClockTime
+ */
+GstClockTime toClockTime(double seconds) {
+    return static_cast<GstClockTime>(seconds * GST_SECOND);
+}
+
+} // namespace
+
+/**
+ * @brief Constructor
+ */
+EventRecorder::EventRecorder(const EventRecordingParams& params)
+    : params_(params),
+      ring_(toClockTime(params.pre_roll), params.ring_byte_budget) {
+}
+
+/**
+ * @brief Destructor
+ */
+EventRecorder::~EventRecorder() {
+    flush();
+}
+
+/**
+ * @brief Creates the appsink that ends the encode branch
+ */
+GstElement* EventRecorder::createSink() {
+    GstElement* sink = gst_element_factory_make("appsink", "event_sink");
+    if (!sink) {
+        std::cerr << "[EventRecorder] Failed to create appsink!" << std::endl;
+        return nullptr;
+    }
+
+    GstCaps* caps = gst_caps_from_string("video/x-h264, stream-format=avc, alignment=au");
+    g_object_set(sink,
+        "caps", caps,
+        "sync", FALSE,      // Encoded data is only buffered, never rendered
+        "async", FALSE,
+        nullptr);
+    gst_caps_unref(caps);
+
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = onNewSample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, this, nullptr);
+    return sink;
+}
+
+/**
+ * @brief Starts or extends a recording
+ */
+void EventRecorder::trigger(guint64 timestamp) {
+    trigger_pts_.store(timestamp, std::memory_order_relaxed);
+    triggered_.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief appsink new-sample callback
+ */
+GstFlowReturn EventRecorder::onNewSample(GstAppSink* sink, gpointer user_data) {
+    EventRecorder* recorder = static_cast<EventRecorder*>(user_data);
+
+    GstSample* sample = gst_app_sink_pull_sample(sink);
+    if (!sample) {
+        return GST_FLOW_EOS;
+    }
+
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    if (buffer) {
+        EncodedUnit unit;
+        unit.buffer = std::shared_ptr<GstBuffer>(gst_buffer_ref(buffer),
+                                                 [](GstBuffer* b) { gst_buffer_unref(b); });
+        unit.pts = GST_BUFFER_PTS(buffer);
+        unit.size = gst_buffer_get_size(buffer);
+        unit.keyframe = !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+        recorder->handleUnit(std::move(unit), gst_sample_get_caps(sample));
+    }
+
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+/**
+ * @brief Routes one unit to the ring and/or the open file
+ */
+void EventRecorder::handleUnit(EncodedUnit unit, GstCaps* caps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (triggered_.exchange(false, std::memory_order_acquire)) {
+        GstClockTime at = trigger_pts_.load(std::memory_order_relaxed);
+        if (!GST_CLOCK_TIME_IS_VALID(at)) {
+            at = unit.pts;
+        }
+        GstClockTime until = at + toClockTime(params_.post_roll);
+        if (!file_ || until > stop_after_) {
+            stop_after_ = until;
+        }
+
+        // A file must start at a keyframe: wait for one if the ring is empty
+        if (!file_ && (ring_.size() > 0 || unit.keyframe)) {
+            startFile(caps);
+        } else if (!file_) {
+            triggered_.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // The ring keeps filling while recording so a later event has pre-roll
+    ring_.push(unit);
+    ring_bytes_metric_.set(static_cast<double>(ring_.bytes()));
+    ring_seconds_metric_.set(static_cast<double>(ring_.duration()) / GST_SECOND);
+    budget_evictions_.store(ring_.budgetEvictions(), std::memory_order_relaxed);
+
+    if (!file_) {
+        return;
+    }
+
+    // Stop on a keyframe so the next file starts cleanly
+    if (unit.keyframe && GST_CLOCK_TIME_IS_VALID(unit.pts) && unit.pts > stop_after_) {
+        closeWriter();
+        return;
+    }
+    writeUnit(unit);
+}
+
+/**
+ * @brief Starts a file with the ring as pre-roll
+ *
+ * Creating the pipeline and opening the file can take a while, so it
+ * happens on the finisher thread; units arriving meanwhile are queued.
+ */
+void EventRecorder::startFile(GstCaps* caps) {
+    auto file = std::make_shared<EventFile>();
+    file->location = eventFileName(params_.location_pattern);
+    file->caps = gst_caps_ref(caps);
+    // Pre-roll: whole GOPs, starting at a keyframe
+    file->pending = ring_.drain();
+
+    file_ = file;
+    events_metric_.inc();
+    recording_metric_.set(1);
+    post([this, file]() { openFile(file); });
+}
+
+/**
+ * @brief Builds and starts the writer pipeline, then pushes the queued units
+ */
+void EventRecorder::openFile(const std::shared_ptr<EventFile>& file) {
+    GstElement* pipeline = gst_pipeline_new("event-writer");
+    GstElement* src = gst_element_factory_make("appsrc", "event_src");
+    GstElement* mux = gst_element_factory_make("mp4mux", nullptr);
+    GstElement* sink = gst_element_factory_make("filesink", nullptr);
+    bool started = pipeline && src && mux && sink;
+    if (!started) {
+        std::cerr << "[EventRecorder] Failed to create writer elements!" << std::endl;
+        for (GstElement* element : {pipeline, src, mux, sink}) {
+            if (element) {
+                gst_object_unref(element);
+            }
+        }
+        pipeline = nullptr;
+    } else {
+        // appsrc only enforces max-bytes when it blocks or leaks; blocking
+        // would stall the encode branch on a slow disk, so the oldest
+        // queued units are dropped instead and counted in pushUnit()
+        g_object_set(src,
+            "caps", file->caps,
+            "format", GST_FORMAT_TIME,
+            "block", FALSE,
+            "max-buffers", static_cast<guint64>(0),
+            "max-bytes", static_cast<guint64>(params_.ring_byte_budget),
+            "max-time", static_cast<guint64>(0),
+            "leaky-type", GST_APP_LEAKY_TYPE_DOWNSTREAM,
+            nullptr);
+        g_object_set(sink, "location", file->location.c_str(), nullptr);
+
+        gst_bin_add_many(GST_BIN(pipeline), src, mux, sink, nullptr);
+        if (!gst_element_link_many(src, mux, sink, nullptr) ||
+            gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+            std::cerr << "[EventRecorder] Failed to start writer for " << file->location << std::endl;
+            gst_element_set_state(pipeline, GST_STATE_NULL);
+            gst_object_unref(pipeline);
+            pipeline = nullptr;
+            started = false;
+        }
+    }
+    gst_caps_unref(file->caps);
+    file->caps = nullptr;
+
+    bool closed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started) {
+            file->pending.clear();
+            if (file_ == file) {
+                file_.reset();
+                recording_metric_.set(0);
+            }
+            return;
+        }
+        file->pipeline = pipeline;
+        file->src = src;
+        for (const EncodedUnit& unit : file->pending) {
+            pushUnit(*file, unit);
+        }
+        file->pending.clear();
+        file->open = true;
+        closed = file->closed;
+    }
+
+    std::cout << "[EventRecorder] Recording event: " << file->location << std::endl;
+    if (closed) {
+        // Ended before the pipeline was up: finish it here, in order
+        gst_app_src_end_of_stream(GST_APP_SRC(src));
+        finishFile(*file);
+    }
+}
+
+/**
+ * @brief Queues or pushes one unit to the current file
+ */
+void EventRecorder::writeUnit(const EncodedUnit& unit) {
+    if (!file_->open) {
+        file_->pending.push_back(unit);
+        return;
+    }
+    pushUnit(*file_, unit);
+}
+
+/**
+ * @brief Pushes one unit to an open file with rebased timestamps
+ *
+ * PTS and DTS move by the same offset, the first unit's DTS: its DTS
+ * becomes 0 and its PTS keeps the reorder delay above it. DTS only grows,
+ * so none is clamped and the PTS-DTS spacing B-frames need survives.
+ */
+void EventRecorder::pushUnit(EventFile& file, const EncodedUnit& unit) {
+    // Metadata copy only; the encoded memory is shared with the ring
+    GstBuffer* out = gst_buffer_copy(unit.buffer.get());
+    GstClockTime pts = GST_BUFFER_PTS(out);
+    GstClockTime dts = GST_BUFFER_DTS(out);
+    if (!GST_CLOCK_TIME_IS_VALID(file.base)) {
+        file.base = GST_CLOCK_TIME_IS_VALID(dts) && (!GST_CLOCK_TIME_IS_VALID(pts) || dts < pts) ? dts : pts;
+    }
+    if (GST_CLOCK_TIME_IS_VALID(file.base)) {
+        // Only leading frames of an open GOP can show before the keyframe
+        if (GST_CLOCK_TIME_IS_VALID(pts)) {
+            GST_BUFFER_PTS(out) = pts > file.base ? pts - file.base : 0;
+        }
+        if (GST_CLOCK_TIME_IS_VALID(dts)) {
+            GST_BUFFER_DTS(out) = dts >= file.base ? dts - file.base : GST_CLOCK_TIME_NONE;
+        }
+    }
+
+    gst_app_src_push_buffer(GST_APP_SRC(file.src), out);
+    units_metric_.inc();
+    bytes_metric_.inc(unit.size);
+
+    // Units leak out of the appsrc queue only on a push
+    guint64 dropped = 0;
+    g_object_get(file.src, "dropped", &dropped, nullptr);
+    if (dropped > file.dropped) {
+        dropped_metric_.inc(dropped - file.dropped);
+        file.dropped = dropped;
+    }
+}
+
+/**
+ * @brief Ends the current file
+ *
+ * mp4mux writes the index on EOS; waiting for it here would stall the
+ * encode branch, so the finisher thread waits and tears the writer down.
+ * A file whose pipeline is still starting is finished by openFile().
+ */
+void EventRecorder::closeWriter() {
+    std::shared_ptr<EventFile> file = std::move(file_);
+    recording_metric_.set(0);
+
+    file->closed = true;
+    if (file->open) {
+        gst_app_src_end_of_stream(GST_APP_SRC(file->src));
+        post([file]() { finishFile(*file); });
+    }
+}
+
+/**
+ * @brief Waits for the writer's EOS and tears it down
+ */
+void EventRecorder::finishFile(EventFile& file) {
+    GstBus* bus = gst_element_get_bus(file.pipeline);
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, 10 * GST_SECOND,
+        static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    if (!msg || GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        std::cerr << "[EventRecorder] Event file may be incomplete: " << file.location << std::endl;
+    } else {
+        std::cout << "[EventRecorder] Event saved: " << file.location << std::endl;
+    }
+    if (msg) {
+        gst_message_unref(msg);
+    }
+    gst_object_unref(bus);
+    gst_element_set_state(file.pipeline, GST_STATE_NULL);
+    gst_object_unref(file.pipeline);
+    file.pipeline = nullptr;
+    file.src = nullptr;
+}
+
+/**
+ * @brief Queues a task for the finisher thread
+ */
+void EventRecorder::post(std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(finisher_mutex_);
+    finisher_tasks_.push_back(std::move(task));
+    if (!finisher_.joinable()) {
+        finisher_stop_ = false;
+        finisher_ = std::thread(&EventRecorder::finisherLoop, this);
+    }
+    finisher_cv_.notify_one();
+}
+
+/**
+ * @brief Finisher thread: runs queued tasks in order
+ */
+void EventRecorder::finisherLoop() {
+    std::unique_lock<std::mutex> lock(finisher_mutex_);
+    for (;;) {
+        finisher_cv_.wait(lock, [this]() { return finisher_stop_ || !finisher_tasks_.empty(); });
+        if (finisher_tasks_.empty()) {
+            return;
+        }
+        std::function<void()> task = std::move(finisher_tasks_.front());
+        finisher_tasks_.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Runs the queued tasks to the end and joins the finisher thread
+ */
+void EventRecorder::joinFinisher() {
+    {
+        std::lock_guard<std::mutex> lock(finisher_mutex_);
+        finisher_stop_ = true;
+    }
+    finisher_cv_.notify_one();
+    if (finisher_.joinable()) {
+        finisher_.join();
+    }
+}
+
+/**
+ * @brief Closes an open file
+ */
+void EventRecorder::flush() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_) {
+            closeWriter();
+        }
+        ring_.clear();
+        triggered_ = false;
+    }
+    joinFinisher();
+}
+
+/**
+ * @brief Returns statistics
+ */
+EventRecorderStats EventRecorder::getStats() const {
+    EventRecorderStats stats;
+    stats.events = events_metric_.value();
+    stats.units_written = units_metric_.value();
+    stats.bytes_written = bytes_metric_.value();
+    stats.units_dropped = dropped_metric_.value();
+    stats.budget_evictions = budget_evictions_.load(std::memory_order_relaxed);
+    stats.ring_bytes = static_cast<size_t>(ring_bytes_metric_.value());
+    stats.ring_seconds = ring_seconds_metric_.value();
+    stats.recording = recording_metric_.value() > 0;
+    if (stats.recording) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_) {
+            stats.current_file = file_->location;
+        }
+    }
+    return stats;
+}
+
+/**
+ * @brief Exports the recorder metrics
+ */
+void EventRecorder::registerMetrics(MetricsRegistry& registry) {
+    registry.addCounter("event_recorder_events_total", "Event files started", events_metric_);
+    registry.addCounter("event_recorder_written_units_total", "Encoded access units written to event files",
+                        units_metric_);
+    registry.addCounter("event_recorder_written_bytes_total", "Encoded bytes written to event files",
+                        bytes_metric_);
+    registry.addCounter("event_recorder_dropped_units_total",
+                        "Encoded access units dropped because the writer fell behind", dropped_metric_);
+    registry.addGauge("event_recorder_ring_bytes", "Encoded pre-roll held in memory", ring_bytes_metric_);
+    registry.addGauge("event_recorder_ring_seconds", "Pre-roll duration held in memory", ring_seconds_metric_);
+    registry.addGauge("event_recorder_recording", "1 while an event file is open", recording_metric_);
+}
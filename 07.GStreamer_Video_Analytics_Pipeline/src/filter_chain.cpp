@@ -0,0 +1,620 @@
+/**
+ * @file filter_chain.cpp
+ * @brief Filter chain compilation and tiled execution
+ *
+ * Geometry is tracked as a 2x3 affine matrix from the op's input to its
+ * output (pixel centres at integer coordinates, as warpAffine expects).
+ * Colour stages are 3x4 matrices on BGR: colour adjust is the YUV transform
+ * of ColorAdjuster (contrast on Y, saturation/hue rotation of U/V) moved to
+ * BGR, grayscale drops U/V. Fused colour stages saturate once, at the end.
+ */
+
+#include "filter_chain.h"
+#include "video_processor.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief Affine map and output size of a geometric stage
+ * @param width Frame width (updated)
+ * @param height Frame height (updated)
+ * @param m Input -> output matrix (identity if the stage is a no-op)
+ * @return false if the stage is not geometric
+ */
+bool stageAffine(FilterStage stage, const ProcessingParams& params,
+                 int& width, int& height, double m[6]) {
+    const double identity[6] = {1, 0, 0, 0, 1, 0};
+    std::copy(identity, identity + 6, m);
+
+    switch (stage) {
+        case FilterStage::CROP:
+            if (params.crop_width > 0 && params.crop_height > 0 && width >= 2 && height >= 2) {
+                int x = std::clamp(params.crop_x, 0, width - 2);
+                int y = std::clamp(params.crop_y, 0, height - 2);
+                int w = std::max(2, std::min(params.crop_width, width - x) & ~1);
+                int h = std::max(2, std::min(params.crop_height, height - y) & ~1);
+                m[2] = -x;
+                m[5] = -y;
+                width = w;
+                height = h;
+            }
+            return true;
+
+        case FilterStage::ROTATE:
+            if (params.rotation % 360 != 0) {
+                // Same matrix as cv::getRotationMatrix2D around the centre
+                double radians = params.rotation * M_PI / 180.0;
+                double alpha = std::cos(radians);
+                double beta = std::sin(radians);
+                // Exact zeros keep multiples of 90 degrees axis-aligned
+                alpha = std::abs(alpha) < 1e-12 ? 0.0 : alpha;
+                beta = std::abs(beta) < 1e-12 ? 0.0 : beta;
+                double cx = width / 2.0;
+                double cy = height / 2.0;
+                double r[6] = {alpha, beta, (1 - alpha) * cx - beta * cy,
+                               -beta, alpha, beta * cx + (1 - alpha) * cy};
+                std::copy(r, r + 6, m);
+            }
+            return true;
+
+        case FilterStage::FLIP:
+            if (params.flip_horizontal) {
+                m[0] = -1;
+                m[2] = width - 1;
+            }
+            if (params.flip_vertical) {
+                m[4] = -1;
+                m[5] = height - 1;
+            }
+            return true;
+
+        case FilterStage::SCALE:
+            if (params.scale_width > 0 && params.scale_height > 0) {
+                int w = std::max(2, params.scale_width & ~1);
+                int h = std::max(2, params.scale_height & ~1);
+                double sx = static_cast<double>(w) / width;
+                double sy = static_cast<double>(h) / height;
+                // Pixel centres: x' + 0.5 = (x + 0.5) * sx
+                m[0] = sx;
+                m[2] = 0.5 * sx - 0.5;
+                m[4] = sy;
+                m[5] = 0.5 * sy - 0.5;
+                width = w;
+                height = h;
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+#ifdef HAVE_OPENCV
+/**
+ * @brief Returns a∘b (b applied first) for 2x3 affine matrices
+ */
+void composeAffine(const double a[6], const double b[6], double r[6]) {
+    double t[6] = {
+        a[0] * b[0] + a[1] * b[3], a[0] * b[1] + a[1] * b[4], a[0] * b[2] + a[1] * b[5] + a[2],
+        a[3] * b[0] + a[4] * b[3], a[3] * b[1] + a[4] * b[4], a[3] * b[2] + a[4] * b[5] + a[5],
+    };
+    std::copy(t, t + 6, r);
+}
+
+/**
+ * @brief Inverts a 2x3 affine matrix
+ */
+void invertAffine(const double a[6], double r[6]) {
+    double det = a[0] * a[4] - a[1] * a[3];
+    r[0] = a[4] / det;
+    r[1] = -a[1] / det;
+    r[3] = -a[3] / det;
+    r[4] = a[0] / det;
+    r[2] = -(r[0] * a[2] + r[1] * a[5]);
+    r[5] = -(r[3] * a[2] + r[4] * a[5]);
+}
+
+/**
+ * @brief Returns true if the matrix has no rotation or shear
+ */
+bool axisAligned(const double m[6]) {
+    return m[1] == 0 && m[3] == 0;
+}
+
+/**
+ * @brief Bounding pixel rectangle of a rectangle mapped through an affine matrix
+ */
+cv::Rect mapRect(const double m[6], const cv::Rect& rect) {
+    double x0 = m[0] * rect.x + m[1] * rect.y + m[2];
+    double y0 = m[3] * rect.x + m[4] * rect.y + m[5];
+    double x1 = m[0] * (rect.x + rect.width - 1) + m[1] * (rect.y + rect.height - 1) + m[2];
+    double y1 = m[3] * (rect.x + rect.width - 1) + m[4] * (rect.y + rect.height - 1) + m[5];
+    int left = static_cast<int>(std::floor(std::min(x0, x1)));
+    int top = static_cast<int>(std::floor(std::min(y0, y1)));
+    int right = static_cast<int>(std::ceil(std::max(x0, x1)));
+    int bottom = static_cast<int>(std::ceil(std::max(y0, y1)));
+    return cv::Rect(left, top, right - left + 1, bottom - top + 1);
+}
+
+/**
+ * @brief 3x4 BGR matrix of a per-pixel stage
+ * @return false if the stage is not per-pixel
+ */
+bool stageColor(FilterStage stage, const ProcessingParams& params, double m[12]) {
+    if (stage != FilterStage::GRAYSCALE && stage != FilterStage::COLOR_ADJUST) {
+        return false;
+    }
+
+    // BGR -> (Y, Cb - 128, Cr - 128), BT.601 digital Cb/Cr like the planes
+    // ColorAdjuster rotates, so hue turns the same way on both paths
+    const double t[9] = {
+        0.114, 0.587, 0.299,
+        0.564 * (1 - 0.114), -0.564 * 0.587, -0.564 * 0.299,
+        -0.713 * 0.114, -0.713 * 0.587, 0.713 * (1 - 0.299),
+    };
+    double det = t[0] * (t[4] * t[8] - t[5] * t[7]) -
+                 t[1] * (t[3] * t[8] - t[5] * t[6]) +
+                 t[2] * (t[3] * t[7] - t[4] * t[6]);
+    const double inv[9] = {
+        (t[4] * t[8] - t[5] * t[7]) / det, (t[2] * t[7] - t[1] * t[8]) / det, (t[1] * t[5] - t[2] * t[4]) / det,
+        (t[5] * t[6] - t[3] * t[8]) / det, (t[0] * t[8] - t[2] * t[6]) / det, (t[2] * t[3] - t[0] * t[5]) / det,
+        (t[3] * t[7] - t[4] * t[6]) / det, (t[1] * t[6] - t[0] * t[7]) / det, (t[0] * t[4] - t[1] * t[3]) / det,
+    };
+
+    double gain = 1.0, a = 0.0, b = 0.0, offset = 0.0;
+    if (stage == FilterStage::COLOR_ADJUST) {
+        double s = std::clamp(params.saturation, 0.0, 4.0);
+        double radians = params.hue * M_PI / 180.0;
+        gain = params.contrast;
+        a = s * std::cos(radians);
+        b = s * std::sin(radians);
+        // Luma offset; a pure Y offset is the same offset on B, G and R
+        offset = 128.0 * (1.0 - gain) + params.brightness;
+    }
+    const double d[9] = {gain, 0, 0, 0, a, -b, 0, b, a};
+
+    double dt[9];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            dt[3 * i + j] = d[3 * i] * t[j] + d[3 * i + 1] * t[3 + j] + d[3 * i + 2] * t[6 + j];
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            m[4 * i + j] = inv[3 * i] * dt[j] + inv[3 * i + 1] * dt[3 + j] + inv[3 * i + 2] * dt[6 + j];
+        }
+        m[4 * i + 3] = offset;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns a∘b (b applied first) for 3x4 colour matrices
+ */
+void composeColor(const double a[12], const double b[12], double r[12]) {
+    double t[12];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            t[4 * i + j] = a[4 * i] * b[j] + a[4 * i + 1] * b[4 + j] + a[4 * i + 2] * b[8 + j];
+        }
+        t[4 * i + 3] += a[4 * i + 3];
+    }
+    std::copy(t, t + 12, r);
+}
+#endif // HAVE_OPENCV
+
+} // namespace
+
+/**
+ * @brief Returns the name of a stage
+ */
+const char* filterStageName(FilterStage stage) {
+    switch (stage) {
+        case FilterStage::CROP:         return "crop";
+        case FilterStage::ROTATE:       return "rotate";
+        case FilterStage::FLIP:         return "flip";
+        case FilterStage::SCALE:        return "scale";
+        case FilterStage::BLUR:         return "blur";
+        case FilterStage::SHARPEN:      return "sharpen";
+        case FilterStage::DENOISE:      return "denoise";
+        case FilterStage::EDGE_DETECT:  return "edge_detect";
+        case FilterStage::GRAYSCALE:    return "grayscale";
+        case FilterStage::COLOR_ADJUST: return "color_adjust";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Computes the frame size a chain produces
+ */
+void filterChainOutputSize(const ProcessingParams& params, int width, int height,
+                           int& out_width, int& out_height) {
+    double m[6];
+    for (FilterStage stage : params.filter_chain) {
+        stageAffine(stage, params, width, height, m);
+    }
+    out_width = width;
+    out_height = height;
+}
+
+#ifdef HAVE_OPENCV
+/**
+ * @brief Compiles params.filter_chain for an input size
+ *
+ * No-op stages (zero crop, rotation 0, ...) are dropped. A geometric stage
+ * is fused into the previous warp only when the result is the same as two
+ * passes: samples outside a crop must stay border, so the crop has to map
+ * back to an axis-aligned window of the warp's input. After a rotation only
+ * flips, which never sample outside the frame, are fused.
+ */
+void FilterChain::configure(const ProcessingParams& params, cv::Size input_size) {
+    ops_.clear();
+    input_size_ = input_size;
+    blur_kernel_ = params.blur_kernel_size | 1; // Must be odd
+    sharpen_strength_ = params.sharpen_strength;
+    denoise_strength_ = params.denoise_strength;
+    edge_threshold1_ = params.edge_threshold1;
+    edge_threshold2_ = params.edge_threshold2;
+
+    int width = input_size.width;
+    int height = input_size.height;
+    for (FilterStage stage : params.filter_chain) {
+        Op* last = ops_.empty() ? nullptr : &ops_.back();
+        const std::string name = filterStageName(stage);
+
+        double warp[6];
+        int stage_width = width;
+        int stage_height = height;
+        if (stageAffine(stage, params, stage_width, stage_height, warp)) {
+            bool identity = warp[0] == 1 && warp[1] == 0 && warp[2] == 0 &&
+                            warp[3] == 0 && warp[4] == 1 && warp[5] == 0 &&
+                            stage_width == width && stage_height == height;
+            if (identity) {
+                continue;
+            }
+            // Crop window in the stage's input coordinates
+            cv::Rect crop(static_cast<int>(-warp[2]), static_cast<int>(-warp[5]), stage_width, stage_height);
+            bool fuse = last && last->kind == Op::Kind::WARP &&
+                        (axisAligned(last->warp) || stage == FilterStage::FLIP);
+            if (fuse) {
+                if (stage == FilterStage::CROP) {
+                    double inverse[6];
+                    invertAffine(last->warp, inverse);
+                    last->window &= mapRect(inverse, crop);
+                }
+                composeAffine(warp, last->warp, last->warp);
+                // Border stays that of the first stage, so a rotation fused
+                // after a crop or scale does not blend the crop edge with black
+                last->name += "+" + name;
+            } else {
+                Op op{};
+                op.kind = Op::Kind::WARP;
+                op.name = name;
+                op.in_size = cv::Size(width, height);
+                std::copy(warp, warp + 6, op.warp);
+                op.window = stage == FilterStage::CROP ? crop : cv::Rect(0, 0, width, height);
+                // Rotation leaves black corners like the single-filter path;
+                // scaling replicates the edge instead of blending it with black
+                op.border = stage == FilterStage::ROTATE ? cv::BORDER_CONSTANT : cv::BORDER_REPLICATE;
+                ops_.push_back(op);
+            }
+            width = stage_width;
+            height = stage_height;
+            ops_.back().out_size = cv::Size(width, height);
+            continue;
+        }
+
+        double color[12];
+        if (stageColor(stage, params, color)) {
+            if (last && last->kind == Op::Kind::COLOR) {
+                double fused[12];
+                double previous[12];
+                std::copy(last->color, last->color + 12, previous);
+                composeColor(color, previous, fused);
+                std::copy(fused, fused + 12, last->color);
+                last->name += "+" + name;
+            } else {
+                Op op{};
+                op.kind = Op::Kind::COLOR;
+                op.name = name;
+                op.in_size = op.out_size = cv::Size(width, height);
+                std::copy(color, color + 12, op.color);
+                ops_.push_back(op);
+            }
+            continue;
+        }
+
+        Op op{};
+        op.kind = stage == FilterStage::EDGE_DETECT ? Op::Kind::FRAME : Op::Kind::NEIGHBOURHOOD;
+        op.name = name;
+        op.in_size = op.out_size = cv::Size(width, height);
+        op.filter = stage;
+        switch (stage) {
+            case FilterStage::BLUR:    op.halo = blur_kernel_ / 2; break;
+            case FilterStage::SHARPEN: op.halo = 1; break;
+            case FilterStage::DENOISE: op.halo = 7 / 2 + 21 / 2; break; // Template + search window
+            default:                   op.halo = 0; break;
+        }
+        ops_.push_back(op);
+    }
+
+    for (Op& op : ops_) {
+        if (op.kind == Op::Kind::WARP) {
+            invertAffine(op.warp, op.inverse);
+            op.integer_shift = op.warp[0] == 1 && op.warp[1] == 0 && op.warp[3] == 0 && op.warp[4] == 1 &&
+                               op.warp[2] == std::floor(op.warp[2]) && op.warp[5] == std::floor(op.warp[5]);
+        }
+    }
+
+    output_size_ = cv::Size(width, height);
+    auto timings = std::make_shared<Timings>();
+    for (const Op& op : ops_) {
+        timings->names.push_back(op.name);
+    }
+    timings->op_ns.reset(new std::atomic<int64_t>[ops_.size()]());
+    std::atomic_store(&timings_, timings);
+    segment_buffers_.resize(ops_.size());
+}
+
+/**
+ * @brief Sets the number of tile bands
+ */
+void FilterChain::setThreads(int threads) {
+    threads_ = threads;
+}
+
+/**
+ * @brief Runs the chain
+ *
+ * Whole-frame ops split the chain into segments; each segment is tiled on its
+ * own and hands a full frame to the next.
+ */
+void FilterChain::run(const cv::Mat& src, cv::Mat& dst) {
+    if (threads_ != pool_threads_) {
+        pool_.start(threads_);
+        pool_threads_ = threads_;
+    }
+    timings_->frames.fetch_add(1, std::memory_order_relaxed);
+
+    if (ops_.empty()) {
+        src.copyTo(dst);
+        return;
+    }
+
+    const cv::Mat* current = &src;
+    size_t begin = 0;
+    for (size_t i = 0; i <= ops_.size(); ++i) {
+        if (i < ops_.size() && ops_[i].kind != Op::Kind::FRAME) {
+            continue;
+        }
+        if (i > begin) {
+            cv::Mat& target = i == ops_.size() ? dst : segment_buffers_[i - 1];
+            target.create(ops_[i - 1].out_size, CV_8UC3);
+            runTiled(begin, i, *current, target);
+            current = &target;
+        }
+        if (i < ops_.size()) {
+            cv::Mat& target = i + 1 == ops_.size() ? dst : segment_buffers_[i];
+            auto start = std::chrono::steady_clock::now();
+            applyFilter(ops_[i], *current, target);
+            addTime(i, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start).count());
+            current = &target;
+        }
+        begin = i + 1;
+    }
+}
+
+/**
+ * @brief Runs ops [begin, end) over the whole frame in tiles
+ *
+ * Tiles are numbered in raster order, so each band gets a horizontal strip.
+ */
+void FilterChain::runTiled(size_t begin, size_t end, const cv::Mat& src, cv::Mat& dst) {
+    const int columns = (dst.cols + kTileWidth - 1) / kTileWidth;
+    const int rows = (dst.rows + kTileHeight - 1) / kTileHeight;
+
+    pool_.run(columns * rows, [&](int first, int last) {
+        std::vector<cv::Mat> scratch(end - begin);
+        for (int index = first; index < last; ++index) {
+            int x = (index % columns) * kTileWidth;
+            int y = (index / columns) * kTileHeight;
+            cv::Rect tile(x, y, std::min(kTileWidth, dst.cols - x), std::min(kTileHeight, dst.rows - y));
+            runTile(begin, end, src, dst, tile, scratch);
+        }
+    });
+}
+
+/**
+ * @brief Runs ops [begin, end) for one output tile
+ *
+ * rects[k] is the region op begin + k reads, rects[k + 1] the region it
+ * writes; the last op writes straight into the tile of dst when it can.
+ */
+void FilterChain::runTile(size_t begin, size_t end, const cv::Mat& src, cv::Mat& dst,
+                          const cv::Rect& tile, std::vector<cv::Mat>& scratch) {
+    const size_t count = end - begin;
+    std::vector<cv::Rect> rects(count + 1);
+    rects[count] = tile;
+    for (size_t k = count; k-- > 0;) {
+        rects[k] = inputRect(ops_[begin + k], rects[k + 1]);
+    }
+
+    cv::Mat current = rects[0].empty() ? cv::Mat() : src(rects[0]);
+    for (size_t k = 0; k < count; ++k) {
+        auto start = std::chrono::steady_clock::now();
+        const Op& op = ops_[begin + k];
+        const cv::Rect& in = rects[k];
+        const cv::Rect& out = rects[k + 1];
+        const bool last = k + 1 == count;
+
+        cv::Mat& buffer = scratch[k];
+        if (out.empty()) {
+            current = cv::Mat();
+            continue;
+        }
+        if (!last || op.kind == Op::Kind::NEIGHBOURHOOD) {
+            buffer.create(op.kind == Op::Kind::NEIGHBOURHOOD ? in.size() : out.size(), CV_8UC3);
+        }
+        cv::Mat target = last ? dst(tile) : buffer;
+
+        switch (op.kind) {
+            case Op::Kind::WARP:
+                if (in.empty()) {
+                    // Tile maps entirely outside the input
+                    target.setTo(cv::Scalar(0, 0, 0));
+                } else if (op.integer_shift && in.size() == out.size()) {
+                    current.copyTo(target);
+                } else {
+                    // Local matrix: tile origin -> 0, input region origin -> 0
+                    double local[6] = {
+                        op.warp[0], op.warp[1], op.warp[0] * in.x + op.warp[1] * in.y + op.warp[2] - out.x,
+                        op.warp[3], op.warp[4], op.warp[3] * in.x + op.warp[4] * in.y + op.warp[5] - out.y,
+                    };
+                    cv::warpAffine(current, target, cv::Mat(2, 3, CV_64F, local), out.size(),
+                                   cv::INTER_LINEAR, op.border, cv::Scalar());
+                }
+                current = target;
+                break;
+
+            case Op::Kind::COLOR:
+                cv::transform(current, target, cv::Mat(3, 4, CV_32F, const_cast<float*>(op.color)));
+                current = target;
+                break;
+
+            default:
+                // Filter the region with its halo, keep the part without it
+                applyFilter(op, current, buffer);
+                current = buffer(cv::Rect(out.x - in.x, out.y - in.y, out.width, out.height));
+                if (last) {
+                    current.copyTo(target);
+                }
+                break;
+        }
+
+        addTime(begin + k, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+/**
+ * @brief Input rectangle an op needs to produce an output rectangle
+ */
+cv::Rect FilterChain::inputRect(const Op& op, const cv::Rect& out) const {
+    const cv::Rect frame(0, 0, op.in_size.width, op.in_size.height);
+    if (out.empty()) {
+        return cv::Rect();
+    }
+
+    switch (op.kind) {
+        case Op::Kind::COLOR:
+            return out;
+
+        case Op::Kind::NEIGHBOURHOOD:
+            return cv::Rect(out.x - op.halo, out.y - op.halo,
+                            out.width + 2 * op.halo, out.height + 2 * op.halo) & frame;
+
+        case Op::Kind::WARP: {
+            if (op.integer_shift) {
+                return cv::Rect(out.x + static_cast<int>(op.inverse[2]),
+                                out.y + static_cast<int>(op.inverse[5]),
+                                out.width, out.height) & op.window;
+            }
+            // Bounding box of the mapped pixel centres plus the bilinear footprint
+            double min_x = 1e18, min_y = 1e18, max_x = -1e18, max_y = -1e18;
+            for (int corner = 0; corner < 4; ++corner) {
+                double x = out.x + (corner & 1 ? out.width - 1 : 0);
+                double y = out.y + (corner & 2 ? out.height - 1 : 0);
+                double sx = op.inverse[0] * x + op.inverse[1] * y + op.inverse[2];
+                double sy = op.inverse[3] * x + op.inverse[4] * y + op.inverse[5];
+                min_x = std::min(min_x, sx);
+                max_x = std::max(max_x, sx);
+                min_y = std::min(min_y, sy);
+                max_y = std::max(max_y, sy);
+            }
+            // Clamp first so far-off tiles cannot overflow int
+            auto clampCoord = [](double v, int limit) {
+                return static_cast<int>(std::clamp(v, -2.0, limit + 2.0));
+            };
+            int x0 = clampCoord(std::floor(min_x) - 1, frame.width);
+            int y0 = clampCoord(std::floor(min_y) - 1, frame.height);
+            int x1 = clampCoord(std::ceil(max_x) + 2, frame.width);
+            int y1 = clampCoord(std::ceil(max_y) + 2, frame.height);
+            // Samples outside the window are border, as after a separate crop
+            return cv::Rect(x0, y0, x1 - x0, y1 - y0) & op.window;
+        }
+
+        default:
+            return frame;
+    }
+}
+
+/**
+ * @brief Applies a neighbourhood or whole-frame filter
+ *
+ * Same kernels as the single-filter VideoProcessor paths.
+ */
+void FilterChain::applyFilter(const Op& op, const cv::Mat& src, cv::Mat& dst) {
+    switch (op.filter) {
+        case FilterStage::BLUR:
+            cv::GaussianBlur(src, dst, cv::Size(blur_kernel_, blur_kernel_), 0);
+            break;
+
+        case FilterStage::SHARPEN: {
+            float kernel[9] = {0, -1, 0,
+                               -1, static_cast<float>(5 + sharpen_strength_), -1,
+                               0, -1, 0};
+            cv::filter2D(src, dst, -1, cv::Mat(3, 3, CV_32F, kernel));
+            break;
+        }
+
+        case FilterStage::DENOISE:
+            cv::fastNlMeansDenoisingColored(src, dst, denoise_strength_, denoise_strength_, 7, 21);
+            break;
+
+        case FilterStage::EDGE_DETECT: {
+            // Whole frame, caller thread only
+            cv::cvtColor(src, gray_, cv::COLOR_BGR2GRAY);
+            cv::Canny(gray_, edges_, edge_threshold1_, edge_threshold2_);
+            dst.create(src.size(), src.type());
+            dst.setTo(cv::Scalar(0, 0, 0));
+            dst.setTo(cv::Scalar(0, 255, 0), edges_);
+            break;
+        }
+
+        default:
+            src.copyTo(dst);
+            break;
+    }
+}
+
+/**
+ * @brief Adds elapsed time to an op's counter
+ */
+void FilterChain::addTime(size_t op, int64_t ns) {
+    timings_->op_ns[op].fetch_add(ns, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the average time per compiled operation
+ */
+std::vector<StageTiming> FilterChain::timings() const {
+    std::vector<StageTiming> result;
+    std::shared_ptr<Timings> timings = std::atomic_load(&timings_);
+    if (!timings) {
+        return result;
+    }
+    uint64_t frames = timings->frames.load(std::memory_order_relaxed);
+    result.reserve(timings->names.size());
+    for (size_t i = 0; i < timings->names.size(); ++i) {
+        StageTiming timing;
+        timing.name = timings->names[i];
+        timing.avg_time = frames ? timings->op_ns[i].load(std::memory_order_relaxed) / 1e6 / frames : 0.0;
+        result.push_back(timing);
+    }
+    return result;
+}
+#endif // HAVE_OPENCV
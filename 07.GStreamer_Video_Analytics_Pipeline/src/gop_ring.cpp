@@ -0,0 +1,105 @@
+/**
+ * @file gop_ring.cpp
+ * @brief Keyframe-aligned encoded access unit ring implementation
+ */
+
+#include "gop_ring.h"
+
+/**
+ * @brief Constructor
+ */
+GopRing::GopRing(GstClockTime window, size_t byte_budget)
+    : window_(window), byte_budget_(byte_budget) {
+}
+
+/**
+ * @brief Changes the limits
+ */
+void GopRing::setLimits(GstClockTime window, size_t byte_budget) {
+    window_ = window;
+    byte_budget_ = byte_budget;
+}
+
+/**
+ * @brief Appends a unit and evicts old GOPs
+ */
+void GopRing::push(EncodedUnit unit) {
+    if (unit.keyframe) {
+        skip_to_keyframe_ = false;
+        gops_.push_back(Gop{0, 0, unit.pts});
+    } else if (skip_to_keyframe_) {
+        return;
+    }
+
+    gops_.back().units++;
+    gops_.back().bytes += unit.size;
+    bytes_ += unit.size;
+    GstClockTime newest = unit.pts;
+    units_.push_back(std::move(unit));
+
+    // Whole GOPs only: the ring must always start at a keyframe
+    while (gops_.size() > 1) {
+        bool over_budget = bytes_ > byte_budget_;
+        bool outside_window = GST_CLOCK_TIME_IS_VALID(newest) &&
+                              GST_CLOCK_TIME_IS_VALID(gops_[1].start) &&
+                              newest >= gops_[1].start + window_;
+        if (!over_budget && !outside_window) {
+            break;
+        }
+        budget_evictions_ += over_budget ? 1 : 0;
+        popGop();
+    }
+
+    // The current GOP alone exceeds the budget: it cannot be cut, drop it
+    if (bytes_ > byte_budget_) {
+        budget_evictions_++;
+        clear();
+    }
+}
+
+/**
+ * @brief Drops the oldest GOP
+ */
+void GopRing::popGop() {
+    const Gop& gop = gops_.front();
+    units_.erase(units_.begin(), units_.begin() + gop.units);
+    bytes_ -= gop.bytes;
+    gops_.pop_front();
+}
+
+/**
+ * @brief Removes and returns every unit
+ */
+std::vector<EncodedUnit> GopRing::drain() {
+    std::vector<EncodedUnit> result(std::make_move_iterator(units_.begin()),
+                                    std::make_move_iterator(units_.end()));
+    units_.clear();
+    gops_.clear();
+    bytes_ = 0;
+    // Following delta units still belong to the last GOP
+    if (!result.empty()) {
+        skip_to_keyframe_ = true;
+    }
+    return result;
+}
+
+/**
+ * @brief Removes every unit
+ */
+void GopRing::clear() {
+    units_.clear();
+    gops_.clear();
+    bytes_ = 0;
+    skip_to_keyframe_ = true;
+}
+
+/**
+ * @brief Returns the time span held
+ */
+GstClockTime GopRing::duration() const {
+    if (units_.empty() || !GST_CLOCK_TIME_IS_VALID(units_.front().pts) ||
+        !GST_CLOCK_TIME_IS_VALID(units_.back().pts)) {
+        return 0;
+    }
+    return units_.back().pts - units_.front().pts;
+}
@@ -6,6 +6,7 @@
  * the pipeline by processing command-line arguments.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -14,6 +15,7 @@
 #include <thread>
 #include <chrono>
 #include <iomanip>
+#include <sstream>
 #include <yaml-cpp/yaml.h>
 #include <gst/gst.h>
 
@@ -21,10 +23,14 @@
 #include "video_processor.h"
 #include "motion_detector.h"
 #include "rtsp_streamer.h"
+#include "stream_host.h"
 
 // Global pipeline manager (for signal handler)
 std::unique_ptr<PipelineManager> g_pipeline_manager;
 
+// Global stream host (multi-stream mode, for signal handler)
+std::unique_ptr<StreamHost> g_stream_host;
+
 /**
  * @brief Signal handler (SIGINT, SIGTERM)
  * @param signum Signal number
@@ -35,6 +41,9 @@ void signalHandler(int signum) {
     if (g_pipeline_manager && g_pipeline_manager->isRunning()) {
         g_pipeline_manager->stop();
     }
+    if (g_stream_host) {
+        g_stream_host->stop();
+    }
     
     // Exit
     std::exit(0);
@@ -47,17 +56,29 @@ void signalHandler(int signum) {
 void showUsage(const std::string& program_name) {
     std::cout << "Usage: " << program_name << " [OPTIONS]\n\n"
               << "Options:\n"
-              << "  -i, --input <source>      Video source (file/webcam/rtsp://...)\n"
+              << "  -i, --input <source>      Video source (file/webcam/test[:pattern]/rtsp://...)\n"
+              << "  --standby <source>        Pre-rolled failover source (same forms as --input)\n"
+              << "  --stall-timeout <ms>      Fail over when the input sends no frames (default: 5000, 0 = off)\n"
+              << "  --stream [id=]<source>    Add a stream to the multi-stream host (repeatable, replaces -i)\n"
+              << "  --threads <n>             Shared analysis workers for --stream (default: 0 = all cores)\n"
+              << "  --queue-depth <n>         Frames queued per stream before the oldest is dropped (default: 2)\n"
               << "  -o, --output <target>     Output target (display/file/rtsp://...)\n"
               << "  -c, --config <file>       Configuration file (YAML)\n"
               << "  --motion-detect           Enable motion detection\n"
               << "  --use-gpu                 Use GPU acceleration\n"
               << "  --record <file>           Record video\n"
+              << "  --record-events <pattern> Record motion events with pre-roll (strftime file pattern)\n"
+              << "  --pre-roll <seconds>      Event pre-roll kept in memory (default: 10)\n"
+              << "  --post-roll <seconds>     Recording after the last motion (default: 10)\n"
               << "  --width <width>           Video width (default: 1920)\n"
               << "  --height <height>         Video height (default: 1080)\n"
               << "  --fps <fps>               Frame rate (default: 30)\n"
               << "  --bitrate <bitrate>       Bit rate (default: 4000000)\n"
               << "  --rtsp-port <port>        RTSP server port (default: 8554)\n"
+              << "  --simulcast <list>        Extra RTSP rungs, e.g. low,high (mounts /live/low, /live/high;\n"
+              << "                            replaces output.rtsp.simulcast from the config)\n"
+              << "  --multicast <addr[:port]> Offer RTSP multicast, e.g. 239.255.0.1:5000\n"
+              << "  --metrics-port <port>     Prometheus /metrics port (default: off)\n"
               << "  -v, --verbose             Verbose output\n"
               << "  -h, --help                Show this help message\n\n"
               << "Examples:\n"
@@ -68,10 +89,68 @@ void showUsage(const std::string& program_name) {
               << "  # Process and stream via RTSP\n"
               << "  " << program_name << " -i rtsp://192.168.1.100:554/stream -o rtsp://0.0.0.0:8554/live\n\n"
               << "  # GPU video processing and recording\n"
-              << "  " << program_name << " -i video.mp4 --use-gpu --record output.mp4\n"
+              << "  " << program_name << " -i video.mp4 --use-gpu --record output.mp4\n\n"
+              << "  # Four cameras on four shared workers (type 'add id=<source>' / 'remove id' at runtime)\n"
+              << "  " << program_name << " --stream cam1=rtsp://10.0.0.1/s --stream cam2=rtsp://10.0.0.2/s"
+              << " --stream test:ball --stream test:snow --threads 4 --motion-detect\n"
               << std::endl;
 }
 
+/**
+ * @brief Determines the source type from an input argument
+ * @param input "webcam", "test[:pattern]", rtsp://, http(s):// or a file path
+ * @param type Source type
+ * @param location Source location
+ */
+void parseInput(const std::string& input, SourceType& type, std::string& location) {
+    if (input == "webcam") {
+        type = SourceType::WEBCAM;
+        location = "/dev/video0";
+    }
+    else if (input == "test" || input.find("test:") == 0) {
+        type = SourceType::TEST;
+        location = input.size() > 5 ? input.substr(5) : "";
+    }
+    else if (input.find("rtsp://") == 0) {
+        type = SourceType::RTSP;
+        location = input;
+    }
+    else if (input.find("http://") == 0 || input.find("https://") == 0) {
+        type = SourceType::HTTP;
+        location = input;
+    }
+    else {
+        type = SourceType::FILE;
+        location = input;
+    }
+}
+
+/**
+ * @brief Splits a "[id=]source" stream argument
+ * @param spec Stream argument
+ * @param index Stream number for the default id "stream<index>"
+ * @return Stream id and source
+ */
+std::pair<std::string, std::string> parseStreamSpec(const std::string& spec, size_t index) {
+    size_t separator = spec.find('=');
+    // "rtsp://host/path?a=b" has no id: an id never contains ':' or '/'
+    if (separator != std::string::npos && spec.find_first_of(":/") > separator) {
+        return {spec.substr(0, separator), spec.substr(separator + 1)};
+    }
+    return {"stream" + std::to_string(index), spec};
+}
+
+/**
+ * @brief Appends a simulcast rung unless one with that name exists
+ * @param rungs Rung names
+ * @param name Rung to add
+ */
+void addSimulcastRung(std::vector<std::string>& rungs, const std::string& name) {
+    if (!name.empty() && std::find(rungs.begin(), rungs.end(), name) == rungs.end()) {
+        rungs.push_back(name);
+    }
+}
+
 /**
  * @brief Parses command-line arguments
  * @param argc Argument count
@@ -81,6 +160,7 @@ void showUsage(const std::string& program_name) {
  */
 bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
     bool verbose = false;
+    bool cli_simulcast = false;     // --simulcast replaces output.rtsp.simulcast
     std::string config_file;
     
     // Process arguments
@@ -95,25 +175,22 @@ bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
             verbose = true;
         }
         else if ((arg == "-i" || arg == "--input") && i + 1 < argc) {
-            std::string input = argv[++i];
-            
-            // Determine input type
-            if (input == "webcam") {
-                config.source_type = SourceType::WEBCAM;
-                config.source_location = "/dev/video0";
-            }
-            else if (input.find("rtsp://") == 0) {
-                config.source_type = SourceType::RTSP;
-                config.source_location = input;
-            }
-            else if (input.find("http://") == 0 || input.find("https://") == 0) {
-                config.source_type = SourceType::HTTP;
-                config.source_location = input;
-            }
-            else {
-                config.source_type = SourceType::FILE;
-                config.source_location = input;
-            }
+            parseInput(argv[++i], config.source_type, config.source_location);
+        }
+        else if (arg == "--standby" && i + 1 < argc) {
+            parseInput(argv[++i], config.standby_type, config.standby_location);
+        }
+        else if (arg == "--stall-timeout" && i + 1 < argc) {
+            config.source_stall_timeout_ms = std::stoi(argv[++i]);
+        }
+        else if (arg == "--stream" && i + 1 < argc) {
+            config.streams.push_back(parseStreamSpec(argv[++i], config.streams.size()));
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            config.thread_count = std::stoi(argv[++i]);
+        }
+        else if (arg == "--queue-depth" && i + 1 < argc) {
+            config.stream_queue_depth = std::stoi(argv[++i]);
         }
         else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
             std::string output = argv[++i];
@@ -144,6 +221,17 @@ bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
             config.enable_recording = true;
             config.record_location = argv[++i];
         }
+        else if (arg == "--record-events" && i + 1 < argc) {
+            config.enable_recording = true;
+            config.recording_mode = RecordingMode::EVENT;
+            config.event_recording.location_pattern = argv[++i];
+        }
+        else if (arg == "--pre-roll" && i + 1 < argc) {
+            config.event_recording.pre_roll = std::stod(argv[++i]);
+        }
+        else if (arg == "--post-roll" && i + 1 < argc) {
+            config.event_recording.post_roll = std::stod(argv[++i]);
+        }
         else if (arg == "--width" && i + 1 < argc) {
             config.width = std::stoi(argv[++i]);
         }
@@ -159,6 +247,27 @@ bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
         else if (arg == "--rtsp-port" && i + 1 < argc) {
             config.rtsp_port = std::stoi(argv[++i]);
         }
+        else if (arg == "--simulcast" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string name;
+            config.rtsp_simulcast.clear();
+            cli_simulcast = true;
+            while (std::getline(list, name, ',')) {
+                addSimulcastRung(config.rtsp_simulcast, name);
+            }
+        }
+        else if (arg == "--multicast" && i + 1 < argc) {
+            std::string group = argv[++i];
+            size_t colon = group.rfind(':');
+            if (colon != std::string::npos) {
+                config.rtsp_multicast_port = std::stoi(group.substr(colon + 1));
+                group = group.substr(0, colon);
+            }
+            config.rtsp_multicast_address = group;
+        }
+        else if (arg == "--metrics-port" && i + 1 < argc) {
+            config.metrics_port = std::stoi(argv[++i]);
+        }
         else {
             std::cerr << "[ERROR] Unknown argument: " << arg << std::endl;
             showUsage(argv[0]);
@@ -184,8 +293,17 @@ bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
                     else if (type == "webcam") config.source_type = SourceType::WEBCAM;
                     else if (type == "rtsp") config.source_type = SourceType::RTSP;
                     else if (type == "http") config.source_type = SourceType::HTTP;
+                    else if (type == "test") config.source_type = SourceType::TEST;
                     
                     config.source_location = input["location"].as<std::string>();
+                    
+                    // Failover input
+                    if (input["standby"]) {
+                        parseInput(input["standby"].as<std::string>(),
+                                   config.standby_type, config.standby_location);
+                    }
+                    config.source_stall_timeout_ms =
+                        input["stall_timeout_ms"].as<int>(config.source_stall_timeout_ms);
                 }
                 
                 // Processing settings
@@ -205,7 +323,61 @@ bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
                     else if (type == "rtsp") config.sink_type = SinkType::RTSP;
                     
                     config.sink_location = output["location"].as<std::string>("");
+                    
+                    if (!cli_simulcast && output["rtsp"] && output["rtsp"]["simulcast"]) {
+                        for (const auto& rung : output["rtsp"]["simulcast"]) {
+                            addSimulcastRung(config.rtsp_simulcast, rung.as<std::string>());
+                        }
+                    }
+                    if (output["rtsp"] && output["rtsp"]["multicast"]) {
+                        auto multicast = output["rtsp"]["multicast"];
+                        config.rtsp_multicast_address = multicast["address"].as<std::string>("");
+                        config.rtsp_multicast_port = multicast["port"].as<int>(5000);
+                    }
                 }
+                
+                // Recording settings
+                if (pipeline["recording"]) {
+                    auto recording = pipeline["recording"];
+                    if (recording["enabled"].as<bool>(false)) {
+                        config.enable_recording = true;
+                        config.record_location = recording["location"].as<std::string>(config.record_location);
+                    }
+                    if (recording["mode"].as<std::string>("continuous") == "event") {
+                        auto& event = config.event_recording;
+                        config.recording_mode = RecordingMode::EVENT;
+                        event.pre_roll = recording["pre_roll"].as<double>(event.pre_roll);
+                        event.post_roll = recording["post_roll"].as<double>(event.post_roll);
+                        event.ring_byte_budget =
+                            recording["ring_budget_mb"].as<size_t>(event.ring_byte_budget >> 20) << 20;
+                        event.location_pattern = recording["event_location"].as<std::string>(event.location_pattern);
+                    }
+                }
+                
+                // Metrics endpoint
+                if (pipeline["metrics"]) {
+                    config.metrics_port = pipeline["metrics"]["port"].as<int>(0);
+                }
+                
+                // Multi-stream host
+                if (pipeline["streams"]) {
+                    for (const auto& stream : pipeline["streams"]) {
+                        std::string input = stream["input"].as<std::string>();
+                        if (stream["id"]) {
+                            config.streams.emplace_back(stream["id"].as<std::string>(), input);
+                        } else {
+                            config.streams.push_back(parseStreamSpec(input, config.streams.size()));
+                        }
+                    }
+                    config.stream_queue_depth =
+                        pipeline["stream_queue_depth"].as<int>(config.stream_queue_depth);
+                }
+            }
+            
+            // Performance settings
+            if (yaml_config["performance"]) {
+                config.thread_count =
+                    yaml_config["performance"]["thread_count"].as<int>(config.thread_count);
             }
         }
         catch (const YAML::Exception& e) {
@@ -215,7 +387,7 @@ bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
     }
     
     // Default values
-    if (config.source_location.empty()) {
+    if (config.source_location.empty() && config.streams.empty()) {
         std::cerr << "[ERROR] No video source specified!" << std::endl;
         showUsage(argv[0]);
         return false;
@@ -225,6 +397,13 @@ bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
     if (verbose) {
         std::cout << "\n[CONFIG] Pipeline Configuration:" << std::endl;
         std::cout << "  Source: " << config.source_location << std::endl;
+        for (const auto& stream : config.streams) {
+            std::cout << "  Stream " << stream.first << ": " << stream.second << std::endl;
+        }
+        if (!config.standby_location.empty()) {
+            std::cout << "  Standby source: " << config.standby_location
+                      << " (failover after " << config.source_stall_timeout_ms << " ms)" << std::endl;
+        }
         std::cout << "  Resolution: " << config.width << "x" << config.height << "@" << config.framerate << "fps" << std::endl;
         std::cout << "  Bitrate: " << config.bitrate << " bps" << std::endl;
         std::cout << "  GPU Acceleration: " << (config.enable_gpu_acceleration ? "Yes" : "No") << std::endl;
@@ -234,7 +413,11 @@ bool parseArguments(int argc, char* argv[], PipelineConfig& config) {
             std::cout << "  RTSP Output: " << config.sink_location << std::endl;
         }
 
-        if (config.enable_recording) {
+        if (config.enable_recording && config.recording_mode == RecordingMode::EVENT) {
+            std::cout << "  Event recording: " << config.event_recording.location_pattern
+                      << " (pre-roll " << config.event_recording.pre_roll
+                      << " s, post-roll " << config.event_recording.post_roll << " s)" << std::endl;
+        } else if (config.enable_recording) {
             std::cout << "  Recording: " << config.record_location << std::endl;
         }
         
@@ -290,9 +473,133 @@ void showPerformanceInfo(PipelineManager* pipeline) {
         std::cout << "  Active Clients: " << stats.active_clients << std::endl;
         std::cout << "  Total Bandwidth: " << std::fixed << std::setprecision(2)
                   << stats.average_bandwidth << " Mbps" << std::endl;
+        std::cout << "  UDP Sent: " << std::setprecision(2)
+                  << stats.udp_bytes_sent / (1024.0 * 1024.0) << " MB" << std::endl;
+        
+        auto recording = streamer->getRecordingStats();
+        if (recording.recording) {
+            std::cout << "  Recording: " << recording.current_file << " ("
+                      << recording.files << " files, "
+                      << recording.bytes / (1024.0 * 1024.0) << " MB)" << std::endl;
+        }
+        
+        // Simulcast rungs (idle rungs have no encoder running)
+        for (const auto& rung : streamer->getRungStats()) {
+            std::cout << "  " << rung.mount << " (" << rung.width << "x" << rung.height << "): "
+                      << rung.subscribers << " clients, "
+                      << (rung.encoding ? "encoding" : "idle") << ", "
+                      << std::setprecision(2) << rung.avg_encode_ms << " ms/frame" << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Displays the per-stream table of the multi-stream host
+ * @param host Stream host
+ */
+void showStreamInfo(StreamHost* host) {
+    std::cout << "\033[2J\033[H"; // Clear screen
+    std::cout << "=== GStreamer Video Analytics Pipeline (" << host->getPool().threads()
+              << " workers) ===" << std::endl;
+    std::cout << "Commands: add [id=]<source>, remove <id>. Press Ctrl+C to exit" << std::endl;
+    std::cout << std::string(72, '-') << std::endl;
+    std::cout << std::left << std::setw(16) << "Stream" << std::right
+              << std::setw(8) << "FPS" << std::setw(12) << "Frames"
+              << std::setw(12) << "Analysed" << std::setw(10) << "Dropped"
+              << std::setw(10) << "ms/frame" << "  State" << std::endl;
+
+    for (const auto& stats : host->getStats()) {
+        std::cout << std::left << std::setw(16) << stats.id << std::right << std::fixed
+                  << std::setw(8) << std::setprecision(1) << stats.fps
+                  << std::setw(12) << stats.input_frames
+                  << std::setw(12) << stats.processed_frames
+                  << std::setw(10) << stats.dropped_frames
+                  << std::setw(10) << std::setprecision(2) << stats.avg_processing_ms
+                  << "  " << (stats.failed ? "failed" : stats.finished ? "finished" : "running")
+                  << std::endl;
     }
 }
 
+/**
+ * @brief Runs the configured streams on one shared worker pool
+ *
+ * Streams are added and removed at runtime with "add [id=]<source>" and
+ * "remove <id>" lines on standard input.
+ * @param config Pipeline configuration (streams, format, motion detection)
+ * @return Exit code
+ */
+int runStreamHost(const PipelineConfig& config) {
+    StreamHostConfig host_config;
+    host_config.thread_count = config.thread_count;
+    host_config.queue_depth = config.stream_queue_depth;
+    host_config.format.width = config.width;
+    host_config.format.height = config.height;
+    host_config.format.framerate = config.framerate;
+    host_config.format.video_format = config.video_format;
+    host_config.enable_motion_detection = config.enable_motion_detection;
+
+    g_stream_host = std::make_unique<StreamHost>(host_config);
+    g_stream_host->setMotionEventCallback(
+        [](const std::string& id, const std::vector<MotionRegion>& regions, guint64, double percentage) {
+            if (percentage > 5.0) { // More than 5% motion
+                std::cout << "\n[MOTION] " << id << ": " << regions.size()
+                          << " region(s) (" << std::fixed << std::setprecision(1)
+                          << percentage << "% area)" << std::endl;
+            }
+        });
+
+    g_stream_host->start();
+    for (const auto& stream : config.streams) {
+        SourceType type;
+        std::string location;
+        parseInput(stream.second, type, location);
+        g_stream_host->addStream(stream.first, location, type);
+    }
+
+    // Metrics endpoint (per-stream series and pool counters)
+    std::unique_ptr<MetricsServer> metrics_server;
+    if (config.metrics_port > 0) {
+        metrics_server = std::make_unique<MetricsServer>(g_stream_host->getMetrics());
+        if (!metrics_server->start(config.metrics_port)) {
+            metrics_server.reset();
+        }
+    }
+
+    // Runtime control on standard input
+    std::thread control([] {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            std::istringstream command(line);
+            std::string verb;
+            std::string argument;
+            command >> verb >> argument;
+            if (verb == "add" && !argument.empty()) {
+                auto stream = parseStreamSpec(argument, g_stream_host->streamCount());
+                SourceType type;
+                std::string location;
+                parseInput(stream.second, type, location);
+                g_stream_host->addStream(stream.first, location, type);
+            } else if (verb == "remove" && !argument.empty()) {
+                if (!g_stream_host->removeStream(argument)) {
+                    std::cerr << "[ERROR] No such stream: " << argument << std::endl;
+                }
+            } else if (!verb.empty()) {
+                std::cerr << "[ERROR] Unknown command: " << line << std::endl;
+            }
+        }
+    });
+    control.detach();
+
+    while (g_stream_host->isRunning()) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        showStreamInfo(g_stream_host.get());
+    }
+
+    metrics_server.reset();
+    g_stream_host.reset();
+    return 0;
+}
+
 /**
  * @brief Main function
  */
@@ -315,6 +622,11 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Multi-stream mode
+    if (!config.streams.empty()) {
+        return runStreamHost(config);
+    }
+    
     try {
         // Create pipeline manager
         g_pipeline_manager = std::make_unique<PipelineManager>(config);
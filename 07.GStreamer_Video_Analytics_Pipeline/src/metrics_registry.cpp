@@ -0,0 +1,268 @@
+/**
+ * @file metrics_registry.cpp
+ * @brief Lock-free metric instruments and Prometheus text rendering
+ */
+
+#include "metrics_registry.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace {
+
+std::atomic<int> next_shard{0};
+
+/**
+ * @brief Formats a sample value
+ */
+std::string formatValue(double value) {
+    if (std::isnan(value)) return "NaN";
+    if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.10g", value);
+    return text;
+}
+
+/**
+ * @brief Escapes a label value (backslash, quote, newline)
+ */
+std::string escapeLabel(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '"') out += "\\\"";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+/**
+ * @brief Escapes help text (backslash, newline)
+ */
+std::string escapeHelp(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+/**
+ * @brief Writes a label set, optionally with one extra label (e.g. le)
+ */
+void writeLabels(std::ostringstream& out, const MetricLabels& labels,
+                 const char* extra_name = nullptr, const std::string& extra_value = "") {
+    if (labels.empty() && !extra_name) {
+        return;
+    }
+    out << '{';
+    bool first = true;
+    for (const auto& label : labels) {
+        out << (first ? "" : ",") << label.first << "=\"" << escapeLabel(label.second) << '"';
+        first = false;
+    }
+    if (extra_name) {
+        out << (first ? "" : ",") << extra_name << "=\"" << extra_value << '"';
+    }
+    out << '}';
+}
+
+const char* typeName(MetricType type) {
+    switch (type) {
+        case MetricType::COUNTER: return "counter";
+        case MetricType::GAUGE: return "gauge";
+        case MetricType::HISTOGRAM: return "histogram";
+    }
+    return "untyped";
+}
+
+} // namespace
+
+/**
+ * @brief Returns the shard of the calling thread
+ */
+int metricShard() {
+    thread_local const int shard =
+        next_shard.fetch_add(1, std::memory_order_relaxed) & (kMetricShards - 1);
+    return shard;
+}
+
+/**
+ * @brief Returns the sum over all shards
+ */
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const Shard& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+/**
+ * @brief Constructor
+ */
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)), shards_(new Shard[kMetricShards]) {
+    std::sort(bounds_.begin(), bounds_.end());
+    for (int i = 0; i < kMetricShards; ++i) {
+        shards_[i].buckets.reset(new std::atomic<uint64_t>[bounds_.size() + 1]());
+    }
+}
+
+/**
+ * @brief Records one observation
+ */
+void Histogram::observe(double value) {
+    size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    Shard& shard = shards_[metricShard()];
+    shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    atomicAdd(shard.sum, value);
+}
+
+/**
+ * @brief Returns the merged shards
+ */
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot result;
+    result.bounds = bounds_;
+    result.buckets.assign(bounds_.size() + 1, 0);
+    for (int i = 0; i < kMetricShards; ++i) {
+        for (size_t b = 0; b <= bounds_.size(); ++b) {
+            result.buckets[b] += shards_[i].buckets[b].load(std::memory_order_relaxed);
+        }
+        result.sum += shards_[i].sum.load(std::memory_order_relaxed);
+    }
+    for (size_t b = 1; b < result.buckets.size(); ++b) {
+        result.buckets[b] += result.buckets[b - 1];
+    }
+    result.count = result.buckets.back();
+    return result;
+}
+
+/**
+ * @brief Returns exponentially spaced bounds
+ */
+std::vector<double> Histogram::exponentialBounds(double start, double factor, int count) {
+    std::vector<double> bounds;
+    bounds.reserve(count);
+    for (int i = 0; i < count; ++i, start *= factor) {
+        bounds.push_back(start);
+    }
+    return bounds;
+}
+
+/**
+ * @brief Returns the family of a name, creating it if needed
+ */
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help,
+                                                 MetricType type) {
+    for (Family& existing : families_) {
+        if (existing.name == name) {
+            return existing;
+        }
+    }
+    families_.push_back(Family{name, help, type, {}, {}});
+    return families_.back();
+}
+
+/**
+ * @brief Registers a counter series
+ */
+void MetricsRegistry::addCounter(const std::string& name, const std::string& help,
+                                 const Counter& counter, const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series series;
+    series.labels = labels;
+    series.counter = &counter;
+    family(name, help, MetricType::COUNTER).series.push_back(series);
+}
+
+/**
+ * @brief Registers a gauge series
+ */
+void MetricsRegistry::addGauge(const std::string& name, const std::string& help,
+                               const Gauge& gauge, const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series series;
+    series.labels = labels;
+    series.gauge = &gauge;
+    family(name, help, MetricType::GAUGE).series.push_back(series);
+}
+
+/**
+ * @brief Registers a histogram series
+ */
+void MetricsRegistry::addHistogram(const std::string& name, const std::string& help,
+                                   const Histogram& histogram, const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series series;
+    series.labels = labels;
+    series.histogram = &histogram;
+    family(name, help, MetricType::HISTOGRAM).series.push_back(series);
+}
+
+/**
+ * @brief Registers a collector polled on every render()
+ */
+void MetricsRegistry::addCollector(const std::string& name, const std::string& help,
+                                   MetricType type, Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    family(name, help, type).collectors.push_back(std::move(collector));
+}
+
+/**
+ * @brief Renders every metric in Prometheus text format
+ */
+std::string MetricsRegistry::render() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    std::vector<MetricSample> samples;
+
+    for (const Family& family : families_) {
+        out << "# HELP " << family.name << ' ' << escapeHelp(family.help) << '\n'
+            << "# TYPE " << family.name << ' ' << typeName(family.type) << '\n';
+
+        for (const Series& series : family.series) {
+            if (series.histogram) {
+                Histogram::Snapshot snap = series.histogram->snapshot();
+                for (size_t b = 0; b < snap.buckets.size(); ++b) {
+                    out << family.name << "_bucket";
+                    writeLabels(out, series.labels, "le",
+                                b < snap.bounds.size() ? formatValue(snap.bounds[b]) : "+Inf");
+                    out << ' ' << snap.buckets[b] << '\n';
+                }
+                out << family.name << "_sum";
+                writeLabels(out, series.labels);
+                out << ' ' << formatValue(snap.sum) << '\n';
+                out << family.name << "_count";
+                writeLabels(out, series.labels);
+                out << ' ' << snap.count << '\n';
+                continue;
+            }
+            out << family.name;
+            writeLabels(out, series.labels);
+            if (series.counter) {
+                out << ' ' << series.counter->value() << '\n';
+            } else {
+                out << ' ' << formatValue(series.gauge->value()) << '\n';
+            }
+        }
+
+        for (const Collector& collector : family.collectors) {
+            samples.clear();
+            collector(samples);
+            for (const MetricSample& sample : samples) {
+                out << family.name;
+                writeLabels(out, sample.labels);
+                out << ' ' << formatValue(sample.value) << '\n';
+            }
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,167 @@
+/**
+ * @file metrics_server.cpp
+ * @brief Minimal /metrics HTTP endpoint implementation (POSIX sockets)
+ */
+
+#include "metrics_server.h"
+#include "metrics_registry.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kPollIntervalMs = 200;     // Stop flag check interval
+constexpr size_t kMaxRequestSize = 8192; // Request headers read before answering
+
+/**
+ * @brief Writes a whole buffer to a socket
+ */
+void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Constructor
+ */
+MetricsServer::MetricsServer(const MetricsRegistry& registry)
+    : registry_(registry) {
+}
+
+/**
+ * @brief Destructor
+ */
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+/**
+ * @brief Binds the port and starts the server thread
+ */
+bool MetricsServer::start(int port, const std::string& address) {
+    if (running_.load()) {
+        return true;
+    }
+
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "[MetricsServer] socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1 ||
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd_, 8) < 0) {
+        std::cerr << "[MetricsServer] Cannot listen on " << address << ":" << port
+                  << ": " << std::strerror(errno) << std::endl;
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::serve, this);
+    std::cout << "[MetricsServer] Serving http://" << address << ":" << port_ << "/metrics" << std::endl;
+    return true;
+}
+
+/**
+ * @brief Stops and joins the server thread
+ */
+void MetricsServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+/**
+ * @brief Accept loop
+ */
+void MetricsServer::serve() {
+    while (running_.load()) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, kPollIntervalMs) <= 0) {
+            continue;
+        }
+        int client = ::accept(listen_fd_, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        handleClient(client);
+        ::close(client);
+    }
+}
+
+/**
+ * @brief Reads one request and writes the response
+ */
+void MetricsServer::handleClient(int client) {
+    // A stalled client must not block the next scrape for long
+    timeval timeout{1, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char chunk[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestSize) {
+        ssize_t n = ::recv(client, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(chunk, static_cast<size_t>(n));
+    }
+
+    std::string line = request.substr(0, request.find("\r\n"));
+    bool get = line.compare(0, 4, "GET ") == 0;
+    std::string path = get ? line.substr(4, line.find(' ', 4) - 4) : "";
+    path = path.substr(0, path.find('?'));
+
+    std::string status;
+    std::string body;
+    std::string type = "text/plain; charset=utf-8";
+    if (!get) {
+        status = "405 Method Not Allowed";
+        body = "Only GET is supported\n";
+    } else if (path == "/metrics") {
+        status = "200 OK";
+        body = registry_.render();
+        type = "text/plain; version=0.0.4; charset=utf-8";
+    } else {
+        status = "404 Not Found";
+        body = "See /metrics\n";
+    }
+
+    sendAll(client, "HTTP/1.1 " + status + "\r\n"
+                    "Content-Type: " + type + "\r\n"
+                    "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                    "Connection: close\r\n\r\n" + body);
+}
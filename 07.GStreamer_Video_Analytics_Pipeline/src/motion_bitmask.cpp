@@ -0,0 +1,471 @@
+/**
+ * @file motion_bitmask.cpp
+ * @brief Bit-packed frame difference, morphology and labelling implementation
+ */
+
+#include "motion_bitmask.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MOTION_BITMASK_SSE2 1
+#endif
+
+namespace {
+
+inline int countTrailingZeros(uint64_t v) {
+    return __builtin_ctzll(v);
+}
+
+/**
+ * @brief Packs |a - b| > threshold for 64 pixels and copies a into b
+ */
+inline uint64_t diffWord64(const uint8_t* a, uint8_t* b, uint8_t threshold) {
+#ifdef MOTION_BITMASK_SSE2
+    const __m128i thr = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t word = 0;
+    for (int k = 0; k < 4; ++k) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16 * k));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16 * k));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        // diff > thr  <=>  saturating (diff - thr) != 0
+        __m128i over = _mm_cmpeq_epi8(_mm_subs_epu8(diff, thr), zero);
+        uint32_t bits = ~static_cast<uint32_t>(_mm_movemask_epi8(over)) & 0xFFFFu;
+        word |= static_cast<uint64_t>(bits) << (16 * k);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(b + 16 * k), va);
+    }
+    return word;
+#else
+    uint64_t word = 0;
+    for (int i = 0; i < 64; ++i) {
+        int d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        word |= static_cast<uint64_t>(d > threshold) << i;
+        b[i] = a[i];
+    }
+    return word;
+#endif
+}
+
+/**
+ * @brief Scalar variant for the partial last word of a row
+ */
+inline uint64_t diffWordTail(const uint8_t* a, uint8_t* b, int count, uint8_t threshold) {
+    uint64_t word = 0;
+    for (int i = 0; i < count; ++i) {
+        int d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        word |= static_cast<uint64_t>(d > threshold) << i;
+        b[i] = a[i];
+    }
+    return word;
+}
+
+/**
+ * @brief OR of the word shifted by 1..r pixels in both directions
+ *
+ * Bit j of word i is pixel i*64 + j, so "left" neighbours come from lower
+ * bits (and the high bits of the previous word).
+ */
+inline uint64_t spreadWord(uint64_t prev, uint64_t cur, uint64_t next, int r) {
+    uint64_t out = cur;
+    for (int k = 1; k <= r; ++k) {
+        out |= (cur << k) | (prev >> (64 - k));
+        out |= (cur >> k) | (next << (64 - k));
+    }
+    return out;
+}
+
+} // namespace
+
+/**
+ * @brief Allocates the mask for a frame size
+ */
+void MotionBitmask::configure(int width, int height) {
+    width_ = width;
+    height_ = height;
+    words_ = (width + kTileWidth - 1) / kTileWidth;
+    tile_rows_ = (height + kTileHeight - 1) / kTileHeight;
+    int tail = width % 64;
+    tail_mask_ = tail ? ((1ull << tail) - 1) : ~0ull;
+    primed_ = false;
+
+    size_t total_words = static_cast<size_t>(words_) * height_;
+    bits_.assign(total_words, 0);
+    scratch_.assign(total_words, 0);
+    previous_.assign(static_cast<size_t>(width_) * height_, 0);
+
+    size_t tiles = static_cast<size_t>(words_) * tile_rows_;
+    tile_active_.assign(tiles, 0);
+    tile_work_.assign(tiles, 0);
+    active_count_ = 0;
+
+    setStaticMask(nullptr, {});
+}
+
+/**
+ * @brief Precomputes the static ROI/exclusion mask
+ */
+void MotionBitmask::setStaticMask(const BitmaskRect* roi,
+                                  const std::vector<BitmaskRect>& exclusions) {
+    static_bits_.assign(static_cast<size_t>(words_) * height_, 0);
+
+    auto setSpan = [this](int y, int x0, int x1, bool value) {
+        uint64_t* r = static_bits_.data() + static_cast<size_t>(y) * words_;
+        for (int x = x0; x < x1;) {
+            int w = x / 64;
+            int b0 = x % 64;
+            int b1 = std::min(64, b0 + (x1 - x));
+            uint64_t span = (b1 - b0 == 64) ? ~0ull : (((1ull << (b1 - b0)) - 1) << b0);
+            r[w] = value ? (r[w] | span) : (r[w] & ~span);
+            x += b1 - b0;
+        }
+    };
+    auto clip = [this](const BitmaskRect& rect, int& x0, int& y0, int& x1, int& y1) {
+        x0 = std::max(0, rect.x);
+        y0 = std::max(0, rect.y);
+        x1 = std::min(width_, rect.x + rect.width);
+        y1 = std::min(height_, rect.y + rect.height);
+        return x0 < x1 && y0 < y1;
+    };
+
+    int x0 = 0, y0 = 0, x1 = width_, y1 = height_;
+    if (!roi || clip(*roi, x0, y0, x1, y1)) {
+        for (int y = y0; y < y1; ++y) {
+            setSpan(y, x0, x1, true);
+        }
+    }
+    for (const auto& zone : exclusions) {
+        if (clip(zone, x0, y0, x1, y1)) {
+            for (int y = y0; y < y1; ++y) {
+                setSpan(y, x0, x1, false);
+            }
+        }
+    }
+
+    // Skipped tiles do not keep their previous pixels current, so start over
+    primed_ = false;
+
+    // A tile is visited only if it contains at least one allowed pixel
+    tile_static_.assign(static_cast<size_t>(words_) * tile_rows_, 0);
+    for (int ty = 0; ty < tile_rows_; ++ty) {
+        int yend = std::min(height_, (ty + 1) * kTileHeight);
+        for (int w = 0; w < words_; ++w) {
+            uint64_t any = 0;
+            for (int y = ty * kTileHeight; y < yend; ++y) {
+                any |= static_bits_[static_cast<size_t>(y) * words_ + w];
+            }
+            tile_static_[static_cast<size_t>(ty) * words_ + w] = any != 0;
+        }
+    }
+}
+
+/**
+ * @brief Fused difference, threshold, packing and previous update
+ */
+int MotionBitmask::diffThreshold(const uint8_t* frame, size_t stride, int threshold) {
+    uint8_t thr = static_cast<uint8_t>(std::clamp(threshold, 0, 255));
+
+    if (!primed_) {
+        for (int y = 0; y < height_; ++y) {
+            std::memcpy(previous_.data() + static_cast<size_t>(y) * width_,
+                        frame + y * stride, width_);
+        }
+        std::fill(bits_.begin(), bits_.end(), 0);
+        std::fill(tile_active_.begin(), tile_active_.end(), 0);
+        active_count_ = 0;
+        primed_ = true;
+        return 0;
+    }
+
+    active_count_ = 0;
+    for (int ty = 0; ty < tile_rows_; ++ty) {
+        int y0 = ty * kTileHeight;
+        int y1 = std::min(height_, y0 + kTileHeight);
+        for (int w = 0; w < words_; ++w) {
+            size_t tile = static_cast<size_t>(ty) * words_ + w;
+            if (!tile_static_[tile]) {
+                // Excluded tile: never read, never set
+                for (int y = y0; y < y1; ++y) {
+                    row(y)[w] = 0;
+                }
+                tile_active_[tile] = 0;
+                continue;
+            }
+
+            int x = w * 64;
+            int count = std::min(64, width_ - x);
+            uint64_t any = 0;
+            for (int y = y0; y < y1; ++y) {
+                const uint8_t* src = frame + y * stride + x;
+                uint8_t* prev = previous_.data() + static_cast<size_t>(y) * width_ + x;
+                uint64_t word = (count == 64) ? diffWord64(src, prev, thr)
+                                              : diffWordTail(src, prev, count, thr);
+                word &= static_bits_[static_cast<size_t>(y) * words_ + w];
+                row(y)[w] = word;
+                any |= word;
+            }
+            tile_active_[tile] = any != 0;
+            active_count_ += any != 0;
+        }
+    }
+    return active_count_;
+}
+
+/**
+ * @brief Binary erosion
+ */
+void MotionBitmask::erode(int radius) {
+    morph(radius, true);
+}
+
+/**
+ * @brief Binary dilation
+ */
+void MotionBitmask::dilate(int radius) {
+    morph(radius, false);
+}
+
+/**
+ * @brief Separable square-element morphology on packed words
+ *
+ * Erosion is computed as the complement of dilating the complement, with
+ * pixels outside the frame treated as set (OpenCV's default morphology
+ * border). Only tiles that can change are processed: active tiles for
+ * erosion, active tiles plus their 8 neighbours for dilation.
+ */
+void MotionBitmask::morph(int radius, bool erode) {
+    radius = std::min(radius, kTileHeight - 1);
+    if (radius <= 0 || active_count_ == 0) {
+        return;
+    }
+
+    // Work set
+    std::fill(tile_work_.begin(), tile_work_.end(), 0);
+    for (int ty = 0; ty < tile_rows_; ++ty) {
+        for (int w = 0; w < words_; ++w) {
+            if (!tile_active_[static_cast<size_t>(ty) * words_ + w]) {
+                continue;
+            }
+            if (erode) {
+                tile_work_[static_cast<size_t>(ty) * words_ + w] = 1;
+                continue;
+            }
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int nty = ty + dy, nw = w + dx;
+                    if (nty >= 0 && nty < tile_rows_ && nw >= 0 && nw < words_) {
+                        tile_work_[static_cast<size_t>(nty) * words_ + nw] = 1;
+                    }
+                }
+            }
+        }
+    }
+
+    // Loads a word of the (possibly complemented) input; padding bits of the
+    // last word behave like pixels outside the frame
+    auto load = [this, erode](const uint64_t* r, int w) -> uint64_t {
+        if (w < 0 || w >= words_) {
+            return 0;
+        }
+        uint64_t v = erode ? ~r[w] : r[w];
+        return (w == words_ - 1) ? (v & tail_mask_) : v;
+    };
+
+    // Horizontal pass into scratch_
+    std::fill(scratch_.begin(), scratch_.end(), 0);
+    for (int ty = 0; ty < tile_rows_; ++ty) {
+        int y0 = ty * kTileHeight;
+        int y1 = std::min(height_, y0 + kTileHeight);
+        for (int w = 0; w < words_; ++w) {
+            if (!tile_work_[static_cast<size_t>(ty) * words_ + w]) {
+                continue;
+            }
+            for (int y = y0; y < y1; ++y) {
+                const uint64_t* r = row(y);
+                scratch_[static_cast<size_t>(y) * words_ + w] =
+                    spreadWord(load(r, w - 1), load(r, w), load(r, w + 1), radius);
+            }
+        }
+    }
+
+    // Vertical pass back into bits_. For erosion the complement of an
+    // inactive tile is all ones, which the horizontal pass skipped, so rows
+    // from non-work tiles are reconstructed on the fly.
+    for (int ty = 0; ty < tile_rows_; ++ty) {
+        int y0 = ty * kTileHeight;
+        int y1 = std::min(height_, y0 + kTileHeight);
+        for (int w = 0; w < words_; ++w) {
+            if (!tile_work_[static_cast<size_t>(ty) * words_ + w]) {
+                continue;
+            }
+            uint64_t valid = (w == words_ - 1) ? tail_mask_ : ~0ull;
+            for (int y = y0; y < y1; ++y) {
+                uint64_t acc = 0;
+                int ya = std::max(0, y - radius);
+                int yb = std::min(height_ - 1, y + radius);
+                for (int yy = ya; yy <= yb; ++yy) {
+                    int nty = yy / kTileHeight;
+                    if (erode && !tile_work_[static_cast<size_t>(nty) * words_ + w]) {
+                        acc = valid; // Complement of an empty tile row
+                        break;
+                    }
+                    acc |= scratch_[static_cast<size_t>(yy) * words_ + w];
+                }
+                row(y)[w] = erode ? (~acc & valid) : (acc & valid);
+            }
+        }
+    }
+
+    refreshActive(tile_work_);
+}
+
+/**
+ * @brief Recomputes tile occupancy for the tiles in work
+ */
+void MotionBitmask::refreshActive(const std::vector<uint8_t>& work) {
+    active_count_ = 0;
+    for (int ty = 0; ty < tile_rows_; ++ty) {
+        int y0 = ty * kTileHeight;
+        int y1 = std::min(height_, y0 + kTileHeight);
+        for (int w = 0; w < words_; ++w) {
+            size_t tile = static_cast<size_t>(ty) * words_ + w;
+            if (work[tile]) {
+                uint64_t any = 0;
+                for (int y = y0; y < y1; ++y) {
+                    any |= row(y)[w];
+                }
+                tile_active_[tile] = any != 0;
+            }
+            active_count_ += tile_active_[tile];
+        }
+    }
+}
+
+/**
+ * @brief 8-connected components over horizontal runs
+ */
+std::vector<BitmaskBlob> MotionBitmask::label() const {
+    struct Run {
+        int x0, x1;     // [x0, x1)
+        int y;
+        int label;
+    };
+
+    std::vector<BitmaskBlob> blobs;
+    if (active_count_ == 0) {
+        return blobs;
+    }
+
+    std::vector<Run> runs;
+    std::vector<int> parent;
+    auto find = [&parent](int a) {
+        while (parent[a] != a) {
+            parent[a] = parent[parent[a]];
+            a = parent[a];
+        }
+        return a;
+    };
+    auto unite = [&](int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    };
+
+    size_t prev_begin = 0, prev_end = 0;
+    int prev_y = -2;
+    for (int ty = 0; ty < tile_rows_; ++ty) {
+        bool band_active = false;
+        for (int w = 0; w < words_ && !band_active; ++w) {
+            band_active = tile_active_[static_cast<size_t>(ty) * words_ + w] != 0;
+        }
+        if (!band_active) {
+            continue;
+        }
+
+        int y0 = ty * kTileHeight;
+        int y1 = std::min(height_, y0 + kTileHeight);
+        for (int y = y0; y < y1; ++y) {
+            size_t cur_begin = runs.size();
+            const uint64_t* r = row(y);
+
+            // Extract runs (they may span word boundaries)
+            int open_start = -1;
+            for (int w = 0; w < words_; ++w) {
+                uint64_t bits = r[w];
+                int base = w * 64;
+                int pos = 0;
+                while (pos < 64) {
+                    if (open_start < 0) {
+                        uint64_t rest = bits >> pos;
+                        if (rest == 0) {
+                            break;
+                        }
+                        pos += countTrailingZeros(rest);
+                        open_start = base + pos;
+                    }
+                    uint64_t zeros = ~bits >> pos;
+                    if (zeros == 0) {
+                        break; // Run continues into the next word
+                    }
+                    pos += countTrailingZeros(zeros);
+                    runs.push_back({open_start, base + pos, y, 0});
+                    open_start = -1;
+                }
+            }
+            if (open_start >= 0) {
+                runs.push_back({open_start, width_, y, 0});
+            }
+
+            // Label and connect to the previous row (8-connectivity)
+            size_t p = (prev_y == y - 1) ? prev_begin : prev_end;
+            for (size_t i = cur_begin; i < runs.size(); ++i) {
+                runs[i].label = static_cast<int>(parent.size());
+                parent.push_back(runs[i].label);
+                while (p < prev_end && runs[p].x1 < runs[i].x0) {
+                    ++p;
+                }
+                for (size_t q = p; q < prev_end && runs[q].x0 <= runs[i].x1; ++q) {
+                    unite(runs[i].label, runs[q].label);
+                }
+            }
+            prev_begin = cur_begin;
+            prev_end = runs.size();
+            prev_y = y;
+        }
+    }
+
+    // Accumulate per root
+    std::vector<int> blob_of(parent.size(), -1);
+    for (const auto& run : runs) {
+        int root = find(run.label);
+        if (blob_of[root] < 0) {
+            blob_of[root] = static_cast<int>(blobs.size());
+            blobs.push_back({run.x0, run.y, run.x1 - run.x0, 1, 0});
+        }
+        BitmaskBlob& blob = blobs[blob_of[root]];
+        int bx1 = std::max(blob.x + blob.width, run.x1);
+        int by1 = std::max(blob.y + blob.height, run.y + 1);
+        blob.x = std::min(blob.x, run.x0);
+        blob.y = std::min(blob.y, run.y);
+        blob.width = bx1 - blob.x;
+        blob.height = by1 - blob.y;
+        blob.area += run.x1 - run.x0;
+    }
+    return blobs;
+}
+
+/**
+ * @brief Expands the mask to 0/255 bytes
+ */
+void MotionBitmask::unpack(uint8_t* dst, size_t stride) const {
+    for (int y = 0; y < height_; ++y) {
+        const uint64_t* r = row(y);
+        uint8_t* out = dst + y * stride;
+        for (int x = 0; x < width_; ++x) {
+            out[x] = ((r[x / 64] >> (x % 64)) & 1) ? 255 : 0;
+        }
+    }
+}
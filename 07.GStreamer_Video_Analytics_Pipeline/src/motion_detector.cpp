@@ -7,15 +7,18 @@
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 // Virtual table for GStreamer base transform
 typedef struct {
     GstBaseTransformClass parent_class;
-} MotionDetectorClass;
+} MotionDetectorElementClass;
 
 typedef struct {
     GstBaseTransform parent;
     MotionDetector* detector;
+    GstVideoInfo info;          // Cached in set_caps
+    gboolean info_valid;        // Caps negotiated
 } MotionDetectorElement;
 
 // GObject type definitions
@@ -24,18 +27,39 @@ typedef struct {
 
 G_DEFINE_TYPE(MotionDetectorElement, motion_detector, GST_TYPE_BASE_TRANSFORM)
 
+// Luma-plane formats are analysed in place, packed RGB is converted to gray
+#define MOTION_DETECTOR_CAPS GST_VIDEO_CAPS_MAKE("{ I420, YV12, NV12, NV21, GRAY8, RGB, BGR }")
+
+static GstStaticPadTemplate motion_detector_sink_template = GST_STATIC_PAD_TEMPLATE(
+    "sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS(MOTION_DETECTOR_CAPS));
+
+static GstStaticPadTemplate motion_detector_src_template = GST_STATIC_PAD_TEMPLATE(
+    "src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS(MOTION_DETECTOR_CAPS));
+
 // Forward declarations
-static GstFlowReturn motion_detector_transform(GstBaseTransform* trans, GstBuffer* inbuf, GstBuffer* outbuf);
+static GstFlowReturn motion_detector_transform_ip(GstBaseTransform* trans, GstBuffer* buf);
 static gboolean motion_detector_set_caps(GstBaseTransform* trans, GstCaps* incaps, GstCaps* outcaps);
+static gboolean motion_detector_stop(GstBaseTransform* trans);
 
 /**
  * @brief GObject class initialization
  */
-static void motion_detector_class_init(MotionDetectorClass* klass) {
+static void motion_detector_class_init(MotionDetectorElementClass* klass) {
+    GstElementClass* element_class = GST_ELEMENT_CLASS(klass);
     GstBaseTransformClass* base_transform_class = GST_BASE_TRANSFORM_CLASS(klass);
+
+    // GstBaseTransform creates its pads from these templates
+    gst_element_class_add_static_pad_template(element_class, &motion_detector_sink_template);
+    gst_element_class_add_static_pad_template(element_class, &motion_detector_src_template);
+    gst_element_class_set_static_metadata(element_class,
+        "Motion Detector",
+        "Filter/Analyzer/Video",
+        "Detects motion and attaches regions as metadata",
+        "GStreamer Video Analytics Pipeline");
     
-    base_transform_class->transform = GST_DEBUG_FUNCPTR(motion_detector_transform);
+    base_transform_class->transform_ip = GST_DEBUG_FUNCPTR(motion_detector_transform_ip);
     base_transform_class->set_caps = GST_DEBUG_FUNCPTR(motion_detector_set_caps);
+    base_transform_class->stop = GST_DEBUG_FUNCPTR(motion_detector_stop);
     
     // Use in-place transform
     base_transform_class->transform_ip_on_passthrough = FALSE;
@@ -45,6 +69,8 @@ static void motion_detector_class_init(MotionDetectorClass* klass) {
  * @brief GObject instance initialization
  */
 static void motion_detector_init(MotionDetectorElement* element) {
+    element->detector = nullptr;
+    element->info_valid = FALSE;
     gst_base_transform_set_in_place(GST_BASE_TRANSFORM(element), TRUE);
 }
 
@@ -82,6 +108,11 @@ MotionDetector::MotionDetector() {
  * @brief Destructor
  */
 MotionDetector::~MotionDetector() {
+    stopAnalysisWorker();
+    track_dispatcher_.stop();
+    if (overlay_) {
+        gst_video_overlay_composition_unref(overlay_);
+    }
     if (element_) {
         gst_object_unref(element_);
     }
@@ -91,7 +122,7 @@ MotionDetector::~MotionDetector() {
  * @brief Creates a GStreamer element
  */
 GstElement* MotionDetector::createElement() {
-    element_ = g_object_new(MOTION_DETECTOR_TYPE, nullptr);
+    element_ = GST_ELEMENT(g_object_new(MOTION_DETECTOR_TYPE, nullptr));
     MOTION_DETECTOR(element_)->detector = this;
     
     return GST_ELEMENT(element_);
@@ -141,6 +172,12 @@ void MotionDetector::setAlgorithm(MotionAlgorithm algorithm) {
     // Reset background model for new algorithm
     previous_frame_ = cv::Mat();
     background_model_ = cv::Mat();
+    running_avg_threads_ = -1;
+    block_motion_threads_ = -1;
+    {
+        std::lock_guard<std::mutex> motions_lock(motions_mutex_);
+        motion_field_ = MotionVectorField();
+    }
     
     if (algorithm == MotionAlgorithm::MOG2) {
         bg_subtractor_ = cv::createBackgroundSubtractorMOG2();
@@ -169,21 +206,83 @@ void MotionDetector::setMotionEventCallback(MotionEventCallback callback) {
     motion_callback_ = callback;
 }
 
+/**
+ * @brief Sets the motion activity callback
+ */
+void MotionDetector::setMotionActivityCallback(MotionActivityCallback callback) {
+    activity_callback_ = std::move(callback);
+}
+
+/**
+ * @brief Sets the track event callback
+ */
+void MotionDetector::setTrackEventCallback(MotionTrackCallback callback) {
+    track_dispatcher_.setCallback(std::move(callback));
+}
+
 /**
  * @brief Returns statistics
  */
 MotionStats MotionDetector::getStats() const {
+    Histogram::Snapshot areas = motion_area_metric_.snapshot();
     std::lock_guard<std::mutex> lock(stats_mutex_);
-    return stats_;
+    MotionStats stats;
+    stats.total_frames = frames_metric_.value() - stats_base_.total_frames;
+    stats.motion_frames = motion_frames_metric_.value() - stats_base_.motion_frames;
+    stats.total_regions = regions_metric_.value() - stats_base_.total_regions;
+    stats.analyzed_frames = analyzed_metric_.value() - stats_base_.analyzed_frames;
+    stats.dropped_frames = dropped_metric_.value() - stats_base_.dropped_frames;
+    stats.track_events = track_events_metric_.value() - stats_base_.track_events;
+    stats.dropped_track_events = dropped_track_events_metric_.value() - stats_base_.dropped_track_events;
+    guint64 area_count = areas.count - stats_base_.motion_frames;
+    if (area_count > 0) {
+        stats.average_motion_area = (areas.sum - area_sum_base_) / area_count;
+    }
+    stats.max_motion_area = max_motion_area_.load(std::memory_order_relaxed);
+    stats.analysis_lag_frames = static_cast<guint64>(lag_metric_.value());
+    stats.max_analysis_lag_frames = static_cast<guint64>(max_lag_.load(std::memory_order_relaxed));
+    stats.last_motion_time = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(last_motion_ns_.load(std::memory_order_relaxed)));
+    return stats;
 }
 
 /**
  * @brief Resets statistics
  */
 void MotionDetector::resetStats() {
+    Histogram::Snapshot areas = motion_area_metric_.snapshot();
     std::lock_guard<std::mutex> lock(stats_mutex_);
-    stats_ = MotionStats();
-    stats_.last_motion_time = std::chrono::steady_clock::now();
+    stats_base_.total_frames = frames_metric_.value();
+    stats_base_.motion_frames = areas.count;
+    stats_base_.total_regions = regions_metric_.value();
+    stats_base_.analyzed_frames = analyzed_metric_.value();
+    stats_base_.dropped_frames = dropped_metric_.value();
+    stats_base_.track_events = track_events_metric_.value();
+    stats_base_.dropped_track_events = dropped_track_events_metric_.value();
+    area_sum_base_ = areas.sum;
+    max_motion_area_ = 0.0;
+    max_lag_ = 0.0;
+    last_motion_ns_ = std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+/**
+ * @brief Exports the detection metrics
+ */
+void MotionDetector::registerMetrics(MetricsRegistry& registry) {
+    registry.addCounter("motion_detector_frames_total", "Frames seen by the motion detector", frames_metric_);
+    registry.addCounter("motion_detector_motion_frames_total", "Frames with motion", motion_frames_metric_);
+    registry.addCounter("motion_detector_regions_total", "Motion regions detected", regions_metric_);
+    registry.addCounter("motion_detector_analyzed_frames_total",
+                        "Frames analysed by the asynchronous worker", analyzed_metric_);
+    registry.addCounter("motion_detector_dropped_frames_total",
+                        "Frames replaced before the asynchronous worker took them", dropped_metric_);
+    registry.addCounter("motion_detector_track_events_total", "Track events queued", track_events_metric_);
+    registry.addCounter("motion_detector_dropped_track_events_total",
+                        "Track events dropped by the bounded queue", dropped_track_events_metric_);
+    registry.addHistogram("motion_detector_motion_area_percent",
+                          "Motion area of frames with motion (percent of the frame)", motion_area_metric_);
+    registry.addGauge("motion_detector_analysis_lag_frames",
+                      "Frames between the analysed and the annotated buffer", lag_metric_);
 }
 
 /**
@@ -194,6 +293,14 @@ std::vector<MotionRegion> MotionDetector::getCurrentMotions() const {
     return current_motions_;
 }
 
+/**
+ * @brief Returns the latest block motion field
+ */
+MotionVectorField MotionDetector::getMotionVectorField() const {
+    std::lock_guard<std::mutex> lock(motions_mutex_);
+    return motion_field_;
+}
+
 /**
  * @brief Enables/disables motion detection
  */
@@ -207,6 +314,8 @@ void MotionDetector::setEnabled(bool enable) {
 void MotionDetector::setROI(int x, int y, int width, int height) {
     roi_ = cv::Rect(x, y, width, height);
     has_roi_ = true;
+    static_mask_dirty_ = true;
+    bitmask_zones_dirty_ = true;
 }
 
 /**
@@ -214,6 +323,8 @@ void MotionDetector::setROI(int x, int y, int width, int height) {
  */
 void MotionDetector::clearROI() {
     has_roi_ = false;
+    static_mask_dirty_ = true;
+    bitmask_zones_dirty_ = true;
 }
 
 /**
@@ -221,6 +332,8 @@ void MotionDetector::clearROI() {
  */
 void MotionDetector::addExclusionZone(int x, int y, int width, int height) {
     exclusion_zones_.push_back(cv::Rect(x, y, width, height));
+    static_mask_dirty_ = true;
+    bitmask_zones_dirty_ = true;
 }
 
 /**
@@ -228,6 +341,8 @@ void MotionDetector::addExclusionZone(int x, int y, int width, int height) {
  */
 void MotionDetector::clearExclusionZones() {
     exclusion_zones_.clear();
+    static_mask_dirty_ = true;
+    bitmask_zones_dirty_ = true;
 }
 
 #ifdef HAVE_OPENCV
@@ -235,6 +350,11 @@ void MotionDetector::clearExclusionZones() {
  * @brief Returns the motion mask
  */
 cv::Mat MotionDetector::getMotionMask() const {
+    if (bitmask_mask_) {
+        cv::Mat mask(bitmask_.height(), bitmask_.width(), CV_8UC1);
+        bitmask_.unpack(mask.data, mask.step[0]);
+        return mask;
+    }
     return motion_mask_.clone();
 }
 
@@ -242,6 +362,11 @@ cv::Mat MotionDetector::getMotionMask() const {
  * @brief Returns the background model
  */
 cv::Mat MotionDetector::getBackgroundModel() const {
+    if (params_.algorithm == MotionAlgorithm::RUNNING_AVG && running_avg_.width() > 0) {
+        cv::Mat background(running_avg_.height(), running_avg_.width(), CV_8UC1);
+        running_avg_.background(background.data, background.step[0]);
+        return background;
+    }
     if (bg_subtractor_) {
         cv::Mat background;
         bg_subtractor_->getBackgroundImage(background);
@@ -251,21 +376,416 @@ cv::Mat MotionDetector::getBackgroundModel() const {
 }
 #endif
 
+#ifdef HAVE_OPENCV
+/**
+ * @brief Returns true for formats whose first plane is full-resolution luma
+ */
+static bool hasLumaPlane(GstVideoFormat format) {
+    switch (format) {
+        case GST_VIDEO_FORMAT_I420:
+        case GST_VIDEO_FORMAT_YV12:
+        case GST_VIDEO_FORMAT_NV12:
+        case GST_VIDEO_FORMAT_NV21:
+        case GST_VIDEO_FORMAT_GRAY8:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Converts a BGR drawing color to BT.601 limited-range YUV
+ */
+static cv::Scalar bgrToYuv(const cv::Scalar& bgr) {
+    double b = bgr[0], g = bgr[1], r = bgr[2];
+    return cv::Scalar(
+         0.257 * r + 0.504 * g + 0.098 * b + 16.0,
+        -0.148 * r - 0.291 * g + 0.439 * b + 128.0,
+         0.439 * r - 0.368 * g - 0.071 * b + 128.0);
+}
+
+/**
+ * @brief Returns the drawing color for a motion intensity
+ */
+static cv::Scalar intensityColor(double intensity) {
+    if (intensity > 0.7) {
+        return cv::Scalar(0, 0, 255);   // Red - high motion
+    } else if (intensity > 0.4) {
+        return cv::Scalar(0, 165, 255); // Orange - medium motion
+    }
+    return cv::Scalar(0, 255, 0);       // Green - low motion
+}
+
+/**
+ * @brief Draws a region's motion direction from its centre
+ *
+ * The arrow spans eight frames of motion so that slow objects stay visible.
+ */
+static void drawMotionVector(cv::Mat& plane, const MotionRegion& region, const cv::Scalar& color) {
+    if (region.dx == 0.0 && region.dy == 0.0) {
+        return;
+    }
+    cv::Point center(region.x + region.width / 2, region.y + region.height / 2);
+    cv::Point tip(center.x + cvRound(region.dx * 8.0), center.y + cvRound(region.dy * 8.0));
+    cv::arrowedLine(plane, center, tip, color, 2);
+}
+
+/**
+ * @brief Block SAD above which a 16x16 block counts as moving
+ *
+ * A mean absolute difference of a quarter of the pixel threshold: a block is
+ * moving when roughly a quarter of its pixels change by the threshold.
+ */
+static int blockSadThreshold(double threshold) {
+    return static_cast<int>(threshold * BlockMotionEstimator::kBlockSize *
+                            BlockMotionEstimator::kBlockSize / 4.0);
+}
+#endif
+
 /**
  * @brief Processes a video frame
+ *
+ * For planar YUV and gray formats the Y plane is wrapped in place (with its
+ * stride) and fed straight to the detector; the buffer is only written where
+ * regions are drawn. Packed RGB/BGR input, the debug view and color MOG2/KNN
+ * input go through processFrameBGR().
  */
 GstBuffer* MotionDetector::processFrame(GstBuffer* buffer, const GstVideoInfo* info) {
     if (!enabled_) {
         return buffer;
     }
     
+    frames_metric_.inc();
+
+#ifdef HAVE_OPENCV
+    if (params_.async_analysis) {
+        processFrameAsync(buffer, info);
+        return buffer;
+    }
+    
+    bool color_subtractor = params_.subtractor_color_input &&
+                            (params_.algorithm == MotionAlgorithm::MOG2 ||
+                             params_.algorithm == MotionAlgorithm::KNN);
+    if (!hasLumaPlane(GST_VIDEO_INFO_FORMAT(info)) ||
+        params_.show_debug_view || color_subtractor) {
+        return processFrameBGR(buffer, info);
+    }
+
+    // Only request write access when something may be drawn
+    GstMapFlags flags = params_.draw_motion_regions ? GST_MAP_READWRITE : GST_MAP_READ;
+    GstVideoFrame frame;
+    if (!gst_video_frame_map(&frame, info, buffer, flags)) {
+        return buffer;
+    }
+    
+    int width = GST_VIDEO_FRAME_WIDTH(&frame);
+    int height = GST_VIDEO_FRAME_HEIGHT(&frame);
+    
+    // Y plane view, no copy and no color conversion
+    cv::Mat luma(height, width, CV_8UC1,
+                 GST_VIDEO_FRAME_PLANE_DATA(&frame, 0),
+                 GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0));
+    
+    // Detect motion
+    std::vector<MotionRegion> regions = detectMotion(luma);
+    updateMotionState(regions, width, height, GST_BUFFER_PTS(buffer), params_);
+    
+    // Visualization (touches only the drawn pixels)
+    if (params_.draw_motion_regions && !regions.empty()) {
+        drawMotionRegionsPlanar(&frame, regions);
+    }
+    
+    gst_video_frame_unmap(&frame);
+#endif // HAVE_OPENCV
+    
+    return buffer;
+}
+
+/**
+ * @brief Stores regions, updates statistics and raises alerts
+ */
+void MotionDetector::updateMotionState(const std::vector<MotionRegion>& regions,
+                                       int width, int height, guint64 timestamp,
+                                       const MotionDetectionParams& params) {
+    // Store motion regions
+    {
+        std::lock_guard<std::mutex> lock(motions_mutex_);
+        current_motions_ = regions;
+    }
+    
+    // Update motion history
+    motion_history_.push_back(regions);
+    if (motion_history_.size() > max_history_size_) {
+        motion_history_.pop_front();
+    }
+    
+    // Track regions; only state changes are queued for the dispatcher
+    if (params.enable_tracking && track_dispatcher_.hasCallback()) {
+        tracker_.setParams(params.tracking);
+        std::vector<MotionTrackEvent> events = tracker_.update(regions, timestamp);
+        if (!events.empty()) {
+            size_t dropped = track_dispatcher_.push(events);
+            track_events_metric_.inc(events.size());
+            dropped_track_events_metric_.inc(dropped);
+        }
+    }
+    
+    if (regions.empty()) {
+        return;
+    }
+    
+    // Calculate motion area
+    double total_area = 0;
+    for (const auto& region : regions) {
+        total_area += region.width * region.height;
+    }
+    double motion_percentage = (total_area / (width * height)) * 100.0;
+    
     // Update statistics
+    motion_frames_metric_.inc();
+    regions_metric_.inc(regions.size());
+    motion_area_metric_.observe(motion_percentage);
+    atomicMax(max_motion_area_, motion_percentage);
+    last_motion_ns_.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                          std::memory_order_relaxed);
+    
+    // Trigger motion event
+    if (motion_percentage > params.alert_threshold) {
+        if (activity_callback_) {
+            activity_callback_(timestamp);
+        }
+        triggerMotionEvent(regions, timestamp, motion_percentage, params);
+    }
+}
+
+/**
+ * @brief Attaches the latest results as ROI and overlay metadata
+ */
+void MotionDetector::attachMotionMeta(GstBuffer* buffer, guint64 frame_no) {
+    std::lock_guard<std::mutex> lock(motions_mutex_);
+    if (analyzed_frame_no_ == 0) {
+        return; // Nothing analysed yet
+    }
+    
+    guint64 lag = frame_no - analyzed_frame_no_;
+    lag_metric_.set(static_cast<double>(lag));
+    atomicMax(max_lag_, static_cast<double>(lag));
+    
+    for (const auto& region : current_motions_) {
+        GstVideoRegionOfInterestMeta* meta = gst_buffer_add_video_region_of_interest_meta(
+            buffer, "motion", region.x, region.y, region.width, region.height);
+        if (meta) {
+            gst_video_region_of_interest_meta_add_param(meta,
+                gst_structure_new("motion",
+                                  "intensity", G_TYPE_DOUBLE, region.intensity,
+                                  "lag-frames", G_TYPE_UINT64, lag,
+                                  nullptr));
+        }
+    }
+    
+    if (overlay_) {
+        gst_buffer_add_video_overlay_composition_meta(buffer, overlay_);
+    }
+}
+
+/**
+ * @brief Stops the asynchronous analysis worker
+ */
+void MotionDetector::stopAnalysisWorker() {
     {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.total_frames++;
+        std::lock_guard<std::mutex> lock(slot_mutex_);
+        if (!worker_running_) {
+            return;
+        }
+        worker_stop_ = true;
     }
+    slot_cv_.notify_all();
+    if (worker_thread_.joinable()) {
+        worker_thread_.join();
+    }
+    
+    std::lock_guard<std::mutex> lock(slot_mutex_);
+    worker_running_ = false;
+    worker_stop_ = false;
+    slot_full_ = false;
+}
 
 #ifdef HAVE_OPENCV
+/**
+ * @brief Hands the frame's luma to the worker and annotates the buffer
+ *
+ * The streaming thread only copies (or, with analysis_scale < 1, decimates)
+ * the Y plane into the hand-over slot; a frame still waiting in the slot is
+ * replaced, so the worker always picks up the newest one. Pixels are never
+ * modified: the most recent results ride on the buffer as metadata.
+ */
+void MotionDetector::processFrameAsync(GstBuffer* buffer, const GstVideoInfo* info) {
+    guint64 frame_no = ++frame_counter_;
+    
+    {
+        std::lock_guard<std::mutex> lock(slot_mutex_);
+        if (!worker_running_) {
+            worker_running_ = true;
+            worker_thread_ = std::thread(&MotionDetector::analysisWorker, this);
+        }
+    }
+    
+    GstVideoFrame frame;
+    if (gst_video_frame_map(&frame, info, buffer, GST_MAP_READ)) {
+        GstVideoFormat format = GST_VIDEO_FRAME_FORMAT(&frame);
+        int width = GST_VIDEO_FRAME_WIDTH(&frame);
+        int height = GST_VIDEO_FRAME_HEIGHT(&frame);
+        void* data = GST_VIDEO_FRAME_PLANE_DATA(&frame, 0);
+        size_t stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0);
+        
+        cv::Mat luma;
+        if (hasLumaPlane(format)) {
+            luma = cv::Mat(height, width, CV_8UC1, data, stride);
+        } else if (format == GST_VIDEO_FORMAT_BGR || format == GST_VIDEO_FORMAT_RGB) {
+            cv::cvtColor(cv::Mat(height, width, CV_8UC3, data, stride), luma,
+                         format == GST_VIDEO_FORMAT_BGR ? cv::COLOR_BGR2GRAY : cv::COLOR_RGB2GRAY);
+        }
+        
+        if (!luma.empty()) {
+            int factor = analysisFactor();
+            if (factor > 1) {
+                cv::resize(luma, staging_frame_,
+                           cv::Size(std::max(1, width / factor), std::max(1, height / factor)),
+                           0, 0, cv::INTER_AREA);
+            } else {
+                luma.copyTo(staging_frame_);
+            }
+        }
+        gst_video_frame_unmap(&frame);
+        
+        if (!luma.empty()) {
+            bool replaced = false;
+            {
+                std::lock_guard<std::mutex> lock(slot_mutex_);
+                replaced = slot_full_;
+                std::swap(slot_frame_, staging_frame_);
+                slot_frame_no_ = frame_no;
+                slot_pts_ = GST_BUFFER_PTS(buffer);
+                slot_width_ = width;
+                slot_height_ = height;
+                slot_full_ = true;
+            }
+            slot_cv_.notify_one();
+            
+            if (replaced) {
+                dropped_metric_.inc();
+            }
+        }
+    }
+    
+    attachMotionMeta(buffer, frame_no);
+}
+
+/**
+ * @brief Worker thread loop
+ */
+void MotionDetector::analysisWorker() {
+    while (true) {
+        guint64 frame_no, pts;
+        int width, height;
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex_);
+            slot_cv_.wait(lock, [this] { return slot_full_ || worker_stop_; });
+            if (worker_stop_) {
+                break;
+            }
+            std::swap(work_frame_, slot_frame_);
+            slot_full_ = false;
+            frame_no = slot_frame_no_;
+            pts = slot_pts_;
+            width = slot_width_;
+            height = slot_height_;
+        }
+        
+        std::vector<MotionRegion> regions;
+        MotionDetectionParams params;
+        {
+            // Serialises with setParameters()/setAlgorithm(); the rest of
+            // the frame uses this copy, never params_ outside the lock
+            std::lock_guard<std::mutex> lock(params_mutex_);
+            regions = detectMotion(work_frame_, true);
+            params = params_;
+        }
+        for (auto& region : regions) {
+            region.timestamp = pts;
+        }
+        
+        GstVideoOverlayComposition* overlay =
+            params.draw_motion_regions ? buildOverlay(regions) : nullptr;
+        
+        updateMotionState(regions, width, height, pts, params);
+        
+        {
+            std::lock_guard<std::mutex> lock(motions_mutex_);
+            std::swap(overlay_, overlay);
+            analyzed_frame_no_ = frame_no;
+        }
+        if (overlay) {
+            gst_video_overlay_composition_unref(overlay);
+        }
+        
+        analyzed_metric_.inc();
+    }
+}
+
+/**
+ * @brief Builds the overlay composition for a set of regions
+ *
+ * Each box is four thin opaque rectangles so the overlay stays small no
+ * matter how large the region is.
+ */
+GstVideoOverlayComposition* MotionDetector::buildOverlay(const std::vector<MotionRegion>& regions) {
+    GstVideoOverlayComposition* composition = nullptr;
+    const int thickness = 2;
+    
+    auto addBar = [&composition](int x, int y, int w, int h, const cv::Scalar& bgr) {
+        if (w <= 0 || h <= 0) {
+            return;
+        }
+        GstBuffer* pixels = gst_buffer_new_allocate(nullptr, w * h * 4, nullptr);
+        GstMapInfo map;
+        if (!gst_buffer_map(pixels, &map, GST_MAP_WRITE)) {
+            gst_buffer_unref(pixels);
+            return;
+        }
+        // Overlay format is BGRA in memory on little-endian hosts
+        cv::Mat(h, w, CV_8UC4, map.data).setTo(cv::Scalar(bgr[0], bgr[1], bgr[2], 255));
+        gst_buffer_unmap(pixels, &map);
+        gst_buffer_add_video_meta(pixels, GST_VIDEO_FRAME_FLAG_NONE,
+                                  GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB, w, h);
+        
+        GstVideoOverlayRectangle* rect = gst_video_overlay_rectangle_new_raw(
+            pixels, x, y, w, h, GST_VIDEO_OVERLAY_FORMAT_FLAG_NONE);
+        gst_buffer_unref(pixels);
+        
+        if (!composition) {
+            composition = gst_video_overlay_composition_new(rect);
+        } else {
+            gst_video_overlay_composition_add_rectangle(composition, rect);
+        }
+        gst_video_overlay_rectangle_unref(rect);
+    };
+    
+    for (const auto& region : regions) {
+        cv::Scalar color = intensityColor(region.intensity);
+        addBar(region.x, region.y, region.width, thickness, color);
+        addBar(region.x, region.y + region.height - thickness, region.width, thickness, color);
+        addBar(region.x, region.y, thickness, region.height, color);
+        addBar(region.x + region.width - thickness, region.y, thickness, region.height, color);
+    }
+    
+    return composition;
+}
+
+/**
+ * @brief Processes a frame through a BGR copy
+ */
+GstBuffer* MotionDetector::processFrameBGR(GstBuffer* buffer, const GstVideoInfo* info) {
     // Convert buffer to OpenCV Mat
     GstMapInfo map;
     if (!gst_buffer_map(buffer, &map, GST_MAP_READWRITE)) {
@@ -302,60 +822,30 @@ GstBuffer* MotionDetector::processFrame(GstBuffer* buffer, const GstVideoInfo* i
     
     // Detect motion
     std::vector<MotionRegion> regions = detectMotion(frame);
+    updateMotionState(regions, width, height, GST_BUFFER_PTS(buffer), params_);
     
-    // Store motion regions
-    {
-        std::lock_guard<std::mutex> lock(motions_mutex_);
-        current_motions_ = regions;
+    // Nothing to write back
+    if (!params_.draw_motion_regions && !params_.show_debug_view) {
+        gst_buffer_unmap(buffer, &map);
+        return buffer;
     }
     
-    // Update motion history
-    motion_history_.push_back(regions);
-    if (motion_history_.size() > max_history_size_) {
-        motion_history_.pop_front();
-    }
+    // Visualization
+    drawMotionRegions(frame, regions);
     
-    // Update statistics
-    if (!regions.empty()) {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.motion_frames++;
-        stats_.last_motion_time = std::chrono::steady_clock::now();
-        stats_.total_regions += regions.size();
-        
-        // Calculate motion area
-        double total_area = 0;
-        for (const auto& region : regions) {
-            total_area += region.width * region.height;
+    // Debug view
+    if (params_.show_debug_view && !motion_mask_.empty()) {
+        cv::Mat debug_view;
+        cv::cvtColor(motion_mask_, debug_view, cv::COLOR_GRAY2BGR);
+        if (debug_view.size() != frame.size()) {
+            cv::resize(debug_view, debug_view, frame.size(), 0, 0, cv::INTER_NEAREST);
         }
-        double motion_percentage = (total_area / (width * height)) * 100.0;
         
-        stats_.average_motion_area = 
-            (stats_.average_motion_area * (stats_.motion_frames - 1) + motion_percentage) 
-            / stats_.motion_frames;
-        
-        stats_.max_motion_area = std::max(stats_.max_motion_area, motion_percentage);
-        
-        // Trigger motion event
-        if (motion_percentage > params_.alert_threshold) {
-            triggerMotionEvent(regions, GST_BUFFER_PTS(buffer));
-        }
-    }
-    
-    // Visualization
-    if (params_.draw_motion_regions || params_.show_debug_view) {
-        drawMotionRegions(frame, regions);
-        
-        // Debug view
-        if (params_.show_debug_view && !motion_mask_.empty()) {
-            cv::Mat debug_view;
-            cv::cvtColor(motion_mask_, debug_view, cv::COLOR_GRAY2BGR);
-            
-            // Split screen: left side original, right side motion mask
-            cv::Mat combined(height, width * 2, CV_8UC3);
-            frame.copyTo(combined(cv::Rect(0, 0, width, height)));
-            debug_view.copyTo(combined(cv::Rect(width, 0, width, height)));
-            frame = combined;
-        }
+        // Split screen: left side original, right side motion mask
+        cv::Mat combined(height, width * 2, CV_8UC3);
+        frame.copyTo(combined(cv::Rect(0, 0, width, height)));
+        debug_view.copyTo(combined(cv::Rect(width, 0, width, height)));
+        frame = combined;
     }
     
     // Write frame back to buffer
@@ -385,16 +875,70 @@ GstBuffer* MotionDetector::processFrame(GstBuffer* buffer, const GstVideoInfo* i
     }
     
     gst_buffer_unmap(buffer, &map);
-#endif // HAVE_OPENCV
-    
     return buffer;
 }
+#endif // HAVE_OPENCV
 
 #ifdef HAVE_OPENCV
+/**
+ * @brief Returns the analysis decimation factor
+ */
+int MotionDetector::analysisFactor() const {
+    if (params_.analysis_scale <= 0.0 || params_.analysis_scale >= 1.0) {
+        return 1;
+    }
+    // Snap 1/scale to the nearest supported power of two
+    double inverse = 1.0 / params_.analysis_scale;
+    if (inverse < 3.0) return 2;
+    if (inverse < 6.0) return 4;
+    return 8;
+}
+
+/**
+ * @brief Maps a full-resolution rectangle onto the analysis grid
+ */
+static cv::Rect toAnalysisRect(const cv::Rect& rect, int factor, const cv::Size& bounds) {
+    int x0 = rect.x / factor;
+    int y0 = rect.y / factor;
+    int x1 = (rect.x + rect.width + factor - 1) / factor;
+    int y1 = (rect.y + rect.height + factor - 1) / factor;
+    return cv::Rect(x0, y0, x1 - x0, y1 - y0) & cv::Rect(0, 0, bounds.width, bounds.height);
+}
+
+/**
+ * @brief Runs motion detection on a single frame outside the pipeline
+ */
+std::vector<MotionRegion> MotionDetector::process(const cv::Mat& frame) {
+    std::vector<MotionRegion> regions = detectMotion(frame);
+    updateMotionState(regions, frame.cols, frame.rows, 0, params_);
+    return regions;
+}
+
 /**
  * @brief Detect motion with OpenCV
+ *
+ * With analysis_scale < 1 the frame is decimated (INTER_AREA) first, so
+ * background modelling, thresholding, morphology and contour extraction run on
+ * the small grid. ROI and exclusion zones are mapped onto that grid and the
+ * regions are scaled back to input coordinates before area filtering.
  */
-std::vector<MotionRegion> MotionDetector::detectMotion(const cv::Mat& frame) {
+std::vector<MotionRegion> MotionDetector::detectMotion(const cv::Mat& input, bool prescaled) {
+    int factor = analysisFactor();
+    const cv::Mat* frame_ptr = &input;
+    if (factor > 1 && !prescaled) {
+        cv::resize(input, analysis_frame_,
+                   cv::Size(std::max(1, input.cols / factor), std::max(1, input.rows / factor)),
+                   0, 0, cv::INTER_AREA);
+        frame_ptr = &analysis_frame_;
+    }
+    const cv::Mat& frame = *frame_ptr;
+    
+    if (params_.algorithm == MotionAlgorithm::FRAME_DIFF && params_.use_bitmask_kernel &&
+        frame.type() == CV_8UC1) {
+        return detectMotionBitmask(frame, factor);
+    }
+    bitmask_mask_ = false;
+    
     cv::Mat mask;
     
     // Algorithm selection
@@ -409,9 +953,12 @@ std::vector<MotionRegion> MotionDetector::detectMotion(const cv::Mat& frame) {
             mask = backgroundSubtraction(frame);
             break;
             
+        case MotionAlgorithm::RUNNING_AVG:
+            mask = runningAverage(frame);
+            break;
+            
         case MotionAlgorithm::OPTICAL_FLOW:
-            // TODO: Optical flow implementation
-            mask = cv::Mat::zeros(frame.size(), CV_8UC1);
+            mask = opticalFlow(frame, factor);
             break;
             
         default:
@@ -419,28 +966,112 @@ std::vector<MotionRegion> MotionDetector::detectMotion(const cv::Mat& frame) {
             break;
     }
     
-    // Apply ROI if set
-    if (has_roi_) {
-        cv::Mat roi_mask = cv::Mat::zeros(mask.size(), CV_8UC1);
-        roi_mask(roi_) = 255;
-        cv::bitwise_and(mask, roi_mask, mask);
-    }
-    
-    // Apply exclusion zones
-    for (const auto& zone : exclusion_zones_) {
-        mask(zone) = 0;
+    // Apply ROI and exclusion zones (mask rebuilt only when they change)
+    if (has_roi_ || !exclusion_zones_.empty()) {
+        if (static_mask_dirty_ || static_mask_.size() != mask.size() ||
+            static_mask_factor_ != factor) {
+            static_mask_.create(mask.size(), CV_8UC1);
+            static_mask_.setTo(cv::Scalar(has_roi_ ? 0 : 255));
+            if (has_roi_) {
+                static_mask_(toAnalysisRect(roi_, factor, mask.size())) = 255;
+            }
+            for (const auto& zone : exclusion_zones_) {
+                cv::Rect scaled = toAnalysisRect(zone, factor, mask.size());
+                if (!scaled.empty()) {
+                    static_mask_(scaled) = 0;
+                }
+            }
+            static_mask_factor_ = factor;
+            static_mask_dirty_ = false;
+        }
+        cv::bitwise_and(mask, static_mask_, mask);
     }
     
     // Morphological operations
-    applyMorphology(mask);
+    applyMorphology(mask, factor);
     
     // Store motion mask
     motion_mask_ = mask.clone();
     
-    // Find motion regions
-    std::vector<MotionRegion> regions = findMotionRegions(mask);
+    // Find motion regions (returned in input coordinates)
+    std::vector<MotionRegion> regions = findMotionRegions(mask, factor);
     
     // Filter regions
+    regions = filterRegions(regions);
+    if (params_.algorithm == MotionAlgorithm::OPTICAL_FLOW) {
+        assignRegionMotion(regions, factor);
+    }
+    return regions;
+}
+
+/**
+ * @brief Frame difference through the bit-packed kernel
+ *
+ * Same stages as the OpenCV path (threshold, erode, dilate, open, close,
+ * components) on a one-bit-per-pixel mask. Tiles outside the ROI are never
+ * read and a frame without changed tiles returns before morphology. The
+ * structuring elements are squares rather than ellipses.
+ */
+std::vector<MotionRegion> MotionDetector::detectMotionBitmask(const cv::Mat& frame, int factor) {
+    if (bitmask_.width() != frame.cols || bitmask_.height() != frame.rows) {
+        bitmask_.configure(frame.cols, frame.rows);
+        bitmask_zones_dirty_ = true;
+    }
+    if (bitmask_zones_dirty_ || bitmask_factor_ != factor) {
+        auto toBitmaskRect = [&](const cv::Rect& rect) {
+            cv::Rect scaled = toAnalysisRect(rect, factor, frame.size());
+            BitmaskRect out;
+            out.x = scaled.x;
+            out.y = scaled.y;
+            out.width = scaled.width;
+            out.height = scaled.height;
+            return out;
+        };
+        BitmaskRect roi = toBitmaskRect(roi_);
+        std::vector<BitmaskRect> exclusions;
+        for (const auto& zone : exclusion_zones_) {
+            exclusions.push_back(toBitmaskRect(zone));
+        }
+        bitmask_.setStaticMask(has_roi_ ? &roi : nullptr, exclusions);
+        bitmask_factor_ = factor;
+        bitmask_zones_dirty_ = false;
+    }
+    bitmask_mask_ = true;
+    
+    int threshold = static_cast<int>(std::floor(params_.threshold));
+    if (bitmask_.diffThreshold(frame.data, frame.step[0], threshold) == 0) {
+        return {};
+    }
+    
+    bitmask_.erode(params_.erosion_size / factor);
+    bitmask_.dilate(params_.dilation_size / factor);
+    int kernel_radius = 2 / factor;
+    if (kernel_radius > 0) {
+        // Opening then closing, as in applyMorphology()
+        bitmask_.erode(kernel_radius);
+        bitmask_.dilate(kernel_radius);
+        bitmask_.dilate(kernel_radius);
+        bitmask_.erode(kernel_radius);
+    }
+    if (bitmask_.activeTiles() == 0) {
+        return {};
+    }
+    
+    std::vector<MotionRegion> regions;
+    for (const auto& blob : bitmask_.label()) {
+        double area = static_cast<double>(blob.area) * factor * factor;
+        if (area < params_.min_area) {
+            continue;
+        }
+        MotionRegion region;
+        region.x = blob.x * factor;
+        region.y = blob.y * factor;
+        region.width = blob.width * factor;
+        region.height = blob.height * factor;
+        region.intensity = std::min(1.0, area / (params_.max_area * 0.5));
+        region.timestamp = 0;
+        regions.push_back(region);
+    }
     return filterRegions(regions);
 }
 
@@ -450,12 +1081,17 @@ std::vector<MotionRegion> MotionDetector::detectMotion(const cv::Mat& frame) {
 cv::Mat MotionDetector::frameDifference(const cv::Mat& frame) {
     cv::Mat gray, diff, mask;
     
-    // Convert to grayscale
-    cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    // Luma planes arrive as gray already
+    if (frame.channels() == 1) {
+        gray = frame;
+    } else {
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    }
     
-    // Store if first frame
-    if (previous_frame_.empty()) {
-        previous_frame_ = gray.clone();
+    // Store if first frame (or the input geometry changed)
+    if (previous_frame_.empty() || previous_frame_.size() != gray.size() ||
+        previous_frame_.type() != gray.type()) {
+        gray.copyTo(previous_frame_);
         return cv::Mat::zeros(frame.size(), CV_8UC1);
     }
     
@@ -465,8 +1101,8 @@ cv::Mat MotionDetector::frameDifference(const cv::Mat& frame) {
     // Thresholding
     cv::threshold(diff, mask, params_.threshold, 255, cv::THRESH_BINARY);
     
-    // Update previous frame
-    previous_frame_ = gray.clone();
+    // Update previous frame (reuses the allocation; gray may be a buffer view)
+    gray.copyTo(previous_frame_);
     
     return mask;
 }
@@ -478,23 +1114,35 @@ cv::Mat MotionDetector::backgroundSubtraction(const cv::Mat& frame) {
     cv::Mat mask;
     
     if (bg_subtractor_) {
-        // Use OpenCV background subtractor
-        bg_subtractor_->apply(frame, mask, params_.learning_rate);
+        // Use OpenCV background subtractor, optionally on a decimated copy
+        int factor = std::max(1, params_.subtractor_downscale);
+        if (factor > 1) {
+            cv::resize(frame, subtractor_input_,
+                       cv::Size(frame.cols / factor, frame.rows / factor),
+                       0, 0, cv::INTER_AREA);
+            bg_subtractor_->apply(subtractor_input_, subtractor_mask_, params_.learning_rate);
+            cv::resize(subtractor_mask_, mask, frame.size(), 0, 0, cv::INTER_NEAREST);
+        } else {
+            bg_subtractor_->apply(frame, mask, params_.learning_rate);
+        }
         
         // Remove shadows (if enabled)
         if (params_.detect_shadows) {
             cv::threshold(mask, mask, 128, 255, cv::THRESH_BINARY);
         }
     } else {
-        // Simple background model
-        if (background_model_.empty()) {
-            background_model_ = frame.clone();
+        // Simple background model (gray or BGR, following the input)
+        if (background_model_.empty() || background_model_.size() != frame.size() ||
+            background_model_.type() != frame.type()) {
+            frame.copyTo(background_model_);
             return cv::Mat::zeros(frame.size(), CV_8UC1);
         }
         
         cv::Mat diff;
         cv::absdiff(frame, background_model_, diff);
-        cv::cvtColor(diff, diff, cv::COLOR_BGR2GRAY);
+        if (diff.channels() != 1) {
+            cv::cvtColor(diff, diff, cv::COLOR_BGR2GRAY);
+        }
         cv::threshold(diff, mask, params_.threshold, 255, cv::THRESH_BINARY);
         
         // Update background model
@@ -505,56 +1153,200 @@ cv::Mat MotionDetector::backgroundSubtraction(const cv::Mat& frame) {
     return mask;
 }
 
+/**
+ * @brief Fixed-point running-average background model
+ *
+ * Runs on luma only; BGR input (debug view, packed formats) is converted
+ * first. Pixels classified as motion are updated with
+ * foreground_learning_rate so slow-moving objects are not absorbed.
+ */
+cv::Mat MotionDetector::runningAverage(const cv::Mat& frame) {
+    const cv::Mat* luma = &frame;
+    if (frame.channels() != 1) {
+        cv::cvtColor(frame, luma_input_, cv::COLOR_BGR2GRAY);
+        luma = &luma_input_;
+    }
+    
+    if (running_avg_.width() != luma->cols || running_avg_.height() != luma->rows ||
+        running_avg_threads_ != params_.analysis_threads) {
+        running_avg_.configure(luma->cols, luma->rows, params_.analysis_threads);
+        running_avg_threads_ = params_.analysis_threads;
+    }
+    running_avg_.setLearningRates(params_.learning_rate, params_.foreground_learning_rate);
+    
+    cv::Mat mask(luma->size(), CV_8UC1);
+    running_avg_.apply(luma->data, luma->step[0], static_cast<int>(std::floor(params_.threshold)),
+                       mask.data, mask.step[0]);
+    return mask;
+}
+
+/**
+ * @brief Block-matching optical flow
+ *
+ * Runs BlockMotionEstimator on luma and marks every moving 16x16 block in the
+ * mask; the regular morphology/contour stages then merge blocks into regions.
+ * The field is published in input coordinates for getMotionVectorField().
+ */
+cv::Mat MotionDetector::opticalFlow(const cv::Mat& frame, int factor) {
+    const cv::Mat* luma = &frame;
+    if (frame.channels() != 1) {
+        cv::cvtColor(frame, luma_input_, cv::COLOR_BGR2GRAY);
+        luma = &luma_input_;
+    }
+    
+    if (block_motion_.width() != luma->cols || block_motion_.height() != luma->rows ||
+        block_motion_threads_ != params_.analysis_threads ||
+        block_motion_range_ != params_.block_search_range) {
+        block_motion_.configure(luma->cols, luma->rows, params_.block_search_range,
+                                params_.analysis_threads);
+        block_motion_threads_ = params_.analysis_threads;
+        block_motion_range_ = params_.block_search_range;
+    }
+    
+    cv::Mat mask = cv::Mat::zeros(luma->size(), CV_8UC1);
+    bool estimated = block_motion_.estimate(luma->data, luma->step[0]);
+    
+    const int block = BlockMotionEstimator::kBlockSize;
+    int blocks_x = block_motion_.blocksX();
+    int blocks_y = block_motion_.blocksY();
+    if (estimated && blocks_x > 0 && blocks_y > 0) {
+        block_mask_.create(blocks_y, blocks_x, CV_8UC1);
+        if (block_motion_.blockMask(blockSadThreshold(params_.threshold),
+                                    block_mask_.data, block_mask_.step[0]) > 0) {
+            cv::Mat covered = mask(cv::Rect(0, 0, blocks_x * block, blocks_y * block));
+            cv::resize(block_mask_, covered, covered.size(), 0, 0, cv::INTER_NEAREST);
+        }
+    }
+    
+    // Publish the field in input coordinates
+    MotionVectorField field;
+    field.blocks_x = blocks_x;
+    field.blocks_y = blocks_y;
+    field.block_size = block * factor;
+    field.vectors = block_motion_.field();
+    for (auto& vector : field.vectors) {
+        vector.dx = static_cast<int16_t>(vector.dx * factor);
+        vector.dy = static_cast<int16_t>(vector.dy * factor);
+    }
+    {
+        std::lock_guard<std::mutex> lock(motions_mutex_);
+        motion_field_ = std::move(field);
+    }
+    
+    return mask;
+}
+
+/**
+ * @brief Sets region directions from the block motion field
+ *
+ * Averages the vectors of the moving blocks whose centres fall inside each
+ * region.
+ */
+void MotionDetector::assignRegionMotion(std::vector<MotionRegion>& regions, int factor) const {
+    const int block = BlockMotionEstimator::kBlockSize;
+    const int sad_threshold = blockSadThreshold(params_.threshold);
+    const std::vector<MotionVector>& field = block_motion_.field();
+    const int blocks_x = block_motion_.blocksX();
+    const int blocks_y = block_motion_.blocksY();
+    
+    for (auto& region : regions) {
+        int bx0 = std::max(0, region.x / factor / block);
+        int by0 = std::max(0, region.y / factor / block);
+        int bx1 = std::min(blocks_x, (region.x + region.width) / factor / block + 1);
+        int by1 = std::min(blocks_y, (region.y + region.height) / factor / block + 1);
+        
+        double sum_x = 0.0, sum_y = 0.0;
+        int count = 0;
+        for (int by = by0; by < by1; ++by) {
+            for (int bx = bx0; bx < bx1; ++bx) {
+                int cx = (bx * block + block / 2) * factor;
+                int cy = (by * block + block / 2) * factor;
+                const MotionVector& vector = field[static_cast<size_t>(by) * blocks_x + bx];
+                if (cx < region.x || cy < region.y ||
+                    cx >= region.x + region.width || cy >= region.y + region.height ||
+                    vector.zero_sad <= sad_threshold) {
+                    continue;
+                }
+                sum_x += vector.dx;
+                sum_y += vector.dy;
+                ++count;
+            }
+        }
+        if (count > 0) {
+            region.dx = sum_x / count * factor;
+            region.dy = sum_y / count * factor;
+        }
+    }
+}
+
 /**
  * @brief Apply morphological operations
+ *
+ * Kernel radii are divided by the analysis factor so the structuring elements
+ * cover the same footprint in input pixels; kernels that shrink to 1x1 are
+ * skipped.
  */
-void MotionDetector::applyMorphology(cv::Mat& mask) {
+void MotionDetector::applyMorphology(cv::Mat& mask, int factor) {
+    int erosion_size = params_.erosion_size / factor;
+    int dilation_size = params_.dilation_size / factor;
+    
     // Erosion (remove small noise)
-    if (params_.erosion_size > 0) {
-        cv::Mat erosion_kernel = cv::getStructuringElement(
-            cv::MORPH_ELLIPSE,
-            cv::Size(params_.erosion_size * 2 + 1, params_.erosion_size * 2 + 1)
-        );
-        cv::erode(mask, mask, erosion_kernel);
+    if (erosion_size > 0) {
+        cv::erode(mask, mask, cachedKernel(erosion_kernel_, erosion_radius_, erosion_size));
     }
     
     // Dilation (fill gaps)
-    if (params_.dilation_size > 0) {
-        cv::Mat dilation_kernel = cv::getStructuringElement(
-            cv::MORPH_ELLIPSE,
-            cv::Size(params_.dilation_size * 2 + 1, params_.dilation_size * 2 + 1)
-        );
-        cv::dilate(mask, mask, dilation_kernel);
+    if (dilation_size > 0) {
+        cv::dilate(mask, mask, cachedKernel(dilation_kernel_, dilation_radius_, dilation_size));
     }
     
-    // Opening operation - remove small objects
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5));
-    cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel);
-    
-    // Closing operation - fill small holes
-    cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, kernel);
+    // 5x5 at full resolution, 3x3 at 1/2, none below
+    int kernel_radius = 2 / factor;
+    if (kernel_radius > 0) {
+        const cv::Mat& kernel = cachedKernel(open_kernel_, open_radius_, kernel_radius);
+        
+        // Opening operation - remove small objects
+        cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel);
+        
+        // Closing operation - fill small holes
+        cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, kernel);
+    }
+}
+
+/**
+ * @brief Returns a cached elliptic structuring element
+ */
+const cv::Mat& MotionDetector::cachedKernel(cv::Mat& kernel, int& cached_radius, int radius) {
+    if (cached_radius != radius) {
+        kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE,
+                                           cv::Size(radius * 2 + 1, radius * 2 + 1));
+        cached_radius = radius;
+    }
+    return kernel;
 }
 
 /**
  * @brief Find motion regions
  */
-std::vector<MotionRegion> MotionDetector::findMotionRegions(const cv::Mat& mask) {
+std::vector<MotionRegion> MotionDetector::findMotionRegions(const cv::Mat& mask, int factor) {
     std::vector<MotionRegion> regions;
     std::vector<std::vector<cv::Point>> contours;
     
     // Find contours
     cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
     
-    // Create a region for each contour
+    // Create a region for each contour, scaled back to input coordinates
+    // so min_area/max_area keep their full-resolution meaning
+    double area_scale = static_cast<double>(factor) * factor;
     for (const auto& contour : contours) {
         cv::Rect bbox = cv::boundingRect(contour);
-        double area = cv::contourArea(contour);
+        double area = cv::contourArea(contour) * area_scale;
         
         MotionRegion region;
-        region.x = bbox.x;
-        region.y = bbox.y;
-        region.width = bbox.width;
-        region.height = bbox.height;
+        region.x = bbox.x * factor;
+        region.y = bbox.y * factor;
+        region.width = bbox.width * factor;
+        region.height = bbox.height * factor;
         region.intensity = std::min(1.0, area / (params_.max_area / 2.0));
         region.timestamp = 0; // Frame timestamp will be added later
         
@@ -606,14 +1398,7 @@ std::vector<MotionRegion> MotionDetector::filterRegions(const std::vector<Motion
 void MotionDetector::drawMotionRegions(cv::Mat& frame, const std::vector<MotionRegion>& regions) {
     for (const auto& region : regions) {
         // Determine color based on intensity
-        cv::Scalar color;
-        if (region.intensity > 0.7) {
-            color = cv::Scalar(0, 0, 255); // Red - high motion
-        } else if (region.intensity > 0.4) {
-            color = cv::Scalar(0, 165, 255); // Orange - medium motion
-        } else {
-            color = cv::Scalar(0, 255, 0); // Green - low motion
-        }
+        cv::Scalar color = intensityColor(region.intensity);
         
         // Draw rectangle
         cv::rectangle(frame, 
@@ -626,6 +1411,10 @@ void MotionDetector::drawMotionRegions(cv::Mat& frame, const std::vector<MotionR
         cv::putText(frame, info, 
                    cv::Point(region.x, region.y - 5),
                    cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
+        
+        if (params_.draw_motion_vectors) {
+            drawMotionVector(frame, region, color);
+        }
     }
     
     // General information
@@ -636,32 +1425,104 @@ void MotionDetector::drawMotionRegions(cv::Mat& frame, const std::vector<MotionR
                    cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 0, 255), 2);
     }
 }
+
+/**
+ * @brief Draw motion regions directly on the planes of a YUV/gray frame
+ *
+ * Rectangles are drawn into the luma plane and, at half resolution, into the
+ * chroma plane(s); labels are luma-only. Untouched pixels are never written.
+ */
+void MotionDetector::drawMotionRegionsPlanar(GstVideoFrame* frame,
+                                             const std::vector<MotionRegion>& regions) {
+    GstVideoFormat format = GST_VIDEO_FRAME_FORMAT(frame);
+    int width = GST_VIDEO_FRAME_WIDTH(frame);
+    int height = GST_VIDEO_FRAME_HEIGHT(frame);
+    
+    cv::Mat y_plane(height, width, CV_8UC1,
+                    GST_VIDEO_FRAME_PLANE_DATA(frame, 0),
+                    GST_VIDEO_FRAME_PLANE_STRIDE(frame, 0));
+    
+    // Chroma views (4:2:0 subsampled)
+    int cw = (width + 1) / 2;
+    int ch = (height + 1) / 2;
+    cv::Mat u_plane, v_plane, uv_plane;
+    switch (format) {
+        case GST_VIDEO_FORMAT_I420:
+        case GST_VIDEO_FORMAT_YV12:
+            u_plane = cv::Mat(ch, cw, CV_8UC1,
+                              GST_VIDEO_FRAME_COMP_DATA(frame, GST_VIDEO_COMP_U),
+                              GST_VIDEO_FRAME_COMP_STRIDE(frame, GST_VIDEO_COMP_U));
+            v_plane = cv::Mat(ch, cw, CV_8UC1,
+                              GST_VIDEO_FRAME_COMP_DATA(frame, GST_VIDEO_COMP_V),
+                              GST_VIDEO_FRAME_COMP_STRIDE(frame, GST_VIDEO_COMP_V));
+            break;
+        case GST_VIDEO_FORMAT_NV12:
+        case GST_VIDEO_FORMAT_NV21:
+            uv_plane = cv::Mat(ch, cw, CV_8UC2,
+                               GST_VIDEO_FRAME_PLANE_DATA(frame, 1),
+                               GST_VIDEO_FRAME_PLANE_STRIDE(frame, 1));
+            break;
+        default:
+            break; // GRAY8: luma only
+    }
+    
+    auto drawRect = [&](const cv::Rect& rect, const cv::Scalar& bgr, int thickness) {
+        cv::Scalar yuv = bgrToYuv(bgr);
+        cv::rectangle(y_plane, rect, cv::Scalar(yuv[0]), thickness);
+        
+        cv::Rect crect(rect.x / 2, rect.y / 2, rect.width / 2, rect.height / 2);
+        int cthickness = std::max(1, thickness / 2);
+        if (!u_plane.empty()) {
+            cv::rectangle(u_plane, crect, cv::Scalar(yuv[1]), cthickness);
+            cv::rectangle(v_plane, crect, cv::Scalar(yuv[2]), cthickness);
+        } else if (!uv_plane.empty()) {
+            cv::Scalar uv = (format == GST_VIDEO_FORMAT_NV12)
+                ? cv::Scalar(yuv[1], yuv[2]) : cv::Scalar(yuv[2], yuv[1]);
+            cv::rectangle(uv_plane, crect, uv, cthickness);
+        }
+    };
+    
+    for (const auto& region : regions) {
+        cv::Scalar color = intensityColor(region.intensity);
+        drawRect(cv::Rect(region.x, region.y, region.width, region.height), color, 2);
+        
+        // Info text (luma only)
+        std::string info = "Motion: " + 
+                          std::to_string(static_cast<int>(region.intensity * 100)) + "%";
+        cv::putText(y_plane, info,
+                   cv::Point(region.x, region.y - 5),
+                   cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(bgrToYuv(color)[0]), 1);
+        
+        if (params_.draw_motion_vectors) {
+            drawMotionVector(y_plane, region, cv::Scalar(bgrToYuv(color)[0]));
+        }
+    }
+    
+    // General information
+    std::string status = "MOTION DETECTED - " + std::to_string(regions.size()) + " regions";
+    cv::putText(y_plane, status,
+               cv::Point(10, 30),
+               cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(235), 2);
+}
 #endif // HAVE_OPENCV
 
 /**
- * @brief Transform callback
+ * @brief In-place transform callback
  */
-static GstFlowReturn motion_detector_transform(GstBaseTransform* trans,
-                                             GstBuffer* inbuf,
-                                             GstBuffer* outbuf) {
+static GstFlowReturn motion_detector_transform_ip(GstBaseTransform* trans,
+                                                GstBuffer* buf) {
     MotionDetectorElement* element = MOTION_DETECTOR(trans);
     MotionDetector* detector = element->detector;
     
     if (!detector) {
         return GST_FLOW_ERROR;
     }
-    
-    // Get video info
-    GstVideoInfo info;
-    GstCaps* caps = gst_pad_get_current_caps(GST_BASE_TRANSFORM_SINK_PAD(trans));
-    if (!gst_video_info_from_caps(&info, caps)) {
-        gst_caps_unref(caps);
-        return GST_FLOW_ERROR;
+    if (!element->info_valid) {
+        return GST_FLOW_NOT_NEGOTIATED;
     }
-    gst_caps_unref(caps);
     
-    // Process frame (in-place)
-    detector->processFrame(inbuf, &info);
+    // Process frame (in-place, video info cached from set_caps)
+    detector->processFrame(buf, &element->info);
     
     return GST_FLOW_OK;
 }
@@ -672,6 +1533,20 @@ static GstFlowReturn motion_detector_transform(GstBaseTransform* trans,
 static gboolean motion_detector_set_caps(GstBaseTransform* trans,
                                        GstCaps* incaps,
                                        GstCaps* outcaps) {
+    MotionDetectorElement* element = MOTION_DETECTOR(trans);
+    element->info_valid = gst_video_info_from_caps(&element->info, incaps);
+    return element->info_valid;
+}
+
+/**
+ * @brief Stop callback - joins the analysis worker
+ */
+static gboolean motion_detector_stop(GstBaseTransform* trans) {
+    MotionDetectorElement* element = MOTION_DETECTOR(trans);
+    if (element->detector) {
+        element->detector->stopAnalysisWorker();
+    }
+    element->info_valid = FALSE;
     return TRUE;
 }
 
@@ -679,8 +1554,10 @@ static gboolean motion_detector_set_caps(GstBaseTransform* trans,
  * @brief Trigger motion event
  */
 void MotionDetector::triggerMotionEvent(const std::vector<MotionRegion>& regions, 
-                                       guint64 timestamp) {
-    if (!motion_callback_ || !params_.enable_alerts) {
+                                       guint64 timestamp,
+                                       double motion_percentage,
+                                       const MotionDetectionParams& params) {
+    if (!motion_callback_ || !params.enable_alerts) {
         return;
     }
     
@@ -689,34 +1566,13 @@ void MotionDetector::triggerMotionEvent(const std::vector<MotionRegion>& regions
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         now - last_alert_time_).count();
     
-    if (elapsed < params_.alert_cooldown_ms) {
+    if (elapsed < params.alert_cooldown_ms) {
         return;
     }
     
-    // Calculate total motion area
-    double total_area = 0;
-    for (const auto& region : regions) {
-        total_area += region.width * region.height;
-    }
-    
-    // Calculate as percentage (relative to frame size)
-    double motion_percentage = 0;
-    if (element_) {
-        GstCaps* caps = gst_pad_get_current_caps(
-            GST_BASE_TRANSFORM_SINK_PAD(GST_BASE_TRANSFORM(element_)));
-        if (caps) {
-            GstVideoInfo info;
-            if (gst_video_info_from_caps(&info, caps)) {
-                int frame_area = GST_VIDEO_INFO_WIDTH(&info) * GST_VIDEO_INFO_HEIGHT(&info);
-                motion_percentage = (total_area / frame_area) * 100.0;
-            }
-            gst_caps_unref(caps);
-        }
-    }
-    
     // Call the callback
     motion_callback_(regions, timestamp, motion_percentage);
     
     // Update last alert time
     last_alert_time_ = now;
-}
\ No newline at end of file
+}
@@ -0,0 +1,270 @@
+/**
+ * @file motion_tracker.cpp
+ * @brief Motion region tracker and event dispatcher implementation
+ */
+
+#include "motion_tracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double iou(const MotionRegion& a, const MotionRegion& b) {
+    int x0 = std::max(a.x, b.x);
+    int y0 = std::max(a.y, b.y);
+    int x1 = std::min(a.x + a.width, b.x + b.width);
+    int y1 = std::min(a.y + a.height, b.y + b.height);
+    if (x1 <= x0 || y1 <= y0) {
+        return 0.0;
+    }
+    double inter = static_cast<double>(x1 - x0) * (y1 - y0);
+    double uni = static_cast<double>(a.width) * a.height +
+                 static_cast<double>(b.width) * b.height - inter;
+    return inter / uni;
+}
+
+double centroidDistance(const MotionRegion& a, const MotionRegion& b) {
+    double dx = (a.x + a.width * 0.5) - (b.x + b.width * 0.5);
+    double dy = (a.y + a.height * 0.5) - (b.y + b.height * 0.5);
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+} // namespace
+
+/**
+ * @brief Constructor
+ */
+MotionTracker::MotionTracker(const MotionTrackerParams& params)
+    : params_(params) {
+}
+
+/**
+ * @brief Associates a frame's regions with the tracks
+ *
+ * Greedy assignment: IoU matches (best first) take precedence over centroid
+ * matches, which only pair regions that do not overlap their track.
+ */
+std::vector<MotionTrackEvent> MotionTracker::update(const std::vector<MotionRegion>& regions,
+                                                    guint64 timestamp) {
+    struct Candidate {
+        double score;
+        size_t track;
+        size_t region;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t t = 0; t < tracks_.size(); ++t) {
+        for (size_t r = 0; r < regions.size(); ++r) {
+            double overlap = iou(tracks_[t].region, regions[r]);
+            if (overlap >= params_.iou_threshold) {
+                candidates.push_back({1.0 + overlap, t, r});
+                continue;
+            }
+            double distance = centroidDistance(tracks_[t].region, regions[r]);
+            if (distance <= params_.max_centroid_distance) {
+                candidates.push_back({1.0 - distance / (params_.max_centroid_distance + 1.0), t, r});
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    std::vector<int> track_region(tracks_.size(), -1);
+    std::vector<bool> region_used(regions.size(), false);
+    for (const auto& c : candidates) {
+        if (track_region[c.track] < 0 && !region_used[c.region]) {
+            track_region[c.track] = static_cast<int>(c.region);
+            region_used[c.region] = true;
+        }
+    }
+
+    std::vector<MotionTrackEvent> events;
+    std::vector<Track> survivors;
+    survivors.reserve(tracks_.size() + regions.size());
+
+    for (size_t t = 0; t < tracks_.size(); ++t) {
+        Track& track = tracks_[t];
+        ++track.age;
+        ++track.since_report;
+
+        if (track_region[t] < 0) {
+            track.hits = 0;
+            ++track.missed;
+            if (!track.confirmed) {
+                continue; // Tentative tracks need consecutive hits
+            }
+            if (track.missed > params_.max_missed_frames) {
+                events.push_back(makeEvent(MotionEventType::EXIT, track, timestamp));
+                continue;
+            }
+            survivors.push_back(track);
+            continue;
+        }
+
+        track.region = regions[track_region[t]];
+        ++track.hits;
+        track.missed = 0;
+
+        if (!track.confirmed) {
+            if (track.hits >= params_.confirm_frames) {
+                track.confirmed = true;
+                track.reported = track.region;
+                track.since_report = 0;
+                events.push_back(makeEvent(MotionEventType::ENTER, track, timestamp));
+            }
+        } else {
+            bool periodic = params_.update_interval > 0 &&
+                            track.since_report >= params_.update_interval;
+            bool moved = centroidDistance(track.region, track.reported) >= params_.update_distance;
+            if (periodic || moved) {
+                track.reported = track.region;
+                track.since_report = 0;
+                events.push_back(makeEvent(MotionEventType::UPDATE, track, timestamp));
+            }
+        }
+        survivors.push_back(track);
+    }
+
+    // Unmatched regions start tentative tracks
+    for (size_t r = 0; r < regions.size(); ++r) {
+        if (region_used[r]) {
+            continue;
+        }
+        Track track;
+        track.id = next_id_++;
+        track.region = regions[r];
+        track.reported = regions[r];
+        track.hits = 1;
+        if (params_.confirm_frames <= 1) {
+            track.confirmed = true;
+            events.push_back(makeEvent(MotionEventType::ENTER, track, timestamp));
+        }
+        survivors.push_back(track);
+    }
+
+    tracks_.swap(survivors);
+    return events;
+}
+
+/**
+ * @brief Returns the number of confirmed tracks
+ */
+size_t MotionTracker::confirmedTracks() const {
+    return std::count_if(tracks_.begin(), tracks_.end(),
+                         [](const Track& track) { return track.confirmed; });
+}
+
+/**
+ * @brief Drops all tracks
+ */
+void MotionTracker::reset() {
+    tracks_.clear();
+}
+
+/**
+ * @brief Builds an event for a track
+ */
+MotionTrackEvent MotionTracker::makeEvent(MotionEventType type, const Track& track,
+                                          guint64 timestamp) {
+    MotionTrackEvent event;
+    event.type = type;
+    event.track_id = track.id;
+    event.region = track.region;
+    event.timestamp = timestamp;
+    event.age = track.age;
+    return event;
+}
+
+/**
+ * @brief Constructor
+ */
+TrackEventDispatcher::TrackEventDispatcher(size_t capacity)
+    : capacity_(std::max<size_t>(1, capacity)) {
+}
+
+/**
+ * @brief Destructor
+ */
+TrackEventDispatcher::~TrackEventDispatcher() {
+    stop();
+}
+
+/**
+ * @brief Sets the callback
+ */
+void TrackEventDispatcher::setCallback(MotionTrackCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = std::move(callback);
+    if (callback_ && !thread_.joinable()) {
+        stop_ = false;
+        thread_ = std::thread(&TrackEventDispatcher::run, this);
+    }
+}
+
+/**
+ * @brief Returns true if a callback is set
+ */
+bool TrackEventDispatcher::hasCallback() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<bool>(callback_);
+}
+
+/**
+ * @brief Queues events without blocking
+ */
+size_t TrackEventDispatcher::push(const std::vector<MotionTrackEvent>& events) {
+    size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& event : events) {
+            if (queue_.size() >= capacity_) {
+                queue_.pop_front();
+                ++dropped;
+            }
+            queue_.push_back(event);
+        }
+    }
+    cv_.notify_one();
+    return dropped;
+}
+
+/**
+ * @brief Delivers queued events and stops the thread
+ */
+void TrackEventDispatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/**
+ * @brief Dispatcher thread loop
+ *
+ * Takes the whole queue at once and calls the callback without holding the
+ * lock, so producers never wait on a slow consumer.
+ */
+void TrackEventDispatcher::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return; // Stop requested and everything delivered
+        }
+        std::deque<MotionTrackEvent> batch;
+        batch.swap(queue_);
+        MotionTrackCallback callback = callback_;
+        lock.unlock();
+
+        if (callback) {
+            for (const auto& event : batch) {
+                callback(event);
+            }
+        }
+
+        lock.lock();
+    }
+}
@@ -19,6 +19,15 @@ PipelineManager::PipelineManager(const PipelineConfig& config)
     // Create video processor
     video_processor_ = std::make_unique<VideoProcessor>();
     
+    // Create input switcher (every source is converted to the pipeline format)
+    SourceFormat format;
+    format.width = config_.width;
+    format.height = config_.height;
+    format.framerate = config_.framerate;
+    format.video_format = config_.video_format;
+    source_switcher_ = std::make_unique<SourceSwitcher>(format);
+    source_switcher_->setStallTimeout(config_.source_stall_timeout_ms);
+    
     // Create motion detector (if enabled)
     if (config_.enable_motion_detection) {
         motion_detector_ = std::make_unique<MotionDetector>();
@@ -35,8 +44,45 @@ PipelineManager::PipelineManager(const PipelineConfig& config)
         rtsp_config.bitrate = config_.bitrate;
         rtsp_config.encoder = config_.encoder;
         
+        // Multicast for clients that ask for it, unicast for the rest
+        if (!config_.rtsp_multicast_address.empty()) {
+            rtsp_config.enable_multicast = true;
+            rtsp_config.multicast_address = config_.rtsp_multicast_address;
+            rtsp_config.multicast_port = config_.rtsp_multicast_port;
+        }
+        
+        // Simulcast ladder, all rungs encoded from the same processed frames
+        for (const std::string& name : config_.rtsp_simulcast) {
+            StreamProfile profile;
+            if (name == "low") profile = StreamProfile::LOW;
+            else if (name == "medium") profile = StreamProfile::MEDIUM;
+            else if (name == "high") profile = StreamProfile::HIGH;
+            else if (name == "ultra") profile = StreamProfile::ULTRA;
+            else {
+                std::cerr << "[PipelineManager] Unknown simulcast profile: " << name << std::endl;
+                continue;
+            }
+            rtsp_config.simulcast.push_back(RTSPStreamer::profileRung(profile, rtsp_config));
+        }
+        
         rtsp_streamer_ = std::make_unique<RTSPStreamer>(rtsp_config);
     }
+    
+    // Create event recorder; motion on the analysis branch starts/extends files
+    if (config_.enable_recording && config_.recording_mode == RecordingMode::EVENT) {
+        event_recorder_ = std::make_unique<EventRecorder>(config_.event_recording);
+        if (motion_detector_) {
+            EventRecorder* recorder = event_recorder_.get();
+            motion_detector_->setMotionActivityCallback([recorder](guint64 timestamp) {
+                recorder->trigger(timestamp);
+            });
+        } else {
+            std::cerr << "[PipelineManager] Event recording without motion detection: "
+                      << "files are only written on EventRecorder::trigger()" << std::endl;
+        }
+    }
+    
+    registerMetrics();
 }
 
 /**
@@ -79,6 +125,11 @@ bool PipelineManager::start() {
         return false;
     }
     
+    // Recording from the RTSP encoder needs processed frames flowing
+    if (recordsRTSPStream()) {
+        rtsp_streamer_->recordStream(true, config_.record_location);
+    }
+    
     // Start main loop thread
     is_running_ = true;
     main_loop_thread_ = std::make_unique<std::thread>(&PipelineManager::mainLoopThread, this);
@@ -86,6 +137,14 @@ bool PipelineManager::start() {
     // Record start time for FPS calculation
     last_fps_time_ = gst_clock_get_time(gst_element_get_clock(pipeline_));
     
+    // Start metrics endpoint (the pipeline runs without it if the port is taken)
+    if (config_.metrics_port > 0) {
+        metrics_server_ = std::make_unique<MetricsServer>(metrics_);
+        if (!metrics_server_->start(config_.metrics_port)) {
+            metrics_server_.reset();
+        }
+    }
+    
     return true;
 }
 
@@ -99,6 +158,9 @@ void PipelineManager::stop() {
     
     is_running_ = false;
     
+    // Stop metrics endpoint
+    metrics_server_.reset();
+    
     // Stop main loop
     if (main_loop_) {
         g_main_loop_quit(main_loop_);
@@ -118,44 +180,45 @@ void PipelineManager::stop() {
     if (rtsp_streamer_) {
         rtsp_streamer_->stop();
     }
+    
+    // Finalise an open event file
+    if (event_recorder_) {
+        event_recorder_->flush();
+    }
+}
+
+/**
+ * @brief Returns true if continuous recording taps the RTSP encoder
+ */
+bool PipelineManager::recordsRTSPStream() const {
+    return config_.enable_recording && config_.recording_mode == RecordingMode::CONTINUOUS &&
+           rtsp_streamer_ && config_.sink_type == SinkType::RTSP;
 }
 
 /**
  * @brief Creates the pipeline and links elements
  */
 bool PipelineManager::createPipeline() {
+    // Continuous recording of an RTSP output taps the RTSP encoder instead
+    const bool record_branch = config_.enable_recording && !recordsRTSPStream();
+    
     // Create main pipeline
     pipeline_ = gst_pipeline_new("video-analytics-pipeline");
     if (!pipeline_) {
         return false;
     }
     
-    // Create video source
-    source_ = createSource();
-    if (!source_) {
+    // Input selector with the configured source (and a warm standby) behind it
+    selector_ = source_switcher_->createElement(pipeline_);
+    if (!selector_ || !source_switcher_->setPrimary(config_.source_location, config_.source_type)) {
         std::cerr << "[PipelineManager] Failed to create video source!" << std::endl;
         return false;
     }
-    
-    // Video converter (for format compatibility)
-    GstElement* videoconvert1 = gst_element_factory_make("videoconvert", "videoconvert1");
-    
-    // Video scaling (for size adjustment)
-    GstElement* videoscale = gst_element_factory_make("videoscale", "videoscale");
-    
-    // Video rate adjuster
-    GstElement* videorate = gst_element_factory_make("videorate", "videorate");
-    
-    // Caps filter (enforce video format)
-    GstElement* capsfilter = gst_element_factory_make("capsfilter", "capsfilter");
-    GstCaps* caps = gst_caps_new_simple("video/x-raw",
-        "width", G_TYPE_INT, config_.width,
-        "height", G_TYPE_INT, config_.height,
-        "framerate", GST_TYPE_FRACTION, config_.framerate, 1,
-        "format", G_TYPE_STRING, config_.video_format.c_str(),
-        nullptr);
-    g_object_set(capsfilter, "caps", caps, nullptr);
-    gst_caps_unref(caps);
+    if (!config_.standby_location.empty() &&
+        !source_switcher_->prepareStandby(config_.standby_location, config_.standby_type)) {
+        std::cerr << "[PipelineManager] Failed to create standby source, continuing without failover"
+                  << std::endl;
+    }
     
     // Tee element (to split the stream)
     tee_ = gst_element_factory_make("tee", "tee");
@@ -190,9 +253,7 @@ bool PipelineManager::createPipeline() {
     }
     
     // Add all elements to pipeline
-    gst_bin_add_many(GST_BIN(pipeline_),
-        source_, videoconvert1, videoscale, videorate, capsfilter,
-        tee_, queue1, nullptr);
+    gst_bin_add_many(GST_BIN(pipeline_), tee_, queue1, nullptr);
     
     // Add video processing element
     if (video_processor_element) {
@@ -207,16 +268,30 @@ bool PipelineManager::createPipeline() {
     gst_bin_add_many(GST_BIN(pipeline_), videoconvert2, sink_, nullptr);
     
     // Create recording branch (if enabled)
-    if (config_.enable_recording) {
+    if (record_branch) {
         gst_bin_add(GST_BIN(pipeline_), queue2);
         
         recording_queue_ = gst_element_factory_make("queue", "recording_queue");
         GstElement* recording_convert = gst_element_factory_make("videoconvert", "recording_convert");
         GstElement* encoder = createEncoder();
-        GstElement* muxer = gst_element_factory_make("mp4mux", "muxer");
-        recording_sink_ = gst_element_factory_make("filesink", "recording_sink");
+        GstElement* muxer = nullptr;
         
-        g_object_set(recording_sink_, "location", config_.record_location.c_str(), nullptr);
+        if (event_recorder_) {
+            // Encoded access units end in the in-memory ring; files are muxed per event
+            muxer = gst_element_factory_make("h264parse", "recording_parse");
+            recording_sink_ = event_recorder_->createSink();
+            
+            // Short GOPs keep the pre-roll close to the configured length
+            if (g_object_class_find_property(G_OBJECT_GET_CLASS(encoder), "key-int-max")) {
+                g_object_set(encoder, "key-int-max", config_.framerate, nullptr);
+            } else if (g_object_class_find_property(G_OBJECT_GET_CLASS(encoder), "gop-size")) {
+                g_object_set(encoder, "gop-size", config_.framerate, nullptr);
+            }
+        } else {
+            muxer = gst_element_factory_make("mp4mux", "muxer");
+            recording_sink_ = gst_element_factory_make("filesink", "recording_sink");
+            g_object_set(recording_sink_, "location", config_.record_location.c_str(), nullptr);
+        }
         
         gst_bin_add_many(GST_BIN(pipeline_),
             recording_queue_, recording_convert, encoder, muxer, recording_sink_, nullptr);
@@ -229,24 +304,18 @@ bool PipelineManager::createPipeline() {
         }
     }
     
-    // Link elements
-    bool link_success = true;
-    
-    // Link based on source type
-    if (config_.source_type == SourceType::RTSP || config_.source_type == SourceType::HTTP) {
-        // Connect signal for dynamic pads
-        g_signal_connect(source_, "pad-added", G_CALLBACK(onPadAdded), videoconvert1);
-        
-        // Link the rest of the pipeline
-        link_success = gst_element_link_many(videoconvert1, videoscale, videorate, 
-                                            capsfilter, tee_, nullptr);
-    } else {
-        // Link directly for sources with static pads
-        link_success = gst_element_link_many(source_, videoconvert1, videoscale, 
-                                            videorate, capsfilter, tee_, nullptr);
+    // Queues whose fill level is exported per tee branch
+    {
+        std::lock_guard<std::mutex> lock(branch_queues_mutex_);
+        branch_queues_.emplace_back("main", GST_ELEMENT(gst_object_ref(queue1)));
+        if (record_branch) {
+            branch_queues_.emplace_back("recording", GST_ELEMENT(gst_object_ref(queue2)));
+            branch_queues_.emplace_back("recording", GST_ELEMENT(gst_object_ref(recording_queue_)));
+        }
     }
     
-    if (!link_success) {
+    // Link input selector to tee
+    if (!gst_element_link(selector_, tee_)) {
         std::cerr << "[PipelineManager] Failed to link pipeline initial elements!" << std::endl;
         return false;
     }
@@ -285,7 +354,7 @@ bool PipelineManager::createPipeline() {
     }
     
     // Tee link for recording branch
-    if (config_.enable_recording) {
+    if (record_branch) {
         GstPad* tee_src2 = gst_element_get_request_pad(tee_, "src_%u");
         GstPad* queue2_sink = gst_element_get_static_pad(queue2, "sink");
         if (gst_pad_link(tee_src2, queue2_sink) != GST_PAD_LINK_OK) {
@@ -301,67 +370,13 @@ bool PipelineManager::createPipeline() {
     gst_object_unref(bus);
     
     // Add elements to map
-    elements_["source"] = source_;
+    elements_["source"] = selector_;
     elements_["tee"] = tee_;
     elements_["sink"] = sink_;
     
     return true;
 }
 
-/**
- * @brief Creates the video source
- */
-GstElement* PipelineManager::createSource() {
-    GstElement* source = nullptr;
-    
-    switch (config_.source_type) {
-        case SourceType::FILE:
-            source = gst_element_factory_make("filesrc", "source");
-            g_object_set(source, "location", config_.source_location.c_str(), nullptr);
-            
-            // Decodebin ekle
-            {
-                GstElement* decodebin = gst_element_factory_make("decodebin", "decoder");
-                gst_bin_add(GST_BIN(pipeline_), decodebin);
-                gst_element_link(source, decodebin);
-                
-                // Connect pads from decodebin
-                g_signal_connect(decodebin, "pad-added", G_CALLBACK(onPadAdded), nullptr);
-                
-                // Return decodebin as source
-                return decodebin;
-            }
-            break;
-            
-        case SourceType::WEBCAM:
-            source = gst_element_factory_make("v4l2src", "source");
-            g_object_set(source, "device", config_.source_location.c_str(), nullptr);
-            break;
-            
-        case SourceType::RTSP:
-            source = gst_element_factory_make("rtspsrc", "source");
-            g_object_set(source, 
-                "location", config_.source_location.c_str(),
-                "latency", 200,
-                "buffer-mode", 0, // For live stream
-                nullptr);
-            break;
-            
-        case SourceType::HTTP:
-            source = gst_element_factory_make("souphttpsrc", "source");
-            g_object_set(source, 
-                "location", config_.source_location.c_str(),
-                "is-live", TRUE,
-                nullptr);
-            break;
-            
-        default:
-            break;
-    }
-    
-    return source;
-}
-
 /**
  * @brief Creates the video sink
  */
@@ -399,11 +414,11 @@ GstElement* PipelineManager::createSink() {
             break;
             
         case SinkType::RTSP:
-            // Use appsink for RTSP
+            // Processed frames are bridged into the RTSP media (callbacks, no signals)
             sink = gst_element_factory_make("appsink", "sink");
             g_object_set(sink, 
-                "emit-signals", TRUE,
-                "max-buffers", 10,
+                "emit-signals", FALSE,
+                "max-buffers", 2,
                 "drop", TRUE,
                 nullptr);
             
@@ -461,6 +476,12 @@ gboolean PipelineManager::busCallback(GstBus* bus, GstMessage* msg, gpointer use
     switch (GST_MESSAGE_TYPE(msg)) {
         case GST_MESSAGE_ERROR:
             {
+                // A failed input is replaced by the standby instead of stopping
+                if (manager->source_switcher_ &&
+                    manager->source_switcher_->handleError(GST_MESSAGE_SRC(msg))) {
+                    break;
+                }
+                
                 GError* error;
                 gchar* debug_info;
                 gst_message_parse_error(msg, &error, &debug_info);
@@ -525,38 +546,6 @@ gboolean PipelineManager::busCallback(GstBus* bus, GstMessage* msg, gpointer use
     return TRUE;
 }
 
-/**
- * @brief Callback for dynamic pad linking
- */
-void PipelineManager::onPadAdded(GstElement* src, GstPad* new_pad, gpointer data) {
-    GstElement* sink = static_cast<GstElement*>(data);
-    GstPad* sink_pad = gst_element_get_static_pad(sink, "sink");
-    
-    if (gst_pad_is_linked(sink_pad)) {
-        gst_object_unref(sink_pad);
-        return;
-    }
-    
-    // Check pad caps
-    GstCaps* new_pad_caps = gst_pad_get_current_caps(new_pad);
-    if (!new_pad_caps) {
-        new_pad_caps = gst_pad_query_caps(new_pad, nullptr);
-    }
-    
-    GstStructure* new_pad_struct = gst_caps_get_structure(new_pad_caps, 0);
-    const gchar* new_pad_type = gst_structure_get_name(new_pad_struct);
-    
-    // Only link video pads
-    if (g_str_has_prefix(new_pad_type, "video/")) {
-        if (gst_pad_link(new_pad, sink_pad) == GST_PAD_LINK_OK) {
-            std::cout << "[PAD] Video pad linked: " << new_pad_type << std::endl;
-        }
-    }
-    
-    gst_caps_unref(new_pad_caps);
-    gst_object_unref(sink_pad);
-}
-
 /**
  * @brief Main event loop thread function
  */
@@ -571,6 +560,15 @@ void PipelineManager::mainLoopThread() {
         return TRUE;
     }, this);
     
+    // Source stall watchdog (fails over to the standby)
+    g_timeout_add(250, [](gpointer data) -> gboolean {
+        PipelineManager* manager = static_cast<PipelineManager*>(data);
+        if (manager->is_running_.load()) {
+            manager->source_switcher_->checkStall();
+        }
+        return TRUE;
+    }, this);
+    
     // Run main loop
     g_main_loop_run(main_loop_);
     
@@ -606,7 +604,7 @@ void PipelineManager::calculateFPS() {
                 guint64 current_frames = stats.frames_processed;
                 guint64 frame_diff = current_frames - frame_count_;
                 
-                current_fps_ = (double)frame_diff * GST_SECOND / diff;
+                fps_metric_.set((double)frame_diff * GST_SECOND / diff);
                 frame_count_ = current_frames;
             }
         }
@@ -615,14 +613,68 @@ void PipelineManager::calculateFPS() {
     last_fps_time_ = current_time;
 }
 
+/**
+ * @brief Registers the pipeline and component metrics
+ *
+ * Queue levels are read from the queue elements at scrape time, so nothing
+ * is added to the streaming threads.
+ */
+void PipelineManager::registerMetrics() {
+    metrics_.addGauge("pipeline_fps", "Frames per second through the video processor", fps_metric_);
+    
+    auto queue_level = [this](const char* property, double scale) {
+        return [this, property, scale](std::vector<MetricSample>& samples) {
+            std::lock_guard<std::mutex> lock(branch_queues_mutex_);
+            for (const auto& queue : branch_queues_) {
+                GValue value = G_VALUE_INIT;
+                g_value_init(&value, G_TYPE_DOUBLE);
+                g_object_get_property(G_OBJECT(queue.second), property, &value);
+                samples.push_back({{{"branch", queue.first}, {"queue", GST_OBJECT_NAME(queue.second)}},
+                                   g_value_get_double(&value) * scale});
+                g_value_unset(&value);
+            }
+        };
+    };
+    metrics_.addCollector("pipeline_queue_level_buffers", "Buffers waiting in a tee branch queue",
+                          MetricType::GAUGE, queue_level("current-level-buffers", 1.0));
+    metrics_.addCollector("pipeline_queue_level_bytes", "Bytes waiting in a tee branch queue",
+                          MetricType::GAUGE, queue_level("current-level-bytes", 1.0));
+    metrics_.addCollector("pipeline_queue_level_seconds", "Media time waiting in a tee branch queue",
+                          MetricType::GAUGE, queue_level("current-level-time", 1e-9));
+    
+    if (video_processor_) {
+        video_processor_->registerMetrics(metrics_);
+    }
+    if (motion_detector_) {
+        motion_detector_->registerMetrics(metrics_);
+    }
+    if (rtsp_streamer_) {
+        rtsp_streamer_->registerMetrics(metrics_);
+    }
+    if (event_recorder_) {
+        event_recorder_->registerMetrics(metrics_);
+    }
+    source_switcher_->registerMetrics(metrics_);
+}
+
 /**
  * @brief Cleans up the pipeline
  */
 void PipelineManager::cleanup() {
+    {
+        std::lock_guard<std::mutex> lock(branch_queues_mutex_);
+        for (auto& queue : branch_queues_) {
+            gst_object_unref(queue.second);
+        }
+        branch_queues_.clear();
+    }
+    
     if (pipeline_) {
         gst_element_set_state(pipeline_, GST_STATE_NULL);
+        source_switcher_->release();
         gst_object_unref(pipeline_);
         pipeline_ = nullptr;
+        selector_ = nullptr;
     }
     
     elements_.clear();
@@ -647,8 +699,20 @@ GstState PipelineManager::getState() const {
  * @brief Changes the video source at runtime
  */
 bool PipelineManager::changeSource(const std::string& new_source, SourceType type) {
-    // TODO: Dynamic source switching implementation
-    return false;
+    // Not built yet: the next start() uses the new source
+    if (!pipeline_) {
+        config_.source_location = new_source;
+        config_.source_type = type;
+        return true;
+    }
+    
+    if (!source_switcher_->changeSource(new_source, type, 5 * GST_SECOND)) {
+        std::cerr << "[PipelineManager] Failed to switch source to " << new_source << std::endl;
+        return false;
+    }
+    config_.source_location = new_source;
+    config_.source_type = type;
+    return true;
 }
 
 /**
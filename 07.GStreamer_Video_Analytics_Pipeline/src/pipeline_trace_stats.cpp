@@ -0,0 +1,339 @@
+/**
+ * @file pipeline_trace_stats.cpp
+ * @brief Per-element trace statistics implementation
+ */
+
+#include "pipeline_trace_stats.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+/**
+ * @brief Summarises a histogram; percentiles are bucket upper bounds capped at max
+ */
+TraceSummary summarise(const Histogram& histogram, double max) {
+    Histogram::Snapshot snap = histogram.snapshot();
+    TraceSummary summary;
+    summary.count = snap.count;
+    summary.max = max;
+    if (snap.count == 0) {
+        return summary;
+    }
+    summary.mean = snap.sum / snap.count;
+
+    auto percentile = [&](double q) {
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * snap.count));
+        for (size_t b = 0; b < snap.buckets.size(); ++b) {
+            if (snap.buckets[b] >= rank) {
+                return b < snap.bounds.size() ? std::min(snap.bounds[b], max) : max;
+            }
+        }
+        return max;
+    };
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    return summary;
+}
+
+/**
+ * @brief Formats a number for JSON (finite, 4 decimals at most)
+ */
+std::string number(double value) {
+    if (!std::isfinite(value)) {
+        return "0";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.4g", value);
+    return text;
+}
+
+/**
+ * @brief Escapes a JSON string
+ */
+std::string quote(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+/**
+ * @brief Renders a summary as a JSON object
+ */
+std::string summaryJson(const TraceSummary& s) {
+    std::ostringstream out;
+    out << "{\"count\": " << s.count << ", \"mean\": " << number(s.mean)
+        << ", \"p50\": " << number(s.p50) << ", \"p95\": " << number(s.p95)
+        << ", \"p99\": " << number(s.p99) << ", \"max\": " << number(s.max) << "}";
+    return out.str();
+}
+
+/**
+ * @brief Renders histogram buckets as [[upper bound, count], ...] (not cumulative)
+ */
+std::string bucketsJson(const Histogram::Snapshot& snap) {
+    std::ostringstream out;
+    out << "[";
+    uint64_t previous = 0;
+    for (size_t b = 0; b < snap.buckets.size(); ++b) {
+        out << (b ? ", " : "") << "["
+            << (b < snap.bounds.size() ? number(snap.bounds[b]) : "\"+Inf\"")
+            << ", " << snap.buckets[b] - previous << "]";
+        previous = snap.buckets[b];
+    }
+    out << "]";
+    return out.str();
+}
+
+constexpr double kNsPerMs = 1e6;
+
+} // namespace
+
+/**
+ * @brief Constructor
+ */
+ElementTrace::ElementTrace(std::string path, std::string factory, bool is_queue)
+    : path_(std::move(path)), factory_(std::move(factory)), is_queue_(is_queue),
+      processing_(Histogram::exponentialBounds(0.01, 2.0, 16)),    // 10 us - 330 ms
+      latency_(Histogram::exponentialBounds(0.1, 2.0, 14)),        // 100 us - 820 ms
+      wait_(Histogram::exponentialBounds(0.1, 2.0, 14)),
+      level_({0, 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 100, 200}) {
+}
+
+/**
+ * @brief Records a processing time
+ */
+void ElementTrace::recordProcessing(uint64_t ns) {
+    double ms = ns / kNsPerMs;
+    processing_.observe(ms);
+    atomicMax(max_processing_, ms);
+}
+
+/**
+ * @brief Records a latency since the source
+ */
+void ElementTrace::recordLatency(uint64_t ns) {
+    double ms = ns / kNsPerMs;
+    latency_.observe(ms);
+    atomicMax(max_latency_, ms);
+}
+
+/**
+ * @brief A frame entered the queue
+ */
+void ElementTrace::enqueue(const void* buffer, uint64_t bytes, uint64_t ts, uint64_t origin) {
+    uint64_t level;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        fifo_.push_back({buffer, bytes, ts, origin});
+        queued_bytes_ += bytes;
+        level = fifo_.size();
+    }
+    level_.observe(static_cast<double>(level - 1));  // Frames ahead of this one
+
+    uint64_t max = max_level_.load(std::memory_order_relaxed);
+    while (level > max && !max_level_.compare_exchange_weak(max, level, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief A frame left the queue
+ */
+bool ElementTrace::dequeue(const void* buffer, uint64_t ts, uint64_t& origin) {
+    uint64_t entered = 0;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        size_t index = 0;
+        while (index < fifo_.size() && fifo_[index].buffer != buffer) {
+            ++index;
+        }
+        if (index == fifo_.size()) {
+            return false;  // Not seen entering (tracer attached mid-stream)
+        }
+        entered = fifo_[index].entered;
+        origin = fifo_[index].origin;
+        // Everything ahead of it was dropped; it leaves too
+        for (size_t i = 0; i <= index; ++i) {
+            queued_bytes_ -= fifo_.front().bytes;
+            fifo_.pop_front();
+        }
+    }
+
+    double ms = (ts - entered) / kNsPerMs;
+    wait_.observe(ms);
+    atomicMax(max_wait_, ms);
+    return true;
+}
+
+/**
+ * @brief Returns the processing time summary
+ */
+TraceSummary ElementTrace::processing() const {
+    return summarise(processing_, max_processing_.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Returns the latency summary
+ */
+TraceSummary ElementTrace::latency() const {
+    return summarise(latency_, max_latency_.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Returns the queue wait summary
+ */
+TraceSummary ElementTrace::queueWait() const {
+    return summarise(wait_, max_wait_.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Returns the current queue fill level
+ */
+void ElementTrace::queueLevel(uint64_t& buffers, uint64_t& bytes) const {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    buffers = fifo_.size();
+    bytes = queued_bytes_;
+}
+
+/**
+ * @brief Returns the trace of an element
+ */
+ElementTrace* PipelineTraceStats::element(const std::string& path, const std::string& factory, bool is_queue) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = by_path_.find(path);
+    if (it != by_path_.end()) {
+        return it->second;
+    }
+    elements_.push_back(std::make_unique<ElementTrace>(path, factory, is_queue));
+    by_path_[path] = elements_.back().get();
+    return elements_.back().get();
+}
+
+/**
+ * @brief Remembers a source push
+ */
+void PipelineTraceStats::recordSource(uint64_t pts, uint64_t ts) {
+    std::lock_guard<std::mutex> lock(source_mutex_);
+    // Keep the first push: a second source with the same PTS is not earlier
+    if (!source_times_.emplace(pts, ts).second) {
+        return;
+    }
+    source_order_.push_back(pts);
+    if (source_order_.size() > kSourceHistory) {
+        source_times_.erase(source_order_.front());
+        source_order_.pop_front();
+    }
+}
+
+/**
+ * @brief Looks up a source push
+ */
+bool PipelineTraceStats::sourceTime(uint64_t pts, uint64_t& ts) const {
+    std::lock_guard<std::mutex> lock(source_mutex_);
+    auto it = source_times_.find(pts);
+    if (it == source_times_.end()) {
+        return false;
+    }
+    ts = it->second;
+    return true;
+}
+
+/**
+ * @brief Renders one log line per element
+ */
+std::vector<std::string> PipelineTraceStats::summaryLines() const {
+    std::vector<ElementTrace*> elements;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& element : elements_) {
+            elements.push_back(element.get());
+        }
+    }
+
+    std::vector<std::string> lines;
+    char line[512];
+    for (const ElementTrace* element : elements) {
+        TraceSummary proc = element->processing();
+        TraceSummary lat = element->latency();
+        int written = std::snprintf(line, sizeof(line),
+            "%s: %llu frames, proc mean %.3f p95 %.3f max %.3f ms, latency p50 %.2f p95 %.2f ms",
+            element->path().c_str(), static_cast<unsigned long long>(proc.count),
+            proc.mean, proc.p95, proc.max, lat.p50, lat.p95);
+        std::string text(line, std::min<size_t>(written, sizeof(line) - 1));
+
+        if (element->isQueue()) {
+            uint64_t buffers = 0;
+            uint64_t bytes = 0;
+            element->queueLevel(buffers, bytes);
+            TraceSummary wait = element->queueWait();
+            std::snprintf(line, sizeof(line), ", level %llu (%llu B, max %llu), wait p95 %.2f ms",
+                          static_cast<unsigned long long>(buffers), static_cast<unsigned long long>(bytes),
+                          static_cast<unsigned long long>(element->maxQueueLevel()), wait.p95);
+            text += line;
+        }
+        lines.push_back(std::move(text));
+    }
+    return lines;
+}
+
+/**
+ * @brief Renders the full report as JSON
+ */
+std::string PipelineTraceStats::toJson() const {
+    std::vector<ElementTrace*> elements;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& element : elements_) {
+            elements.push_back(element.get());
+        }
+    }
+
+    std::ostringstream out;
+    out << "{\n  \"unit\": \"ms\",\n  \"elements\": [";
+    for (size_t i = 0; i < elements.size(); ++i) {
+        const ElementTrace& element = *elements[i];
+        out << (i ? "," : "") << "\n    {\"path\": " << quote(element.path())
+            << ", \"factory\": " << quote(element.factory())
+            << ",\n     \"processing\": " << summaryJson(element.processing())
+            << ",\n     \"latency_from_source\": " << summaryJson(element.latency());
+        if (element.isQueue()) {
+            uint64_t buffers = 0;
+            uint64_t bytes = 0;
+            element.queueLevel(buffers, bytes);
+            out << ",\n     \"queue\": {\"level_buffers\": " << buffers
+                << ", \"level_bytes\": " << bytes
+                << ", \"max_level_buffers\": " << element.maxQueueLevel()
+                << ", \"level_histogram\": " << bucketsJson(element.queueLevelHistogram())
+                << ", \"wait\": " << summaryJson(element.queueWait()) << "}";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+/**
+ * @brief Writes the JSON report
+ */
+bool PipelineTraceStats::writeJson(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file << toJson();
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,359 @@
+/**
+ * @file pipeline_tracer.cpp
+ * @brief "pipelinetracer" GStreamer tracer: per-element latency and queue occupancy
+ *
+ * Loaded by GStreamer itself, so any application is traced without changes:
+ *
+ *   GST_PLUGIN_PATH=build GST_TRACERS="pipelinetracer(interval=5,file=trace.json)" \
+ *   GST_DEBUG=pipelinetracer:4 ./gstreamer_video_analytics -c config/pipeline_config.yaml
+ *
+ * Every buffer push from element U to element D is bracketed by the
+ * pad-push-pre/post hooks. A per-thread stack of open pushes turns them into:
+ *  - processing time of D: push into D until D pushes on (or, for sinks and
+ *    elements that keep the frame, until the push into D returns);
+ *  - latency of D: time since a source pushed the frame, carried along the
+ *    thread and through queues (PTS lookup for other thread hops);
+ *  - queue fill level and wait: frames pushed into a queue and not yet
+ *    pushed out by its streaming thread.
+ * Each hook does a few clock-free updates (the timestamp comes from the hook)
+ * and lock-free histogram inserts, so the tracer can stay on at 1080p30.
+ *
+ * Parameters: interval=<seconds> between summaries in the log (0 = off,
+ * default 5), file=<path> for the JSON report (default pipeline_trace.json)
+ * written when a top-level pipeline posts EOS or shuts down.
+ */
+
+#include "pipeline_trace_stats.h"
+#include <gst/gst.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+GST_DEBUG_CATEGORY_STATIC(pipeline_tracer_debug);
+#define GST_CAT_DEFAULT pipeline_tracer_debug
+
+typedef struct {
+    GstTracerClass parent_class;
+} PipelineTracerClass;
+
+typedef struct {
+    GstTracer parent;
+    PipelineTraceStats* stats;          // All element traces
+    std::string* file;                  // JSON report path
+    guint64 interval;                   // Log interval (ns, 0 = off)
+    std::atomic<guint64>* next_log;     // Timestamp of the next summary
+} PipelineTracer;
+
+// GObject type definitions
+#define PIPELINE_TRACER_TYPE (pipeline_tracer_get_type())
+#define PIPELINE_TRACER(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), PIPELINE_TRACER_TYPE, PipelineTracer))
+
+G_DEFINE_TYPE(PipelineTracer, pipeline_tracer, GST_TYPE_TRACER)
+
+namespace {
+
+/**
+ * @brief A push in progress on this thread
+ */
+struct OpenPush {
+    GstPad* pad;            // Pushing pad
+    GstElement* element;    // Receiving element
+    ElementTrace* trace;    // Its trace
+    guint64 entered;        // Push time (ns)
+    guint64 origin;         // Source push time of the frame (ns, 0 = unknown)
+    bool exited;            // Element already pushed the frame on
+};
+
+thread_local std::vector<OpenPush> open_pushes;
+
+GQuark trace_quark;         // Element qdata: ElementTrace*
+
+/**
+ * @brief Returns the element a pad pushes into, looking through ghost pads
+ */
+GstElement* peerElement(GstPad* pad) {
+    GstPad* peer = GST_PAD_PEER(pad);
+    for (int depth = 0; peer && depth < 16; ++depth) {
+        GstObject* parent = GST_OBJECT_PARENT(peer);
+        if (GST_IS_GHOST_PAD(peer)) {
+            // Sink ghost pad of a bin: continue at its target
+            GstPad* internal = GST_PAD_CAST(gst_proxy_pad_get_internal(GST_PROXY_PAD(peer)));
+            peer = internal ? GST_PAD_PEER(internal) : nullptr;
+            if (internal) {
+                gst_object_unref(internal);
+            }
+        } else if (parent && GST_IS_GHOST_PAD(parent)) {
+            // Internal pad of a source ghost pad: leave the bin
+            peer = GST_PAD_PEER(GST_PAD_CAST(parent));
+        } else {
+            return parent && GST_IS_ELEMENT(parent) ? GST_ELEMENT_CAST(parent) : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns the trace of an element, cached on the element
+ */
+ElementTrace* traceOf(PipelineTracer* self, GstElement* element) {
+    auto* trace = static_cast<ElementTrace*>(g_object_get_qdata(G_OBJECT(element), trace_quark));
+    if (trace) {
+        return trace;
+    }
+
+    const gchar* type = G_OBJECT_TYPE_NAME(element);
+    GstElementFactory* factory = gst_element_get_factory(element);
+    std::string factory_name = factory ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : type;
+    bool is_queue = g_str_equal(type, "GstQueue") || g_str_equal(type, "GstQueue2");
+
+    gchar* path = gst_object_get_path_string(GST_OBJECT(element));
+    trace = self->stats->element(path, factory_name, is_queue);
+    g_free(path);
+    g_object_set_qdata(G_OBJECT(element), trace_quark, trace);
+    return trace;
+}
+
+/**
+ * @brief Returns the innermost open push into an element
+ */
+OpenPush* findOpen(GstElement* element) {
+    for (auto it = open_pushes.rbegin(); it != open_pushes.rend(); ++it) {
+        if (it->element == element) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Logs a summary line per element once per interval
+ */
+void maybeLog(PipelineTracer* self, guint64 ts) {
+    if (self->interval == 0) {
+        return;
+    }
+    guint64 next = self->next_log->load(std::memory_order_relaxed);
+    if (ts < next) {
+        return;
+    }
+    // One thread logs; the others keep going
+    if (!self->next_log->compare_exchange_strong(next, ts + self->interval, std::memory_order_relaxed)) {
+        return;
+    }
+    if (next == 0) {
+        return;  // First frame: start the clock
+    }
+    for (const std::string& line : self->stats->summaryLines()) {
+        GST_INFO_OBJECT(self, "%s", line.c_str());
+    }
+}
+
+/**
+ * @brief Writes the JSON report
+ */
+void writeReport(PipelineTracer* self) {
+    if (self->stats->writeJson(*self->file)) {
+        GST_INFO_OBJECT(self, "Trace report written to %s", self->file->c_str());
+    } else {
+        GST_WARNING_OBJECT(self, "Cannot write trace report to %s", self->file->c_str());
+    }
+}
+
+/**
+ * @brief A buffer (or list) is about to be pushed from a pad
+ */
+void pushPre(PipelineTracer* self, guint64 ts, GstPad* pad, gconstpointer identity,
+             GstBuffer* first, guint64 bytes) {
+    GstObject* parent = GST_OBJECT_PARENT(pad);
+    if (!parent || !GST_IS_ELEMENT(parent) || GST_IS_BIN(parent)) {
+        return;  // Ghost pad forwarding; the real elements are traced
+    }
+    GstElement* element = GST_ELEMENT_CAST(parent);
+    ElementTrace* trace = traceOf(self, element);
+    guint64 pts = first ? GST_BUFFER_PTS(first) : GST_CLOCK_TIME_NONE;
+
+    // Where the frame came from
+    guint64 origin = 0;
+    OpenPush* open = findOpen(element);
+    if (open) {
+        if (!open->exited) {
+            trace->recordProcessing(ts - open->entered);
+            open->exited = true;
+        }
+        origin = open->origin;
+    } else if (element->numsinkpads == 0) {
+        origin = ts;
+        if (pts != GST_CLOCK_TIME_NONE) {
+            self->stats->recordSource(pts, ts);
+        }
+    } else if (!(trace->isQueue() && trace->dequeue(identity, ts, origin)) && pts != GST_CLOCK_TIME_NONE) {
+        self->stats->sourceTime(pts, origin);
+    }
+    if (origin && origin != ts) {
+        trace->recordLatency(ts - origin);
+    }
+
+    GstElement* peer = peerElement(pad);
+    if (peer) {
+        ElementTrace* peer_trace = traceOf(self, peer);
+        if (peer_trace->isQueue()) {
+            peer_trace->enqueue(identity, bytes, ts, origin);
+        }
+        open_pushes.push_back({pad, peer, peer_trace, ts, origin, false});
+    }
+    maybeLog(self, ts);
+}
+
+/**
+ * @brief A push from a pad returned
+ */
+void pushPost(guint64 ts, GstPad* pad) {
+    for (size_t i = open_pushes.size(); i-- > 0;) {
+        if (open_pushes[i].pad != pad) {
+            continue;
+        }
+        const OpenPush& open = open_pushes[i];
+        // Sinks, and elements that dropped or kept the frame
+        if (!open.exited && !open.trace->isQueue()) {
+            open.trace->recordProcessing(ts - open.entered);
+            if (open.element->numsrcpads == 0 && open.origin) {
+                open.trace->recordLatency(ts - open.origin);
+            }
+        }
+        open_pushes.resize(i);
+        return;
+    }
+}
+
+} // namespace
+
+// Hook callbacks (signatures from gst/gsttracerutils.h)
+static void on_pad_push_pre(GObject* self, GstClockTime ts, GstPad* pad, GstBuffer* buffer) {
+    pushPre(PIPELINE_TRACER(self), ts, pad, buffer, buffer, gst_buffer_get_size(buffer));
+}
+
+static void on_pad_push_post(GObject*, GstClockTime ts, GstPad* pad, GstFlowReturn) {
+    pushPost(ts, pad);
+}
+
+static void on_pad_push_list_pre(GObject* self, GstClockTime ts, GstPad* pad, GstBufferList* list) {
+    GstBuffer* first = gst_buffer_list_length(list) ? gst_buffer_list_get(list, 0) : nullptr;
+    pushPre(PIPELINE_TRACER(self), ts, pad, list, first, gst_buffer_list_calculate_size(list));
+}
+
+static void on_pad_push_list_post(GObject*, GstClockTime ts, GstPad* pad, GstFlowReturn) {
+    pushPost(ts, pad);
+}
+
+static void on_element_post_message_pre(GObject* self, GstClockTime, GstElement* element, GstMessage* message) {
+    if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS && GST_IS_PIPELINE(element) &&
+        !GST_OBJECT_PARENT(element)) {
+        writeReport(PIPELINE_TRACER(self));
+    }
+}
+
+static void on_element_change_state_post(GObject* self, GstClockTime, GstElement* element,
+                                         GstStateChange transition, GstStateChangeReturn) {
+    if (transition == GST_STATE_CHANGE_READY_TO_NULL && GST_IS_PIPELINE(element) &&
+        !GST_OBJECT_PARENT(element)) {
+        writeReport(PIPELINE_TRACER(self));
+    }
+}
+
+/**
+ * @brief Reads the tracer parameters, e.g. "interval=5,file=trace.json"
+ */
+static void pipeline_tracer_constructed(GObject* object) {
+    PipelineTracer* self = PIPELINE_TRACER(object);
+    G_OBJECT_CLASS(pipeline_tracer_parent_class)->constructed(object);
+
+    gchar* params = nullptr;
+    g_object_get(object, "params", &params, nullptr);
+    if (!params) {
+        return;
+    }
+    gchar* text = g_strdup_printf("pipelinetracer,%s", params);
+    GstStructure* structure = gst_structure_from_string(text, nullptr);
+    if (structure) {
+        gdouble interval;
+        if (gst_structure_get_double(structure, "interval", &interval)) {
+            self->interval = interval > 0 ? static_cast<guint64>(interval * GST_SECOND) : 0;
+        } else {
+            gint seconds;
+            if (gst_structure_get_int(structure, "interval", &seconds)) {
+                self->interval = seconds > 0 ? static_cast<guint64>(seconds) * GST_SECOND : 0;
+            }
+        }
+        if (const gchar* file = gst_structure_get_string(structure, "file")) {
+            *self->file = file;
+        }
+        gst_structure_free(structure);
+    } else {
+        GST_WARNING_OBJECT(self, "Cannot parse parameters '%s'", params);
+    }
+    g_free(text);
+    g_free(params);
+}
+
+/**
+ * @brief Writes a final report and frees the statistics
+ */
+static void pipeline_tracer_finalize(GObject* object) {
+    PipelineTracer* self = PIPELINE_TRACER(object);
+    writeReport(self);
+    delete self->stats;
+    delete self->file;
+    delete self->next_log;
+    G_OBJECT_CLASS(pipeline_tracer_parent_class)->finalize(object);
+}
+
+/**
+ * @brief GObject class initialization
+ */
+static void pipeline_tracer_class_init(PipelineTracerClass* klass) {
+    GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+    gobject_class->constructed = pipeline_tracer_constructed;
+    gobject_class->finalize = pipeline_tracer_finalize;
+
+    trace_quark = g_quark_from_static_string("pipelinetracer-trace");
+}
+
+/**
+ * @brief GObject instance initialization
+ */
+static void pipeline_tracer_init(PipelineTracer* self) {
+    self->stats = new PipelineTraceStats();
+    self->file = new std::string("pipeline_trace.json");
+    self->interval = 5 * GST_SECOND;
+    self->next_log = new std::atomic<guint64>(0);
+
+    GstTracer* tracer = GST_TRACER(self);
+    gst_tracing_register_hook(tracer, "pad-push-pre", G_CALLBACK(on_pad_push_pre));
+    gst_tracing_register_hook(tracer, "pad-push-post", G_CALLBACK(on_pad_push_post));
+    gst_tracing_register_hook(tracer, "pad-push-list-pre", G_CALLBACK(on_pad_push_list_pre));
+    gst_tracing_register_hook(tracer, "pad-push-list-post", G_CALLBACK(on_pad_push_list_post));
+    gst_tracing_register_hook(tracer, "element-post-message-pre", G_CALLBACK(on_element_post_message_pre));
+    gst_tracing_register_hook(tracer, "element-change-state-post", G_CALLBACK(on_element_change_state_post));
+}
+
+/**
+ * @brief Plugin entry point
+ */
+static gboolean plugin_init(GstPlugin* plugin) {
+    GST_DEBUG_CATEGORY_INIT(pipeline_tracer_debug, "pipelinetracer", 0,
+        "Per-element latency and queue occupancy tracer");
+
+    return gst_tracer_register(plugin, "pipelinetracer", PIPELINE_TRACER_TYPE);
+}
+
+GST_PLUGIN_DEFINE(
+    GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    pipelinetracer,
+    "Per-element latency and queue occupancy tracer",
+    plugin_init,
+    "1.0.0",
+    "LGPL",
+    "gstreamer_video_analytics",
+    "https://gstreamer.freedesktop.org/"
+)
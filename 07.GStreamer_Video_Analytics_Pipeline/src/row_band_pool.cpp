@@ -0,0 +1,97 @@
+/**
+ * @file row_band_pool.cpp
+ * @brief Persistent row-band worker pool implementation
+ */
+
+#include "row_band_pool.h"
+#include <algorithm>
+
+/**
+ * @brief Destructor
+ */
+RowBandPool::~RowBandPool() {
+    stop();
+}
+
+/**
+ * @brief Restarts the pool with a number of bands
+ */
+void RowBandPool::start(int bands) {
+    stop();
+
+    if (bands <= 0) {
+        bands = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    bands_ = bands;
+
+    stop_ = false;
+    for (int band = 1; band < bands_; ++band) {
+        workers_.emplace_back(&RowBandPool::worker, this, band, generation_);
+    }
+}
+
+/**
+ * @brief Splits [0, rows) into bands and runs the job on each
+ */
+void RowBandPool::run(int rows, const BandJob& job) {
+    if (bands_ == 1 || rows < bands_) {
+        job(0, rows);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &job;
+        rows_ = rows;
+        ++generation_;
+        pending_ = bands_ - 1;
+    }
+    start_cv_.notify_all();
+
+    job(0, rows / bands_);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+    job_ = nullptr;
+}
+
+/**
+ * @brief Stops and joins the workers
+ */
+void RowBandPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    bands_ = 1;
+}
+
+/**
+ * @brief Worker loop
+ */
+void RowBandPool::worker(int band, uint64_t seen) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) {
+            return;
+        }
+        seen = generation_;
+        const BandJob& job = *job_;
+        int begin = rows_ * band / bands_;
+        int end = rows_ * (band + 1) / bands_;
+        lock.unlock();
+
+        job(begin, end);
+
+        lock.lock();
+        if (--pending_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
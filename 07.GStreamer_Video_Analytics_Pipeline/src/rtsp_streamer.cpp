@@ -4,6 +4,7 @@
  */
 
 #include "rtsp_streamer.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -23,6 +24,19 @@ RTSPStreamer::RTSPStreamer(const RTSPConfig& config)
     
     // Record start time
     start_time_ = std::chrono::steady_clock::now();
+    
+    video_bridge_ = std::make_unique<AppSrcBridge>(static_cast<guint>(config_.bridge_max_buffers));
+    recorder_ = std::make_unique<StreamRecorder>(
+        config_.encoder.find("h265") != std::string::npos ? "h265parse" : "h264parse",
+        config_.max_record_duration);
+    
+    // Simulcast ladder: one extra mount per rung
+    for (const SimulcastRung& rung_config : config_.simulcast) {
+        auto rung = std::make_unique<Rung>();
+        rung->config = rung_config;
+        rung->mount = config_.mount_point + "/" + rung_config.name;
+        rungs_.push_back(std::move(rung));
+    }
 }
 
 /**
@@ -53,6 +67,10 @@ bool RTSPStreamer::start() {
     std::cout << "[RTSPStreamer] RTSP server started: " 
               << getStreamURL() << std::endl;
     
+    if (config_.enable_recording) {
+        recordStream(true);
+    }
+    
     return true;
 }
 
@@ -64,6 +82,9 @@ void RTSPStreamer::stop() {
         return;
     }
     
+    // Finish the recording while the media is still running
+    recordStream(false);
+    
     is_running_ = false;
     
     // Stop main loop
@@ -87,6 +108,13 @@ void RTSPStreamer::stop() {
         factory_ = nullptr;
     }
     
+    for (auto& rung : rungs_) {
+        if (rung->factory) {
+            g_object_unref(rung->factory);
+            rung->factory = nullptr;
+        }
+    }
+    
     if (auth_) {
         g_object_unref(auth_);
         auth_ = nullptr;
@@ -102,6 +130,15 @@ void RTSPStreamer::stop() {
         address_pool_ = nullptr;
     }
     
+    {
+        std::lock_guard<std::mutex> lock(media_mutex_);
+        for (auto& entry : medias_) {
+            retired_udp_bytes_ += entry.second;
+            g_object_unref(entry.first);
+        }
+        medias_.clear();
+    }
+    
     std::cout << "[RTSPStreamer] RTSP server stopped." << std::endl;
 }
 
@@ -110,6 +147,9 @@ void RTSPStreamer::stop() {
  */
 void RTSPStreamer::setVideoSource(GstElement* source) {
     video_source_ = source;
+    if (source) {
+        video_bridge_->attachSink(source);
+    }
 }
 
 /**
@@ -181,13 +221,95 @@ bool RTSPStreamer::disconnectClient(const std::string& client_id) {
  * @brief Returns server statistics
  */
 RTSPStats RTSPStreamer::getStats() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
+    RTSPStats stats;
+    stats.active_clients = static_cast<int>(active_clients_metric_.value());
+    stats.total_connections = static_cast<int>(connections_metric_.value());
+    stats.total_bytes_sent = bytes_metric_.value();
+    stats.total_frames_sent = frames_metric_.value();
+    stats.average_bandwidth = bandwidth_metric_.value();
+    stats.udp_bytes_sent = udpBytesSent();
     
     // Update uptime
     auto now = std::chrono::steady_clock::now();
-    stats_.uptime = now - start_time_;
+    stats.uptime = now - start_time_;
     
-    return stats_;
+    return stats;
+}
+
+/**
+ * @brief Exports the server metrics
+ */
+void RTSPStreamer::registerMetrics(MetricsRegistry& registry) {
+    registry.addGauge("rtsp_active_clients", "Connected RTSP clients", active_clients_metric_);
+    registry.addCounter("rtsp_connections_total", "RTSP client connections", connections_metric_);
+    registry.addCounter("rtsp_sent_bytes_total", "Encoded bytes handed to the RTP payloaders", bytes_metric_);
+    registry.addCounter("rtsp_sent_frames_total", "Encoded frames handed to the RTP payloaders", frames_metric_);
+    registry.addGauge("rtsp_client_bandwidth_mbps", "Average bandwidth per playing client", bandwidth_metric_);
+    registry.addCollector("rtsp_udp_sent_bytes_total", "RTP/RTCP bytes sent over UDP (unicast and multicast)",
+                          MetricType::COUNTER, [this](std::vector<MetricSample>& samples) {
+                              samples.push_back({{}, static_cast<double>(udpBytesSent())});
+                          });
+    video_bridge_->registerMetrics(registry, "rtsp_bridge");
+    recorder_->registerMetrics(registry, "rtsp_recording");
+    
+    for (auto& rung : rungs_) {
+        MetricLabels labels = {{"rung", rung->config.name}};
+        registry.addGauge("rtsp_rung_subscribers", "Clients playing a simulcast rung", rung->subscribers, labels);
+        registry.addGauge("rtsp_rung_encoding", "Simulcast rung encoder running (1) or idle (0)",
+                          rung->encoding, labels);
+        registry.addCounter("rtsp_rung_encoded_frames_total", "Frames encoded by a simulcast rung",
+                            rung->frames, labels);
+        registry.addHistogram("rtsp_rung_encode_seconds", "Encode time per frame of a simulcast rung",
+                              rung->encode_seconds, labels);
+    }
+}
+
+/**
+ * @brief Returns the statistics of every simulcast rung
+ */
+std::vector<RungStats> RTSPStreamer::getRungStats() const {
+    std::vector<RungStats> result;
+    for (const auto& rung : rungs_) {
+        RungStats stats;
+        stats.name = rung->config.name;
+        stats.mount = rung->mount;
+        stats.width = rung->config.width;
+        stats.height = rung->config.height;
+        stats.bitrate = rung->config.bitrate;
+        stats.subscribers = static_cast<int>(rung->subscribers.value());
+        stats.encoding = rung->encoding.value() > 0;
+        stats.encoded_frames = rung->frames.value();
+        
+        Histogram::Snapshot snapshot = rung->encode_seconds.snapshot();
+        stats.avg_encode_ms = snapshot.count ? snapshot.sum * 1000.0 / snapshot.count : 0.0;
+        result.push_back(stats);
+    }
+    return result;
+}
+
+/**
+ * @brief Returns the ladder rung of a quality profile
+ */
+SimulcastRung RTSPStreamer::profileRung(StreamProfile profile, const RTSPConfig& config) {
+    SimulcastRung rung;
+    switch (profile) {
+        case StreamProfile::LOW:
+            rung = {"low", 854, 480, 1000000};
+            break;
+        case StreamProfile::MEDIUM:
+            rung = {"medium", 1280, 720, 2500000};
+            break;
+        case StreamProfile::HIGH:
+            rung = {"high", 1920, 1080, 5000000};
+            break;
+        case StreamProfile::ULTRA:
+            rung = {"ultra", 3840, 2160, 15000000};
+            break;
+        case StreamProfile::CUSTOM:
+            rung = {"custom", config.width, config.height, config.bitrate};
+            break;
+    }
+    return rung;
 }
 
 /**
@@ -259,16 +381,46 @@ void RTSPStreamer::setIPFilter(const std::vector<std::string>& allowed_ips) {
  * @brief Record the stream
  */
 bool RTSPStreamer::recordStream(bool enable, const std::string& filename) {
-    if (enable && !is_recording_) {
-        // TODO: Recording implementation
-        record_filename_ = filename;
-        is_recording_ = true;
+    std::lock_guard<std::mutex> lock(record_mutex_);
+    
+    if (enable && !record_media_) {
+        if (!is_running_.load()) {
+            std::cerr << "[RTSPStreamer] Server is not running, cannot record!" << std::endl;
+            return false;
+        }
         
-        std::cout << "[RTSPStreamer] Recording started: " << filename << std::endl;
+        GstRTSPMedia* media = holdMainMedia();
+        if (!media) {
+            return false;
+        }
+        
+        // Branch off the encoded stream behind the parser of the main mount
+        GstElement* element = gst_rtsp_media_get_element(media);
+        GstElement* tee = gst_bin_get_by_name(GST_BIN(element), "rectee");
+        gst_object_unref(element);
+        
+        std::string pattern = filename.empty() ? config_.record_path + "/rtsp_%Y%m%d_%H%M%S.mp4" : filename;
+        bool attached = tee && recorder_->attach(tee, pattern);
+        if (tee) {
+            gst_object_unref(tee);
+        }
+        if (!attached) {
+            std::cerr << "[RTSPStreamer] Failed to start recording!" << std::endl;
+            gst_rtsp_media_unprepare(media);
+            g_object_unref(media);
+            return false;
+        }
+        record_media_ = media;
+        
+        std::cout << "[RTSPStreamer] Recording started: " << pattern << std::endl;
         return true;
-    } else if (!enable && is_recording_) {
-        // TODO: Stop recording
-        is_recording_ = false;
+    } else if (!enable && record_media_) {
+        recorder_->detach();
+        
+        // Clients still playing keep the media; otherwise it is torn down
+        gst_rtsp_media_unprepare(record_media_);
+        g_object_unref(record_media_);
+        record_media_ = nullptr;
         
         std::cout << "[RTSPStreamer] Recording stopped." << std::endl;
         return true;
@@ -277,6 +429,43 @@ bool RTSPStreamer::recordStream(bool enable, const std::string& filename) {
     return false;
 }
 
+/**
+ * @brief Returns recording statistics
+ */
+StreamRecorderStats RTSPStreamer::getRecordingStats() const {
+    return recorder_->getStats();
+}
+
+/**
+ * @brief Keeps the shared main media prepared and playing
+ */
+GstRTSPMedia* RTSPStreamer::holdMainMedia() {
+    // Clients of the main mount get the same shared media (same URL key)
+    GstRTSPUrl* url = nullptr;
+    if (gst_rtsp_url_parse(getStreamURL().c_str(), &url) != GST_RTSP_OK) {
+        return nullptr;
+    }
+    GstRTSPMedia* media = gst_rtsp_media_factory_construct(factory_, url);
+    gst_rtsp_url_free(url);
+    if (!media) {
+        std::cerr << "[RTSPStreamer] Failed to create the main media!" << std::endl;
+        return nullptr;
+    }
+    
+    GstRTSPThreadPool* pool = gst_rtsp_server_get_thread_pool(server_);
+    GstRTSPThread* thread = gst_rtsp_thread_pool_get_thread(pool, GST_RTSP_THREAD_TYPE_MEDIA, nullptr);
+    g_object_unref(pool);
+    if (!thread || !gst_rtsp_media_prepare(media, thread)) {
+        std::cerr << "[RTSPStreamer] Failed to prepare the main media!" << std::endl;
+        g_object_unref(media);
+        return nullptr;
+    }
+    
+    // Our prepare counts as a user: the last client leaving does not pause it
+    gst_rtsp_media_set_pipeline_state(media, GST_STATE_PLAYING);
+    return media;
+}
+
 /**
  * @brief Take a snapshot
  */
@@ -306,6 +495,23 @@ bool RTSPStreamer::createServer() {
     // Get mount points
     mounts_ = gst_rtsp_server_get_mount_points(server_);
     
+    // Multicast group, shared by every mount: each media takes an RTP/RTCP
+    // port pair per stream (video, audio) from the range
+    if (config_.enable_multicast) {
+        const int media_count = 1 + static_cast<int>(rungs_.size());
+        address_pool_ = gst_rtsp_address_pool_new();
+        if (!gst_rtsp_address_pool_add_range(address_pool_,
+                config_.multicast_address.c_str(),
+                config_.multicast_address.c_str(),
+                config_.multicast_port,
+                config_.multicast_port + 4 * media_count - 1,
+                config_.multicast_ttl)) {
+            std::cerr << "[RTSPStreamer] Invalid multicast range: " << config_.multicast_address
+                      << ":" << config_.multicast_port << std::endl;
+            return false;
+        }
+    }
+    
     // Create media factory
     factory_ = createMediaFactory();
     if (!factory_) {
@@ -317,24 +523,21 @@ bool RTSPStreamer::createServer() {
                                       config_.mount_point.c_str(), 
                                       factory_);
     
+    // Simulcast rungs: same frames, own encoder, own mount
+    for (auto& rung : rungs_) {
+        rung->factory = createMediaFactory(&rung->config);
+        g_object_ref(rung->factory);  // The mount points take the other reference
+        gst_rtsp_mount_points_add_factory(mounts_, rung->mount.c_str(), rung->factory);
+        std::cout << "[RTSPStreamer] Simulcast rung " << rung->config.name << " ("
+                  << rung->config.width << "x" << rung->config.height << ", "
+                  << rung->config.bitrate / 1000 << " kbps): " << rung->mount << std::endl;
+    }
+    
     // Apply security settings
     if (config_.security != SecurityType::NONE) {
         applySecurity();
     }
     
-    // Multicast settings
-    if (config_.enable_multicast) {
-        address_pool_ = gst_rtsp_address_pool_new();
-        gst_rtsp_address_pool_add_range(address_pool_,
-            config_.multicast_address.c_str(),
-            config_.multicast_address.c_str(),
-            config_.multicast_port,
-            config_.multicast_port + 10,
-            config_.multicast_ttl);
-        
-        gst_rtsp_media_factory_set_address_pool(factory_, address_pool_);
-    }
-    
     // Connect client connection signals
     g_signal_connect(server_, "client-connected",
                      G_CALLBACK(onClientConnected), this);
@@ -348,11 +551,11 @@ bool RTSPStreamer::createServer() {
 /**
  * @brief Creates the media factory
  */
-GstRTSPMediaFactory* RTSPStreamer::createMediaFactory() {
+GstRTSPMediaFactory* RTSPStreamer::createMediaFactory(const SimulcastRung* rung) {
     GstRTSPMediaFactory* factory = gst_rtsp_media_factory_new();
     
     // Build pipeline string
-    std::string pipeline = buildPipelineString();
+    std::string pipeline = buildPipelineString(rung);
     
     // Factory settings
     gst_rtsp_media_factory_set_launch(factory, pipeline.c_str());
@@ -365,6 +568,19 @@ GstRTSPMediaFactory* RTSPStreamer::createMediaFactory() {
         gst_rtsp_media_factory_set_enable_rtcp(factory, TRUE);
     }
     
+    // Multicast: clients that ask for it join one group per media, so the
+    // server sends each packet once however many watch. Clients without
+    // multicast fall back to unicast UDP, then to TCP interleaved.
+    if (address_pool_) {
+        gst_rtsp_media_factory_set_address_pool(factory, address_pool_);
+        gst_rtsp_media_factory_set_protocols(factory, static_cast<GstRTSPLowerTrans>(
+            GST_RTSP_LOWER_TRANS_UDP_MCAST | GST_RTSP_LOWER_TRANS_UDP | GST_RTSP_LOWER_TRANS_TCP));
+        gst_rtsp_media_factory_set_max_mcast_ttl(factory, static_cast<guint>(config_.multicast_ttl));
+        if (!config_.multicast_iface.empty()) {
+            gst_rtsp_media_factory_set_multicast_iface(factory, config_.multicast_iface.c_str());
+        }
+    }
+    
     // Connect media configure signal
     g_signal_connect(factory, "media-configure",
                      G_CALLBACK(onMediaConfigure), this);
@@ -375,47 +591,57 @@ GstRTSPMediaFactory* RTSPStreamer::createMediaFactory() {
 /**
  * @brief Builds the pipeline string
  */
-std::string RTSPStreamer::buildPipelineString() {
+std::string RTSPStreamer::buildPipelineString(const SimulcastRung* rung) {
     std::stringstream pipeline;
+    const int width = rung ? rung->width : config_.width;
+    const int height = rung ? rung->height : config_.height;
+    const int bitrate = rung ? rung->bitrate : config_.bitrate;
     
     // Video part
     if (video_source_) {
-        // Get video from AppSrc
+        // Processed frames from the analytics pipeline; caps are set by the bridge
         pipeline << "appsrc name=videosrc ! ";
+        if (rung) {
+            // Scaled from the shared frames; nothing upstream runs twice
+            pipeline << "videoscale ! video/x-raw,width=" << width
+                     << ",height=" << height << " ! ";
+        }
+        pipeline << "videoconvert ! ";
     } else {
         // Use test pattern
         pipeline << "videotestsrc is-live=true ! ";
+        
+        // Video caps
+        pipeline << "video/x-raw,width=" << width 
+                 << ",height=" << height
+                 << ",framerate=" << config_.framerate << "/1 ! ";
     }
     
-    // Video caps
-    pipeline << "video/x-raw,width=" << config_.width 
-             << ",height=" << config_.height
-             << ",framerate=" << config_.framerate << "/1 ! ";
-    
     // Video encoder
     if (config_.encoder == "nvh264enc" || config_.encoder == "nvh265enc") {
         // NVIDIA encoder
-        pipeline << config_.encoder << " preset=low-latency bitrate=" 
-                 << (config_.bitrate / 1000) << " ! ";
+        pipeline << config_.encoder << " name=venc preset=low-latency bitrate=" 
+                 << (bitrate / 1000) << " ! ";
     } else if (config_.encoder == "x264enc") {
         // x264 encoder
-        pipeline << "x264enc speed-preset=ultrafast tune=zerolatency bitrate="
-                 << (config_.bitrate / 1000) << " ! ";
+        pipeline << "x264enc name=venc speed-preset=ultrafast tune=zerolatency bitrate="
+                 << (bitrate / 1000) << " ! ";
     } else if (config_.encoder == "x265enc") {
         // x265 encoder
-        pipeline << "x265enc speed-preset=ultrafast tune=zerolatency bitrate="
-                 << (config_.bitrate / 1000) << " ! ";
+        pipeline << "x265enc name=venc speed-preset=ultrafast tune=zerolatency bitrate="
+                 << (bitrate / 1000) << " ! ";
     }
     
-    // RTP payloader
+    // RTP payloader; the main mount's tee is where recordStream() branches off
+    const char* tee = rung ? "" : "tee name=rectee ! ";
     if (config_.encoder.find("h265") != std::string::npos) {
-        pipeline << "h265parse ! rtph265pay name=pay0 pt=96 ";
+        pipeline << "h265parse ! " << tee << "rtph265pay name=pay0 pt=96 ";
     } else {
-        pipeline << "h264parse ! rtph264pay name=pay0 pt=96 ";
+        pipeline << "h264parse ! " << tee << "rtph264pay name=pay0 pt=96 ";
     }
     
-    // Audio part (if enabled)
-    if (config_.enable_audio) {
+    // Audio part (if enabled; rungs are video-only)
+    if (config_.enable_audio && !rung) {
         pipeline << " ";
         
         if (audio_source_) {
@@ -511,14 +737,12 @@ void RTSPStreamer::onClientConnected(GstRTSPServer* server,
     {
         std::lock_guard<std::mutex> lock(streamer->clients_mutex_);
         streamer->clients_[info.id] = info;
+        streamer->client_ids_[client] = info.id;
     }
     
     // Update statistics
-    {
-        std::lock_guard<std::mutex> lock(streamer->stats_mutex_);
-        streamer->stats_.active_clients++;
-        streamer->stats_.total_connections++;
-    }
+    streamer->active_clients_metric_.add(1);
+    streamer->connections_metric_.inc();
     
     // Call callback
     if (streamer->client_callback_) {
@@ -529,6 +753,12 @@ void RTSPStreamer::onClientConnected(GstRTSPServer* server,
     g_signal_connect(client, "closed",
                      G_CALLBACK(onClientDisconnected), streamer);
     
+    // Simulcast subscribers
+    if (!streamer->rungs_.empty()) {
+        g_signal_connect(client, "play-request", G_CALLBACK(onPlayRequest), streamer);
+        g_signal_connect(client, "teardown-request", G_CALLBACK(onTeardownRequest), streamer);
+    }
+    
     std::cout << "[RTSPStreamer] Client connected: " 
               << info.address << ":" << info.port << std::endl;
 }
@@ -536,8 +766,7 @@ void RTSPStreamer::onClientConnected(GstRTSPServer* server,
 /**
  * @brief Client disconnected callback
  */
-void RTSPStreamer::onClientDisconnected(GstRTSPServer* server,
-                                       GstRTSPClient* client,
+void RTSPStreamer::onClientDisconnected(GstRTSPClient* client,
                                        gpointer user_data) {
     RTSPStreamer* streamer = static_cast<RTSPStreamer*>(user_data);
     
@@ -549,23 +778,30 @@ void RTSPStreamer::onClientDisconnected(GstRTSPServer* server,
         std::lock_guard<std::mutex> lock(streamer->clients_mutex_);
         
         // Find client
-        for (auto it = streamer->clients_.begin(); it != streamer->clients_.end(); ++it) {
-            // TODO: Compare GstRTSPClient pointer
-            if (true) { // Placeholder
+        auto id = streamer->client_ids_.find(client);
+        if (id != streamer->client_ids_.end()) {
+            auto it = streamer->clients_.find(id->second);
+            if (it != streamer->clients_.end()) {
                 info = it->second;
                 streamer->clients_.erase(it);
                 found = true;
-                break;
             }
+            streamer->client_ids_.erase(id);
+        }
+        
+        // Closed without TEARDOWN: leave every rung it was playing
+        auto rungs = streamer->client_rungs_.find(client);
+        if (rungs != streamer->client_rungs_.end()) {
+            for (Rung* rung : rungs->second) {
+                rung->subscribers.add(-1);
+            }
+            streamer->client_rungs_.erase(rungs);
         }
     }
     
     if (found) {
         // Update statistics
-        {
-            std::lock_guard<std::mutex> lock(streamer->stats_mutex_);
-            streamer->stats_.active_clients--;
-        }
+        streamer->active_clients_metric_.add(-1);
         
         // Call callback
         if (streamer->client_callback_) {
@@ -577,6 +813,58 @@ void RTSPStreamer::onClientDisconnected(GstRTSPServer* server,
     }
 }
 
+/**
+ * @brief Returns the rung a request URL path belongs to
+ */
+RTSPStreamer::Rung* RTSPStreamer::findRung(const std::string& path) const {
+    for (const auto& rung : rungs_) {
+        const std::string& mount = rung->mount;
+        if (path.compare(0, mount.size(), mount) == 0 &&
+            (path.size() == mount.size() || path[mount.size()] == '/')) {
+            return rung.get();
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief PLAY request callback
+ */
+void RTSPStreamer::onPlayRequest(GstRTSPClient* client, GstRTSPContext* ctx, gpointer user_data) {
+    RTSPStreamer* streamer = static_cast<RTSPStreamer*>(user_data);
+    if (!ctx->uri || !ctx->uri->abspath) {
+        return;
+    }
+    
+    Rung* rung = streamer->findRung(ctx->uri->abspath);
+    if (rung) {
+        std::lock_guard<std::mutex> lock(streamer->clients_mutex_);
+        // PAUSE/PLAY repeats the request; count the client once
+        if (streamer->client_rungs_[client].insert(rung).second) {
+            rung->subscribers.add(1);
+        }
+    }
+}
+
+/**
+ * @brief TEARDOWN request callback
+ */
+void RTSPStreamer::onTeardownRequest(GstRTSPClient* client, GstRTSPContext* ctx, gpointer user_data) {
+    RTSPStreamer* streamer = static_cast<RTSPStreamer*>(user_data);
+    if (!ctx->uri || !ctx->uri->abspath) {
+        return;
+    }
+    
+    Rung* rung = streamer->findRung(ctx->uri->abspath);
+    if (rung) {
+        std::lock_guard<std::mutex> lock(streamer->clients_mutex_);
+        auto it = streamer->client_rungs_.find(client);
+        if (it != streamer->client_rungs_.end() && it->second.erase(rung)) {
+            rung->subscribers.add(-1);
+        }
+    }
+}
+
 /**
  * @brief Media configuration callback
  */
@@ -588,22 +876,56 @@ void RTSPStreamer::onMediaConfigure(GstRTSPMediaFactory* factory,
     // Connect media state change signal
     g_signal_connect(media, "new-state",
                      G_CALLBACK(onMediaStateChanged), streamer);
+    g_signal_connect(media, "unprepared", G_CALLBACK(onMediaUnprepared), streamer);
+    
+    {
+        std::lock_guard<std::mutex> lock(streamer->media_mutex_);
+        if (streamer->medias_.emplace(media, 0).second) {
+            g_object_ref(media);
+        }
+    }
     
     // Get pipeline
     GstElement* pipeline = gst_rtsp_media_get_element(media);
     
+    // Simulcast rung: time its encoder. A rung media only exists while
+    // clients play it; when the last one leaves it is unprepared, its
+    // encoder is destroyed and the bridge stops feeding it.
+    for (auto& rung : streamer->rungs_) {
+        if (rung->factory != factory) {
+            continue;
+        }
+        GstElement* encoder = gst_bin_get_by_name(GST_BIN(pipeline), "venc");
+        if (encoder) {
+            GstPad* sink_pad = gst_element_get_static_pad(encoder, "sink");
+            GstPad* src_pad = gst_element_get_static_pad(encoder, "src");
+            gst_pad_add_probe(sink_pad, GST_PAD_PROBE_TYPE_BUFFER, onEncoderInput, rung.get(), nullptr);
+            gst_pad_add_probe(src_pad, GST_PAD_PROBE_TYPE_BUFFER, onEncoderOutput, rung.get(), nullptr);
+            gst_object_unref(sink_pad);
+            gst_object_unref(src_pad);
+            gst_object_unref(encoder);
+        }
+        rung->encoding.add(1);
+        g_object_set_data(G_OBJECT(media), "rtsp-rung", rung.get());
+        break;
+    }
+    
+    // Count what is streamed (encoded access units into the payloader)
+    GstElement* payloader = gst_bin_get_by_name(GST_BIN(pipeline), "pay0");
+    if (payloader) {
+        GstPad* pad = gst_element_get_static_pad(payloader, "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, onPayloadBuffer, streamer, nullptr);
+        gst_object_unref(pad);
+        gst_object_unref(payloader);
+    }
+    
     // Connect video source if available
     if (streamer->video_source_) {
         GstElement* videosrc = gst_bin_get_by_name(GST_BIN(pipeline), "videosrc");
         if (videosrc) {
-            // AppSrc settings
-            g_object_set(videosrc,
-                "stream-type", GST_APP_STREAM_TYPE_STREAM,
-                "format", GST_FORMAT_TIME,
-                "is-live", TRUE,
-                nullptr);
-            
-            // TODO: Data feeding mechanism for AppSrc
+            // Fed by the bridge until the media is torn down; a shared
+            // media (one encoder) is configured once for all its clients
+            streamer->video_bridge_->addTarget(videosrc);
             
             gst_object_unref(videosrc);
         }
@@ -629,6 +951,140 @@ void RTSPStreamer::onMediaConfigure(GstRTSPMediaFactory* factory,
     gst_object_unref(pipeline);
 }
 
+/**
+ * @brief Media unprepared callback
+ */
+void RTSPStreamer::onMediaUnprepared(GstRTSPMedia* media, gpointer user_data) {
+    RTSPStreamer* streamer = static_cast<RTSPStreamer*>(user_data);
+    
+    Rung* rung = static_cast<Rung*>(g_object_get_data(G_OBJECT(media), "rtsp-rung"));
+    if (rung) {
+        rung->encoding.add(-1);
+        std::lock_guard<std::mutex> lock(rung->timing_mutex);
+        rung->in_flight.clear();
+    }
+    
+    GstElement* pipeline = gst_rtsp_media_get_element(media);
+    GstElement* videosrc = gst_bin_get_by_name(GST_BIN(pipeline), "videosrc");
+    if (videosrc) {
+        streamer->video_bridge_->removeTarget(videosrc);
+        gst_object_unref(videosrc);
+    }
+    gst_object_unref(pipeline);
+    
+    // Its UDP sinks are gone; keep what was last read from them
+    std::lock_guard<std::mutex> lock(streamer->media_mutex_);
+    auto it = streamer->medias_.find(media);
+    if (it != streamer->medias_.end()) {
+        streamer->retired_udp_bytes_ += it->second;
+        g_object_unref(it->first);
+        streamer->medias_.erase(it);
+    }
+}
+
+/**
+ * @brief Returns the bytes the UDP sinks of a media have sent
+ */
+guint64 RTSPStreamer::mediaUdpBytes(GstRTSPMedia* media) {
+    // The stream sinks live in the media pipeline, next to the launch bin
+    GstElement* element = gst_rtsp_media_get_element(media);
+    GstObject* pipeline = gst_object_get_parent(GST_OBJECT(element));
+    gst_object_unref(element);
+    if (!pipeline) {
+        return 0;
+    }
+    
+    guint64 total = 0;
+    GstIterator* it = gst_bin_iterate_all_by_element_factory_name(GST_BIN(pipeline), "multiudpsink");
+    GValue item = G_VALUE_INIT;
+    bool done = false;
+    while (!done) {
+        switch (gst_iterator_next(it, &item)) {
+        case GST_ITERATOR_OK: {
+            guint64 bytes = 0;
+            g_object_get(g_value_get_object(&item), "bytes-served", &bytes, nullptr);
+            total += bytes;
+            g_value_reset(&item);
+            break;
+        }
+        case GST_ITERATOR_RESYNC:
+            total = 0;
+            gst_iterator_resync(it);
+            break;
+        default:
+            done = true;
+            break;
+        }
+    }
+    g_value_unset(&item);
+    gst_iterator_free(it);
+    gst_object_unref(pipeline);
+    return total;
+}
+
+/**
+ * @brief Returns the UDP bytes sent by all media since start
+ */
+guint64 RTSPStreamer::udpBytesSent() const {
+    std::lock_guard<std::mutex> lock(media_mutex_);
+    guint64 total = retired_udp_bytes_;
+    for (auto& entry : medias_) {
+        // bytes-served only grows while the media is prepared
+        entry.second = std::max(entry.second, mediaUdpBytes(entry.first));
+        total += entry.second;
+    }
+    return total;
+}
+
+/**
+ * @brief Notes when a frame enters a rung encoder
+ */
+GstPadProbeReturn RTSPStreamer::onEncoderInput(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+    Rung* rung = static_cast<Rung*>(user_data);
+    GstClockTime pts = GST_BUFFER_PTS(GST_PAD_PROBE_INFO_BUFFER(info));
+    
+    std::lock_guard<std::mutex> lock(rung->timing_mutex);
+    rung->in_flight.emplace_back(pts, g_get_monotonic_time());
+    // Bounded: an encoder never holds more than a few frames (zerolatency)
+    if (rung->in_flight.size() > 64) {
+        rung->in_flight.pop_front();
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * @brief Measures the encode time of a frame leaving a rung encoder
+ */
+GstPadProbeReturn RTSPStreamer::onEncoderOutput(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+    Rung* rung = static_cast<Rung*>(user_data);
+    GstClockTime pts = GST_BUFFER_PTS(GST_PAD_PROBE_INFO_BUFFER(info));
+    gint64 now = g_get_monotonic_time();
+    rung->frames.inc();
+    
+    std::lock_guard<std::mutex> lock(rung->timing_mutex);
+    // Frames before the matching one were dropped by the encoder
+    while (!rung->in_flight.empty()) {
+        auto entry = rung->in_flight.front();
+        rung->in_flight.pop_front();
+        if (entry.first == pts) {
+            rung->encode_seconds.observe((now - entry.second) / 1e6);
+            break;
+        }
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * @brief Counts encoded frames entering the payloader
+ */
+GstPadProbeReturn RTSPStreamer::onPayloadBuffer(GstPad* pad, GstPadProbeInfo* info,
+                                                gpointer user_data) {
+    RTSPStreamer* streamer = static_cast<RTSPStreamer*>(user_data);
+    streamer->frames_metric_.inc();
+    streamer->bytes_metric_.inc(gst_buffer_get_size(GST_PAD_PROBE_INFO_BUFFER(info)));
+    return GST_PAD_PROBE_OK;
+}
+
 /**
  * @brief Stream state changed callback
  */
@@ -703,8 +1159,6 @@ void RTSPStreamer::serverMainLoop() {
  * @brief Update statistics
  */
 void RTSPStreamer::updateStats() {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    
     // Active client count is already up to date
 
     // Bandwidth calculation
@@ -727,15 +1181,12 @@ void RTSPStreamer::updateStats() {
     }
     
     // Average bandwidth
-    if (active_count > 0) {
-        stats_.average_bandwidth = total_bandwidth / active_count;
-    } else {
-        stats_.average_bandwidth = 0;
-    }
+    bandwidth_metric_.set(active_count > 0 ? total_bandwidth / active_count : 0.0);
     
     // Debug output
-    if (stats_.active_clients > 0) {
-        std::cout << "[RTSPStreamer] Active clients: " << stats_.active_clients
+    int active_clients = static_cast<int>(active_clients_metric_.value());
+    if (active_clients > 0) {
+        std::cout << "[RTSPStreamer] Active clients: " << active_clients
                   << ", Total bandwidth: " << std::fixed << std::setprecision(2)
                   << total_bandwidth << " Mbps" << std::endl;
     }
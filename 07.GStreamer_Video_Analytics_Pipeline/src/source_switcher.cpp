@@ -0,0 +1,704 @@
+/**
+ * @file source_switcher.cpp
+ * @brief Hot input switching implementation
+ */
+
+#include "source_switcher.h"
+#include <chrono>
+#include <iostream>
+
+/**
+ * @brief Constructor
+ */
+SourceSwitcher::SourceSwitcher(const SourceFormat& format)
+    : format_(format) {
+}
+
+/**
+ * @brief Destructor
+ */
+SourceSwitcher::~SourceSwitcher() {
+    release();
+}
+
+/**
+ * @brief Creates the input-selector inside the pipeline
+ */
+GstElement* SourceSwitcher::createElement(GstElement* pipeline) {
+    release();
+
+    selector_ = gst_element_factory_make("input-selector", "source_selector");
+    if (!selector_) {
+        std::cerr << "[SourceSwitcher] Failed to create input-selector!" << std::endl;
+        return nullptr;
+    }
+
+    // Inactive inputs are dropped at once instead of waiting for the active one
+    g_object_set(selector_, "sync-streams", FALSE, nullptr);
+    gst_bin_add(GST_BIN(pipeline), selector_);
+    pipeline_ = pipeline;
+
+    output_pad_ = gst_element_get_static_pad(selector_, "src");
+    output_probe_ = gst_pad_add_probe(output_pad_, GST_PAD_PROBE_TYPE_BUFFER,
+                                      onOutputBuffer, this, nullptr);
+    return selector_;
+}
+
+/**
+ * @brief Drops every branch
+ */
+void SourceSwitcher::release() {
+    joinReaper();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::unique_ptr<Branch>* branch : {&active_, &standby_}) {
+        if (*branch) {
+            gst_object_unref((*branch)->selector_pad);
+            branch->reset();
+        }
+    }
+    if (output_pad_) {
+        gst_pad_remove_probe(output_pad_, output_probe_);
+        gst_object_unref(output_pad_);
+        output_pad_ = nullptr;
+    }
+    selector_ = nullptr;
+    pipeline_ = nullptr;
+    switch_pending_ = false;
+    last_output_us_ = 0;
+    last_output_end_ = GST_CLOCK_TIME_NONE;
+    standby_ready_metric_.set(0);
+}
+
+/**
+ * @brief Builds a branch bin and links it to a new selector pad
+ */
+std::unique_ptr<SourceSwitcher::Branch> SourceSwitcher::createBranch(const std::string& location,
+                                                                     SourceType type) {
+    auto branch = std::make_unique<Branch>();
+    branch->owner = this;
+    branch->location = location;
+    branch->type = type;
+    branch->live = type != SourceType::FILE;
+
+    std::string name = "input" + std::to_string(branch_counter_++);
+    branch->bin = gst_bin_new(name.c_str());
+
+    // Every input leaves the branch in the pipeline format: no renegotiation on switch
+    GstElement* convert = gst_element_factory_make("videoconvert", nullptr);
+    GstElement* scale = gst_element_factory_make("videoscale", nullptr);
+    GstElement* rate = gst_element_factory_make("videorate", nullptr);
+    GstElement* capsfilter = gst_element_factory_make("capsfilter", nullptr);
+    if (!convert || !scale || !rate || !capsfilter) {
+        std::cerr << "[SourceSwitcher] Failed to create input branch elements!" << std::endl;
+        for (GstElement* element : {convert, scale, rate, capsfilter}) {
+            if (element) {
+                gst_object_unref(element);
+            }
+        }
+        gst_object_unref(branch->bin);
+        return nullptr;
+    }
+
+    GstCaps* caps = gst_caps_new_simple("video/x-raw",
+        "width", G_TYPE_INT, format_.width,
+        "height", G_TYPE_INT, format_.height,
+        "framerate", GST_TYPE_FRACTION, format_.framerate, 1,
+        "format", G_TYPE_STRING, format_.video_format.c_str(),
+        nullptr);
+    g_object_set(capsfilter, "caps", caps, nullptr);
+    gst_caps_unref(caps);
+
+    gst_bin_add_many(GST_BIN(branch->bin), convert, scale, rate, capsfilter, nullptr);
+    if (!gst_element_link_many(convert, scale, rate, capsfilter, nullptr) ||
+        !createSourceElements(*branch, convert)) {
+        std::cerr << "[SourceSwitcher] Failed to build input branch for " << location << std::endl;
+        gst_object_unref(branch->bin);
+        return nullptr;
+    }
+
+    GstPad* pad = gst_element_get_static_pad(capsfilter, "src");
+    branch->ghost_pad = gst_ghost_pad_new("src", pad);
+    gst_object_unref(pad);
+    gst_element_add_pad(branch->bin, branch->ghost_pad);
+    gst_pad_add_probe(branch->ghost_pad, GST_PAD_PROBE_TYPE_BUFFER, onBranchBuffer, branch.get(), nullptr);
+    branch->last_frame_us = g_get_monotonic_time();
+
+    gst_bin_add(GST_BIN(pipeline_), branch->bin);
+    branch->selector_pad = gst_element_get_request_pad(selector_, "sink_%u");
+    if (gst_pad_link(branch->ghost_pad, branch->selector_pad) != GST_PAD_LINK_OK) {
+        std::cerr << "[SourceSwitcher] Input branch -> selector link failed!" << std::endl;
+        gst_element_release_request_pad(selector_, branch->selector_pad);
+        gst_object_unref(branch->selector_pad);
+        gst_bin_remove(GST_BIN(pipeline_), branch->bin);
+        return nullptr;
+    }
+    return branch;
+}
+
+/**
+ * @brief Creates the source part of a branch, linked to its converter
+ */
+bool SourceSwitcher::createSourceElements(Branch& branch, GstElement* convert) {
+    std::string prefix = GST_OBJECT_NAME(branch.bin);
+    std::string src_name = prefix + "_src";
+    const char* location = branch.location.c_str();
+    GstElement* source = nullptr;
+    GstElement* decodebin = nullptr;
+
+    switch (branch.type) {
+        case SourceType::FILE:
+            source = gst_element_factory_make("filesrc", src_name.c_str());
+            decodebin = gst_element_factory_make("decodebin", (prefix + "_decoder").c_str());
+            if (source) {
+                g_object_set(source, "location", location, nullptr);
+            }
+            break;
+
+        case SourceType::WEBCAM:
+            source = gst_element_factory_make("v4l2src", src_name.c_str());
+            if (source) {
+                g_object_set(source, "device", location, nullptr);
+            }
+            break;
+
+        case SourceType::RTSP:
+            source = gst_element_factory_make("rtspsrc", src_name.c_str());
+            decodebin = gst_element_factory_make("decodebin", (prefix + "_decoder").c_str());
+            if (source) {
+                g_object_set(source,
+                    "location", location,
+                    "latency", 200,
+                    "buffer-mode", 0, // For live stream
+                    nullptr);
+            }
+            break;
+
+        case SourceType::HTTP:
+            source = gst_element_factory_make("souphttpsrc", src_name.c_str());
+            decodebin = gst_element_factory_make("decodebin", (prefix + "_decoder").c_str());
+            if (source) {
+                g_object_set(source,
+                    "location", location,
+                    "is-live", TRUE,
+                    nullptr);
+            }
+            break;
+
+        case SourceType::TEST:
+            source = gst_element_factory_make("videotestsrc", src_name.c_str());
+            if (source) {
+                g_object_set(source, "is-live", TRUE, nullptr);
+                if (!branch.location.empty()) {
+                    gst_util_set_object_arg(G_OBJECT(source), "pattern", location);
+                }
+            }
+            break;
+
+        default:
+            std::cerr << "[SourceSwitcher] Source type cannot be used as a switchable input" << std::endl;
+            return false;
+    }
+
+    bool needs_decoder = branch.type == SourceType::FILE || branch.type == SourceType::RTSP ||
+                         branch.type == SourceType::HTTP;
+    if (!source || (needs_decoder && !decodebin)) {
+        std::cerr << "[SourceSwitcher] Failed to create source for " << branch.location << std::endl;
+        for (GstElement* element : {source, decodebin}) {
+            if (element) {
+                gst_object_unref(element);
+            }
+        }
+        return false;
+    }
+
+    gst_bin_add(GST_BIN(branch.bin), source);
+    if (!decodebin) {
+        return gst_element_link(source, convert);
+    }
+
+    // Decoded pads appear once the stream type is known
+    gst_bin_add(GST_BIN(branch.bin), decodebin);
+    g_signal_connect(decodebin, "pad-added", G_CALLBACK(onPadAdded), convert);
+    if (branch.type == SourceType::RTSP) {
+        g_signal_connect(source, "pad-added", G_CALLBACK(onPadAdded), decodebin);
+        return true;
+    }
+    return gst_element_link(source, decodebin);
+}
+
+/**
+ * @brief Adds the first input and makes it active
+ */
+bool SourceSwitcher::setPrimary(const std::string& location, SourceType type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!selector_) {
+        return false;
+    }
+
+    std::unique_ptr<Branch> branch = createBranch(location, type);
+    if (!branch) {
+        return false;
+    }
+    g_object_set(selector_, "active-pad", branch->selector_pad, nullptr);
+    gst_element_sync_state_with_parent(branch->bin);
+
+    std::unique_ptr<Branch> old = std::move(active_);
+    active_ = std::move(branch);
+    if (old) {
+        retire(std::move(old));
+    }
+    return true;
+}
+
+/**
+ * @brief Builds and pre-rolls a standby input
+ *
+ * Live inputs run and are dropped by the selector, so they are current at
+ * switch time. A file would be decoded to its end that way; it is blocked
+ * on its first frame instead and resumes from there when selected.
+ */
+bool SourceSwitcher::prepareStandby(const std::string& location, SourceType type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!selector_) {
+        return false;
+    }
+
+    if (standby_) {
+        retire(std::move(standby_));
+        standby_ready_metric_.set(0);
+    }
+
+    std::unique_ptr<Branch> branch = createBranch(location, type);
+    if (!branch) {
+        return false;
+    }
+    if (!branch->live) {
+        branch->block_probe = gst_pad_add_probe(branch->ghost_pad,
+            static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER),
+            [](GstPad*, GstPadProbeInfo*, gpointer) { return GST_PAD_PROBE_OK; },
+            nullptr, nullptr);
+    }
+    branch->standby = true;
+    gst_element_sync_state_with_parent(branch->bin);
+    standby_ = std::move(branch);
+
+    std::cout << "[SourceSwitcher] Standby input: " << location << std::endl;
+    return true;
+}
+
+/**
+ * @brief Waits until the standby has decoded its first frame
+ */
+bool SourceSwitcher::waitForStandby(GstClockTime timeout) {
+    Branch* target = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        target = standby_.get();
+    }
+    if (!target) {
+        return false;
+    }
+
+    // The standby may be replaced meanwhile; only ever compare the pointer then
+    auto settled = [this, target]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return standby_.get() != target || target->has_data.load(std::memory_order_acquire);
+    };
+    {
+        std::unique_lock<std::mutex> lock(ready_mutex_);
+        ready_cv_.wait_for(lock, std::chrono::nanoseconds(timeout), settled);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return standby_.get() == target && target->has_data.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Makes the standby active
+ */
+bool SourceSwitcher::switchToStandby() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return switchLocked(false);
+}
+
+/**
+ * @brief Switches to an input, reusing a matching warm standby
+ */
+bool SourceSwitcher::changeSource(const std::string& location, SourceType type, GstClockTime timeout) {
+    bool warm = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!selector_) {
+            return false;
+        }
+        if (active_ && active_->location == location && active_->type == type) {
+            return true;
+        }
+        warm = standby_ && standby_->location == location && standby_->type == type;
+    }
+
+    if (!warm && !prepareStandby(location, type)) {
+        return false;
+    }
+    if (!waitForStandby(timeout)) {
+        // Kept as standby: a later call switches as soon as it is ready
+        std::cerr << "[SourceSwitcher] Input not ready in time: " << location << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!standby_ || standby_->location != location || standby_->type != type) {
+        return false;
+    }
+    return switchLocked(false);
+}
+
+/**
+ * @brief Makes the standby active (mutex_ held)
+ *
+ * The standby's running time is shifted so its next frame continues the
+ * output: a file standby starts at running time 0 and is moved to "now",
+ * a live standby already carries clock-based running times and is only
+ * moved if it would step backwards.
+ */
+bool SourceSwitcher::switchLocked(bool failover) {
+    if (!standby_ || !standby_->has_data.load(std::memory_order_acquire)) {
+        return false;
+    }
+    Branch& next = *standby_;
+
+    GstClockTime target = last_output_end_.load(std::memory_order_relaxed);
+    if (!next.live) {
+        GstClockTime now = pipelineRunningTime();
+        if (GST_CLOCK_TIME_IS_VALID(now) && (!GST_CLOCK_TIME_IS_VALID(target) || now > target)) {
+            target = now;
+        }
+    }
+    GstClockTime next_rt = nextRunningTime(next);
+    if (GST_CLOCK_TIME_IS_VALID(target) && GST_CLOCK_TIME_IS_VALID(next_rt) && target > next_rt) {
+        gst_pad_set_offset(next.ghost_pad, static_cast<gint64>(target - next_rt));
+    }
+
+    switch_from_us_.store(last_output_us_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    switch_from_rt_.store(last_output_end_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    switch_pending_.store(true, std::memory_order_release);
+
+    g_object_set(selector_, "active-pad", next.selector_pad, nullptr);
+    if (next.block_probe) {
+        gst_pad_remove_probe(next.ghost_pad, next.block_probe);
+        next.block_probe = 0;
+    }
+
+    std::unique_ptr<Branch> old = std::move(active_);
+    active_ = std::move(standby_);
+    active_->standby = false;
+    switches_metric_.inc();
+    if (failover) {
+        failovers_metric_.inc();
+    }
+    standby_ready_metric_.set(0);
+
+    std::cout << "[SourceSwitcher] " << (failover ? "Failed over to " : "Switched to ")
+              << active_->location << std::endl;
+
+    if (old) {
+        retire(std::move(old));
+    }
+    return true;
+}
+
+/**
+ * @brief Fails over to the standby if the active live input has stalled
+ */
+bool SourceSwitcher::checkStall() {
+    gint64 timeout_us = static_cast<gint64>(stall_timeout_ms_.load()) * 1000;
+    if (timeout_us <= 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_ || !active_->live || !standby_ || !standby_->has_data.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    gint64 idle_us = now - active_->last_frame_us.load(std::memory_order_relaxed);
+    if (idle_us < timeout_us) {
+        return false;
+    }
+    // Failing over to an input that has stalled as well would not help
+    if (standby_->live && now - standby_->last_frame_us.load(std::memory_order_relaxed) >= timeout_us) {
+        return false;
+    }
+
+    std::cerr << "[SourceSwitcher] No frames from " << active_->location << " for "
+              << idle_us / 1000 << " ms" << std::endl;
+    return switchLocked(true);
+}
+
+/**
+ * @brief Handles an error posted by an input branch
+ */
+bool SourceSwitcher::handleError(GstObject* source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (active_ && gst_object_has_as_ancestor(source, GST_OBJECT(active_->bin))) {
+        if (!standby_ || !standby_->has_data.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::cerr << "[SourceSwitcher] Input failed: " << active_->location << std::endl;
+        return switchLocked(true);
+    }
+
+    if (standby_ && gst_object_has_as_ancestor(source, GST_OBJECT(standby_->bin))) {
+        std::cerr << "[SourceSwitcher] Standby input failed, dropped: " << standby_->location << std::endl;
+        retire(std::move(standby_));
+        standby_ready_metric_.set(0);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Queues a branch for the reaper thread
+ *
+ * Stopping a source can block (an RTSP teardown waits for the server), so
+ * it never runs on the caller's thread, and the caller may hold mutex_:
+ * only reaper_mutex_ is taken here, never a join.
+ */
+void SourceSwitcher::retire(std::unique_ptr<Branch> branch) {
+    std::lock_guard<std::mutex> lock(reaper_mutex_);
+    retired_.push_back(std::move(branch));
+    if (!reaper_.joinable()) {
+        reaper_stop_ = false;
+        reaper_ = std::thread(&SourceSwitcher::reaperLoop, this);
+    }
+    reaper_cv_.notify_one();
+}
+
+/**
+ * @brief Reaper thread: stops and removes queued branches
+ *
+ * pipeline_ and selector_ do not change while it runs: release() joins it
+ * before clearing them.
+ */
+void SourceSwitcher::reaperLoop() {
+    std::unique_lock<std::mutex> lock(reaper_mutex_);
+    for (;;) {
+        reaper_cv_.wait(lock, [this]() { return reaper_stop_ || !retired_.empty(); });
+        if (retired_.empty()) {
+            return;
+        }
+        std::unique_ptr<Branch> branch = std::move(retired_.front());
+        retired_.pop_front();
+        lock.unlock();
+
+        // Keep the branch out of pipeline state changes while it goes down
+        gst_element_set_locked_state(branch->bin, TRUE);
+        gst_element_set_state(branch->bin, GST_STATE_NULL);
+
+        gst_pad_unlink(branch->ghost_pad, branch->selector_pad);
+        gst_element_release_request_pad(selector_, branch->selector_pad);
+        gst_object_unref(branch->selector_pad);
+        gst_bin_remove(GST_BIN(pipeline_), branch->bin);
+
+        std::cout << "[SourceSwitcher] Input removed: " << branch->location << std::endl;
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Drains the reaper queue and joins the thread
+ */
+void SourceSwitcher::joinReaper() {
+    {
+        std::lock_guard<std::mutex> lock(reaper_mutex_);
+        reaper_stop_ = true;
+    }
+    reaper_cv_.notify_one();
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+}
+
+/**
+ * @brief Returns the running time the branch's next frame would have
+ */
+GstClockTime SourceSwitcher::nextRunningTime(Branch& branch) const {
+    GstClockTime pts = branch.last_pts.load(std::memory_order_relaxed);
+    if (!GST_CLOCK_TIME_IS_VALID(pts)) {
+        return GST_CLOCK_TIME_NONE;
+    }
+
+    // A blocked standby holds its next frame; a running one has passed it
+    if (!branch.block_probe) {
+        GstClockTime duration = branch.last_duration.load(std::memory_order_relaxed);
+        pts += GST_CLOCK_TIME_IS_VALID(duration) ? duration : GST_SECOND / format_.framerate;
+    }
+
+    GstEvent* event = gst_pad_get_sticky_event(branch.ghost_pad, GST_EVENT_SEGMENT, 0);
+    if (!event) {
+        return GST_CLOCK_TIME_NONE;
+    }
+    const GstSegment* segment = nullptr;
+    gst_event_parse_segment(event, &segment);
+    GstClockTime running_time = gst_segment_to_running_time(segment, GST_FORMAT_TIME, pts);
+    gst_event_unref(event);
+    return running_time;
+}
+
+/**
+ * @brief Returns the pipeline running time
+ */
+GstClockTime SourceSwitcher::pipelineRunningTime() const {
+    GstClock* clock = gst_element_get_clock(pipeline_);
+    if (!clock) {
+        return GST_CLOCK_TIME_NONE;
+    }
+    GstClockTime now = gst_clock_get_time(clock) - gst_element_get_base_time(pipeline_);
+    gst_object_unref(clock);
+    return now;
+}
+
+/**
+ * @brief Branch output probe: frame bookkeeping
+ */
+GstPadProbeReturn SourceSwitcher::onBranchBuffer(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+    Branch* branch = static_cast<Branch*>(user_data);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+    branch->last_pts.store(GST_BUFFER_PTS(buffer), std::memory_order_relaxed);
+    branch->last_duration.store(GST_BUFFER_DURATION(buffer), std::memory_order_relaxed);
+    branch->last_frame_us.store(g_get_monotonic_time(), std::memory_order_relaxed);
+
+    if (!branch->has_data.load(std::memory_order_acquire)) {
+        SourceSwitcher* owner = branch->owner;
+        {
+            std::lock_guard<std::mutex> lock(owner->ready_mutex_);
+            branch->has_data.store(true, std::memory_order_release);
+        }
+        owner->ready_cv_.notify_all();
+        if (branch->standby.load(std::memory_order_relaxed)) {
+            owner->standby_ready_metric_.set(1);
+        }
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * @brief Selector output probe: switch gap and output running time
+ */
+GstPadProbeReturn SourceSwitcher::onOutputBuffer(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+    SourceSwitcher* switcher = static_cast<SourceSwitcher*>(user_data);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    gint64 now = g_get_monotonic_time();
+
+    GstClockTime start = GST_CLOCK_TIME_NONE;
+    GstClockTime end = GST_CLOCK_TIME_NONE;
+    if (GST_BUFFER_PTS_IS_VALID(buffer)) {
+        GstEvent* event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+        if (event) {
+            const GstSegment* segment = nullptr;
+            gst_event_parse_segment(event, &segment);
+            start = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+            gst_event_unref(event);
+        }
+        if (GST_CLOCK_TIME_IS_VALID(start)) {
+            end = start + (GST_BUFFER_DURATION_IS_VALID(buffer) ? GST_BUFFER_DURATION(buffer)
+                                                                : GST_SECOND / switcher->format_.framerate);
+        }
+    }
+
+    // First frame of the new input
+    if (switcher->switch_pending_.exchange(false, std::memory_order_acquire)) {
+        gint64 from = switcher->switch_from_us_.load(std::memory_order_relaxed);
+        if (from > 0) {
+            double gap = static_cast<double>(now - from) / G_USEC_PER_SEC;
+            switcher->gap_metric_.observe(gap);
+            switcher->last_gap_metric_.set(gap);
+        }
+        GstClockTime from_rt = switcher->switch_from_rt_.load(std::memory_order_relaxed);
+        if (GST_CLOCK_TIME_IS_VALID(from_rt) && GST_CLOCK_TIME_IS_VALID(start)) {
+            switcher->last_pts_gap_metric_.set(
+                (static_cast<double>(start) - static_cast<double>(from_rt)) / GST_SECOND);
+        }
+    }
+
+    switcher->last_output_us_.store(now, std::memory_order_relaxed);
+    if (GST_CLOCK_TIME_IS_VALID(end)) {
+        switcher->last_output_end_.store(end, std::memory_order_relaxed);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * @brief Links a dynamic video pad to the element's sink pad
+ *
+ * Accepts decoded video from decodebin and video RTP streams from rtspsrc.
+ */
+void SourceSwitcher::onPadAdded(GstElement* src, GstPad* new_pad, gpointer data) {
+    GstElement* sink = static_cast<GstElement*>(data);
+    GstPad* sink_pad = gst_element_get_static_pad(sink, "sink");
+
+    if (gst_pad_is_linked(sink_pad)) {
+        gst_object_unref(sink_pad);
+        return;
+    }
+
+    GstCaps* caps = gst_pad_get_current_caps(new_pad);
+    if (!caps) {
+        caps = gst_pad_query_caps(new_pad, nullptr);
+    }
+
+    GstStructure* structure = gst_caps_get_structure(caps, 0);
+    const gchar* type = gst_structure_get_name(structure);
+    const gchar* media = gst_structure_get_string(structure, "media");
+    bool video = g_str_has_prefix(type, "video/") ||
+                 (g_str_has_prefix(type, "application/x-rtp") && media && g_str_equal(media, "video"));
+
+    if (video && gst_pad_link(new_pad, sink_pad) == GST_PAD_LINK_OK) {
+        std::cout << "[PAD] Video pad linked: " << type << std::endl;
+    }
+
+    gst_caps_unref(caps);
+    gst_object_unref(sink_pad);
+}
+
+/**
+ * @brief Returns statistics
+ */
+SourceSwitchStats SourceSwitcher::getStats() const {
+    SourceSwitchStats stats;
+    stats.switches = switches_metric_.value();
+    stats.failovers = failovers_metric_.value();
+    stats.last_gap_ms = last_gap_metric_.value() * 1000.0;
+    stats.last_pts_gap_ms = last_pts_gap_metric_.value() * 1000.0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_) {
+        stats.active_location = active_->location;
+    }
+    if (standby_) {
+        stats.standby_location = standby_->location;
+        stats.standby_ready = standby_->has_data.load(std::memory_order_acquire);
+    }
+    return stats;
+}
+
+/**
+ * @brief Exports the switching metrics
+ */
+void SourceSwitcher::registerMetrics(MetricsRegistry& registry) {
+    registry.addCounter("source_switches_total", "Active input changes", switches_metric_);
+    registry.addCounter("source_failovers_total", "Switches to the standby after a stall or error",
+                        failovers_metric_);
+    registry.addHistogram("source_switch_gap_seconds",
+                          "Wall time between the last frame of the old and the first of the new input",
+                          gap_metric_);
+    registry.addGauge("source_switch_last_gap_seconds", "Gap of the latest switch", last_gap_metric_);
+    registry.addGauge("source_switch_last_pts_step_seconds", "Output running-time step across the latest switch",
+                      last_pts_gap_metric_);
+    registry.addGauge("source_standby_ready", "1 while a pre-rolled standby input is available",
+                      standby_ready_metric_);
+}
@@ -0,0 +1,544 @@
+/**
+ * @file stream_host.cpp
+ * @brief Multi-stream host implementation
+ */
+
+#include "stream_host.h"
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+/**
+ * @brief Frame reference owned by a queued task (unreffed if the task is dropped)
+ */
+struct PendingFrame {
+    GstBuffer* buffer;
+
+    explicit PendingFrame(GstBuffer* b) : buffer(b) {}
+    ~PendingFrame() {
+        if (buffer) {
+            gst_buffer_unref(buffer);
+        }
+    }
+
+    /**
+     * @brief Hands the reference to the caller
+     */
+    GstBuffer* release() {
+        GstBuffer* b = buffer;
+        buffer = nullptr;
+        return b;
+    }
+};
+
+/**
+ * @brief Bus watch data: identifies the stream without dereferencing it
+ */
+struct BusWatch {
+    StreamHost* host;
+    std::string id;
+    const void* stream;
+};
+
+} // namespace
+
+/**
+ * @brief Constructor
+ */
+StreamHost::StreamHost(const StreamHostConfig& config)
+    : config_(config), pool_(config.thread_count) {
+
+    // The pool provides the parallelism: every stage runs single-threaded on its lane
+    config_.processing.processing_threads = 1;
+    config_.motion.async_analysis = false;
+    config_.motion.analysis_threads = 1;
+    config_.motion.draw_motion_regions = false;  // Frames are not rendered
+
+    context_ = g_main_context_new();
+    registerMetrics();
+
+    std::cout << "[StreamHost] " << pool_.threads() << " worker(s), "
+              << config_.queue_depth << " frame(s) queued per stream" << std::endl;
+}
+
+/**
+ * @brief Destructor
+ */
+StreamHost::~StreamHost() {
+    stop();
+    g_main_context_unref(context_);
+}
+
+/**
+ * @brief Starts the main loop thread
+ */
+bool StreamHost::start() {
+    if (is_running_.load()) {
+        return true;
+    }
+
+    main_loop_ = g_main_loop_new(context_, FALSE);
+    last_fps_us_ = g_get_monotonic_time();
+
+    // FPS calculation timer
+    GSource* timer = g_timeout_source_new(1000);
+    g_source_set_callback(timer, [](gpointer data) -> gboolean {
+        static_cast<StreamHost*>(data)->updateFPS();
+        return G_SOURCE_CONTINUE;
+    }, this, nullptr);
+    g_source_attach(timer, context_);
+    g_source_unref(timer);
+
+    is_running_ = true;
+    main_loop_thread_ = std::thread(&StreamHost::mainLoopThread, this);
+    return true;
+}
+
+/**
+ * @brief Removes every stream and stops the main loop
+ */
+void StreamHost::stop() {
+    std::map<std::string, std::unique_ptr<Stream>> streams;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams.swap(streams_);
+    }
+    for (auto& entry : streams) {
+        destroyStream(*entry.second);
+    }
+
+    if (main_loop_) {
+        // Quit from inside the loop: a quit before g_main_loop_run() started would be lost
+        GSource* quit = g_idle_source_new();
+        g_source_set_callback(quit, [](gpointer loop) -> gboolean {
+            g_main_loop_quit(static_cast<GMainLoop*>(loop));
+            return G_SOURCE_REMOVE;
+        }, main_loop_, nullptr);
+        g_source_attach(quit, context_);
+        g_source_unref(quit);
+        if (main_loop_thread_.joinable()) {
+            main_loop_thread_.join();
+        }
+        g_main_loop_unref(main_loop_);
+        main_loop_ = nullptr;
+    }
+    is_running_ = false;
+}
+
+/**
+ * @brief Builds a stream pipeline and starts it
+ */
+bool StreamHost::addStream(const std::string& id, const std::string& location, SourceType type) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (streams_.count(id)) {
+            std::cerr << "[StreamHost] Stream already exists: " << id << std::endl;
+            return false;
+        }
+    }
+
+    auto stream = std::make_unique<Stream>();
+    stream->host = this;
+    stream->id = id;
+    stream->location = location;
+
+    stream->processor = std::make_unique<VideoProcessor>();
+    stream->processor->setParameters(config_.processing);
+
+    if (config_.enable_motion_detection) {
+        stream->detector = std::make_unique<MotionDetector>();
+        stream->detector->setParameters(config_.motion);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (motion_callback_) {
+            StreamMotionCallback callback = motion_callback_;
+            stream->detector->setMotionEventCallback(
+                [callback, id](const std::vector<MotionRegion>& regions, guint64 timestamp, double percentage) {
+                    callback(id, regions, timestamp, percentage);
+                });
+        }
+    }
+
+    stream->lane = pool_.createLane(config_.queue_depth);
+
+    if (!buildStream(*stream, type)) {
+        destroyStream(*stream);
+        return false;
+    }
+
+    // Listed before playing: the bus watch looks the stream up by id
+    Stream* added = stream.get();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!streams_.try_emplace(id, std::move(stream)).second) {
+            std::cerr << "[StreamHost] Stream already exists: " << id << std::endl;
+            destroyStream(*added);
+            return false;
+        }
+    }
+
+    if (gst_element_set_state(added->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        std::cerr << "[StreamHost] Failed to start stream " << id << ": " << location << std::endl;
+        removeStream(id);
+        return false;
+    }
+
+    std::cout << "[StreamHost] Stream " << id << " started: " << location << std::endl;
+    return true;
+}
+
+/**
+ * @brief Stops a stream
+ */
+bool StreamHost::removeStream(const std::string& id) {
+    std::unique_ptr<Stream> stream;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(id);
+        if (it == streams_.end()) {
+            return false;
+        }
+        stream = std::move(it->second);
+        streams_.erase(it);
+    }
+
+    destroyStream(*stream);
+    std::cout << "[StreamHost] Stream " << id << " removed" << std::endl;
+    return true;
+}
+
+/**
+ * @brief Returns the number of streams
+ */
+size_t StreamHost::streamCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streams_.size();
+}
+
+/**
+ * @brief Returns per-stream statistics
+ */
+std::vector<StreamStats> StreamHost::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<StreamStats> result;
+    result.reserve(streams_.size());
+
+    for (const auto& entry : streams_) {
+        const Stream& stream = *entry.second;
+        StreamStats stats;
+        stats.id = stream.id;
+        stats.location = stream.location;
+        stats.fps = stream.fps_metric.value();
+        stats.input_frames = stream.lane->submitted();
+        stats.processed_frames = stream.lane->executed();
+        stats.dropped_frames = stream.lane->dropped();
+        if (stats.processed_frames > 0) {
+            stats.avg_processing_ms = stream.busy_ns.load(std::memory_order_relaxed) / 1e6 /
+                                      stats.processed_frames;
+        }
+        if (stream.detector) {
+            stats.motion_frames = stream.detector->getStats().motion_frames;
+        }
+        stats.finished = stream.finished.load();
+        stats.failed = stream.failed.load();
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+/**
+ * @brief Sets the motion event callback
+ */
+void StreamHost::setMotionEventCallback(StreamMotionCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    motion_callback_ = std::move(callback);
+}
+
+/**
+ * @brief Creates the pipeline of a stream
+ *
+ * input branch -> input-selector -> appsink. The appsink callback only
+ * queues the frame on the stream's lane.
+ */
+bool StreamHost::buildStream(Stream& stream, SourceType type) {
+    stream.pipeline = gst_pipeline_new(("stream-" + stream.id).c_str());
+    stream.switcher = std::make_unique<SourceSwitcher>(config_.format);
+
+    GstElement* selector = stream.switcher->createElement(stream.pipeline);
+    GstElement* sink = gst_element_factory_make("appsink", "analysis_sink");
+    if (!stream.pipeline || !selector || !sink) {
+        std::cerr << "[StreamHost] Failed to create elements for stream " << stream.id << std::endl;
+        if (sink) {
+            gst_object_unref(sink);
+        }
+        return false;
+    }
+
+    g_object_set(sink,
+        "sync", TRUE,                   // Files play at their frame rate, like a live input
+        "enable-last-sample", FALSE,    // Keeps the frame writable for in-place filters
+        nullptr);
+
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = onNewSample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, &stream, nullptr);
+
+    gst_bin_add(GST_BIN(stream.pipeline), sink);
+    if (!gst_element_link(selector, sink)) {
+        std::cerr << "[StreamHost] Failed to link stream " << stream.id << std::endl;
+        return false;
+    }
+
+    if (!stream.switcher->setPrimary(stream.location, type)) {
+        std::cerr << "[StreamHost] Failed to create source for stream " << stream.id
+                  << ": " << stream.location << std::endl;
+        return false;
+    }
+
+    // Bus messages of every stream are handled on the host main loop
+    GstBus* bus = gst_element_get_bus(stream.pipeline);
+    stream.bus_watch = gst_bus_create_watch(bus);
+    g_source_set_callback(stream.bus_watch, G_SOURCE_FUNC(busCallback),
+                          new BusWatch{this, stream.id, &stream},
+                          [](gpointer data) { delete static_cast<BusWatch*>(data); });
+    g_source_attach(stream.bus_watch, context_);
+    gst_object_unref(bus);
+    return true;
+}
+
+/**
+ * @brief Stops a stream and frees its pipeline
+ *
+ * NULL state first (no more samples), then the lane is closed (queued frames
+ * dropped, a running analysis finishes) before the stages go away.
+ */
+void StreamHost::destroyStream(Stream& stream) {
+    if (stream.pipeline) {
+        gst_element_set_state(stream.pipeline, GST_STATE_NULL);
+    }
+    if (stream.lane) {
+        pool_.closeLane(*stream.lane);
+    }
+    if (stream.bus_watch) {
+        g_source_destroy(stream.bus_watch);
+        g_source_unref(stream.bus_watch);
+        stream.bus_watch = nullptr;
+    }
+    if (stream.switcher) {
+        stream.switcher->release();
+    }
+    if (stream.pipeline) {
+        gst_object_unref(stream.pipeline);
+        stream.pipeline = nullptr;
+    }
+    if (stream.caps) {
+        gst_caps_unref(stream.caps);
+        stream.caps = nullptr;
+    }
+}
+
+/**
+ * @brief Runs the stream's analysis on one frame
+ */
+void StreamHost::analyse(Stream& stream, GstBuffer* buffer, const GstVideoInfo& info) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Usually free: the sample was released, so the task holds the only reference
+    buffer = gst_buffer_make_writable(buffer);
+
+    const GstVideoInfo* out_info = &info;
+    GstVideoInfo resized;
+    if (stream.processor->resizesFrames()) {
+        int width = 0;
+        int height = 0;
+        stream.processor->outputSize(GST_VIDEO_INFO_WIDTH(&info), GST_VIDEO_INFO_HEIGHT(&info), width, height);
+        gst_video_info_set_format(&resized, GST_VIDEO_INFO_FORMAT(&info), width, height);
+
+        GstBuffer* output = gst_buffer_new_allocate(nullptr, GST_VIDEO_INFO_SIZE(&resized), nullptr);
+        gst_buffer_copy_into(output, buffer,
+                             static_cast<GstBufferCopyFlags>(GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS),
+                             0, -1);
+        stream.processor->processFrame(buffer, output, &info, &resized);
+        gst_buffer_unref(buffer);
+        buffer = output;
+        out_info = &resized;
+    } else {
+        stream.processor->processFrameInPlace(buffer, &info);
+    }
+
+    if (stream.detector) {
+        stream.detector->processFrame(buffer, out_info);
+    }
+    gst_buffer_unref(buffer);
+
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    stream.busy_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                             std::memory_order_relaxed);
+}
+
+/**
+ * @brief Updates the per-stream FPS
+ */
+void StreamHost::updateFPS() {
+    gint64 now = g_get_monotonic_time();
+    double seconds = (now - last_fps_us_) / static_cast<double>(G_USEC_PER_SEC);
+    last_fps_us_ = now;
+    if (seconds <= 0.0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : streams_) {
+        Stream& stream = *entry.second;
+        guint64 processed = stream.lane->executed();
+        stream.fps_metric.set((processed - stream.fps_frames) / seconds);
+        stream.fps_frames = processed;
+    }
+}
+
+/**
+ * @brief Registers the per-stream and pool metrics
+ *
+ * Streams come and go, so their series are collected at scrape time
+ * instead of being registered as instruments.
+ */
+void StreamHost::registerMetrics() {
+    auto perStream = [this](std::function<double(const Stream&)> value) {
+        return [this, value](std::vector<MetricSample>& samples) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& entry : streams_) {
+                samples.push_back({{{"stream", entry.first}}, value(*entry.second)});
+            }
+        };
+    };
+
+    metrics_.addCollector("stream_fps", "Frames analysed per second", MetricType::GAUGE,
+        perStream([](const Stream& s) { return s.fps_metric.value(); }));
+    metrics_.addCollector("stream_frames_total", "Frames delivered by the stream pipeline", MetricType::COUNTER,
+        perStream([](const Stream& s) { return static_cast<double>(s.lane->submitted()); }));
+    metrics_.addCollector("stream_processed_frames_total", "Frames analysed by the worker pool", MetricType::COUNTER,
+        perStream([](const Stream& s) { return static_cast<double>(s.lane->executed()); }));
+    metrics_.addCollector("stream_dropped_frames_total", "Oldest frames dropped because the stream queue was full",
+        MetricType::COUNTER,
+        perStream([](const Stream& s) { return static_cast<double>(s.lane->dropped()); }));
+    metrics_.addCollector("stream_queue_frames", "Frames waiting for a worker", MetricType::GAUGE,
+        perStream([](const Stream& s) { return static_cast<double>(s.lane->pending()); }));
+
+    metrics_.addCollector("stream_host_streams", "Hosted streams", MetricType::GAUGE,
+        [this](std::vector<MetricSample>& samples) {
+            samples.push_back({{}, static_cast<double>(streamCount())});
+        });
+    metrics_.addCollector("worker_pool_threads", "Shared analysis workers", MetricType::GAUGE,
+        [this](std::vector<MetricSample>& samples) {
+            samples.push_back({{}, static_cast<double>(pool_.threads())});
+        });
+    metrics_.addCollector("worker_pool_tasks_total", "Frames analysed by all workers", MetricType::COUNTER,
+        [this](std::vector<MetricSample>& samples) {
+            samples.push_back({{}, static_cast<double>(pool_.executed())});
+        });
+    metrics_.addCollector("worker_pool_steals_total", "Stream turns taken from another worker's queue",
+        MetricType::COUNTER,
+        [this](std::vector<MetricSample>& samples) {
+            samples.push_back({{}, static_cast<double>(pool_.steals())});
+        });
+}
+
+/**
+ * @brief Main loop thread function
+ */
+void StreamHost::mainLoopThread() {
+    g_main_context_push_thread_default(context_);
+    g_main_loop_run(main_loop_);
+    g_main_context_pop_thread_default(context_);
+}
+
+/**
+ * @brief appsink new-sample callback
+ */
+GstFlowReturn StreamHost::onNewSample(GstAppSink* sink, gpointer user_data) {
+    Stream* stream = static_cast<Stream*>(user_data);
+
+    GstSample* sample = gst_app_sink_pull_sample(sink);
+    if (!sample) {
+        return GST_FLOW_EOS;
+    }
+
+    // Parse the format once per caps (a new caps object after renegotiation)
+    GstCaps* caps = gst_sample_get_caps(sample);
+    if (caps && caps != stream->caps) {
+        if (stream->caps) {
+            gst_caps_unref(stream->caps);
+        }
+        stream->caps = gst_caps_ref(caps);
+        stream->info_valid = gst_video_info_from_caps(&stream->info, caps);
+    }
+
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    if (!buffer || !stream->info_valid) {
+        gst_sample_unref(sample);
+        return GST_FLOW_OK;
+    }
+
+    auto frame = std::make_shared<PendingFrame>(gst_buffer_ref(buffer));
+    gst_sample_unref(sample);
+
+    GstVideoInfo info = stream->info;
+    stream->lane->submit([stream, frame, info] {
+        stream->host->analyse(*stream, frame->release(), info);
+    });
+    return GST_FLOW_OK;
+}
+
+/**
+ * @brief Bus callback of a stream
+ */
+gboolean StreamHost::busCallback(GstBus* /*bus*/, GstMessage* message, gpointer user_data) {
+    BusWatch* watch = static_cast<BusWatch*>(user_data);
+    StreamHost* host = watch->host;
+
+    std::lock_guard<std::mutex> lock(host->mutex_);
+    auto it = host->streams_.find(watch->id);
+    if (it == host->streams_.end() || it->second.get() != watch->stream) {
+        return FALSE;  // Removed stream
+    }
+    Stream& stream = *it->second;
+
+    switch (GST_MESSAGE_TYPE(message)) {
+        case GST_MESSAGE_ERROR: {
+            // A ready standby input takes over; otherwise only this stream fails
+            if (stream.switcher->handleError(GST_MESSAGE_SRC(message))) {
+                break;
+            }
+            GError* error = nullptr;
+            gchar* debug = nullptr;
+            gst_message_parse_error(message, &error, &debug);
+            std::cerr << "[StreamHost] Stream " << stream.id << " failed: "
+                      << (error ? error->message : "unknown error") << std::endl;
+            g_clear_error(&error);
+            g_free(debug);
+            stream.failed = true;
+            break;
+        }
+
+        case GST_MESSAGE_EOS:
+            std::cout << "[StreamHost] Stream " << stream.id << " finished" << std::endl;
+            stream.finished = true;
+            break;
+
+        case GST_MESSAGE_WARNING: {
+            GError* warning = nullptr;
+            gchar* debug = nullptr;
+            gst_message_parse_warning(message, &warning, &debug);
+            std::cerr << "[StreamHost] Stream " << stream.id << " warning: "
+                      << (warning ? warning->message : "") << std::endl;
+            g_clear_error(&warning);
+            g_free(debug);
+            break;
+        }
+
+        default:
+            break;
+    }
+    return TRUE;
+}
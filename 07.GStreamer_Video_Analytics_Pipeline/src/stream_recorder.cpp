@@ -0,0 +1,291 @@
+/**
+ * @file stream_recorder.cpp
+ * @brief Tee branch recording implementation
+ */
+
+#include "stream_recorder.h"
+#include <gst/video/video.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+/**
+ * @brief Expands the strftime pattern with the local time
+ */
+std::string recordingFileName(const std::string& pattern) {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char name[512];
+    if (std::strftime(name, sizeof(name), pattern.c_str(), &local) == 0) {
+        return pattern;
+    }
+    return name;
+}
+
+} // namespace
+
+/**
+ * @brief Constructor
+ */
+StreamRecorder::StreamRecorder(const std::string& parser, int max_duration)
+    : parser_(parser),
+      max_duration_(std::max(0, max_duration)) {
+}
+
+/**
+ * @brief Destructor
+ */
+StreamRecorder::~StreamRecorder() {
+    detach();
+}
+
+/**
+ * @brief Adds the recording branch to a tee of a playing pipeline
+ */
+bool StreamRecorder::attach(GstElement* tee, const std::string& location_pattern) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bin_) {
+        return false;
+    }
+
+    GstElement* parent = GST_ELEMENT(gst_object_get_parent(GST_OBJECT(tee)));
+    GstElement* bin = gst_bin_new(nullptr);
+    GstElement* queue = gst_element_factory_make("queue", nullptr);
+    GstElement* parser = gst_element_factory_make(parser_.c_str(), nullptr);
+    GstElement* splitmux = gst_element_factory_make("splitmuxsink", nullptr);
+    GstElement* sink = gst_element_factory_make("filesink", nullptr);
+    if (!parent || !bin || !queue || !parser || !splitmux || !sink) {
+        std::cerr << "[StreamRecorder] Failed to create recording branch!" << std::endl;
+        for (GstElement* element : {parent, bin, queue, parser, splitmux, sink}) {
+            if (element) {
+                gst_object_unref(element);
+            }
+        }
+        return false;
+    }
+
+    // A slow disk drops the oldest frames here instead of stalling the tee
+    g_object_set(queue,
+        "max-size-buffers", 0u,
+        "max-size-bytes", 0u,
+        "max-size-time", static_cast<guint64>(5 * GST_SECOND),
+        "leaky", 2,                 // Downstream (oldest)
+        nullptr);
+
+    // Rotation asks the encoder for a keyframe so every file starts on one
+    g_object_set(splitmux,
+        "max-size-time", static_cast<guint64>(max_duration_) * GST_SECOND,
+        "send-keyframe-requests", max_duration_ > 0 ? TRUE : FALSE,
+        "sink", sink,
+        nullptr);
+    g_signal_connect(splitmux, "format-location", G_CALLBACK(onFormatLocation), this);
+
+    GstPad* sink_pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_add_probe(sink_pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, onSinkEvent, this, nullptr);
+    gst_object_unref(sink_pad);
+
+    gst_bin_add_many(GST_BIN(bin), queue, parser, splitmux, nullptr);
+    if (!gst_element_link_many(queue, parser, splitmux, nullptr)) {
+        std::cerr << "[StreamRecorder] Failed to link recording branch!" << std::endl;
+        gst_object_unref(bin);
+        gst_object_unref(parent);
+        return false;
+    }
+    GstPad* queue_sink = gst_element_get_static_pad(queue, "sink");
+    gst_element_add_pad(bin, gst_ghost_pad_new("sink", queue_sink));
+    gst_object_unref(queue_sink);
+
+    gchar* directory = g_path_get_dirname(location_pattern.c_str());
+    g_mkdir_with_parents(directory, 0755);
+    g_free(directory);
+
+    pattern_ = location_pattern;
+    last_file_.clear();
+    keyframe_seen_ = false;
+    stopping_ = false;
+    finished_ = false;
+
+    // The new pad stays blocked until the branch runs, so no buffer reaches
+    // an element that is still changing state
+    tee_pad_ = gst_element_request_pad_simple(tee, "src_%u");
+    gulong block = gst_pad_add_probe(tee_pad_, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+                                     onTeeBlocked, nullptr, nullptr);
+
+    bin_ = GST_ELEMENT(gst_object_ref(bin));
+    gst_bin_add(GST_BIN(parent), bin);
+    GstPad* branch_sink = gst_element_get_static_pad(bin, "sink");
+    gst_pad_link(tee_pad_, branch_sink);
+    gst_element_sync_state_with_parent(bin);
+
+    gst_pad_add_probe(tee_pad_, GST_PAD_PROBE_TYPE_BUFFER, onTeeBuffer, this, nullptr);
+    gst_pad_remove_probe(tee_pad_, block);
+
+    // Start the first file now rather than at the next regular keyframe
+    gst_pad_push_event(branch_sink,
+        gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE, TRUE, 0));
+    gst_object_unref(branch_sink);
+    gst_object_unref(parent);
+
+    tee_ = GST_ELEMENT(gst_object_ref(tee));
+    recording_metric_.set(1);
+    return true;
+}
+
+/**
+ * @brief Removes the branch
+ */
+void StreamRecorder::detach() {
+    GstPad* tee_pad = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!bin_ || stopping_) {
+            return;
+        }
+        stopping_ = true;
+        finished_ = !keyframe_seen_;    // Nothing written, nothing to finalise
+        tee_pad = tee_pad_;
+    }
+
+    // Idle: between two pushes, so the other branches never see a gap
+    gst_pad_add_probe(tee_pad, GST_PAD_PROBE_TYPE_IDLE, onTeeIdle, this, nullptr);
+
+    std::string file;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!finished_cv_.wait_for(lock, std::chrono::seconds(10), [this] { return finished_; })) {
+            std::cerr << "[StreamRecorder] Recording may be incomplete: " << last_file_ << std::endl;
+        }
+        file = last_file_;
+    }
+
+    gst_element_set_state(bin_, GST_STATE_NULL);
+    GstObject* parent = gst_object_get_parent(GST_OBJECT(bin_));
+    if (parent) {
+        gst_bin_remove(GST_BIN(parent), bin_);
+        gst_object_unref(parent);
+    }
+    gst_element_release_request_pad(tee_, tee_pad_);
+    gst_object_unref(tee_pad_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    gst_object_unref(bin_);
+    gst_object_unref(tee_);
+    bin_ = nullptr;
+    tee_ = nullptr;
+    tee_pad_ = nullptr;
+    recording_metric_.set(0);
+
+    if (!file.empty()) {
+        std::cout << "[StreamRecorder] Recording saved: " << file << std::endl;
+    }
+}
+
+/**
+ * @brief Returns statistics
+ */
+StreamRecorderStats StreamRecorder::getStats() const {
+    StreamRecorderStats stats;
+    stats.files = files_metric_.value();
+    stats.bytes = bytes_metric_.value();
+    stats.recording = recording_metric_.value() > 0;
+    if (stats.recording) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.current_file = last_file_;
+    }
+    return stats;
+}
+
+/**
+ * @brief Exports the recorder metrics
+ */
+void StreamRecorder::registerMetrics(MetricsRegistry& registry, const std::string& prefix) {
+    registry.addCounter(prefix + "_files_total", "Recording files started", files_metric_);
+    registry.addCounter(prefix + "_bytes_total", "Encoded bytes handed to the recording branch",
+                        bytes_metric_);
+    registry.addGauge(prefix + "_active", "1 while the recording branch is attached", recording_metric_);
+}
+
+/**
+ * @brief Drops frames until the first keyframe, counts bytes
+ */
+GstPadProbeReturn StreamRecorder::onTeeBuffer(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+    StreamRecorder* recorder = static_cast<StreamRecorder*>(user_data);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+    std::lock_guard<std::mutex> lock(recorder->mutex_);
+    if (recorder->stopping_) {
+        return GST_PAD_PROBE_DROP;
+    }
+    if (!recorder->keyframe_seen_) {
+        if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+            return GST_PAD_PROBE_DROP;
+        }
+        recorder->keyframe_seen_ = true;
+    }
+    recorder->bytes_metric_.inc(gst_buffer_get_size(buffer));
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * @brief Holds the new tee pad until the branch is linked and running
+ */
+GstPadProbeReturn StreamRecorder::onTeeBlocked(GstPad*, GstPadProbeInfo*, gpointer) {
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * @brief Unlinks the idle tee pad and sends EOS into the branch
+ */
+GstPadProbeReturn StreamRecorder::onTeeIdle(GstPad* pad, GstPadProbeInfo*, gpointer) {
+    GstPad* branch_sink = gst_pad_get_peer(pad);
+    if (branch_sink) {
+        gst_pad_unlink(pad, branch_sink);
+        // splitmuxsink finalises the open file on EOS
+        gst_pad_send_event(branch_sink, gst_event_new_eos());
+        gst_object_unref(branch_sink);
+    }
+    return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * @brief Notes EOS at the file sink
+ */
+GstPadProbeReturn StreamRecorder::onSinkEvent(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+    StreamRecorder* recorder = static_cast<StreamRecorder*>(user_data);
+    if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) == GST_EVENT_EOS) {
+        std::lock_guard<std::mutex> lock(recorder->mutex_);
+        if (recorder->stopping_) {
+            recorder->finished_ = true;
+            recorder->finished_cv_.notify_all();
+        }
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * @brief splitmuxsink format-location handler
+ */
+gchar* StreamRecorder::onFormatLocation(GstElement*, guint fragment_id, gpointer user_data) {
+    StreamRecorder* recorder = static_cast<StreamRecorder*>(user_data);
+
+    std::lock_guard<std::mutex> lock(recorder->mutex_);
+    std::string name = recordingFileName(recorder->pattern_);
+    if (fragment_id > 0 && recorder->pattern_.find('%') == std::string::npos) {
+        // Plain file name: number the following files
+        size_t dot = name.rfind('.');
+        size_t slash = name.rfind('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+            dot = name.size();
+        }
+        name.insert(dot, "_" + std::to_string(fragment_id));
+    }
+    recorder->last_file_ = name;
+    recorder->files_metric_.inc();
+
+    std::cout << "[StreamRecorder] Recording: " << name << std::endl;
+    return g_strdup(name.c_str());
+}
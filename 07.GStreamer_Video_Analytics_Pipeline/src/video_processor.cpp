@@ -4,6 +4,7 @@
  */
 
 #include "video_processor.h"
+#include <gst/video/gstvideopool.h>
 #include <iostream>
 #include <cstring>
 #include <algorithm>
@@ -12,11 +13,14 @@
 // Virtual table for GStreamer base transform
 typedef struct {
     GstBaseTransformClass parent_class;
-} VideoProcessorClass;
+} VideoProcessorElementClass;
 
 typedef struct {
     GstBaseTransform parent;
     VideoProcessor* processor;
+    GstVideoInfo info;          // Input, cached in set_caps
+    GstVideoInfo out_info;      // Output (crop/scale change its size)
+    gboolean info_valid;        // Caps negotiated
 } VideoProcessorElement;
 
 // GObject type definitions
@@ -25,23 +29,50 @@ typedef struct {
 
 G_DEFINE_TYPE(VideoProcessorElement, video_processor, GST_TYPE_BASE_TRANSFORM)
 
+// Formats the filters handle natively (see applyPixelFilter / applyGeometry)
+#define VIDEO_PROCESSOR_CAPS GST_VIDEO_CAPS_MAKE("{ I420, YV12, NV12, NV21, RGB, BGR }")
+
+static GstStaticPadTemplate video_processor_sink_template = GST_STATIC_PAD_TEMPLATE(
+    "sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS(VIDEO_PROCESSOR_CAPS));
+
+static GstStaticPadTemplate video_processor_src_template = GST_STATIC_PAD_TEMPLATE(
+    "src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS(VIDEO_PROCESSOR_CAPS));
+
 // Forward declarations
 static GstFlowReturn video_processor_transform(GstBaseTransform* trans, GstBuffer* inbuf, GstBuffer* outbuf);
+static GstFlowReturn video_processor_transform_ip(GstBaseTransform* trans, GstBuffer* buf);
 static gboolean video_processor_set_caps(GstBaseTransform* trans, GstCaps* incaps, GstCaps* outcaps);
 static GstCaps* video_processor_transform_caps(GstBaseTransform* trans, GstPadDirection direction, GstCaps* caps, GstCaps* filter);
+static gboolean video_processor_transform_size(GstBaseTransform* trans, GstPadDirection direction, GstCaps* caps, gsize size, GstCaps* othercaps, gsize* othersize);
+static gboolean video_processor_decide_allocation(GstBaseTransform* trans, GstQuery* query);
+static gboolean video_processor_stop(GstBaseTransform* trans);
 
 /**
  * @brief GObject class initialization
  */
-static void video_processor_class_init(VideoProcessorClass* klass) {
+static void video_processor_class_init(VideoProcessorElementClass* klass) {
+    GstElementClass* element_class = GST_ELEMENT_CLASS(klass);
     GstBaseTransformClass* base_transform_class = GST_BASE_TRANSFORM_CLASS(klass);
 
+    // GstBaseTransform creates its pads from these templates
+    gst_element_class_add_static_pad_template(element_class, &video_processor_sink_template);
+    gst_element_class_add_static_pad_template(element_class, &video_processor_src_template);
+    gst_element_class_set_static_metadata(element_class,
+        "Video Processor",
+        "Filter/Effect/Video",
+        "Applies the configured filter chain to raw video",
+        "GStreamer Video Analytics Pipeline");
+
     // Set transform functions
     base_transform_class->transform = GST_DEBUG_FUNCPTR(video_processor_transform);
+    base_transform_class->transform_ip = GST_DEBUG_FUNCPTR(video_processor_transform_ip);
     base_transform_class->set_caps = GST_DEBUG_FUNCPTR(video_processor_set_caps);
     base_transform_class->transform_caps = GST_DEBUG_FUNCPTR(video_processor_transform_caps);
+    base_transform_class->transform_size = GST_DEBUG_FUNCPTR(video_processor_transform_size);
+    base_transform_class->decide_allocation = GST_DEBUG_FUNCPTR(video_processor_decide_allocation);
+    base_transform_class->stop = GST_DEBUG_FUNCPTR(video_processor_stop);
     
-    // In-place transform disabled (copy required)
+    // Passthrough (no filter) must not touch the buffer
     base_transform_class->transform_ip_on_passthrough = FALSE;
 }
 
@@ -49,10 +80,61 @@ static void video_processor_class_init(VideoProcessorClass* klass) {
  * @brief GObject instance initialization
  */
 static void video_processor_init(VideoProcessorElement* element) {
+    element->processor = nullptr;
+    element->info_valid = FALSE;
+
     // Passthrough active by default
     gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(element), TRUE);
 }
 
+/**
+ * @brief Returns true for filters that map every pixel onto itself
+ *
+ * These run on the (writable) input buffer; CUSTOM is included because the
+ * callback receives and may modify the buffer itself.
+ */
+static bool isPixelFilter(FilterType type) {
+    switch (type) {
+        case FilterType::GRAYSCALE:
+        case FilterType::BRIGHTNESS:
+        case FilterType::CONTRAST:
+        case FilterType::COLOR_ADJUST:
+        case FilterType::CUSTOM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Returns true if rotation or flips are requested
+ */
+static bool hasGeometry(const ProcessingParams& params) {
+#ifdef HAVE_OPENCV
+    return params.rotation % 360 != 0 || params.flip_horizontal || params.flip_vertical;
+#else
+    return false; // Geometry needs OpenCV
+#endif
+}
+
+/**
+ * @brief Returns true if the chain has a crop or scale stage that takes effect
+ */
+static bool chainResizes(const ProcessingParams& params) {
+#ifdef HAVE_OPENCV
+    if (params.filter_type != FilterType::CHAIN) {
+        return false;
+    }
+    for (FilterStage stage : params.filter_chain) {
+        if ((stage == FilterStage::CROP && params.crop_width > 0 && params.crop_height > 0) ||
+            (stage == FilterStage::SCALE && params.scale_width > 0 && params.scale_height > 0)) {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
 /**
  * @brief Constructor
  */
@@ -60,6 +142,11 @@ VideoProcessor::VideoProcessor() {
     // Reset statistics
     resetStats();
 
+    {
+        std::lock_guard<std::mutex> lock(params_mutex_);
+        publishParameters();
+    }
+
 #ifdef HAVE_OPENCV
     std::cout << "[VideoProcessor] OpenCV support enabled." << std::endl;
 #endif
@@ -79,19 +166,70 @@ VideoProcessor::~VideoProcessor() {
  */
 GstElement* VideoProcessor::createElement() {
     // Create custom element
-    element_ = g_object_new(VIDEO_PROCESSOR_TYPE, nullptr);
+    element_ = GST_ELEMENT(g_object_new(VIDEO_PROCESSOR_TYPE, nullptr));
     
     // Store VideoProcessor pointer
     VIDEO_PROCESSOR(element_)->processor = this;
     
     // Set element properties
-    gst_base_transform_set_in_place(GST_BASE_TRANSFORM(element_), FALSE);
-    gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(element_), 
-                                      params_.filter_type == FilterType::NONE);
+    std::lock_guard<std::mutex> lock(params_mutex_);
+    updateTransformMode();
     
     return GST_ELEMENT(element_);
 }
 
+/**
+ * @brief Publishes params_ to the streaming thread
+ *
+ * The streaming thread reads an immutable copy and the colour tables through
+ * atomic shared_ptr loads, so it never waits on params_mutex_.
+ */
+void VideoProcessor::publishParameters() {
+    std::atomic_store(&active_params_, std::make_shared<const ProcessingParams>(params_));
+    
+    color_adjuster_.setParams(params_.brightness, params_.contrast,
+                              params_.saturation, params_.hue);
+    color_adjuster_.setThreads(params_.processing_threads);
+    
+    updateTransformMode();
+}
+
+/**
+ * @brief Selects passthrough, in-place or pooled transform
+ *
+ * NONE forwards input buffers untouched. Per-pixel filters without rotation
+ * or flips modify the input buffer in place. Everything else reads the input
+ * and writes into a buffer from the pool chosen in decide_allocation.
+ */
+void VideoProcessor::updateTransformMode() {
+    if (!element_) {
+        return;
+    }
+    
+    GstBaseTransform* trans = GST_BASE_TRANSFORM(element_);
+    bool passthrough = params_.filter_type == FilterType::NONE ||
+                       (params_.filter_type == FilterType::CHAIN && params_.filter_chain.empty());
+#ifndef HAVE_OPENCV
+    // Neighbourhood filters need OpenCV; without it they are a no-op
+    passthrough = passthrough || !isPixelFilter(params_.filter_type);
+#endif
+    bool in_place = isPixelFilter(params_.filter_type) && !hasGeometry(params_);
+    
+    bool resizing = chainResizes(params_);
+    bool changed = (passthrough != static_cast<bool>(gst_base_transform_is_passthrough(trans))) ||
+                   (in_place != static_cast<bool>(gst_base_transform_is_in_place(trans))) ||
+                   resizing || resizing_;
+    resizing_ = resizing;
+    gst_base_transform_set_passthrough(trans, passthrough);
+    gst_base_transform_set_in_place(trans, in_place);
+    
+    // Renegotiate allocation (only the out-of-place mode needs an output pool)
+    // and, when the chain crops or scales, the output caps
+    if (changed) {
+        gst_base_transform_reconfigure_src(trans);
+    }
+}
+
 /**
  * @brief Sets processing parameters
  */
@@ -99,11 +237,8 @@ void VideoProcessor::setParameters(const ProcessingParams& params) {
     std::lock_guard<std::mutex> lock(params_mutex_);
     params_ = params;
     
-    // Update passthrough mode
-    if (element_) {
-        gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(element_), 
-                                          params_.filter_type == FilterType::NONE);
-    }
+    // Update the streaming thread's copy and passthrough / in-place mode
+    publishParameters();
 }
 
 /**
@@ -121,10 +256,7 @@ void VideoProcessor::setFilter(FilterType type) {
     std::lock_guard<std::mutex> lock(params_mutex_);
     params_.filter_type = type;
     
-    if (element_) {
-        gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(element_), 
-                                          type == FilterType::NONE);
-    }
+    publishParameters();
 }
 
 /**
@@ -138,16 +270,53 @@ void VideoProcessor::setCustomProcessor(ProcessingCallback callback) {
  * @brief Returns statistics
  */
 ProcessingStats VideoProcessor::getStats() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    return stats_;
+    ProcessingStats stats;
+    Histogram::Snapshot times = frame_time_metric_.snapshot();
+    stats.frames_processed = times.count - frames_base_.load(std::memory_order_relaxed);
+    stats.dropped_frames = dropped_metric_.value() - dropped_base_.load(std::memory_order_relaxed);
+    if (stats.frames_processed > 0) {
+        double sum = times.sum - time_base_.load(std::memory_order_relaxed);
+        stats.avg_processing_time = sum * 1000.0 / stats.frames_processed;
+        stats.min_processing_time = min_processing_time_.load(std::memory_order_relaxed);
+        stats.max_processing_time = max_processing_time_.load(std::memory_order_relaxed);
+    }
+#ifdef HAVE_OPENCV
+    if (std::atomic_load(&active_params_)->filter_type == FilterType::CHAIN) {
+        stats.stage_timings = chain_.timings();
+    }
+#endif
+    return stats;
 }
 
 /**
  * @brief Resets statistics
  */
 void VideoProcessor::resetStats() {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    stats_ = ProcessingStats();
+    Histogram::Snapshot times = frame_time_metric_.snapshot();
+    frames_base_ = times.count;
+    time_base_ = times.sum;
+    dropped_base_ = dropped_metric_.value();
+    min_processing_time_ = ProcessingStats().min_processing_time;
+    max_processing_time_ = 0.0;
+}
+
+/**
+ * @brief Exports the processing metrics
+ */
+void VideoProcessor::registerMetrics(MetricsRegistry& registry) {
+    registry.addHistogram("video_processor_frame_seconds",
+                          "Time spent filtering one frame", frame_time_metric_);
+    registry.addCounter("video_processor_dropped_frames_total",
+                        "Frames dropped by the video processor", dropped_metric_);
+#ifdef HAVE_OPENCV
+    registry.addCollector("video_processor_stage_seconds",
+                          "Average time per frame of each filter chain operation",
+                          MetricType::GAUGE, [this](std::vector<MetricSample>& samples) {
+        for (const StageTiming& timing : chain_.timings()) {
+            samples.push_back({{{"stage", timing.name}}, timing.avg_time / 1000.0});
+        }
+    });
+#endif
 }
 
 /**
@@ -179,324 +348,670 @@ void VideoProcessor::addMetadata(const std::string& key, const std::string& valu
 }
 
 /**
- * @brief Processes a video frame
+ * @brief Returns true if the filter chain may change the frame size
+ */
+bool VideoProcessor::resizesFrames() const {
+    std::lock_guard<std::mutex> lock(params_mutex_);
+    return chainResizes(params_);
+}
+
+/**
+ * @brief Returns the output size for an input size
+ */
+void VideoProcessor::outputSize(int width, int height, int& out_width, int& out_height) const {
+    std::lock_guard<std::mutex> lock(params_mutex_);
+    out_width = width;
+    out_height = height;
+    if (chainResizes(params_)) {
+        filterChainOutputSize(params_, width, height, out_width, out_height);
+    }
+}
+
+/**
+ * @brief Filters a frame in place
  */
-GstBuffer* VideoProcessor::processFrame(GstBuffer* buffer, const GstVideoInfo* info) {
+GstFlowReturn VideoProcessor::processFrameInPlace(GstBuffer* buffer, const GstVideoInfo* info) {
     auto start_time = std::chrono::high_resolution_clock::now();
+    std::shared_ptr<const ProcessingParams> params = std::atomic_load(&active_params_);
     
-    // Update statistics
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        stats_.frames_processed++;
+    // Use custom processor if available
+    if (params->filter_type == FilterType::CUSTOM) {
+        if (custom_processor_) {
+            applyCustom(buffer, info);
+        }
+        recordFrame(start_time);
+        return GST_FLOW_OK;
     }
     
-    // Use custom processor if available
-    if (custom_processor_ && params_.filter_type == FilterType::CUSTOM) {
-        return custom_processor_(buffer, info->width, info->height);
+    // Map the buffer (video meta strides are honoured)
+    GstVideoFrame frame;
+    if (!gst_video_frame_map(&frame, info, buffer, GST_MAP_READWRITE)) {
+        return GST_FLOW_ERROR;
+    }
+    
+    applyPixelFilter(&frame, *params);
+    
+    saveSnapshotIfRequested(&frame);
+    gst_video_frame_unmap(&frame);
+    
+    recordFrame(start_time);
+    return GST_FLOW_OK;
+}
+
+/**
+ * @brief Filters a frame into an output buffer
+ */
+GstFlowReturn VideoProcessor::processFrame(GstBuffer* inbuf, GstBuffer* outbuf,
+                                           const GstVideoInfo* in_info, const GstVideoInfo* out_info) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::shared_ptr<const ProcessingParams> params = std::atomic_load(&active_params_);
+    
+    GstVideoFrame in_frame;
+    GstVideoFrame out_frame;
+    if (!gst_video_frame_map(&in_frame, in_info, inbuf, GST_MAP_READ)) {
+        return GST_FLOW_ERROR;
+    }
+    if (!gst_video_frame_map(&out_frame, out_info, outbuf, GST_MAP_WRITE)) {
+        gst_video_frame_unmap(&in_frame);
+        return GST_FLOW_ERROR;
+    }
+    
+    bool filtered = false;
+#ifdef HAVE_OPENCV
+    if (params->filter_type == FilterType::CHAIN) {
+        prepareChain(params, cv::Size(GST_VIDEO_INFO_WIDTH(in_info), GST_VIDEO_INFO_HEIGHT(in_info)));
+    }
+    // Filters write straight into the mapped output buffer
+    filtered = filterFrame(&in_frame, &out_frame, *params);
+#endif
+    bool same_size = GST_VIDEO_INFO_WIDTH(in_info) == GST_VIDEO_INFO_WIDTH(out_info) &&
+                     GST_VIDEO_INFO_HEIGHT(in_info) == GST_VIDEO_INFO_HEIGHT(out_info);
+    if (!filtered && !(same_size && gst_video_frame_copy(&out_frame, &in_frame))) {
+        // Unsupported format, or caps not yet renegotiated for a new chain size
+        gst_video_frame_unmap(&out_frame);
+        gst_video_frame_unmap(&in_frame);
+        dropped_metric_.inc();
+        return GST_BASE_TRANSFORM_FLOW_DROPPED;
+    }
+    
+    // Per-pixel filters run on the output in its native format
+    applyPixelFilter(&out_frame, *params);
+    
+    saveSnapshotIfRequested(&out_frame);
+    gst_video_frame_unmap(&out_frame);
+    gst_video_frame_unmap(&in_frame);
+    
+    recordFrame(start_time);
+    return GST_FLOW_OK;
+}
+
+/**
+ * @brief Runs the custom callback and keeps its result in the buffer
+ */
+void VideoProcessor::applyCustom(GstBuffer* buffer, const GstVideoInfo* info) {
+    GstBuffer* result = custom_processor_(buffer, GST_VIDEO_INFO_WIDTH(info),
+                                          GST_VIDEO_INFO_HEIGHT(info));
+    if (!result || result == buffer) {
+        return;
     }
     
-    // Map the buffer
+    // Callback produced a new buffer: copy its contents back in place
     GstMapInfo map;
-    if (!gst_buffer_map(buffer, &map, GST_MAP_READWRITE)) {
-        return buffer;
+    if (gst_buffer_map(result, &map, GST_MAP_READ)) {
+        gst_buffer_fill(buffer, 0, map.data, std::min<gsize>(map.size, gst_buffer_get_size(buffer)));
+        gst_buffer_unmap(result, &map);
+    }
+    gst_buffer_unref(result);
+}
+
+/**
+ * @brief Saves the frame if a snapshot was requested
+ */
+void VideoProcessor::saveSnapshotIfRequested(const GstVideoFrame* frame) {
+    if (!take_snapshot_.load(std::memory_order_relaxed)) {
+        return;
     }
     
 #ifdef HAVE_OPENCV
-    // OpenCV processing
-    if (params_.filter_type != FilterType::NONE) {
-        cv::Mat mat = bufferToMat(buffer, info);
-        
-        // Apply filter
-        applyOpenCVFilter(mat, params_.filter_type);
-        
-        // Take snapshot
-        if (take_snapshot_) {
-            cv::imwrite(snapshot_filename_, mat);
-            take_snapshot_ = false;
-            std::cout << "[VideoProcessor] Snapshot saved: " 
-                      << snapshot_filename_ << std::endl;
-        }
-        
-        // Convert Mat back to buffer
-        gst_buffer_unmap(buffer, &map);
-        return matToBuffer(mat, info);
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    take_snapshot_ = false;
+    
+    cv::Mat bgr;
+    if (frameToMat(frame, bgr)) {
+        cv::imwrite(snapshot_filename_, bgr);
+        std::cout << "[VideoProcessor] Snapshot saved: " 
+                  << snapshot_filename_ << std::endl;
     }
-#else
-    // Simple CPU processing
-    switch (params_.filter_type) {
+#endif
+}
+
+/**
+ * @brief Updates timing statistics for one frame
+ */
+void VideoProcessor::recordFrame(std::chrono::high_resolution_clock::time_point start_time) {
+    // Calculate processing time
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+    double processing_time = duration.count() / 1000.0; // ms
+    
+    // Update statistics (atomics only, no lock on the streaming thread)
+    frame_time_metric_.observe(processing_time / 1000.0);
+    atomicMin(min_processing_time_, processing_time);
+    atomicMax(max_processing_time_, processing_time);
+}
+
+/**
+ * @brief Applies grayscale filter (CPU)
+ */
+void VideoProcessor::applyGrayscale(GstVideoFrame* frame) {
+    int width = GST_VIDEO_FRAME_WIDTH(frame);
+    int height = GST_VIDEO_FRAME_HEIGHT(frame);
+    
+    switch (GST_VIDEO_FRAME_FORMAT(frame)) {
+        case GST_VIDEO_FORMAT_I420:
+        case GST_VIDEO_FORMAT_YV12:
+            // Y plane is already grayscale, set U and V to 128 (neutral color)
+            for (int plane = 1; plane <= 2; plane++) {
+                guint8* data = static_cast<guint8*>(GST_VIDEO_FRAME_PLANE_DATA(frame, plane));
+                int stride = GST_VIDEO_FRAME_PLANE_STRIDE(frame, plane);
+                int uv_width = GST_VIDEO_FRAME_COMP_WIDTH(frame, plane);
+                int uv_height = GST_VIDEO_FRAME_COMP_HEIGHT(frame, plane);
+                for (int i = 0; i < uv_height; i++) {
+                    memset(data + i * stride, 128, uv_width);
+                }
+            }
+            break;
+            
+        case GST_VIDEO_FORMAT_NV12:
+        case GST_VIDEO_FORMAT_NV21:
+            {
+                // Interleaved UV plane
+                guint8* data = static_cast<guint8*>(GST_VIDEO_FRAME_PLANE_DATA(frame, 1));
+                int stride = GST_VIDEO_FRAME_PLANE_STRIDE(frame, 1);
+                int uv_width = GST_VIDEO_FRAME_COMP_WIDTH(frame, 1) * 2;
+                int uv_height = GST_VIDEO_FRAME_COMP_HEIGHT(frame, 1);
+                for (int i = 0; i < uv_height; i++) {
+                    memset(data + i * stride, 128, uv_width);
+                }
+            }
+            break;
+            
+        case GST_VIDEO_FORMAT_RGB:
+        case GST_VIDEO_FORMAT_BGR:
+            {
+                // BT.601 weights in 8-bit fixed point, red first for RGB
+                bool rgb = GST_VIDEO_FRAME_FORMAT(frame) == GST_VIDEO_FORMAT_RGB;
+                int w0 = rgb ? 77 : 29;
+                int w2 = rgb ? 29 : 77;
+                guint8* data = static_cast<guint8*>(GST_VIDEO_FRAME_PLANE_DATA(frame, 0));
+                int stride = GST_VIDEO_FRAME_PLANE_STRIDE(frame, 0);
+                for (int y = 0; y < height; y++) {
+                    guint8* row = data + y * stride;
+                    for (int x = 0; x < width; x++, row += 3) {
+                        guint8 gray = static_cast<guint8>((row[0] * w0 + row[1] * 150 + row[2] * w2 + 128) >> 8);
+                        row[0] = row[1] = row[2] = gray;
+                    }
+                }
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Applies per-pixel filters in place
+ */
+void VideoProcessor::applyPixelFilter(GstVideoFrame* frame, const ProcessingParams& params) {
+    switch (params.filter_type) {
         case FilterType::GRAYSCALE:
-            applyGrayscale(map.data, info);
+            applyGrayscale(frame);
             break;
             
         case FilterType::BRIGHTNESS:
         case FilterType::CONTRAST:
-            adjustBrightnessContrast(map.data, info);
+        case FilterType::COLOR_ADJUST:
+            applyColorAdjust(frame);
             break;
             
         default:
             break;
     }
-#endif
-    
-    gst_buffer_unmap(buffer, &map);
-    
-    // Calculate processing time
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-    double processing_time = duration.count() / 1000.0; // ms
+}
+
+/**
+ * @brief Applies the colour tables
+ *
+ * YUV formats get the luma table and the chroma rotation in one pass; packed
+ * RGB/BGR only gets the luma table on every channel (brightness/contrast).
+ */
+void VideoProcessor::applyColorAdjust(GstVideoFrame* frame) {
+    int width = GST_VIDEO_FRAME_WIDTH(frame);
+    int height = GST_VIDEO_FRAME_HEIGHT(frame);
+    auto plane = [frame](int index) {
+        return static_cast<uint8_t*>(GST_VIDEO_FRAME_PLANE_DATA(frame, index));
+    };
+    auto stride = [frame](int index) {
+        return GST_VIDEO_FRAME_PLANE_STRIDE(frame, index);
+    };
     
-    // Update statistics
-    {
-        std::lock_guard<std::mutex> lock(stats_mutex_);
-        processing_time_sum_ += processing_time;
-        stats_.avg_processing_time = processing_time_sum_ / stats_.frames_processed;
-        stats_.min_processing_time = std::min(stats_.min_processing_time, processing_time);
-        stats_.max_processing_time = std::max(stats_.max_processing_time, processing_time);
+    switch (GST_VIDEO_FRAME_FORMAT(frame)) {
+        case GST_VIDEO_FORMAT_I420:
+        case GST_VIDEO_FORMAT_YV12:
+            // Component order, so YV12's swapped planes resolve to U and V
+            color_adjuster_.applyPlanar(
+                static_cast<uint8_t*>(GST_VIDEO_FRAME_COMP_DATA(frame, 0)), GST_VIDEO_FRAME_COMP_STRIDE(frame, 0),
+                static_cast<uint8_t*>(GST_VIDEO_FRAME_COMP_DATA(frame, 1)), GST_VIDEO_FRAME_COMP_STRIDE(frame, 1),
+                static_cast<uint8_t*>(GST_VIDEO_FRAME_COMP_DATA(frame, 2)), GST_VIDEO_FRAME_COMP_STRIDE(frame, 2),
+                width, height);
+            break;
+            
+        case GST_VIDEO_FORMAT_NV12:
+        case GST_VIDEO_FORMAT_NV21:
+            color_adjuster_.applySemiPlanar(plane(0), stride(0), plane(1), stride(1), width, height,
+                                            GST_VIDEO_FRAME_FORMAT(frame) == GST_VIDEO_FORMAT_NV21);
+            break;
+            
+        case GST_VIDEO_FORMAT_RGB:
+        case GST_VIDEO_FORMAT_BGR:
+            color_adjuster_.applyPacked(plane(0), stride(0), width * 3, height);
+            break;
+            
+        default:
+            break;
     }
-    
-    return buffer;
 }
 
+#ifdef HAVE_OPENCV
 /**
- * @brief Applies grayscale filter (CPU)
+ * @brief Wraps plane 0 of a packed 24-bit frame without copying
+ */
+static cv::Mat packedMat(const GstVideoFrame* frame) {
+    return cv::Mat(GST_VIDEO_FRAME_HEIGHT(frame), GST_VIDEO_FRAME_WIDTH(frame), CV_8UC3,
+                   GST_VIDEO_FRAME_PLANE_DATA(frame, 0),
+                   GST_VIDEO_FRAME_PLANE_STRIDE(frame, 0));
+}
+
+/**
+ * @brief Bytes per row of a 4:2:0 plane as OpenCV packs it
+ *
+ * Semi-planar formats keep U and V interleaved in one full-width plane.
+ */
+static int rowBytes420(const GstVideoFrame* frame, int plane) {
+    int width = GST_VIDEO_FRAME_WIDTH(frame);
+    if (plane == 0 || GST_VIDEO_FRAME_N_PLANES(frame) == 2) {
+        return width;
+    }
+    return width / 2;
+}
+
+/**
+ * @brief Returns true if the 4:2:0 planes are laid out exactly as OpenCV expects
+ *
+ * The default GStreamer layout for even sizes with 8-aligned width is tight,
+ * so cvtColor can read and write the mapped buffer directly.
  */
-void VideoProcessor::applyGrayscale(guint8* data, const GstVideoInfo* info) {
-    int width = GST_VIDEO_INFO_WIDTH(info);
-    int height = GST_VIDEO_INFO_HEIGHT(info);
-    int stride = GST_VIDEO_INFO_PLANE_STRIDE(info, 0);
-    
-    // For I420 format, Y plane is already grayscale
-    // Set U and V planes to 128 (neutral color)
-    if (GST_VIDEO_INFO_FORMAT(info) == GST_VIDEO_FORMAT_I420) {
-        int y_size = stride * height;
-        int uv_stride = GST_VIDEO_INFO_PLANE_STRIDE(info, 1);
-        int uv_height = height / 2;
-        
-        // U plane
-        guint8* u_plane = data + y_size;
-        for (int i = 0; i < uv_height; i++) {
-            memset(u_plane + i * uv_stride, 128, width / 2);
+static bool isPacked420(const GstVideoFrame* frame) {
+    int height = GST_VIDEO_FRAME_HEIGHT(frame);
+    const guint8* expected = static_cast<const guint8*>(GST_VIDEO_FRAME_PLANE_DATA(frame, 0));
+    for (guint plane = 0; plane < GST_VIDEO_FRAME_N_PLANES(frame); plane++) {
+        int row_bytes = rowBytes420(frame, plane);
+        if (GST_VIDEO_FRAME_PLANE_DATA(frame, plane) != expected ||
+            GST_VIDEO_FRAME_PLANE_STRIDE(frame, plane) != row_bytes) {
+            return false;
         }
-        
-        // V plane
-        guint8* v_plane = u_plane + (uv_stride * uv_height);
-        for (int i = 0; i < uv_height; i++) {
-            memset(v_plane + i * uv_stride, 128, width / 2);
+        expected += static_cast<size_t>(row_bytes) * (plane ? height / 2 : height);
+    }
+    return true;
+}
+
+/**
+ * @brief Copies 4:2:0 planes between a mapped frame and a packed OpenCV buffer
+ * @param to_frame true: yuv -> frame, false: frame -> yuv
+ *
+ * Planes keep their memory order, so the packed buffer has the layout
+ * OpenCV names after the frame format (I420, YV12, NV12 or NV21).
+ */
+static void copy420(const GstVideoFrame* frame, cv::Mat& yuv, bool to_frame) {
+    int height = GST_VIDEO_FRAME_HEIGHT(frame);
+    guint8* packed = yuv.data;
+    
+    for (guint plane = 0; plane < GST_VIDEO_FRAME_N_PLANES(frame); plane++) {
+        int row_bytes = rowBytes420(frame, plane);
+        int plane_height = plane ? height / 2 : height;
+        guint8* data = static_cast<guint8*>(GST_VIDEO_FRAME_PLANE_DATA(frame, plane));
+        int stride = GST_VIDEO_FRAME_PLANE_STRIDE(frame, plane);
+        for (int i = 0; i < plane_height; i++) {
+            if (to_frame) {
+                memcpy(data + i * stride, packed, row_bytes);
+            } else {
+                memcpy(packed, data + i * stride, row_bytes);
+            }
+            packed += row_bytes;
         }
     }
 }
 
 /**
- * @brief Adjusts brightness/contrast (CPU)
+ * @brief Writes packed I420 into a mapped NV12/NV21 frame
+ *
+ * OpenCV has no BGR to semi-planar conversion, so the chroma planes are
+ * interleaved here.
  */
-void VideoProcessor::adjustBrightnessContrast(guint8* data, const GstVideoInfo* info) {
-    int width = GST_VIDEO_INFO_WIDTH(info);
-    int height = GST_VIDEO_INFO_HEIGHT(info);
-    int stride = GST_VIDEO_INFO_PLANE_STRIDE(info, 0);
+static void writeSemiPlanar(const cv::Mat& i420, GstVideoFrame* frame) {
+    int width = GST_VIDEO_FRAME_WIDTH(frame);
+    int height = GST_VIDEO_FRAME_HEIGHT(frame);
+    bool vu = GST_VIDEO_FRAME_FORMAT(frame) == GST_VIDEO_FORMAT_NV21;
+    const guint8* y = i420.data;
+    const guint8* u = y + static_cast<size_t>(width) * height;
+    const guint8* v = u + static_cast<size_t>(width / 2) * (height / 2);
     
-    double brightness = params_.brightness;
-    double contrast = params_.contrast;
+    guint8* luma = static_cast<guint8*>(GST_VIDEO_FRAME_PLANE_DATA(frame, 0));
+    int luma_stride = GST_VIDEO_FRAME_PLANE_STRIDE(frame, 0);
+    for (int i = 0; i < height; i++, y += width) {
+        memcpy(luma + i * luma_stride, y, width);
+    }
     
-    // Process Y plane (brightness)
-    for (int y = 0; y < height; y++) {
-        guint8* row = data + y * stride;
-        for (int x = 0; x < width; x++) {
-            int pixel = row[x];
-            
-            // Apply contrast
-            pixel = (int)((pixel - 128) * contrast + 128);
-            
-            // Add brightness
-            pixel += brightness;
-            
-            // Check bounds
-            row[x] = (guint8)CLAMP(pixel, 0, 255);
+    guint8* chroma = static_cast<guint8*>(GST_VIDEO_FRAME_PLANE_DATA(frame, 1));
+    int chroma_stride = GST_VIDEO_FRAME_PLANE_STRIDE(frame, 1);
+    for (int i = 0; i < height / 2; i++) {
+        guint8* row = chroma + i * chroma_stride;
+        for (int x = 0; x < width / 2; x++, u++, v++) {
+            row[2 * x] = vu ? *v : *u;
+            row[2 * x + 1] = vu ? *u : *v;
         }
     }
 }
 
-#ifdef HAVE_OPENCV
 /**
- * @brief Converts buffer to OpenCV Mat
+ * @brief Returns the OpenCV YUV to BGR code for a 4:2:0 format, or -1
  */
-cv::Mat VideoProcessor::bufferToMat(GstBuffer* buffer, const GstVideoInfo* info) {
-    GstMapInfo map;
-    gst_buffer_map(buffer, &map, GST_MAP_READ);
-    
-    cv::Mat mat;
-    int width = GST_VIDEO_INFO_WIDTH(info);
-    int height = GST_VIDEO_INFO_HEIGHT(info);
+static int yuv420ToBgrCode(GstVideoFormat format) {
+    switch (format) {
+        case GST_VIDEO_FORMAT_I420: return cv::COLOR_YUV2BGR_I420;
+        case GST_VIDEO_FORMAT_YV12: return cv::COLOR_YUV2BGR_YV12;
+        case GST_VIDEO_FORMAT_NV12: return cv::COLOR_YUV2BGR_NV12;
+        case GST_VIDEO_FORMAT_NV21: return cv::COLOR_YUV2BGR_NV21;
+        default: return -1;
+    }
+}
+
+/**
+ * @brief Converts a mapped frame to BGR
+ */
+bool VideoProcessor::frameToMat(const GstVideoFrame* frame, cv::Mat& mat) {
+    int width = GST_VIDEO_FRAME_WIDTH(frame);
+    int height = GST_VIDEO_FRAME_HEIGHT(frame);
     
-    switch (GST_VIDEO_INFO_FORMAT(info)) {
+    switch (GST_VIDEO_FRAME_FORMAT(frame)) {
         case GST_VIDEO_FORMAT_I420:
+        case GST_VIDEO_FORMAT_YV12:
+        case GST_VIDEO_FORMAT_NV12:
+        case GST_VIDEO_FORMAT_NV21:
             {
-                // Convert I420 to BGR
-                cv::Mat yuv(height + height/2, width, CV_8UC1, map.data);
-                cv::cvtColor(yuv, mat, cv::COLOR_YUV2BGR_I420);
+                if (width % 2 || height % 2) {
+                    return false;
+                }
+                int code = yuv420ToBgrCode(GST_VIDEO_FRAME_FORMAT(frame));
+                if (isPacked420(frame)) {
+                    cv::Mat yuv(height + height / 2, width, CV_8UC1, GST_VIDEO_FRAME_PLANE_DATA(frame, 0));
+                    cv::cvtColor(yuv, mat, code);
+                } else {
+                    yuv_scratch_.create(height + height / 2, width, CV_8UC1);
+                    copy420(frame, yuv_scratch_, false);
+                    cv::cvtColor(yuv_scratch_, mat, code);
+                }
             }
-            break;
+            return true;
             
         case GST_VIDEO_FORMAT_RGB:
-            mat = cv::Mat(height, width, CV_8UC3, map.data).clone();
-            cv::cvtColor(mat, mat, cv::COLOR_RGB2BGR);
-            break;
+            cv::cvtColor(packedMat(frame), mat, cv::COLOR_RGB2BGR);
+            return true;
             
         case GST_VIDEO_FORMAT_BGR:
-            mat = cv::Mat(height, width, CV_8UC3, map.data).clone();
-            break;
+            packedMat(frame).copyTo(mat);
+            return true;
             
         default:
-            std::cerr << "[VideoProcessor] Unsupported video format!" << std::endl;
-            mat = cv::Mat(height, width, CV_8UC3, cv::Scalar(0, 0, 0));
-            break;
+            return false;
     }
-    
-    gst_buffer_unmap(buffer, &map);
-    return mat;
 }
 
 /**
- * @brief Converts OpenCV Mat to buffer
+ * @brief Writes a BGR image into a mapped frame
  */
-GstBuffer* VideoProcessor::matToBuffer(const cv::Mat& mat, const GstVideoInfo* info) {
-    GstBuffer* buffer = gst_buffer_new_allocate(nullptr, 
-                                               GST_VIDEO_INFO_SIZE(info), nullptr);
-    
-    GstMapInfo map;
-    gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+bool VideoProcessor::matToFrame(const cv::Mat& mat, GstVideoFrame* frame) {
+    int width = GST_VIDEO_FRAME_WIDTH(frame);
+    int height = GST_VIDEO_FRAME_HEIGHT(frame);
     
-    int width = GST_VIDEO_INFO_WIDTH(info);
-    int height = GST_VIDEO_INFO_HEIGHT(info);
-    
-    switch (GST_VIDEO_INFO_FORMAT(info)) {
+    switch (GST_VIDEO_FRAME_FORMAT(frame)) {
         case GST_VIDEO_FORMAT_I420:
+        case GST_VIDEO_FORMAT_YV12:
             {
-                // Convert BGR to I420
-                cv::Mat yuv;
-                cv::cvtColor(mat, yuv, cv::COLOR_BGR2YUV_I420);
-                memcpy(map.data, yuv.data, GST_VIDEO_INFO_SIZE(info));
+                if (width % 2 || height % 2) {
+                    return false;
+                }
+                int code = GST_VIDEO_FRAME_FORMAT(frame) == GST_VIDEO_FORMAT_YV12
+                               ? cv::COLOR_BGR2YUV_YV12 : cv::COLOR_BGR2YUV_I420;
+                if (isPacked420(frame)) {
+                    // Same size and type: cvtColor writes into the buffer
+                    cv::Mat yuv(height + height / 2, width, CV_8UC1, GST_VIDEO_FRAME_PLANE_DATA(frame, 0));
+                    cv::cvtColor(mat, yuv, code);
+                } else {
+                    cv::cvtColor(mat, yuv_scratch_, code);
+                    copy420(frame, yuv_scratch_, true);
+                }
             }
-            break;
+            return true;
+            
+        case GST_VIDEO_FORMAT_NV12:
+        case GST_VIDEO_FORMAT_NV21:
+            if (width % 2 || height % 2) {
+                return false;
+            }
+            cv::cvtColor(mat, yuv_scratch_, cv::COLOR_BGR2YUV_I420);
+            writeSemiPlanar(yuv_scratch_, frame);
+            return true;
             
         case GST_VIDEO_FORMAT_RGB:
             {
-                cv::Mat rgb;
+                cv::Mat rgb = packedMat(frame);
                 cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
-                memcpy(map.data, rgb.data, width * height * 3);
             }
-            break;
+            return true;
             
         case GST_VIDEO_FORMAT_BGR:
-            memcpy(map.data, mat.data, width * height * 3);
-            break;
+            {
+                cv::Mat bgr = packedMat(frame);
+                mat.copyTo(bgr);
+            }
+            return true;
             
         default:
-            break;
+            return false;
+    }
+}
+
+/**
+ * @brief Filters a mapped frame into another
+ */
+bool VideoProcessor::filterFrame(const GstVideoFrame* in, GstVideoFrame* out,
+                                 const ProcessingParams& params) {
+    if (params.filter_type == FilterType::CHAIN) {
+        if (chain_.outputSize() != cv::Size(GST_VIDEO_FRAME_WIDTH(out), GST_VIDEO_FRAME_HEIGHT(out))) {
+            return false;
+        }
+        if (GST_VIDEO_FRAME_FORMAT(in) == GST_VIDEO_FORMAT_BGR) {
+            cv::Mat dst = packedMat(out);
+            chain_.run(packedMat(in), dst);
+            return true;
+        }
+        if (!frameToMat(in, bgr_input_)) {
+            return false;
+        }
+        bgr_output_.create(chain_.outputSize(), CV_8UC3);
+        chain_.run(bgr_input_, bgr_output_);
+        return matToFrame(bgr_output_, out);
     }
     
-    gst_buffer_unmap(buffer, &map);
-    return buffer;
+    if (GST_VIDEO_FRAME_FORMAT(in) == GST_VIDEO_FORMAT_BGR) {
+        // Read the input buffer, write the output buffer, no intermediate copy
+        cv::Mat dst = packedMat(out);
+        applyOpenCVFilter(packedMat(in), dst, params);
+        return true;
+    }
+    
+    if (!frameToMat(in, bgr_input_)) {
+        return false;
+    }
+    bgr_output_.create(bgr_input_.size(), bgr_input_.type());
+    applyOpenCVFilter(bgr_input_, bgr_output_, params);
+    return matToFrame(bgr_output_, out);
+}
+
+/**
+ * @brief Recompiles the filter chain after a parameter or size change
+ *
+ * Parameters are published as a new immutable snapshot, so comparing the
+ * pointer is enough to notice a change.
+ */
+void VideoProcessor::prepareChain(const std::shared_ptr<const ProcessingParams>& params,
+                                  cv::Size input_size) {
+    if (params == chain_params_ && chain_.inputSize() == input_size) {
+        return;
+    }
+    chain_.configure(*params, input_size);
+    chain_.setThreads(params->processing_threads);
+    chain_params_ = params;
 }
 
 /**
  * @brief Applies OpenCV-based filter
+ *
+ * Neighbourhood filters read src and write either dst or, when rotation or
+ * flips follow, a scratch image that the geometry pass then maps into dst.
+ * Per-pixel filters commute with geometry and run afterwards on the output
+ * frame. dst keeps its size and type, so OpenCV never reallocates it.
  */
-void VideoProcessor::applyOpenCVFilter(cv::Mat& mat, FilterType type) {
-    switch (type) {
-        case FilterType::GRAYSCALE:
-            cv::cvtColor(mat, mat, cv::COLOR_BGR2GRAY);
-            cv::cvtColor(mat, mat, cv::COLOR_GRAY2BGR);
-            break;
-            
+void VideoProcessor::applyOpenCVFilter(const cv::Mat& src, cv::Mat& dst,
+                                       const ProcessingParams& params) {
+    bool geometry = hasGeometry(params);
+    cv::Mat& target = geometry ? geometry_scratch_ : dst;
+    const cv::Mat* stage = &src;
+    
+    switch (params.filter_type) {
         case FilterType::BLUR:
-            applyBlur(mat);
+            applyBlur(src, target, params);
+            stage = &target;
             break;
             
         case FilterType::SHARPEN:
-            applySharpen(mat);
+            applySharpen(src, target, params);
+            stage = &target;
             break;
             
         case FilterType::EDGE_DETECT:
-            applyEdgeDetection(mat);
+            applyEdgeDetection(src, target, params);
+            stage = &target;
             break;
             
         case FilterType::DENOISE:
-            applyDenoise(mat);
-            break;
-            
-        case FilterType::BRIGHTNESS:
-        case FilterType::CONTRAST:
-            mat.convertTo(mat, -1, params_.contrast, params_.brightness);
+            applyDenoise(src, target, params);
+            stage = &target;
             break;
             
         default:
             break;
     }
     
-    // Apply rotation
-    if (params_.rotation != 0) {
-        cv::Point2f center(mat.cols / 2.0, mat.rows / 2.0);
-        cv::Mat rot_mat = cv::getRotationMatrix2D(center, params_.rotation, 1.0);
-        cv::warpAffine(mat, mat, rot_mat, mat.size());
+    if (geometry) {
+        applyGeometry(*stage, dst, params);
+    } else if (stage == &src) {
+        src.copyTo(dst);
+    }
+}
+
+/**
+ * @brief Applies rotation and flips in one resampling pass
+ */
+void VideoProcessor::applyGeometry(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params) {
+    if (params.rotation % 360 == 0) {
+        if (params.flip_horizontal && params.flip_vertical) {
+            cv::flip(src, dst, -1);
+        } else if (params.flip_horizontal) {
+            cv::flip(src, dst, 1);
+        } else {
+            cv::flip(src, dst, 0);
+        }
+        return;
     }
     
-    // Apply flip
-    if (params_.flip_horizontal && params_.flip_vertical) {
-        cv::flip(mat, mat, -1);
-    } else if (params_.flip_horizontal) {
-        cv::flip(mat, mat, 1);
-    } else if (params_.flip_vertical) {
-        cv::flip(mat, mat, 0);
+    cv::Point2f center(src.cols / 2.0f, src.rows / 2.0f);
+    cv::Mat rot_mat = cv::getRotationMatrix2D(center, params.rotation, 1.0);
+    
+    // Fold the flips into the affine matrix: x' = (W - 1) - x
+    for (int row = 0; row < 2; row++) {
+        bool flip = row == 0 ? params.flip_horizontal : params.flip_vertical;
+        if (!flip) {
+            continue;
+        }
+        for (int col = 0; col < 3; col++) {
+            rot_mat.at<double>(row, col) = -rot_mat.at<double>(row, col);
+        }
+        rot_mat.at<double>(row, 2) += (row == 0 ? src.cols : src.rows) - 1;
     }
+    
+    cv::warpAffine(src, dst, rot_mat, src.size());
 }
 
 /**
  * @brief Blur filter
  */
-void VideoProcessor::applyBlur(cv::Mat& mat) {
-    int kernel_size = params_.blur_kernel_size;
+void VideoProcessor::applyBlur(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params) {
+    int kernel_size = params.blur_kernel_size;
     if (kernel_size % 2 == 0) kernel_size++; // Must be odd
     
-    cv::GaussianBlur(mat, mat, cv::Size(kernel_size, kernel_size), 0);
+    cv::GaussianBlur(src, dst, cv::Size(kernel_size, kernel_size), 0);
 }
 
 /**
  * @brief Sharpening filter
  */
-void VideoProcessor::applySharpen(cv::Mat& mat) {
+void VideoProcessor::applySharpen(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params) {
     cv::Mat kernel = (cv::Mat_<float>(3, 3) << 
         0, -1, 0,
-        -1, 5 + params_.sharpen_strength, -1,
+        -1, 5 + params.sharpen_strength, -1,
         0, -1, 0);
     
-    cv::filter2D(mat, mat, -1, kernel);
+    cv::filter2D(src, dst, -1, kernel);
 }
 
 /**
  * @brief Edge detection filter
  */
-void VideoProcessor::applyEdgeDetection(cv::Mat& mat) {
-    cv::Mat gray, edges;
-    cv::cvtColor(mat, gray, cv::COLOR_BGR2GRAY);
+void VideoProcessor::applyEdgeDetection(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params) {
+    cv::cvtColor(src, gray_, cv::COLOR_BGR2GRAY);
     
-    cv::Canny(gray, edges, params_.edge_threshold1, params_.edge_threshold2);
+    cv::Canny(gray_, edges_, params.edge_threshold1, params.edge_threshold2);
     
     // Show edges in color
-    mat.setTo(cv::Scalar(0, 0, 0));
-    mat.setTo(cv::Scalar(0, 255, 0), edges);
+    dst.create(src.size(), src.type());
+    dst.setTo(cv::Scalar(0, 0, 0));
+    dst.setTo(cv::Scalar(0, 255, 0), edges_);
 }
 
 /**
  * @brief Noise reduction filter
  */
-void VideoProcessor::applyDenoise(cv::Mat& mat) {
-    cv::fastNlMeansDenoisingColored(mat, mat, params_.denoise_strength, 
-                                    params_.denoise_strength, 7, 21);
+void VideoProcessor::applyDenoise(const cv::Mat& src, cv::Mat& dst, const ProcessingParams& params) {
+    cv::fastNlMeansDenoisingColored(src, dst, params.denoise_strength, 
+                                    params.denoise_strength, 7, 21);
 }
 #endif // HAVE_OPENCV
 
 /**
- * @brief GStreamer transform callback
+ * @brief GStreamer transform callback (filters into a pooled output buffer)
  */
 static GstFlowReturn video_processor_transform(GstBaseTransform* trans, 
                                              GstBuffer* inbuf, 
@@ -507,28 +1022,29 @@ static GstFlowReturn video_processor_transform(GstBaseTransform* trans,
     if (!processor) {
         return GST_FLOW_ERROR;
     }
-    
-    // Get video info
-    GstVideoInfo info;
-    GstCaps* caps = gst_pad_get_current_caps(GST_BASE_TRANSFORM_SINK_PAD(trans));
-    if (!gst_video_info_from_caps(&info, caps)) {
-        gst_caps_unref(caps);
-        return GST_FLOW_ERROR;
+    if (!element->info_valid) {
+        return GST_FLOW_NOT_NEGOTIATED;
     }
-    gst_caps_unref(caps);
     
-    // Process frame
-    GstBuffer* result = processor->processFrame(inbuf, &info);
+    return processor->processFrame(inbuf, outbuf, &element->info, &element->out_info);
+}
+
+/**
+ * @brief GStreamer in-place transform callback (per-pixel filters)
+ */
+static GstFlowReturn video_processor_transform_ip(GstBaseTransform* trans,
+                                                GstBuffer* buf) {
+    VideoProcessorElement* element = VIDEO_PROCESSOR(trans);
+    VideoProcessor* processor = element->processor;
     
-    // Copy result
-    if (result != inbuf) {
-        gst_buffer_copy_into(outbuf, result, GST_BUFFER_COPY_ALL, 0, -1);
-        gst_buffer_unref(result);
-    } else {
-        gst_buffer_copy_into(outbuf, inbuf, GST_BUFFER_COPY_ALL, 0, -1);
+    if (!processor) {
+        return GST_FLOW_ERROR;
+    }
+    if (!element->info_valid) {
+        return GST_FLOW_NOT_NEGOTIATED;
     }
     
-    return GST_FLOW_OK;
+    return processor->processFrameInPlace(buf, &element->info);
 }
 
 /**
@@ -538,32 +1054,45 @@ static gboolean video_processor_set_caps(GstBaseTransform* trans,
                                        GstCaps* incaps,
                                        GstCaps* outcaps) {
     VideoProcessorElement* element = VIDEO_PROCESSOR(trans);
-    VideoProcessor* processor = element->processor;
-    
-    if (!processor) {
-        return FALSE;
-    }
-    
-    // Store video info
-    GstVideoInfo info;
-    if (gst_video_info_from_caps(&info, incaps)) {
-        processor->video_info_ = info;
-        processor->video_info_valid_ = true;
-    }
-    
-    return TRUE;
+    element->info_valid = gst_video_info_from_caps(&element->info, incaps) &&
+                          gst_video_info_from_caps(&element->out_info, outcaps);
+    return element->info_valid;
 }
 
 /**
  * @brief Transform caps callback
+ *
+ * The format never changes. When the filter chain crops or scales, a fixed
+ * input size maps to the chain's output size, and any input size can
+ * produce a given output size.
  */
 static GstCaps* video_processor_transform_caps(GstBaseTransform* trans,
                                              GstPadDirection direction,
                                              GstCaps* caps,
                                              GstCaps* filter) {
-    // Return the same caps (we don't change the format)
+    VideoProcessor* processor = VIDEO_PROCESSOR(trans)->processor;
     GstCaps* result = gst_caps_copy(caps);
     
+    if (processor && processor->resizesFrames()) {
+        for (guint i = 0; i < gst_caps_get_size(result); i++) {
+            GstStructure* structure = gst_caps_get_structure(result, i);
+            int width = 0;
+            int height = 0;
+            if (direction == GST_PAD_SINK &&
+                gst_structure_get_int(structure, "width", &width) &&
+                gst_structure_get_int(structure, "height", &height)) {
+                int out_width = width;
+                int out_height = height;
+                processor->outputSize(width, height, out_width, out_height);
+                gst_structure_set(structure, "width", G_TYPE_INT, out_width,
+                                  "height", G_TYPE_INT, out_height, nullptr);
+            } else {
+                gst_structure_remove_field(structure, "width");
+                gst_structure_remove_field(structure, "height");
+            }
+        }
+    }
+    
     if (filter) {
         GstCaps* tmp = gst_caps_intersect_full(result, filter, GST_CAPS_INTERSECT_FIRST);
         gst_caps_unref(result);
@@ -574,19 +1103,90 @@ static GstCaps* video_processor_transform_caps(GstBaseTransform* trans,
 }
 
 /**
- * @brief Transform callback wrapper
+ * @brief Buffer size callback (output size follows the negotiated caps)
  */
-GstFlowReturn VideoProcessor::transformCallback(GstBaseTransform* trans,
-                                              GstBuffer* inbuf,
-                                              GstBuffer* outbuf) {
-    return video_processor_transform(trans, inbuf, outbuf);
+static gboolean video_processor_transform_size(GstBaseTransform*,
+                                             GstPadDirection,
+                                             GstCaps*,
+                                             gsize,
+                                             GstCaps* othercaps,
+                                             gsize* othersize) {
+    GstVideoInfo info;
+    if (!gst_video_info_from_caps(&info, othercaps)) {
+        return FALSE;
+    }
+    *othersize = GST_VIDEO_INFO_SIZE(&info);
+    return TRUE;
 }
 
 /**
- * @brief Set caps callback wrapper
+ * @brief Allocation callback - chooses the output buffer pool
+ *
+ * Only called out of place. Prefers the downstream pool, falls back to a
+ * video buffer pool of our own, and keeps at least two buffers so one can be
+ * filled while the previous one is still downstream.
  */
-gboolean VideoProcessor::setCapsCallback(GstBaseTransform* trans,
-                                       GstCaps* incaps,
-                                       GstCaps* outcaps) {
-    return video_processor_set_caps(trans, incaps, outcaps);
-}
\ No newline at end of file
+static gboolean video_processor_decide_allocation(GstBaseTransform* trans,
+                                                GstQuery* query) {
+    GstCaps* caps = nullptr;
+    gst_query_parse_allocation(query, &caps, nullptr);
+    
+    GstVideoInfo info;
+    if (!caps || !gst_video_info_from_caps(&info, caps)) {
+        return FALSE;
+    }
+    
+    GstBufferPool* pool = nullptr;
+    guint size = GST_VIDEO_INFO_SIZE(&info);
+    guint min_buffers = 0;
+    guint max_buffers = 0;
+    bool update = gst_query_get_n_allocation_pools(query) > 0;
+    if (update) {
+        gst_query_parse_nth_allocation_pool(query, 0, &pool, &size, &min_buffers, &max_buffers);
+        size = std::max(size, static_cast<guint>(GST_VIDEO_INFO_SIZE(&info)));
+    }
+    min_buffers = std::max(min_buffers, 2u);
+    
+    if (!pool) {
+        pool = gst_video_buffer_pool_new();
+    }
+    
+    GstStructure* config = gst_buffer_pool_get_config(pool);
+    gst_buffer_pool_config_set_params(config, caps, size, min_buffers, max_buffers);
+    bool video_meta = gst_query_find_allocation_meta(query, GST_VIDEO_META_API_TYPE, nullptr);
+    if (video_meta) {
+        gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+    }
+    
+    if (!gst_buffer_pool_set_config(pool, config)) {
+        // Downstream pool rejected the configuration (e.g. already active)
+        gst_object_unref(pool);
+        pool = gst_video_buffer_pool_new();
+        config = gst_buffer_pool_get_config(pool);
+        gst_buffer_pool_config_set_params(config, caps, size, min_buffers, max_buffers);
+        if (video_meta) {
+            gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+        }
+        if (!gst_buffer_pool_set_config(pool, config)) {
+            gst_object_unref(pool);
+            return FALSE;
+        }
+    }
+    
+    if (update) {
+        gst_query_set_nth_allocation_pool(query, 0, pool, size, min_buffers, max_buffers);
+    } else {
+        gst_query_add_allocation_pool(query, pool, size, min_buffers, max_buffers);
+    }
+    gst_object_unref(pool);
+    
+    return GST_BASE_TRANSFORM_CLASS(video_processor_parent_class)->decide_allocation(trans, query);
+}
+
+/**
+ * @brief Stop callback
+ */
+static gboolean video_processor_stop(GstBaseTransform* trans) {
+    VIDEO_PROCESSOR(trans)->info_valid = FALSE;
+    return TRUE;
+}
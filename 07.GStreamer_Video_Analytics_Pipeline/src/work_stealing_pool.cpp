@@ -0,0 +1,209 @@
+/**
+ * @file work_stealing_pool.cpp
+ * @brief Shared work-stealing pool implementation
+ */
+
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <iostream>
+
+/**
+ * @brief Constructor
+ */
+WorkLane::WorkLane(WorkStealingPool* pool, size_t capacity, size_t home)
+    : pool_(pool), capacity_(std::max<size_t>(1, capacity)), home_(home) {
+}
+
+/**
+ * @brief Queues a task
+ */
+bool WorkLane::submit(Task task) {
+    bool dropped = false;
+    bool wake = false;
+    Task stale;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+        if (tasks_.size() >= capacity_) {
+            // Destroyed after unlocking: a task may own expensive resources
+            stale = std::move(tasks_.front());
+            tasks_.pop_front();
+            dropped = true;
+        }
+        tasks_.push_back(std::move(task));
+        if (!scheduled_) {
+            scheduled_ = true;
+            wake = true;
+        }
+    }
+
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    if (dropped) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (wake) {
+        pool_->schedule(shared_from_this(), home_);
+    }
+    return !dropped;
+}
+
+/**
+ * @brief Returns the queued tasks
+ */
+size_t WorkLane::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+/**
+ * @brief Constructor
+ */
+WorkStealingPool::WorkStealingPool(int threads)
+    : count_(threads > 0 ? static_cast<size_t>(threads)
+                         : std::max(1u, std::thread::hardware_concurrency())),
+      deques_(std::make_unique<Deque[]>(count_)) {
+    workers_.reserve(count_);
+    for (size_t i = 0; i < count_; ++i) {
+        workers_.emplace_back(&WorkStealingPool::worker, this, i);
+    }
+}
+
+/**
+ * @brief Destructor
+ */
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Creates a lane
+ */
+std::shared_ptr<WorkLane> WorkStealingPool::createLane(size_t capacity) {
+    size_t home = next_home_.fetch_add(1, std::memory_order_relaxed) % count_;
+    return std::shared_ptr<WorkLane>(new WorkLane(this, capacity, home));
+}
+
+/**
+ * @brief Closes a lane
+ */
+void WorkStealingPool::closeLane(WorkLane& lane) {
+    std::deque<WorkLane::Task> discarded;
+    std::unique_lock<std::mutex> lock(lane.mutex_);
+    lane.closed_ = true;
+    std::swap(discarded, lane.tasks_);
+    // A queued token finds the lane closed and drops it
+    lane.idle_cv_.wait(lock, [&lane] { return !lane.running_; });
+}
+
+/**
+ * @brief Queues a runnable lane on a worker's deque
+ */
+void WorkStealingPool::schedule(std::shared_ptr<WorkLane> lane, size_t worker) {
+    {
+        std::lock_guard<std::mutex> lock(deques_[worker].mutex);
+        deques_[worker].lanes.push_back(std::move(lane));
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+
+    // Lock/unlock so a worker between its check and its wait cannot miss this
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    sleep_cv_.notify_one();
+}
+
+/**
+ * @brief Takes a lane from the own deque (front) or steals one (back)
+ */
+std::shared_ptr<WorkLane> WorkStealingPool::take(size_t self) {
+    for (size_t i = 0; i < count_; ++i) {
+        size_t victim = (self + i) % count_;
+        Deque& deque = deques_[victim];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (deque.lanes.empty()) {
+            continue;
+        }
+
+        std::shared_ptr<WorkLane> lane;
+        if (victim == self) {
+            lane = std::move(deque.lanes.front());
+            deque.lanes.pop_front();
+        } else {
+            lane = std::move(deque.lanes.back());
+            deque.lanes.pop_back();
+            steals_.fetch_add(1, std::memory_order_relaxed);
+        }
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return lane;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Runs one task of a lane and re-queues it if more are waiting
+ */
+void WorkStealingPool::runLane(size_t self, const std::shared_ptr<WorkLane>& lane) {
+    WorkLane::Task task;
+    {
+        std::lock_guard<std::mutex> lock(lane->mutex_);
+        if (lane->closed_ || lane->tasks_.empty()) {
+            lane->scheduled_ = false;
+            return;
+        }
+        task = std::move(lane->tasks_.front());
+        lane->tasks_.pop_front();
+        lane->running_ = true;
+    }
+
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "[WorkStealingPool] Task failed: " << e.what() << std::endl;
+    }
+    task = nullptr;
+
+    lane->executed_.fetch_add(1, std::memory_order_relaxed);
+    executed_.fetch_add(1, std::memory_order_relaxed);
+
+    bool again = false;
+    {
+        std::lock_guard<std::mutex> lock(lane->mutex_);
+        lane->running_ = false;
+        again = !lane->closed_ && !lane->tasks_.empty();
+        lane->scheduled_ = again;
+    }
+    lane->idle_cv_.notify_all();
+
+    // Back of the own deque: every other runnable lane gets a turn first
+    if (again) {
+        schedule(lane, self);
+    }
+}
+
+/**
+ * @brief Worker loop
+ */
+void WorkStealingPool::worker(size_t self) {
+    while (true) {
+        std::shared_ptr<WorkLane> lane = take(self);
+        if (lane) {
+            runLane(self, lane);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [this] {
+            return stop_ || queued_.load(std::memory_order_acquire) > 0;
+        });
+        if (stop_) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#include "color_adjust.h"
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Straight floating-point reference of the same transform
+static uint8_t refLuma(int y, double brightness, double contrast) {
+    long value = std::lround((y - 128) * contrast + 128.0 + brightness);
+    return static_cast<uint8_t>(std::min(255L, std::max(0L, value)));
+}
+
+static void refChroma(uint8_t u, uint8_t v, double saturation, double hue, int& ru, int& rv) {
+    double h = hue * M_PI / 180.0;
+    double du = u - 128.0, dv = v - 128.0;
+    ru = static_cast<int>(std::lround(128.0 + saturation * (std::cos(h) * du - std::sin(h) * dv)));
+    rv = static_cast<int>(std::lround(128.0 + saturation * (std::sin(h) * du + std::cos(h) * dv)));
+    ru = std::min(255, std::max(0, ru));
+    rv = std::min(255, std::max(0, rv));
+}
+
+static std::vector<uint8_t> noise(size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& p : data) p = static_cast<uint8_t>(rng() & 0xFF);
+    return data;
+}
+
+// Default parameters leave every plane untouched.
+static void test_identity() {
+    ColorAdjuster adjuster;
+    assert(adjuster.isIdentity());
+    const int w = 64, h = 32;
+    auto y = noise(w * h, 1), u = noise(w * h / 4, 2), v = noise(w * h / 4, 3);
+    auto y0 = y, u0 = u, v0 = v;
+    adjuster.applyPlanar(y.data(), w, u.data(), w / 2, v.data(), w / 2, w, h);
+    assert(y == y0 && u == u0 && v == v0);
+}
+
+// Luma table matches the reference for brightness/contrast.
+static void test_luma_table() {
+    ColorAdjuster adjuster;
+    adjuster.setParams(25.0, 1.4, 1.0, 0.0);
+    auto tables = adjuster.tables();
+    assert(!tables->luma_identity && tables->chroma_identity);
+    for (int i = 0; i < 256; ++i) {
+        assert(tables->luma[i] == refLuma(i, 25.0, 1.4));
+    }
+}
+
+// SIMD rows (odd widths exercise the scalar tail) stay within one level of
+// the floating-point reference, planar and interleaved alike.
+static void test_chroma_matches_reference() {
+    const double saturation = 1.6, hue = 35.0;
+    ColorAdjuster adjuster;
+    adjuster.setParams(0.0, 1.0, saturation, hue);
+    auto tables = adjuster.tables();
+
+    const int width = 77;
+    auto u = noise(width, 4), v = noise(width, 5);
+    std::vector<uint8_t> uv(2 * width);
+    for (int i = 0; i < width; ++i) {
+        uv[2 * i] = u[i];
+        uv[2 * i + 1] = v[i];
+    }
+    auto u0 = u, v0 = v;
+    ColorAdjuster::rotatePlanar(tables->uv_scale, tables->uv_rotate, u.data(), v.data(), width);
+    ColorAdjuster::rotateInterleaved(tables->uv_scale, tables->uv_rotate, uv.data(), width);
+
+    for (int i = 0; i < width; ++i) {
+        int ru, rv;
+        refChroma(u0[i], v0[i], saturation, hue, ru, rv);
+        assert(std::abs(u[i] - ru) <= 1 && std::abs(v[i] - rv) <= 1);
+        assert(uv[2 * i] == u[i] && uv[2 * i + 1] == v[i]);
+    }
+}
+
+// Saturation 0 gives neutral chroma; hue 180 mirrors it around 128.
+static void test_saturation_and_hue() {
+    const int w = 48, h = 16;
+    auto u = noise(w * h / 4, 6), v = noise(w * h / 4, 7);
+    std::vector<uint8_t> y(w * h, 100);
+
+    ColorAdjuster gray;
+    gray.setParams(0.0, 1.0, 0.0, 0.0);
+    auto gu = u, gv = v;
+    gray.applyPlanar(y.data(), w, gu.data(), w / 2, gv.data(), w / 2, w, h);
+    for (size_t i = 0; i < gu.size(); ++i) assert(gu[i] == 128 && gv[i] == 128);
+
+    ColorAdjuster flip;
+    flip.setParams(0.0, 1.0, 1.0, 180.0);
+    auto fu = u, fv = v;
+    flip.applyPlanar(y.data(), w, fu.data(), w / 2, fv.data(), w / 2, w, h);
+    for (size_t i = 0; i < fu.size(); ++i) {
+        assert(fu[i] == std::min(255, 256 - u[i]));
+        assert(fv[i] == std::min(255, 256 - v[i]));
+    }
+}
+
+// NV21 stores V first; the result must equal NV12 with the lanes swapped.
+static void test_nv21_matches_nv12() {
+    const int w = 40, h = 8;
+    ColorAdjuster adjuster;
+    adjuster.setParams(10.0, 1.1, 1.3, -50.0);
+    auto y = noise(w * h, 8), uv = noise(w * h / 2, 9);
+    std::vector<uint8_t> vu(uv.size());
+    for (size_t i = 0; i < uv.size(); i += 2) {
+        vu[i] = uv[i + 1];
+        vu[i + 1] = uv[i];
+    }
+    auto y12 = y, y21 = y;
+    adjuster.applySemiPlanar(y12.data(), w, uv.data(), w, w, h, false);
+    adjuster.applySemiPlanar(y21.data(), w, vu.data(), w, w, h, true);
+    assert(y12 == y21);
+    for (size_t i = 0; i < uv.size(); i += 2) {
+        assert(vu[i] == uv[i + 1] && vu[i + 1] == uv[i]);
+    }
+}
+
+// Row bands give the same frame as a single pass; odd sizes and strides
+// larger than the width are handled.
+static void test_threads_match_single() {
+    const int w = 333, h = 181, stride = 352, cstride = 176;
+    const int ch = (h + 1) / 2;
+    auto y = noise(stride * h, 10), u = noise(cstride * ch, 11), v = noise(cstride * ch, 12);
+
+    ColorAdjuster single;
+    single.setParams(-15.0, 1.25, 0.7, 20.0);
+    auto y1 = y, u1 = u, v1 = v;
+    single.applyPlanar(y1.data(), stride, u1.data(), cstride, v1.data(), cstride, w, h);
+
+    ColorAdjuster banded;
+    banded.setParams(-15.0, 1.25, 0.7, 20.0);
+    banded.setThreads(4);
+    auto y4 = y, u4 = u, v4 = v;
+    banded.applyPlanar(y4.data(), stride, u4.data(), cstride, v4.data(), cstride, w, h);
+
+    assert(y1 == y4 && u1 == u4 && v1 == v4);
+    // Padding past the width is not touched
+    for (int r = 0; r < h; ++r) {
+        for (int x = w; x < stride; ++x) assert(y1[r * stride + x] == y[r * stride + x]);
+    }
+}
+
+int main() {
+    test_identity();
+    test_luma_table();
+    test_chroma_matches_reference();
+    test_saturation_and_hue();
+    test_nv21_matches_nv12();
+    test_threads_match_single();
+    std::cout << "test_color_adjust: OK\n";
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "color_adjust.h"
+#include "filter_chain.h"
+#include "video_processor.h"
+#include <cassert>
+#include <iostream>
+#include <random>
+
+static ProcessingParams chainParams(std::vector<FilterStage> stages) {
+    ProcessingParams params;
+    params.filter_type = FilterType::CHAIN;
+    params.filter_chain = std::move(stages);
+    return params;
+}
+
+// Crop then scale gives the scale size; rotate/flip keep the size.
+static void test_output_size() {
+    ProcessingParams params = chainParams({FilterStage::CROP, FilterStage::ROTATE,
+                                           FilterStage::FLIP, FilterStage::DENOISE});
+    params.crop_x = 100;
+    params.crop_y = 50;
+    params.crop_width = 641;
+    params.crop_height = 360;
+    params.rotation = 90;
+    params.flip_horizontal = true;
+    int w = 0, h = 0;
+    filterChainOutputSize(params, 1920, 1080, w, h);
+    assert(w == 640 && h == 360);
+
+    params.filter_chain.push_back(FilterStage::SCALE);
+    params.scale_width = 320;
+    params.scale_height = 180;
+    filterChainOutputSize(params, 1920, 1080, w, h);
+    assert(w == 320 && h == 180);
+}
+
+// Crop rectangles are clamped to the frame; a zero crop is a no-op.
+static void test_crop_clamped() {
+    ProcessingParams params = chainParams({FilterStage::CROP});
+    params.crop_x = 600;
+    params.crop_y = 400;
+    params.crop_width = 200;
+    params.crop_height = 200;
+    int w = 0, h = 0;
+    filterChainOutputSize(params, 640, 480, w, h);
+    assert(w == 40 && h == 80);
+
+    params.crop_width = 0;
+    filterChainOutputSize(params, 640, 480, w, h);
+    assert(w == 640 && h == 480);
+}
+
+#ifdef HAVE_OPENCV
+static cv::Mat noiseImage(cv::Size size) {
+    cv::Mat image(size, CV_8UC3);
+    std::mt19937 rng(5);
+    for (int y = 0; y < image.rows; ++y) {
+        uint8_t* row = image.ptr<uint8_t>(y);
+        for (int x = 0; x < image.cols * 3; ++x) row[x] = static_cast<uint8_t>(rng());
+    }
+    cv::GaussianBlur(image, image, cv::Size(9, 9), 0); // Some structure for the filters
+    return image;
+}
+
+static double maxDifference(const cv::Mat& a, const cv::Mat& b) {
+    return cv::norm(a, b, cv::NORM_INF);
+}
+
+// Tiled blur -> sharpen on several threads equals the whole-frame filters.
+static void test_tiled_matches_whole_frame() {
+    ProcessingParams params = chainParams({FilterStage::BLUR, FilterStage::SHARPEN});
+    params.blur_kernel_size = 7;
+    cv::Mat src = noiseImage(cv::Size(613, 301)); // Partial tiles on both axes
+
+    FilterChain chain;
+    chain.configure(params, src.size());
+    chain.setThreads(3);
+    cv::Mat dst(chain.outputSize(), CV_8UC3);
+    chain.run(src, dst);
+
+    cv::Mat blurred, expected;
+    cv::GaussianBlur(src, blurred, cv::Size(7, 7), 0);
+    float k[9] = {0, -1, 0, -1, 6, -1, 0, -1, 0};
+    cv::filter2D(blurred, expected, -1, cv::Mat(3, 3, CV_32F, k));
+    assert(maxDifference(dst, expected) == 0);
+}
+
+// Crop + rotate + flip fuse into one warp that matches the separate passes.
+static void test_geometry_fused() {
+    ProcessingParams params = chainParams({FilterStage::CROP, FilterStage::ROTATE, FilterStage::FLIP});
+    params.crop_x = 40;
+    params.crop_y = 20;
+    params.crop_width = 400;
+    params.crop_height = 240;
+    params.rotation = 30;
+    params.flip_vertical = true;
+    cv::Mat src = noiseImage(cv::Size(640, 360));
+
+    FilterChain chain;
+    chain.configure(params, src.size());
+    auto timings = chain.timings();
+    assert(timings.size() == 1 && timings[0].name == "crop+rotate+flip");
+
+    cv::Mat dst(chain.outputSize(), CV_8UC3);
+    chain.run(src, dst);
+
+    cv::Mat cropped = src(cv::Rect(40, 20, 400, 240)).clone();
+    cv::Mat rotated, expected;
+    // The fused warp keeps the crop's replicated border
+    cv::warpAffine(cropped, rotated, cv::getRotationMatrix2D(cv::Point2f(200, 120), 30, 1.0), cropped.size(),
+                   cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    cv::flip(rotated, expected, 0);
+    // Single resampling versus crop copy + warp: fixed-point rounding only
+    assert(maxDifference(dst, expected) <= 1);
+}
+
+// Grayscale and colour adjust fuse into one op; grayscale output is neutral.
+static void test_color_fused() {
+    ProcessingParams params = chainParams({FilterStage::COLOR_ADJUST, FilterStage::GRAYSCALE});
+    params.brightness = 10;
+    params.contrast = 1.2;
+    params.saturation = 1.5;
+    params.hue = 40;
+    cv::Mat src = noiseImage(cv::Size(300, 200));
+
+    FilterChain chain;
+    chain.configure(params, src.size());
+    assert(chain.timings().size() == 1);
+
+    cv::Mat dst(src.size(), CV_8UC3);
+    chain.run(src, dst);
+    for (int y = 0; y < dst.rows; ++y) {
+        for (int x = 0; x < dst.cols; ++x) {
+            cv::Vec3b p = dst.at<cv::Vec3b>(y, x);
+            assert(std::abs(p[0] - p[1]) <= 1 && std::abs(p[1] - p[2]) <= 1);
+        }
+    }
+}
+
+// Hue in the chain turns BGR the way the single filter turns I420 Cb/Cr.
+static void test_hue_matches_single_filter() {
+    // Flat 16x16 patches, so 4:2:0 chroma subsampling averages nothing
+    const cv::Vec3b colours[] = {
+        {60, 120, 180}, {180, 120, 60}, {90, 160, 110}, {150, 90, 140},
+        {128, 128, 128}, {100, 110, 170}, {170, 140, 90}, {120, 70, 100},
+    };
+    cv::Mat src(32, 64, CV_8UC3);
+    for (int i = 0; i < 8; ++i) {
+        src(cv::Rect((i % 4) * 16, (i / 4) * 16, 16, 16)).setTo(cv::Scalar(colours[i][0], colours[i][1], colours[i][2]));
+    }
+
+    for (double hue : {40.0, -75.0}) {
+        ProcessingParams params = chainParams({FilterStage::COLOR_ADJUST});
+        params.hue = hue;
+        FilterChain chain;
+        chain.configure(params, src.size());
+        cv::Mat dst(src.size(), CV_8UC3);
+        chain.run(src, dst);
+
+        cv::Mat yuv, expected;
+        cv::cvtColor(src, yuv, cv::COLOR_BGR2YUV_I420);
+        const int w = src.cols, h = src.rows;
+        uint8_t* y = yuv.data;
+        uint8_t* u = y + w * h;
+        uint8_t* v = u + w * h / 4;
+        ColorAdjuster adjuster;
+        adjuster.setParams(0.0, 1.0, 1.0, hue);
+        adjuster.applyPlanar(y, w, u, w / 2, v, w / 2, w, h);
+        cv::cvtColor(yuv, expected, cv::COLOR_YUV2BGR_I420);
+        // YUV round trip and Q12 rounding; analog U/V scalings are off by 9+
+        assert(maxDifference(dst, expected) <= 3);
+    }
+}
+#endif
+
+int main() {
+    test_output_size();
+    test_crop_clamped();
+#ifdef HAVE_OPENCV
+    test_tiled_matches_whole_frame();
+    test_geometry_fused();
+    test_color_fused();
+    test_hue_matches_single_filter();
+#endif
+    std::cout << "test_filter_chain: OK\n";
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "gop_ring.h"
+#include <cassert>
+#include <iostream>
+
+static int released = 0;
+
+// 30 fps stream, keyframe every `gop` frames, `size` bytes per frame.
+static EncodedUnit frame(int n, int gop, size_t size = 1000) {
+    EncodedUnit unit;
+    unit.buffer = std::shared_ptr<GstBuffer>(nullptr, [](GstBuffer*) { released++; });
+    unit.pts = static_cast<GstClockTime>(n) * GST_SECOND / 30;
+    unit.size = size;
+    unit.keyframe = n % gop == 0;
+    return unit;
+}
+
+// Delta frames before the first keyframe are never stored.
+static void test_starts_at_keyframe() {
+    GopRing ring(2 * GST_SECOND, 1 << 20);
+    for (int n = 25; n < 35; ++n) ring.push(frame(n, 30));
+    assert(ring.size() == 5 && ring.gops() == 1);
+    std::vector<EncodedUnit> units = ring.drain();
+    assert(units.front().keyframe && units.front().pts == GST_SECOND);
+    assert(ring.size() == 0);
+}
+
+// The ring keeps at least the window, evicting whole GOPs only.
+static void test_window() {
+    GopRing ring(2 * GST_SECOND, 1 << 20);
+    for (int n = 0; n < 30 * 10; ++n) ring.push(frame(n, 30));
+    assert(ring.duration() >= 2 * GST_SECOND);
+    assert(ring.duration() < 3 * GST_SECOND);
+    std::vector<EncodedUnit> units = ring.drain();
+    assert(units.front().keyframe);
+    assert(units.size() == 90);  // 2 full GOPs + the current one (1 s each)
+}
+
+// The byte budget wins over the window; evicted buffers are released.
+static void test_byte_budget() {
+    released = 0;
+    GopRing ring(60 * GST_SECOND, 75000);
+    for (int n = 0; n < 30 * 5; ++n) ring.push(frame(n, 30));
+    assert(ring.bytes() <= 75000);
+    assert(ring.gops() == 2 && ring.size() == 60);
+    assert(ring.budgetEvictions() == 3);
+    assert(released == 90);
+}
+
+// A GOP larger than the budget is dropped until the next keyframe.
+static void test_oversized_gop() {
+    GopRing ring(10 * GST_SECOND, 20000);
+    for (int n = 0; n < 30; ++n) ring.push(frame(n, 30));
+    assert(ring.size() == 0 && ring.budgetEvictions() == 1);
+    for (int n = 30; n < 40; ++n) ring.push(frame(n, 30));
+    assert(ring.size() == 10 && ring.gops() == 1);
+    std::vector<EncodedUnit> units = ring.drain();
+    assert(units.front().keyframe && units.front().pts == GST_SECOND);
+}
+
+// After a drain, deltas of the drained GOP are skipped until a keyframe.
+static void test_drain_resyncs() {
+    GopRing ring(2 * GST_SECOND, 1 << 20);
+    for (int n = 0; n < 10; ++n) ring.push(frame(n, 30));
+    ring.drain();
+    for (int n = 10; n < 31; ++n) ring.push(frame(n, 30));
+    assert(ring.size() == 1 && ring.gops() == 1);
+}
+
+int main() {
+    test_starts_at_keyframe();
+    test_window();
+    test_byte_budget();
+    test_oversized_gop();
+    test_drain_resyncs();
+    std::cout << "test_gop_ring: OK\n";
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "metrics_registry.h"
+#include "metrics_server.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static bool contains(const std::string& text, const std::string& line) {
+    return text.find(line) != std::string::npos;
+}
+
+// Concurrent increments from several threads all land in the total.
+static void test_counter_threads() {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) counter.inc();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    assert(counter.value() == 80000);
+}
+
+// Buckets are cumulative and use upper-inclusive bounds.
+static void test_histogram_buckets() {
+    Histogram histogram({1.0, 5.0, 10.0});
+    for (double v : {0.5, 1.0, 3.0, 7.0, 50.0}) histogram.observe(v);
+    Histogram::Snapshot snap = histogram.snapshot();
+    assert(snap.count == 5);
+    assert(snap.sum == 61.5);
+    assert((snap.buckets == std::vector<uint64_t>{2, 3, 4, 5}));
+}
+
+// Text format: HELP/TYPE once per family, labels escaped, collectors polled.
+static void test_render() {
+    MetricsRegistry registry;
+    Counter dropped;
+    dropped.inc(3);
+    Gauge fps;
+    fps.set(29.5);
+    Histogram time({0.01, 0.1});
+    time.observe(0.05);
+    Counter a, b;
+    a.inc();
+    b.inc(2);
+
+    registry.addCounter("dropped_total", "Dropped frames", dropped);
+    registry.addGauge("fps", "Current FPS", fps);
+    registry.addHistogram("frame_seconds", "Frame time", time);
+    registry.addCounter("events_total", "Events", a, {{"kind", "enter"}});
+    registry.addCounter("events_total", "Events", b, {{"kind", "say \"hi\""}});
+    int polls = 0;
+    registry.addCollector("queue_level", "Queue level", MetricType::GAUGE,
+                          [&polls](std::vector<MetricSample>& samples) {
+        polls++;
+        samples.push_back({{{"branch", "main"}}, 4});
+    });
+
+    std::string text = registry.render();
+    assert(contains(text, "# TYPE dropped_total counter\ndropped_total 3\n"));
+    assert(contains(text, "fps 29.5\n"));
+    assert(contains(text, "# TYPE frame_seconds histogram\n"));
+    assert(contains(text, "frame_seconds_bucket{le=\"0.01\"} 0\n"));
+    assert(contains(text, "frame_seconds_bucket{le=\"0.1\"} 1\n"));
+    assert(contains(text, "frame_seconds_bucket{le=\"+Inf\"} 1\n"));
+    assert(contains(text, "frame_seconds_count 1\n"));
+    assert(text.find("# HELP events_total") == text.rfind("# HELP events_total"));
+    assert(contains(text, "events_total{kind=\"enter\"} 1\n"));
+    assert(contains(text, "events_total{kind=\"say \\\"hi\\\"\"} 2\n"));
+    assert(contains(text, "queue_level{branch=\"main\"} 4\n"));
+    assert(polls == 1);
+}
+
+static std::string httpGet(int port, const std::string& path) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int connected = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    assert(connected == 0);
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ssize_t sent = ::send(fd, request.data(), request.size(), 0);
+    assert(sent == static_cast<ssize_t>(request.size()));
+    std::string response;
+    char chunk[1024];
+    ssize_t n;
+    while ((n = ::recv(fd, chunk, sizeof(chunk), 0)) > 0) response.append(chunk, n);
+    ::close(fd);
+    return response;
+}
+
+// The endpoint serves /metrics and rejects other paths.
+static void test_server() {
+    MetricsRegistry registry;
+    Counter frames;
+    frames.inc(7);
+    registry.addCounter("frames_total", "Frames", frames);
+
+    MetricsServer server(registry);
+    if (!server.start(0, "127.0.0.1")) {
+        std::cout << "test_metrics_registry: no loopback socket, server test skipped\n";
+        return;
+    }
+    std::string ok = httpGet(server.port(), "/metrics");
+    assert(contains(ok, "HTTP/1.1 200 OK\r\n"));
+    assert(contains(ok, "version=0.0.4"));
+    assert(contains(ok, "\r\n\r\n# HELP frames_total Frames\n# TYPE frames_total counter\nframes_total 7\n"));
+    assert(contains(httpGet(server.port(), "/"), "HTTP/1.1 404"));
+    server.stop();
+    assert(!server.isRunning());
+}
+
+int main() {
+    test_counter_threads();
+    test_histogram_buckets();
+    test_render();
+    test_server();
+    std::cout << "test_metrics_registry: OK\n";
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "motion_tracker.h"
+#include <cassert>
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static MotionRegion blob(int x, int y, int w = 60, int h = 60) {
+    MotionRegion r{};
+    r.x = x; r.y = y; r.width = w; r.height = h;
+    r.intensity = 0.5;
+    return r;
+}
+
+static int count(const std::vector<MotionTrackEvent>& events, MotionEventType type) {
+    int n = 0;
+    for (const auto& e : events) n += (e.type == type);
+    return n;
+}
+
+// A blob crossing the frame: one ENTER after confirmation, a few UPDATEs,
+// one EXIT after it disappears, always with the same ID.
+static void test_enter_update_exit() {
+    MotionTrackerParams params;
+    params.confirm_frames = 3;
+    params.max_missed_frames = 5;
+    params.update_interval = 10;
+    params.update_distance = 1000.0;
+    MotionTracker tracker(params);
+
+    std::vector<MotionTrackEvent> all;
+    for (int t = 0; t < 40; ++t) {
+        auto ev = tracker.update({ blob(100 + t * 6, 200) }, t);
+        all.insert(all.end(), ev.begin(), ev.end());
+        if (t == 1) assert(all.empty());            // Not confirmed yet
+    }
+    for (int t = 40; t < 50; ++t) {
+        auto ev = tracker.update({}, t);
+        all.insert(all.end(), ev.begin(), ev.end());
+    }
+
+    assert(count(all, MotionEventType::ENTER) == 1);
+    assert(count(all, MotionEventType::EXIT) == 1);
+    // Confirmed at t=2, periodic updates at t=12, 22, 32
+    assert(count(all, MotionEventType::UPDATE) == 3);
+    assert(all.front().type == MotionEventType::ENTER && all.front().timestamp == 2);
+    assert(all.back().type == MotionEventType::EXIT && all.back().timestamp == 45);
+    for (const auto& e : all) assert(e.track_id == all.front().track_id);
+    assert(tracker.confirmedTracks() == 0);
+}
+
+// Single-frame flicker never reaches confirmation and produces no events.
+static void test_flicker_suppressed() {
+    MotionTracker tracker;
+    int events = 0;
+    for (int t = 0; t < 30; ++t) {
+        std::vector<MotionRegion> regions;
+        if (t % 2 == 0) regions.push_back(blob(500, 300));
+        events += static_cast<int>(tracker.update(regions, t).size());
+    }
+    assert(events == 0);
+}
+
+// A short gap (shorter than max_missed_frames) keeps the track alive.
+static void test_gap_keeps_id() {
+    MotionTrackerParams params;
+    params.max_missed_frames = 4;
+    params.update_interval = 0;
+    params.update_distance = 10.0;
+    MotionTracker tracker(params);
+
+    std::vector<MotionTrackEvent> all;
+    for (int t = 0; t < 30; ++t) {
+        std::vector<MotionRegion> regions;
+        if (t < 10 || t >= 13) regions.push_back(blob(50 + t * 4, 100));
+        auto ev = tracker.update(regions, t);
+        all.insert(all.end(), ev.begin(), ev.end());
+    }
+    assert(count(all, MotionEventType::ENTER) == 1);
+    assert(count(all, MotionEventType::EXIT) == 0);
+    assert(count(all, MotionEventType::UPDATE) > 0);
+    for (const auto& e : all) assert(e.track_id == all.front().track_id);
+}
+
+// Two blobs moving in opposite directions on separate rows keep their IDs.
+static void test_two_blobs_distinct_ids() {
+    MotionTracker tracker;
+    int id_top = -1, id_bottom = -1;
+    for (int t = 0; t < 30; ++t) {
+        auto ev = tracker.update({ blob(100 + t * 8, 100), blob(700 - t * 8, 400) }, t);
+        for (const auto& e : ev) {
+            if (e.type != MotionEventType::ENTER) continue;
+            if (e.region.y == 100) id_top = e.track_id;
+            else id_bottom = e.track_id;
+        }
+    }
+    assert(id_top > 0 && id_bottom > 0 && id_top != id_bottom);
+    assert(tracker.confirmedTracks() == 2);
+}
+
+// Fast motion without overlap is still associated through the centroid.
+static void test_centroid_fallback() {
+    MotionTrackerParams params;
+    params.max_centroid_distance = 100.0;
+    params.update_interval = 0;
+    params.update_distance = 1e9;
+    MotionTracker tracker(params);
+    int enters = 0;
+    for (int t = 0; t < 20; ++t) {
+        auto ev = tracker.update({ blob(t * 70, 100, 50, 50) }, t);
+        enters += count(ev, MotionEventType::ENTER);
+    }
+    assert(enters == 1);
+}
+
+// The dispatcher delivers in order on its own thread and drops the oldest
+// events once the bound is exceeded.
+static void test_dispatcher_bounded() {
+    std::vector<int> delivered;
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+    std::thread::id caller = std::this_thread::get_id();
+    bool other_thread = true;
+
+    TrackEventDispatcher dispatcher(4);
+    dispatcher.setCallback([&](const MotionTrackEvent& e) {
+        started = true;
+        while (!release) std::this_thread::yield();
+        other_thread = other_thread && std::this_thread::get_id() != caller;
+        delivered.push_back(e.track_id);
+    });
+
+    auto make = [](int id) {
+        MotionTrackEvent e{};
+        e.type = MotionEventType::UPDATE;
+        e.track_id = id;
+        return e;
+    };
+
+    // First event is taken by the dispatcher and blocks in the callback
+    dispatcher.push({ make(0) });
+    while (!started) std::this_thread::yield();
+    size_t dropped = 0;
+    for (int id = 1; id <= 10; ++id) dropped += dispatcher.push({ make(id) });
+    assert(dropped == 6);
+
+    release = true;
+    dispatcher.stop();
+    assert(other_thread);
+    assert((delivered == std::vector<int>{0, 7, 8, 9, 10}));
+}
+
+int main() {
+    test_enter_update_exit();
+    test_flicker_suppressed();
+    test_gap_keeps_id();
+    test_two_blobs_distinct_ids();
+    test_centroid_fallback();
+    test_dispatcher_bounded();
+    std::cout << "test_motion_tracker: OK\n";
+    return 0;
+}
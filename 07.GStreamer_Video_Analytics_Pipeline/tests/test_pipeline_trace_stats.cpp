@@ -0,0 +1,136 @@
+#include "pipeline_trace_stats.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+static const uint64_t kMs = 1000000;
+
+// Percentiles come from the bucket upper bounds and never exceed the maximum.
+static void test_summary() {
+    ElementTrace trace("/GstPipeline:p/GstVideoConvert:convert", "videoconvert", false);
+    for (int i = 0; i < 98; ++i) trace.recordProcessing(1 * kMs);
+    trace.recordProcessing(30 * kMs);
+    trace.recordProcessing(40 * kMs);
+
+    TraceSummary summary = trace.processing();
+    assert(summary.count == 100);
+    assert(summary.max == 40.0);
+    assert(summary.p50 >= 1.0 && summary.p50 < 2.0);
+    assert(summary.p95 == summary.p50);
+    assert(summary.p99 >= 30.0 && summary.p99 <= 40.0);
+    assert(summary.mean > 1.6 && summary.mean < 1.8);
+    assert(trace.latency().count == 0);
+}
+
+// Queue level and wait; frames overtaken by a later one were dropped.
+static void test_queue() {
+    ElementTrace queue("/GstPipeline:p/GstQueue:q", "queue", true);
+    int frames[4];
+    queue.enqueue(&frames[0], 100, 0 * kMs, 1);
+    queue.enqueue(&frames[1], 100, 1 * kMs, 2);
+    queue.enqueue(&frames[2], 100, 2 * kMs, 3);
+
+    uint64_t buffers = 0, bytes = 0;
+    queue.queueLevel(buffers, bytes);
+    assert(buffers == 3 && bytes == 300);
+    assert(queue.maxQueueLevel() == 3);
+
+    uint64_t origin = 0;
+    bool left = queue.dequeue(&frames[0], 5 * kMs, origin);
+    assert(left && origin == 1);
+    // frames[1] leaked away: frames[2] leaves next and takes it along
+    left = queue.dequeue(&frames[2], 6 * kMs, origin);
+    assert(left && origin == 3);
+    queue.queueLevel(buffers, bytes);
+    assert(buffers == 0 && bytes == 0);
+    // Never seen entering
+    left = queue.dequeue(&frames[3], 7 * kMs, origin);
+    assert(!left);
+
+    TraceSummary wait = queue.queueWait();
+    assert(wait.count == 2 && wait.max == 5.0);
+    Histogram::Snapshot levels = queue.queueLevelHistogram();
+    assert(levels.count == 3 && levels.buckets[0] == 1 && levels.buckets[2] == 3);
+}
+
+// Source history is bounded; the first push of a PTS wins.
+static void test_source_history() {
+    PipelineTraceStats stats;
+    stats.recordSource(40, 1000);
+    stats.recordSource(40, 2000);
+    uint64_t ts = 0;
+    assert(stats.sourceTime(40, ts) && ts == 1000);
+    for (uint64_t pts = 100; pts < 1000; ++pts) stats.recordSource(pts, pts);
+    assert(!stats.sourceTime(40, ts));
+    assert(stats.sourceTime(999, ts) && ts == 999);
+    assert(!stats.sourceTime(12345, ts));
+}
+
+// One trace per path, shared by concurrent callers.
+static void test_element_lookup() {
+    PipelineTraceStats stats;
+    std::vector<std::thread> threads;
+    std::vector<ElementTrace*> seen(4);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&stats, &seen, t] {
+            ElementTrace* trace = stats.element("/p/sink", "fakesink", false);
+            for (int i = 0; i < 1000; ++i) trace->recordLatency(2 * kMs);
+            seen[t] = trace;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (ElementTrace* trace : seen) assert(trace == seen[0]);
+    assert(seen[0]->latency().count == 4000);
+    assert(stats.summaryLines().size() == 1);
+}
+
+// Log lines and the JSON report name every element; queues get a queue section.
+static void test_report() {
+    PipelineTraceStats stats;
+    stats.element("/p/src", "videotestsrc", false)->recordProcessing(kMs / 2);
+    ElementTrace* queue = stats.element("/p/q\"1", "queue", true);
+    int frame;
+    queue->enqueue(&frame, 6220800, 0, 0);
+
+    std::vector<std::string> lines = stats.summaryLines();
+    assert(lines.size() == 2);
+    assert(contains(lines[0], "/p/src: 1 frames"));
+    assert(contains(lines[1], "level 1 (6220800 B, max 1)"));
+
+    std::string json = stats.toJson();
+    assert(contains(json, "\"path\": \"/p/src\", \"factory\": \"videotestsrc\""));
+    assert(contains(json, "\"path\": \"/p/q\\\"1\""));
+    assert(contains(json, "\"level_bytes\": 6220800"));
+    assert(contains(json, "[\"+Inf\", 0]"));
+    assert(json.find("\"queue\": {") == json.rfind("\"queue\": {"));
+
+    const char* path = "test_pipeline_trace.json";
+    bool written_ok = stats.writeJson(path);
+    assert(written_ok);
+    std::ifstream file(path);
+    std::stringstream written;
+    written << file.rdbuf();
+    assert(written.str() == json);
+    std::remove(path);
+    written_ok = stats.writeJson("/nonexistent/dir/trace.json");
+    assert(!written_ok);
+}
+
+int main() {
+    test_summary();
+    test_queue();
+    test_source_history();
+    test_element_lookup();
+    test_report();
+    std::cout << "test_pipeline_trace_stats: OK\n";
+    return 0;
+}
@@ -0,0 +1,462 @@
+#include "appsrc_bridge.h"
+#include "rtsp_streamer.h"
+#include <glib/gstdio.h>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Exit code CTest reports as skipped (SKIP_RETURN_CODE in tests/CMakeLists.txt).
+static const int kSkipped = 77;
+
+// Returns true if every element factory is installed, else names the first missing one.
+static bool haveElements(std::initializer_list<const char*> names) {
+    for (const char* name : names) {
+        GstElementFactory* factory = gst_element_factory_find(name);
+        if (!factory) {
+            std::cout << "missing GStreamer element " << name << ", skipping\n";
+            return false;
+        }
+        gst_object_unref(factory);
+    }
+    return true;
+}
+
+static void sleepMs(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static GstElement* launch(const std::string& description) {
+    GError* error = nullptr;
+    GstElement* pipeline = gst_parse_launch(description.c_str(), &error);
+    if (error) {
+        std::cerr << description << ": " << error->message << "\n";
+        g_error_free(error);
+    }
+    assert(pipeline);
+    return pipeline;
+}
+
+static GstElement* byName(GstElement* pipeline, const char* name) {
+    GstElement* element = gst_bin_get_by_name(GST_BIN(pipeline), name);
+    assert(element);
+    return element;
+}
+
+static void stopPipeline(GstElement* pipeline) {
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+}
+
+// A 30 fps live producer ending in an appsink, as the processed branch does.
+static GstElement* producer() {
+    return launch("videotestsrc is-live=true pattern=ball ! "
+                  "video/x-raw,format=I420,width=320,height=240,framerate=30/1 ! "
+                  "appsink name=sink max-buffers=2 drop=true");
+}
+
+struct FirstPts {
+    GstClockTime pts = GST_CLOCK_TIME_NONE;
+    guint64 frames = 0;
+};
+
+static GstPadProbeReturn countBuffer(GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+    FirstPts* seen = static_cast<FirstPts*>(user_data);
+    if (seen->frames++ == 0) {
+        seen->pts = GST_BUFFER_PTS(GST_PAD_PROBE_INFO_BUFFER(info));
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// A consumer at 5 fps neither slows the producer nor grows its queue;
+// caps come from the producer and timestamps start at zero.
+static void test_slow_consumer() {
+    AppSrcBridge bridge(3);
+    GstElement* source = producer();
+    GstElement* sink = byName(source, "sink");
+    bridge.attachSink(sink);
+    gst_element_set_state(source, GST_STATE_PLAYING);
+    sleepMs(1000);
+
+    GstElement* consumer = launch("appsrc name=src ! identity sleep-time=200000 ! fakesink name=out sync=false");
+    GstElement* src = byName(consumer, "src");
+    GstElement* out = byName(consumer, "out");
+    FirstPts seen;
+    GstPad* pad = gst_element_get_static_pad(out, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, countBuffer, &seen, nullptr);
+    gst_object_unref(pad);
+    bridge.addTarget(src);
+    gst_element_set_state(consumer, GST_STATE_PLAYING);
+
+    guint64 before = bridge.samples();
+    sleepMs(2000);
+    guint64 produced = bridge.samples() - before;
+
+    guint64 level = 0;
+    g_object_get(src, "current-level-buffers", &level, nullptr);
+    GstCaps* caps = gst_app_src_get_caps(GST_APP_SRC(src));
+    std::cout << "slow consumer: " << produced << " produced, " << seen.frames << " consumed, level "
+              << level << ", first pts " << seen.pts / 1000000 << " ms\n";
+    assert(produced >= 50);
+    assert(seen.frames > 0 && seen.frames < produced / 2);
+    assert(level <= 3);
+    assert(seen.pts < 100 * GST_MSECOND);
+    assert(caps);
+    GstStructure* structure = gst_caps_get_structure(caps, 0);
+    gint width = 0;
+    gboolean has_width = gst_structure_get_int(structure, "width", &width);
+    assert(has_width && width == 320);
+    gst_caps_unref(caps);
+
+    bool removed = bridge.removeTarget(src);
+    bool removed_again = bridge.removeTarget(src);
+    assert(removed && !removed_again);
+    assert(bridge.targetCount() == 0);
+
+    gst_object_unref(src);
+    gst_object_unref(out);
+    stopPipeline(consumer);
+    gst_object_unref(sink);
+    stopPipeline(source);
+}
+
+// Encoded frames per second at the payloader of the shared media.
+static double encodedFps(RTSPStreamer& streamer, int ms) {
+    guint64 before = streamer.getStats().total_frames_sent;
+    sleepMs(ms);
+    return (streamer.getStats().total_frames_sent - before) * 1000.0 / ms;
+}
+
+// One shared media encodes once: 10 clients cost the same encode rate as 1.
+static void test_shared_media() {
+    RTSPConfig config;
+    config.address = "127.0.0.1";
+    config.port = 18554;
+    config.enable_audio = false;
+    config.encoder = "x264enc";
+    config.bitrate = 500000;
+    RTSPStreamer streamer(config);
+
+    GstElement* source = producer();
+    GstElement* sink = byName(source, "sink");
+    streamer.setVideoSource(sink);
+    MetricsRegistry registry;
+    streamer.registerMetrics(registry);
+    bool started = streamer.start();
+    assert(started);
+    gst_element_set_state(source, GST_STATE_PLAYING);
+
+    const std::string client = "rtspsrc location=" + streamer.getStreamURL() +
+                               " latency=0 ! rtph264depay ! fakesink sync=false";
+    std::vector<GstElement*> clients;
+    clients.push_back(launch(client));
+    gst_element_set_state(clients.back(), GST_STATE_PLAYING);
+    sleepMs(2000);
+    double one = encodedFps(streamer, 2000);
+
+    for (int i = 1; i < 10; ++i) {
+        clients.push_back(launch(client));
+        gst_element_set_state(clients.back(), GST_STATE_PLAYING);
+    }
+    sleepMs(2000);
+    double ten = encodedFps(streamer, 2000);
+
+    std::string metrics = registry.render();
+    std::cout << "encoded fps: 1 client " << one << ", 10 clients " << ten << "\n";
+    assert(one > 20.0 && one < 40.0);
+    assert(ten > one * 0.8 && ten < one * 1.2);
+    assert(metrics.find("rtsp_bridge_media 1") != std::string::npos);
+
+    for (GstElement* pipeline : clients) {
+        stopPipeline(pipeline);
+    }
+    streamer.stop();
+    gst_object_unref(sink);
+    stopPipeline(source);
+}
+
+static RungStats rung(RTSPStreamer& streamer, const std::string& name) {
+    for (const auto& stats : streamer.getRungStats()) {
+        if (stats.name == name) {
+            return stats;
+        }
+    }
+    assert(false && "rung not found");
+    return {};
+}
+
+// Only watched rungs encode; subscribers are counted per rung.
+static void test_simulcast() {
+    RTSPConfig config;
+    config.address = "127.0.0.1";
+    config.port = 18555;
+    config.enable_audio = false;
+    config.simulcast.push_back(RTSPStreamer::profileRung(StreamProfile::LOW, config));
+    config.simulcast.push_back({"tiny", 160, 120, 200000});
+    RTSPStreamer streamer(config);
+
+    GstElement* source = producer();
+    GstElement* sink = byName(source, "sink");
+    streamer.setVideoSource(sink);
+    bool started = streamer.start();
+    assert(started);
+    gst_element_set_state(source, GST_STATE_PLAYING);
+    sleepMs(1000);
+    assert(!rung(streamer, "low").encoding && !rung(streamer, "tiny").encoding);
+    assert(rung(streamer, "low").mount == "/live/low");
+
+    std::vector<GstElement*> clients;
+    for (int i = 0; i < 2; ++i) {
+        clients.push_back(launch("rtspsrc location=rtsp://127.0.0.1:18555/live/tiny latency=0 ! "
+                                 "rtph264depay ! fakesink sync=false"));
+        gst_element_set_state(clients.back(), GST_STATE_PLAYING);
+    }
+    sleepMs(3000);
+
+    RungStats tiny = rung(streamer, "tiny");
+    RungStats low = rung(streamer, "low");
+    std::cout << "simulcast: tiny " << tiny.subscribers << " clients, " << tiny.encoded_frames
+              << " frames, " << tiny.avg_encode_ms << " ms/frame; low "
+              << (low.encoding ? "encoding" : "idle") << "\n";
+    assert(tiny.encoding && tiny.subscribers == 2);
+    assert(tiny.encoded_frames > 30 && tiny.avg_encode_ms > 0.0);
+    assert(!low.encoding && low.subscribers == 0 && low.encoded_frames == 0);
+    assert(streamer.getStats().total_frames_sent >= tiny.encoded_frames);
+
+    for (GstElement* pipeline : clients) {
+        stopPipeline(pipeline);
+    }
+    sleepMs(1000);
+    tiny = rung(streamer, "tiny");
+    assert(tiny.subscribers == 0 && !tiny.encoding);
+
+    streamer.stop();
+    gst_object_unref(sink);
+    stopPipeline(source);
+}
+
+// UDP bytes per second the server sends (all media, all sinks).
+static double egressRate(RTSPStreamer& streamer, int ms) {
+    guint64 before = streamer.getStats().udp_bytes_sent;
+    sleepMs(ms);
+    return (streamer.getStats().udp_bytes_sent - before) * 1000.0 / ms;
+}
+
+static GstElement* rtspClient(const std::string& url, const std::string& protocols, FirstPts& seen) {
+    GstElement* pipeline = launch("rtspsrc location=" + url + " protocols=" + protocols +
+                                  " multicast-iface=lo latency=0 ! rtph264depay ! fakesink name=out sync=false");
+    GstElement* out = byName(pipeline, "out");
+    GstPad* pad = gst_element_get_static_pad(out, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, countBuffer, &seen, nullptr);
+    gst_object_unref(pad);
+    gst_object_unref(out);
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    return pipeline;
+}
+
+// Multicast clients share one group: egress stays flat as they join, while
+// a client without multicast still gets the stream over unicast.
+static void test_multicast() {
+    RTSPConfig config;
+    config.address = "127.0.0.1";
+    config.port = 18556;
+    config.enable_audio = false;
+    config.encoder = "x264enc";
+    config.bitrate = 500000;
+    config.enable_multicast = true;
+    config.multicast_address = "239.255.42.42";
+    config.multicast_port = 15000;
+    config.multicast_iface = "lo";
+    RTSPStreamer streamer(config);
+
+    GstElement* source = producer();
+    GstElement* sink = byName(source, "sink");
+    streamer.setVideoSource(sink);
+    MetricsRegistry registry;
+    streamer.registerMetrics(registry);
+    bool started = streamer.start();
+    assert(started);
+    gst_element_set_state(source, GST_STATE_PLAYING);
+
+    std::vector<FirstPts> seen(5);
+    std::vector<GstElement*> clients;
+    clients.push_back(rtspClient(streamer.getStreamURL(), "udp-mcast", seen[0]));
+    sleepMs(2000);
+    double one = egressRate(streamer, 2000);
+
+    for (int i = 1; i < 4; ++i) {
+        clients.push_back(rtspClient(streamer.getStreamURL(), "udp-mcast", seen[i]));
+    }
+    sleepMs(2000);
+    double four = egressRate(streamer, 2000);
+
+    // Unicast fallback: one more copy of the stream on the wire
+    clients.push_back(rtspClient(streamer.getStreamURL(), "udp", seen[4]));
+    sleepMs(2000);
+    double mixed = egressRate(streamer, 2000);
+
+    std::cout << "udp egress: 1 multicast client " << one / 1024 << " KiB/s, 4 clients "
+              << four / 1024 << " KiB/s, + 1 unicast " << mixed / 1024 << " KiB/s\n";
+    for (const FirstPts& client : seen) {
+        assert(client.frames > 0);
+    }
+    assert(one > 0.0);
+    assert(four > one * 0.75 && four < one * 1.25);
+    assert(mixed > one * 1.5);
+    assert(registry.render().find("rtsp_udp_sent_bytes_total") != std::string::npos);
+
+    for (GstElement* pipeline : clients) {
+        stopPipeline(pipeline);
+    }
+    streamer.stop();
+    gst_object_unref(sink);
+    stopPipeline(source);
+}
+
+// Frames per second at the payloader and process CPU seconds per second.
+static void encodeLoad(RTSPStreamer& streamer, int ms, double& fps, double& cpu) {
+    std::clock_t start = std::clock();
+    fps = encodedFps(streamer, ms);
+    cpu = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC * 1000.0 / ms;
+}
+
+// A recorded file is complete (has its index) and starts on a keyframe.
+static bool validRecording(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    if (content.str().find("moov") == std::string::npos) {
+        return false;
+    }
+
+    GstElement* reader = launch("filesrc location=" + path + " ! qtdemux ! fakesink name=out");
+    GstElement* out = byName(reader, "out");
+    FirstPts seen;
+    bool keyframe = false;
+    GstPad* pad = gst_element_get_static_pad(out, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER,
+        [](GstPad*, GstPadProbeInfo* info, gpointer user_data) {
+            bool* key = static_cast<bool*>(user_data);
+            *key = !GST_BUFFER_FLAG_IS_SET(GST_PAD_PROBE_INFO_BUFFER(info), GST_BUFFER_FLAG_DELTA_UNIT);
+            return GST_PAD_PROBE_REMOVE;
+        }, &keyframe, nullptr);
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, countBuffer, &seen, nullptr);
+    gst_object_unref(pad);
+    gst_object_unref(out);
+
+    gst_element_set_state(reader, GST_STATE_PLAYING);
+    GstBus* bus = gst_element_get_bus(reader);
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, 5 * GST_SECOND,
+        static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    bool eos = msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+    if (msg) {
+        gst_message_unref(msg);
+    }
+    gst_object_unref(bus);
+    stopPipeline(reader);
+    std::cout << "  " << path << ": " << seen.frames << " frames, "
+              << (keyframe ? "starts on a keyframe" : "starts mid-GOP") << "\n";
+    return eos && keyframe && seen.frames > 0;
+}
+
+// Recording taps the RTSP encoder: it starts and stops under a playing
+// client without a gap or a second encode, outlives the last client and
+// rotates into complete files that start on keyframes.
+static void test_recording() {
+    char dir_template[] = "/tmp/test_rtsp_recording_XXXXXX";
+    std::string dir = g_mkdtemp(dir_template);
+
+    RTSPConfig config;
+    config.address = "127.0.0.1";
+    config.port = 18557;
+    config.enable_audio = false;
+    config.encoder = "x264enc";
+    config.bitrate = 500000;
+    config.record_path = dir;
+    config.max_record_duration = 2;
+    RTSPStreamer streamer(config);
+
+    GstElement* source = producer();
+    GstElement* sink = byName(source, "sink");
+    streamer.setVideoSource(sink);
+    MetricsRegistry registry;
+    streamer.registerMetrics(registry);
+    bool started = streamer.start();
+    assert(started);
+    gst_element_set_state(source, GST_STATE_PLAYING);
+
+    FirstPts seen;
+    GstElement* client = rtspClient(streamer.getStreamURL(), "tcp", seen);
+    sleepMs(2000);
+    double streaming_fps = 0.0, streaming_cpu = 0.0;
+    encodeLoad(streamer, 2000, streaming_fps, streaming_cpu);
+
+    bool recording = streamer.recordStream(true);
+    bool recording_again = streamer.recordStream(true);
+    assert(recording && !recording_again);
+    guint64 before = seen.frames;
+    double recording_fps = 0.0, recording_cpu = 0.0;
+    encodeLoad(streamer, 2000, recording_fps, recording_cpu);
+    guint64 received = seen.frames - before;
+
+    std::cout << "recording: " << streaming_fps << " fps / " << streaming_cpu << " CPU streaming, "
+              << recording_fps << " fps / " << recording_cpu << " CPU recording, client got "
+              << received << " frames\n";
+    assert(recording_fps > streaming_fps * 0.8 && recording_fps < streaming_fps * 1.2);
+    assert(recording_cpu < streaming_cpu * 1.5);
+    assert(received > 40);
+
+    // The last client leaving does not stop the recording
+    stopPipeline(client);
+    sleepMs(1000);
+    guint64 bytes = streamer.getRecordingStats().bytes;
+    sleepMs(2000);
+    StreamRecorderStats stats = streamer.getRecordingStats();
+    assert(stats.recording && stats.bytes > bytes);
+    assert(stats.files >= 2);
+    assert(registry.render().find("rtsp_recording_active 1") != std::string::npos);
+
+    bool stopped = streamer.recordStream(false);
+    bool stopped_again = streamer.recordStream(false);
+    assert(stopped && !stopped_again);
+    stats = streamer.getRecordingStats();
+    assert(!stats.recording);
+
+    guint64 files = 0;
+    GDir* listing = g_dir_open(dir.c_str(), 0, nullptr);
+    while (const gchar* name = g_dir_read_name(listing)) {
+        std::string path = dir + "/" + name;
+        assert(validRecording(path));
+        std::remove(path.c_str());
+        ++files;
+    }
+    g_dir_close(listing);
+    g_rmdir(dir.c_str());
+    assert(files == stats.files);
+
+    streamer.stop();
+    gst_object_unref(sink);
+    stopPipeline(source);
+}
+
+int main(int argc, char* argv[]) {
+    gst_init(&argc, &argv);
+    if (!haveElements({"videotestsrc", "appsrc", "appsink", "x264enc", "h264parse", "rtph264pay",
+                       "rtspsrc", "rtph264depay", "splitmuxsink", "qtdemux"})) {
+        return kSkipped;
+    }
+    test_slow_consumer();
+    test_shared_media();
+    test_simulcast();
+    test_multicast();
+    test_recording();
+    std::cout << "test_rtsp_bridge: OK\n";
+    return 0;
+}
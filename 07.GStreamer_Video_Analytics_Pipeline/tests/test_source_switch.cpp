@@ -0,0 +1,216 @@
+#include "source_switcher.h"
+#include <cassert>
+#include <chrono>
+#include <initializer_list>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Exit code CTest reports as skipped (SKIP_RETURN_CODE in tests/CMakeLists.txt).
+static const int kSkipped = 77;
+
+// Returns true if every element factory is installed, else names the first missing one.
+static bool haveElements(std::initializer_list<const char*> names) {
+    for (const char* name : names) {
+        GstElementFactory* factory = gst_element_factory_find(name);
+        if (!factory) {
+            std::cout << "missing GStreamer element " << name << ", skipping\n";
+            return false;
+        }
+        gst_object_unref(factory);
+    }
+    return true;
+}
+
+// Output running times seen by the sink.
+struct Output {
+    std::mutex mutex;
+    std::vector<GstClockTime> running_times;
+
+    size_t frames() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return running_times.size();
+    }
+};
+
+static GstPadProbeReturn onSinkBuffer(GstPad* pad, GstPadProbeInfo* info, gpointer data) {
+    Output* output = static_cast<Output*>(data);
+    GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstEvent* event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    const GstSegment* segment = nullptr;
+    gst_event_parse_segment(event, &segment);
+    GstClockTime running_time = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    gst_event_unref(event);
+
+    std::lock_guard<std::mutex> lock(output->mutex);
+    output->running_times.push_back(running_time);
+    return GST_PAD_PROBE_OK;
+}
+
+// switcher inputs -> input-selector -> fakesink (sync, like a display)
+struct Harness {
+    SourceSwitcher switcher;
+    GstElement* pipeline;
+    Output output;
+
+    explicit Harness(const SourceFormat& format) : switcher(format) {
+        pipeline = gst_pipeline_new("switch-test");
+        GstElement* selector = switcher.createElement(pipeline);
+        GstElement* sink = gst_element_factory_make("fakesink", "sink");
+        assert(selector && sink);
+        g_object_set(sink, "sync", TRUE, nullptr);
+        gst_bin_add(GST_BIN(pipeline), sink);
+        gboolean linked = gst_element_link(selector, sink);
+        assert(linked);
+
+        GstPad* pad = gst_element_get_static_pad(sink, "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, onSinkBuffer, &output, nullptr);
+        gst_object_unref(pad);
+    }
+
+    ~Harness() {
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        switcher.release();
+        gst_object_unref(pipeline);
+    }
+
+    void play() {
+        GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PLAYING);
+        assert(ret != GST_STATE_CHANGE_FAILURE);
+    }
+
+    // Output never steps back and never skips more than max_step.
+    void checkContinuity(GstClockTime max_step) {
+        std::lock_guard<std::mutex> lock(output.mutex);
+        assert(output.running_times.size() > 2);
+        for (size_t i = 1; i < output.running_times.size(); ++i) {
+            assert(output.running_times[i] > output.running_times[i - 1]);
+            assert(output.running_times[i] - output.running_times[i - 1] <= max_step);
+        }
+    }
+};
+
+static void sleepMs(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static SourceFormat testFormat() {
+    SourceFormat format;
+    format.width = 320;
+    format.height = 240;
+    format.framerate = 30;
+    return format;
+}
+
+// A warm standby is switched to within about one frame, without a timestamp jump.
+static void test_warm_switch() {
+    Harness harness(testFormat());
+    bool primary = harness.switcher.setPrimary("smpte", SourceType::TEST);
+    bool standby = harness.switcher.prepareStandby("ball", SourceType::TEST);
+    assert(primary && standby);
+    harness.play();
+
+    bool ready = harness.switcher.waitForStandby(2 * GST_SECOND);
+    assert(ready);
+    sleepMs(300);
+    bool switched = harness.switcher.switchToStandby();
+    assert(switched);
+    sleepMs(300);
+
+    SourceSwitchStats stats = harness.switcher.getStats();
+    std::cout << "warm switch gap: " << stats.last_gap_ms << " ms (pts step "
+              << stats.last_pts_gap_ms << " ms)\n";
+    assert(stats.switches == 1 && stats.failovers == 0);
+    assert(stats.active_location == "ball" && stats.standby_location.empty());
+    assert(stats.last_gap_ms > 0.0 && stats.last_gap_ms < 100.0);
+    harness.checkContinuity(100 * GST_MSECOND);
+}
+
+// changeSource pre-rolls an unknown input first; the active one is a no-op.
+static void test_change_source() {
+    Harness harness(testFormat());
+    bool primary = harness.switcher.setPrimary("smpte", SourceType::TEST);
+    assert(primary);
+    harness.play();
+    sleepMs(200);
+
+    bool unchanged = harness.switcher.changeSource("smpte", SourceType::TEST, GST_SECOND);
+    assert(unchanged);
+    assert(harness.switcher.getStats().switches == 0);
+
+    bool changed = harness.switcher.changeSource("snow", SourceType::TEST, 2 * GST_SECOND);
+    assert(changed);
+    sleepMs(300);
+    SourceSwitchStats stats = harness.switcher.getStats();
+    std::cout << "cold switch gap: " << stats.last_gap_ms << " ms\n";
+    assert(stats.switches == 1 && stats.active_location == "snow");
+    assert(stats.last_gap_ms < 100.0);
+    harness.checkContinuity(100 * GST_MSECOND);
+}
+
+// A stalled live input fails over to the standby after the timeout.
+static void test_stall_failover() {
+    Harness harness(testFormat());
+    harness.switcher.setStallTimeout(200);
+    bool primary = harness.switcher.setPrimary("smpte", SourceType::TEST);
+    bool standby = harness.switcher.prepareStandby("ball", SourceType::TEST);
+    assert(primary && standby);
+    harness.play();
+    bool ready = harness.switcher.waitForStandby(2 * GST_SECOND);
+    assert(ready);
+    sleepMs(200);
+    bool stalled = harness.switcher.checkStall();
+    assert(!stalled);
+
+    // Freeze the primary like a dead network connection
+    GstElement* source = gst_bin_get_by_name(GST_BIN(harness.pipeline), "input0_src");
+    assert(source);
+    GstPad* pad = gst_element_get_static_pad(source, "src");
+    gst_pad_add_probe(pad, static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER),
+                      [](GstPad*, GstPadProbeInfo*, gpointer) { return GST_PAD_PROBE_OK; }, nullptr, nullptr);
+    gst_object_unref(pad);
+    gst_object_unref(source);
+
+    bool failed_over = false;
+    for (int i = 0; i < 40 && !failed_over; ++i) {
+        sleepMs(50);
+        failed_over = harness.switcher.checkStall();
+    }
+    assert(failed_over);
+
+    size_t frames = harness.output.frames();
+    sleepMs(300);
+    assert(harness.output.frames() > frames);
+
+    SourceSwitchStats stats = harness.switcher.getStats();
+    std::cout << "failover gap: " << stats.last_gap_ms << " ms\n";
+    assert(stats.switches == 1 && stats.failovers == 1);
+    assert(stats.last_gap_ms >= 200.0 && stats.last_gap_ms < 1000.0);
+    harness.checkContinuity(GST_SECOND);
+}
+
+// Without a ready standby there is nothing to switch to.
+static void test_no_standby() {
+    Harness harness(testFormat());
+    bool primary = harness.switcher.setPrimary("smpte", SourceType::TEST);
+    assert(primary);
+    bool switched = harness.switcher.switchToStandby();
+    bool ready = harness.switcher.waitForStandby(GST_MSECOND);
+    bool standby = harness.switcher.prepareStandby("", SourceType::APPSRC);
+    assert(!switched && !ready && !standby);
+}
+
+int main(int argc, char* argv[]) {
+    gst_init(&argc, &argv);
+    if (!haveElements({"videotestsrc", "input-selector", "videoconvert", "videoscale",
+                       "videorate", "capsfilter", "fakesink"})) {
+        return kSkipped;
+    }
+    test_warm_switch();
+    test_change_source();
+    test_stall_failover();
+    test_no_standby();
+    std::cout << "test_source_switch: OK\n";
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "stream_host.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+static void sleepMs(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static StreamHostConfig testConfig(int threads) {
+    StreamHostConfig config;
+    config.thread_count = threads;
+    config.format.width = 320;
+    config.format.height = 240;
+    config.format.framerate = 30;
+    return config;
+}
+
+static StreamStats find(const std::vector<StreamStats>& all, const std::string& id) {
+    for (const auto& stats : all) {
+        if (stats.id == id) {
+            return stats;
+        }
+    }
+    assert(false && "stream not found");
+    return {};
+}
+
+// Streams start and stop at runtime; the others keep running.
+static void test_add_remove() {
+    StreamHost host(testConfig(2));
+    bool started = host.start();
+    assert(started);
+    bool added_a = host.addStream("a", "smpte", SourceType::TEST);
+    bool added_b = host.addStream("b", "ball", SourceType::TEST);
+    bool added_c = host.addStream("c", "snow", SourceType::TEST);
+    bool added_dup = host.addStream("b", "ball", SourceType::TEST);
+    assert(added_a && added_b && added_c);
+    assert(!added_dup);
+    assert(host.streamCount() == 3);
+    sleepMs(1500);
+
+    std::vector<StreamStats> stats = host.getStats();
+    assert(stats.size() == 3);
+    for (const auto& s : stats) {
+        std::cout << s.id << ": " << s.fps << " fps, " << s.processed_frames << " analysed, "
+                  << s.dropped_frames << " dropped\n";
+        assert(s.processed_frames > 20 && s.fps > 15.0);
+        assert(s.input_frames >= s.processed_frames + s.dropped_frames);
+        assert(!s.failed && !s.finished);
+    }
+
+    guint64 a_before = find(stats, "a").processed_frames;
+    bool removed = host.removeStream("b");
+    bool removed_again = host.removeStream("b");
+    assert(removed);
+    assert(!removed_again);
+    assert(host.streamCount() == 2);
+    sleepMs(500);
+    assert(find(host.getStats(), "a").processed_frames > a_before);
+
+    bool readded = host.addStream("b", "ball", SourceType::TEST);
+    assert(readded);
+    sleepMs(500);
+    assert(find(host.getStats(), "b").processed_frames > 0);
+    host.stop();
+    assert(host.streamCount() == 0);
+}
+
+// One worker shared by many streams: every stream gets its turns.
+static void test_fair_share() {
+    StreamHost host(testConfig(1));
+    bool started = host.start();
+    assert(started);
+    for (int i = 0; i < 8; ++i) {
+        bool added = host.addStream("s" + std::to_string(i), "ball", SourceType::TEST);
+        assert(added);
+    }
+    sleepMs(2000);
+
+    guint64 least = ~0ull;
+    guint64 most = 0;
+    for (const auto& s : host.getStats()) {
+        least = std::min(least, s.processed_frames);
+        most = std::max(most, s.processed_frames);
+    }
+    std::cout << "8 streams on 1 worker: " << least << " - " << most << " frames analysed\n";
+    assert(least > 0 && most - least <= most / 4 + 5);
+    assert(host.getPool().executed() > 0);
+}
+
+// An input that cannot start is rejected without touching the others.
+static void test_bad_input() {
+    StreamHost host(testConfig(1));
+    bool started = host.start();
+    assert(started);
+    bool added_good = host.addStream("good", "smpte", SourceType::TEST);
+    bool added_bad = host.addStream("bad", "/nonexistent/video.mp4", SourceType::FILE);
+    assert(added_good);
+    assert(!added_bad);
+    assert(host.streamCount() == 1);
+    sleepMs(500);
+    assert(find(host.getStats(), "good").processed_frames > 0);
+
+    std::string metrics = host.getMetrics().render();
+    assert(metrics.find("stream_processed_frames_total{stream=\"good\"}") != std::string::npos);
+    assert(metrics.find("worker_pool_threads 1") != std::string::npos);
+}
+
+int main(int argc, char* argv[]) {
+    gst_init(&argc, &argv);
+    test_add_remove();
+    test_fair_share();
+    test_bad_input();
+    std::cout << "test_stream_host: OK\n";
+    return 0;
+}
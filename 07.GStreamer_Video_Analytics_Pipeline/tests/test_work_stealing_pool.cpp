@@ -0,0 +1,177 @@
+#include "work_stealing_pool.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static void waitFor(const std::function<bool()>& done) {
+    for (int i = 0; i < 2000 && !done(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(done());
+}
+
+// Simple gate that holds a worker inside a task.
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+    std::atomic<bool> entered{false};
+
+    void wait() {
+        entered = true;
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return open; });
+    }
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+        }
+        cv.notify_all();
+    }
+};
+
+// Tasks of one lane run in order and never concurrently, on any worker.
+static void test_lane_is_serial() {
+    WorkStealingPool pool(4);
+    std::vector<std::shared_ptr<WorkLane>> lanes;
+    std::vector<std::vector<int>> seen(8);
+    std::atomic<int> in_flight[8] = {};
+    std::atomic<bool> overlap{false};
+
+    for (int l = 0; l < 8; ++l) {
+        lanes.push_back(pool.createLane(1000));
+    }
+    for (int n = 0; n < 200; ++n) {
+        for (int l = 0; l < 8; ++l) {
+            lanes[l]->submit([&, l, n] {
+                if (in_flight[l].fetch_add(1) != 0) {
+                    overlap = true;
+                }
+                seen[l].push_back(n);
+                in_flight[l].fetch_sub(1);
+            });
+        }
+    }
+    waitFor([&] { return pool.executed() == 8 * 200; });
+    for (auto& lane : lanes) {
+        pool.closeLane(*lane);  // Also orders the tasks' writes before the checks
+    }
+
+    assert(!overlap);
+    for (int l = 0; l < 8; ++l) {
+        assert(seen[l].size() == 200);
+        for (int n = 0; n < 200; ++n) {
+            assert(seen[l][n] == n);
+        }
+        assert(lanes[l]->dropped() == 0 && lanes[l]->executed() == 200);
+    }
+}
+
+// A full lane drops its oldest tasks; the newest ones run.
+static void test_drop_oldest() {
+    WorkStealingPool pool(1);
+    Gate gate;
+    std::shared_ptr<WorkLane> blocker = pool.createLane(1);
+    std::shared_ptr<WorkLane> lane = pool.createLane(2);
+    blocker->submit([&] { gate.wait(); });
+    waitFor([&] { return gate.entered.load(); });
+
+    std::vector<int> ran;
+    for (int n = 0; n < 5; ++n) {
+        bool kept = lane->submit([&ran, n] { ran.push_back(n); });
+        assert(kept == (n < 2));
+    }
+    assert(lane->pending() == 2 && lane->dropped() == 3 && lane->submitted() == 5);
+
+    gate.release();
+    waitFor([&] { return lane->executed() == 2; });
+    pool.closeLane(*blocker);
+    pool.closeLane(*lane);
+    assert(ran.size() == 2 && ran[0] == 3 && ran[1] == 4);
+}
+
+// A lane with a long backlog does not delay a lane with one task.
+static void test_fair_turns() {
+    WorkStealingPool pool(1);
+    Gate gate;
+    std::shared_ptr<WorkLane> busy = pool.createLane(100);
+    std::shared_ptr<WorkLane> quiet = pool.createLane(100);
+    std::atomic<int> order{0};
+    std::atomic<int> quiet_at{-1};
+
+    busy->submit([&] { gate.wait(); order++; });
+    waitFor([&] { return gate.entered.load(); });
+    for (int n = 0; n < 50; ++n) {
+        busy->submit([&] { order++; });
+    }
+    quiet->submit([&] { quiet_at = order.fetch_add(1); });
+
+    gate.release();
+    waitFor([&] { return pool.executed() == 52; });
+    assert(quiet_at >= 0 && quiet_at <= 2);
+    pool.closeLane(*busy);
+    pool.closeLane(*quiet);
+}
+
+// Closing discards queued tasks, waits for the running one, rejects new ones.
+static void test_close_lane() {
+    WorkStealingPool pool(2);
+    Gate gate;
+    std::shared_ptr<WorkLane> lane = pool.createLane(10);
+    std::atomic<int> ran{0};
+    lane->submit([&] { gate.wait(); ran++; });
+    waitFor([&] { return gate.entered.load(); });
+    for (int n = 0; n < 5; ++n) {
+        lane->submit([&] { ran++; });
+    }
+
+    std::thread closer([&] { pool.closeLane(*lane); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate.release();
+    closer.join();
+
+    assert(ran == 1 && lane->pending() == 0);
+    bool accepted = lane->submit([&] { ran++; });
+    assert(!accepted);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(ran == 1);
+}
+
+// Work queued on one worker's deque is picked up by the others.
+static void test_stealing() {
+    WorkStealingPool pool(4);
+    Gate gate;
+    std::vector<std::shared_ptr<WorkLane>> lanes;
+    for (int l = 0; l < 4; ++l) {
+        lanes.push_back(pool.createLane(4));
+    }
+    // Lanes 0 and 4 share worker 0's deque
+    std::shared_ptr<WorkLane> same_home = pool.createLane(4);
+    std::atomic<int> done{0};
+    lanes[0]->submit([&] { gate.wait(); });
+    waitFor([&] { return gate.entered.load(); });
+    same_home->submit([&] { done++; });
+    waitFor([&] { return done.load() == 1; });
+    gate.release();
+
+    for (auto& lane : lanes) {
+        pool.closeLane(*lane);
+    }
+    pool.closeLane(*same_home);
+    assert(pool.threads() == 4);
+}
+
+int main() {
+    test_lane_is_serial();
+    test_drop_oldest();
+    test_fair_turns();
+    test_close_lane();
+    test_stealing();
+    std::cout << "test_work_stealing_pool: OK\n";
+    return 0;
+}
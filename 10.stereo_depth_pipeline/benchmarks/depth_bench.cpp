@@ -0,0 +1,159 @@
+// ─── depth_bench ─────────────────────────────────────────────────────────────
+//
+// Banded vs. full-frame disparity: DepthEstimator::compute FPS against the
+// thread count for BM and SGBM at 640x480, 1280x720 and 1920x1080.
+//
+// The stereo pair is synthetic: a random texture seen over a slanted ground
+// plane with a closer box in the middle. Each banded disparity map is checked
+// against the single-threaded full-frame map, separately for rows near a
+// seam (within bandMargin()) and for the rest of the frame.
+//
+// Usage: depth_bench [frames] [max_threads]
+//
+#include "depth_estimator.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// ─── Synthetic stereo pair ───────────────────────────────────────────────────
+static void makePair(int width, int height, cv::Mat& left, cv::Mat& right)
+{
+    cv::Mat texture(height, width, CV_8UC1);
+    cv::randu(texture, 0, 256);
+    cv::GaussianBlur(texture, texture, cv::Size(0, 0), 1.2);
+    cv::cvtColor(texture, left, cv::COLOR_GRAY2BGR);
+
+    // right(x) = left(x + d): disparity grows towards the bottom (ground),
+    // the box in the middle is closer than the ground behind it
+    const float scale = width / 640.f;
+    cv::Mat mapX(height, width, CV_32F), mapY(height, width, CV_32F);
+    cv::Rect box(width * 3 / 8, height / 3, width / 4, height / 3);
+    for (int y = 0; y < height; ++y) {
+        float* mx = mapX.ptr<float>(y);
+        float* my = mapY.ptr<float>(y);
+        for (int x = 0; x < width; ++x) {
+            float d = (8.f + 24.f * y / height) * scale;
+            if (box.contains(cv::Point(x, y))) d = 44.f * scale;
+            mx[x] = x + std::min(d, 60.f);      // stays inside 64 disparities
+            my[x] = static_cast<float>(y);
+        }
+    }
+    cv::remap(left, right, mapX, mapY, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+}
+
+// ─── Measurement ─────────────────────────────────────────────────────────────
+static double measureFps(DepthEstimator& est, const cv::Mat& left, const cv::Mat& right,
+                         int frames, cv::Mat& disparity)
+{
+    est.compute(left, right);                       // warm-up, allocates buffers
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+        disparity = est.compute(left, right).disparity16;
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return frames / s;
+}
+
+struct Mismatch {
+    double seamPct  = 0.0;     // rows within bandMargin() of a seam
+    double otherPct = 0.0;     // all other rows
+};
+
+static Mismatch compareBands(const DepthEstimator& est, const cv::Mat& ref, const cv::Mat& disp)
+{
+    std::vector<char> nearSeam(ref.rows, 0);
+    const int margin = est.bandMargin();
+    std::vector<cv::Range> bands = est.disparityBands(ref.rows);
+    for (size_t i = 1; i < bands.size(); ++i) {
+        int seam = bands[i].start;
+        for (int y = std::max(0, seam - margin); y < std::min(ref.rows, seam + margin); ++y)
+            nearSeam[y] = 1;
+    }
+
+    size_t seamTotal = 0, seamDiff = 0, otherTotal = 0, otherDiff = 0;
+    for (int y = 0; y < ref.rows; ++y) {
+        const int16_t* a = ref.ptr<int16_t>(y);
+        const int16_t* b = disp.ptr<int16_t>(y);
+        size_t diff = 0;
+        for (int x = 0; x < ref.cols; ++x) diff += (a[x] != b[x]);
+        if (nearSeam[y]) { seamTotal += ref.cols; seamDiff += diff; }
+        else             { otherTotal += ref.cols; otherDiff += diff; }
+    }
+
+    Mismatch m;
+    m.seamPct  = seamTotal  ? 100.0 * seamDiff  / seamTotal  : 0.0;
+    m.otherPct = otherTotal ? 100.0 * otherDiff / otherTotal : 0.0;
+    return m;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+int main(int argc, char* argv[])
+{
+    int frames     = (argc > 1) ? std::stoi(argv[1]) : 10;
+    int maxThreads = (argc > 2) ? std::stoi(argv[2]) : cv::getNumberOfCPUs();
+
+    std::vector<int> threadCounts;
+    for (int n = 1; n < maxThreads; n *= 2) threadCounts.push_back(n);
+    threadCounts.push_back(maxThreads);
+
+    // Away from the seams a band sees the same pixels as the full frame; only
+    // speckle filtering (BM, SGBM) and long vertical paths (SGBM) leak through
+    const double bmLimitPct = 0.5, sgbmLimitPct = 2.0;
+    bool ok = true;
+
+    const cv::Size sizes[] = { {640, 480}, {1280, 720}, {1920, 1080} };
+    for (auto algo : { DepthEstimator::Algorithm::BLOCK_MATCHING,
+                       DepthEstimator::Algorithm::SEMI_GLOBAL_BM }) {
+        const bool isBM = (algo == DepthEstimator::Algorithm::BLOCK_MATCHING);
+
+        for (const cv::Size& size : sizes) {
+            cv::Mat left, right;
+            makePair(size.width, size.height, left, right);
+
+            DepthEstimator est;
+            est.setAlgorithm(algo);
+
+            // Reference: full frame on one thread
+            cv::Mat ref, disp;
+            cv::setNumThreads(1);
+            est.setThreads(1);
+            measureFps(est, left, right, 1, ref);
+
+            std::cout << "\n" << (isBM ? "BM" : "SGBM") << " " << size.width << "x" << size.height
+                      << "  (band margin " << est.bandMargin() << " rows)\n"
+                      << "threads  full fps  banded fps  speedup  bands  diff% seams  diff% other\n";
+
+            for (int n : threadCounts) {
+                cv::setNumThreads(n);
+
+                // Full frame: the matcher's own parallel_for_ on n threads
+                est.setThreads(1);
+                double fullFps = measureFps(est, left, right, frames, disp);
+
+                // Banded: one band per thread
+                est.setThreads(n);
+                double bandFps = measureFps(est, left, right, frames, disp);
+                Mismatch m = compareBands(est, ref, disp);
+                ok = ok && m.otherPct <= (isBM ? bmLimitPct : sgbmLimitPct);
+
+                std::cout << std::fixed
+                          << std::setw(7)  << n
+                          << std::setw(10) << std::setprecision(1) << fullFps
+                          << std::setw(12) << bandFps
+                          << std::setw(8)  << std::setprecision(2) << bandFps / fullFps << "x"
+                          << std::setw(7)  << est.disparityBands(size.height).size()
+                          << std::setw(13) << std::setprecision(3) << m.seamPct
+                          << std::setw(13) << m.otherPct << "\n";
+            }
+        }
+    }
+
+    std::cout << "\nAway from seams: " << (ok ? "equivalent" : "MISMATCH")
+              << " (limit " << bmLimitPct << "% BM, " << sgbmLimitPct << "% SGBM)\n";
+    return ok ? 0 : 1;
+}
@@ -3,6 +3,7 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/calib3d.hpp>
 #include <string>
+#include <vector>
 
 // ─── Result structure ────────────────────────────────────────────────────────
 struct DepthResult {
@@ -12,6 +13,7 @@ struct DepthResult {
     cv::Mat colorDepth;    // Colorized image (BGR, 8-bit)
     float   minDepthM  = 0.f;
     float   maxDepthM  = 0.f;
+    int     validPixels = 0;   // pixels with a depth below maxDepth
     bool    valid      = false;
 };
 
@@ -29,6 +31,23 @@ struct DepthResult {
 //   If setSim(true) is called, the right image is produced as a horizontally
 //   shifted version of the left image. Mimics a real stereo camera pair.
 //
+// Banded disparity:
+//   The rectified pair is split into horizontal bands, one per thread. Each
+//   band is matched by its own matcher on the OpenCV thread pool, and the
+//   results are stitched. Each band also matches bandMargin() extra rows
+//   above and below it, so the block window (and, for SGBM, most of the
+//   vertical path aggregation) sees the same pixels as on the full frame.
+//   Results only differ in a few rows around each seam.
+//
+// Depth, colour and statistics:
+//   A disparity has only (minDisparity + numDisparities) * 16 possible
+//   values, so depth and colour come from lookup tables built once. A single
+//   fused pass over the disparity map writes the depth map and the colour
+//   image and gathers the statistics. setOutputs() limits the pass (and the
+//   float disparity) to what the caller actually uses. Colours use the fixed
+//   scale 0..maxDepth (red = near, blue = far, black = invalid), so a colour
+//   does not depend on the other pixels of the frame.
+//
 class DepthEstimator {
 public:
     enum class Algorithm {
@@ -36,13 +55,26 @@ public:
         SEMI_GLOBAL_BM     // cv::StereoSGBM – slow, more accurate
     };
 
+    // DepthResult fields filled by compute() (disparity16 always is)
+    enum Output : unsigned {
+        OUT_DISPARITY_F = 1u << 0,   // disparityF
+        OUT_DEPTH       = 1u << 1,   // depthMap
+        OUT_COLOR       = 1u << 2,   // colorDepth
+        OUT_STATS       = 1u << 3,   // minDepthM, maxDepthM, validPixels
+        OUT_ALL         = OUT_DISPARITY_F | OUT_DEPTH | OUT_COLOR | OUT_STATS
+    };
+
     DepthEstimator();
 
     // ── Parameters ───────────────────────────────────────────────────────────
     void setAlgorithm(Algorithm a) { algo_ = a; initMatchers(); }
-    void setFocalLength(float f)   { focalPx_ = f; }
-    void setBaseline(float b)      { baselineM_ = b; }
-    void setMaxDepth(float d)      { maxDepthM_ = d; }
+    void setFocalLength(float f)   { focalPx_ = f; lutValid_ = false; }
+    void setBaseline(float b)      { baselineM_ = b; lutValid_ = false; }
+    void setMaxDepth(float d)      { maxDepthM_ = d; lutValid_ = false; }
+    void setOutputs(unsigned mask) { outputs_ = mask; }
+
+    // Disparity bands matched in parallel (0 = cv::getNumThreads(), 1 = full frame)
+    void setThreads(int n)         { threads_ = n; }
 
     // In simulation mode, generate right image from left image (shift pixels)
     void setSim(bool enable, int shift = 30) { simMode_ = enable; simShift_ = shift; }
@@ -57,6 +89,13 @@ public:
     // Returns depth in meters at pixel coordinate (-1 = invalid)
     float depthAt(const DepthResult& r, int x, int y) const;
 
+    // ── Banding ──────────────────────────────────────────────────────────────
+    // Rows each band writes for an image of the given height (one band = full frame)
+    std::vector<cv::Range> disparityBands(int rows) const;
+
+    // Extra rows a band matches above and below the rows it writes
+    int bandMargin() const;
+
 private:
     Algorithm algo_     = Algorithm::BLOCK_MATCHING;
     float focalPx_      = 554.f;    // 640x480 @ ~60° FOV
@@ -66,6 +105,9 @@ private:
     bool simMode_       = false;
     int  simShift_      = 30;       // pixels
 
+    int  threads_       = 0;        // 0 = cv::getNumThreads()
+    unsigned outputs_   = OUT_ALL;
+
     bool calibrated_    = false;
     cv::Mat R1_, R2_, P1_, P2_, Q_;
     cv::Mat mapL1_, mapL2_, mapR1_, mapR2_;
@@ -73,11 +115,22 @@ private:
     cv::Ptr<cv::StereoBM>   bm_;
     cv::Ptr<cv::StereoSGBM> sgbm_;
 
+    // One matcher per band (matchers keep per-call buffers, so no sharing)
+    std::vector<cv::Ptr<cv::StereoMatcher>> bandMatchers_;
+
+    // Lookup tables indexed by the raw disparity (16x fixed point)
+    std::vector<float>     depthLut_;       // meters, 0 = invalid
+    std::vector<cv::Vec3b> colorLut_;       // BGR, black = invalid
+    int  lutFirstValid_ = 0;                // valid entries: first..last
+    int  lutLastValid_  = -1;
+    bool lutValid_      = false;
+
     void initMatchers();
+    cv::Ptr<cv::StereoMatcher> cloneMatcher() const;
 
     // Helper functions
     void        rectify(cv::Mat& left, cv::Mat& right) const;
     cv::Mat     computeDisparity(const cv::Mat& leftGray, const cv::Mat& rightGray);
-    cv::Mat     disparityToDepth(const cv::Mat& disp16);
-    cv::Mat     colorize(const cv::Mat& depthM);
+    void        buildLuts();
+    void        mapDisparity(DepthResult& r);
 };
@@ -1,7 +1,14 @@
 #include "depth_estimator.h"
+#include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
 
+// Rows above a band that SGBM's top-down path aggregation still feels. The
+// influence fades with distance (every step re-normalises the path cost, and
+// a P2 jump caps any disparity change), so this is a trade-off, not a bound.
+static constexpr int kSgbmPathMargin = 24;
+
 // ─────────────────────────────────────────────────────────────────────────────
 DepthEstimator::DepthEstimator()
 {
@@ -38,6 +45,59 @@ void DepthEstimator::initMatchers()
         /*speckleRange=*/32,
         /*mode=*/cv::StereoSGBM::MODE_SGBM_3WAY
     );
+
+    // Band matchers and lookup tables are rebuilt on the next frame
+    bandMatchers_.clear();
+    lutValid_ = false;
+}
+
+// ─── Band matcher ────────────────────────────────────────────────────────────
+// A fresh matcher with the parameters of the active one
+cv::Ptr<cv::StereoMatcher> DepthEstimator::cloneMatcher() const
+{
+    if (algo_ == Algorithm::BLOCK_MATCHING) {
+        cv::Ptr<cv::StereoBM> bm = cv::StereoBM::create(bm_->getNumDisparities(),
+                                                        bm_->getBlockSize());
+        bm->setPreFilterType(bm_->getPreFilterType());
+        bm->setPreFilterSize(bm_->getPreFilterSize());
+        bm->setPreFilterCap(bm_->getPreFilterCap());
+        bm->setMinDisparity(bm_->getMinDisparity());
+        bm->setTextureThreshold(bm_->getTextureThreshold());
+        bm->setUniquenessRatio(bm_->getUniquenessRatio());
+        bm->setSpeckleWindowSize(bm_->getSpeckleWindowSize());
+        bm->setSpeckleRange(bm_->getSpeckleRange());
+        bm->setDisp12MaxDiff(bm_->getDisp12MaxDiff());
+        return bm;
+    }
+    return cv::StereoSGBM::create(
+        sgbm_->getMinDisparity(), sgbm_->getNumDisparities(), sgbm_->getBlockSize(),
+        sgbm_->getP1(), sgbm_->getP2(), sgbm_->getDisp12MaxDiff(),
+        sgbm_->getPreFilterCap(), sgbm_->getUniquenessRatio(),
+        sgbm_->getSpeckleWindowSize(), sgbm_->getSpeckleRange(), sgbm_->getMode());
+}
+
+// ─── Band layout ─────────────────────────────────────────────────────────────
+int DepthEstimator::bandMargin() const
+{
+    if (algo_ == Algorithm::BLOCK_MATCHING) {
+        // Matching window plus the prefilter window in front of it
+        return bm_->getBlockSize() / 2 + bm_->getPreFilterSize() / 2;
+    }
+    return sgbm_->getBlockSize() / 2 + kSgbmPathMargin;
+}
+
+std::vector<cv::Range> DepthEstimator::disparityBands(int rows) const
+{
+    int threads = (threads_ > 0) ? threads_ : cv::getNumThreads();
+
+    // A band writes at least twice the rows it only reads (the margins)
+    int maxBands = std::max(1, rows / (2 * bandMargin()));
+    int count    = std::clamp(threads, 1, maxBands);
+
+    std::vector<cv::Range> bands;
+    for (int i = 0; i < count; ++i)
+        bands.emplace_back(rows * i / count, rows * (i + 1) / count);
+    return bands;
 }
 
 // ─── Calibration loading ─────────────────────────────────────────────────────
@@ -72,6 +132,7 @@ bool DepthEstimator::loadCalibration(const std::string& yamlPath)
     baselineM_ = static_cast<float>(-1.0 / Q_.at<double>(3, 2));
 
     calibrated_ = true;
+    lutValid_   = false;
     std::cout << "[DepthEstimator] Calibration loaded. f=" << focalPx_
               << " px, baseline=" << baselineM_ * 100.f << " cm\n";
     return true;
@@ -107,22 +168,11 @@ DepthResult DepthEstimator::compute(const cv::Mat& left, const cv::Mat& right)
     result.disparity16 = computeDisparity(grayL, grayR);
 
     // float disparity (actual pixel value)
-    result.disparity16.convertTo(result.disparityF, CV_32F, 1.0 / 16.0);
-
-    // Depth map (meters)
-    result.depthMap = disparityToDepth(result.disparity16);
-
-    // Statistics
-    cv::Mat validMask = result.depthMap > 0.01f;
-    if (cv::countNonZero(validMask) > 0) {
-        double mn, mx;
-        cv::minMaxLoc(result.depthMap, &mn, &mx, nullptr, nullptr, validMask);
-        result.minDepthM = static_cast<float>(mn);
-        result.maxDepthM = static_cast<float>(mx);
-    }
+    if (outputs_ & OUT_DISPARITY_F)
+        result.disparity16.convertTo(result.disparityF, CV_32F, 1.0 / 16.0);
 
-    // Color image
-    result.colorDepth = colorize(result.depthMap);
+    // Depth map, color image and statistics in one pass
+    mapDisparity(result);
     result.valid = true;
     return result;
 }
@@ -149,48 +199,128 @@ void DepthEstimator::rectify(cv::Mat& left, cv::Mat& right) const
 cv::Mat DepthEstimator::computeDisparity(const cv::Mat& grayL, const cv::Mat& grayR)
 {
     cv::Mat disp;
-    if (algo_ == Algorithm::BLOCK_MATCHING) {
-        bm_->compute(grayL, grayR, disp);
-    } else {
-        sgbm_->compute(grayL, grayR, disp);
+    std::vector<cv::Range> bands = disparityBands(grayL.rows);
+
+    // One band: the matcher parallelises internally over the full frame
+    if (bands.size() == 1) {
+        if (algo_ == Algorithm::BLOCK_MATCHING) {
+            bm_->compute(grayL, grayR, disp);
+        } else {
+            sgbm_->compute(grayL, grayR, disp);
+        }
+        return disp;   // CV_16S, actual = disp / 16
     }
+
+    while (bandMatchers_.size() < bands.size())
+        bandMatchers_.push_back(cloneMatcher());
+
+    disp.create(grayL.size(), CV_16S);
+    const int margin = bandMargin();
+
+    // Each band runs on one pool thread; OpenCV runs the matcher's own
+    // parallel_for_ serially when it is nested in this one
+    cv::parallel_for_(cv::Range(0, static_cast<int>(bands.size())), [&](const cv::Range& r) {
+        for (int i = r.start; i < r.end; ++i) {
+            const cv::Range& own = bands[i];
+            cv::Range read(std::max(0, own.start - margin),
+                           std::min(grayL.rows, own.end + margin));
+
+            cv::Mat bandDisp;
+            bandMatchers_[i]->compute(grayL.rowRange(read), grayR.rowRange(read), bandDisp);
+            bandDisp.rowRange(own.start - read.start, own.end - read.start)
+                    .copyTo(disp.rowRange(own));
+        }
+    }, static_cast<double>(bands.size()));
+
     return disp;   // CV_16S, actual = disp / 16
 }
 
-// ─── Disparity → Depth (meters) ──────────────────────────────────────────────
-//   depth = (focalPx * baselineM) / disparity_px
-cv::Mat DepthEstimator::disparityToDepth(const cv::Mat& disp16)
+// ─── Lookup tables ───────────────────────────────────────────────────────────
+//   depth = (focalPx * baselineM) / disparity_px, one entry per raw disparity
+void DepthEstimator::buildLuts()
 {
-    cv::Mat depth(disp16.size(), CV_32F, cv::Scalar(0.f));
-
-    for (int y = 0; y < disp16.rows; ++y) {
-        const int16_t* row = disp16.ptr<int16_t>(y);
-        float*         out = depth.ptr<float>(y);
-        for (int x = 0; x < disp16.cols; ++x) {
-            float d = static_cast<float>(row[x]) / 16.f;
-            if (d > 0.f) {
-                float z = (focalPx_ * baselineM_) / d;
-                out[x] = (z < maxDepthM_) ? z : 0.f;
-            }
+    const cv::StereoMatcher& m = (algo_ == Algorithm::BLOCK_MATCHING)
+        ? static_cast<const cv::StereoMatcher&>(*bm_)
+        : static_cast<const cv::StereoMatcher&>(*sgbm_);
+    const int size = std::max(1, (m.getMinDisparity() + m.getNumDisparities()) * 16);
+
+    // JET palette, inverted so that near = warm color
+    cv::Mat ramp(1, 256, CV_8U), palette;
+    for (int i = 0; i < 256; ++i) ramp.at<uchar>(0, i) = static_cast<uchar>(255 - i);
+    cv::applyColorMap(ramp, palette, cv::COLORMAP_JET);
+
+    depthLut_.assign(size, 0.f);
+    colorLut_.assign(size, cv::Vec3b(0, 0, 0));
+    lutFirstValid_ = size;
+    lutLastValid_  = -1;
+
+    for (int i = 1; i < size; ++i) {
+        float d = static_cast<float>(i) / 16.f;
+        float z = (focalPx_ * baselineM_) / d;
+        depthLut_[i] = (z < maxDepthM_) ? z : 0.f;
+
+        // Depth is monotonic in disparity, so the valid entries are contiguous
+        if (depthLut_[i] > 0.01f) {
+            lutFirstValid_ = std::min(lutFirstValid_, i);
+            lutLastValid_  = i;
+            int level = cv::saturate_cast<uchar>(depthLut_[i] * 255.f / maxDepthM_);
+            colorLut_[i] = palette.at<cv::Vec3b>(0, level);
         }
     }
-    return depth;
+    lutValid_ = true;
 }
 
-// ─── Colorization (JET colormap) ─────────────────────────────────────────────
-cv::Mat DepthEstimator::colorize(const cv::Mat& depthM)
+// ─── Disparity → depth, color, statistics (fused) ────────────────────────────
+void DepthEstimator::mapDisparity(DepthResult& r)
 {
-    cv::Mat norm;
-    // 0 → red (near), maxDepthM_ → blue (far) – JET is inverted
-    cv::normalize(depthM, norm, 0, 255, cv::NORM_MINMAX, CV_8U);
-    cv::bitwise_not(norm, norm);   // near = warm color
+    const bool wantDepth = (outputs_ & OUT_DEPTH) != 0;
+    const bool wantColor = (outputs_ & OUT_COLOR) != 0;
+    const bool wantStats = (outputs_ & OUT_STATS) != 0;
+    if (!wantDepth && !wantColor && !wantStats) return;
+
+    if (!lutValid_) buildLuts();
+
+    const cv::Mat& disp16 = r.disparity16;
+    if (wantDepth) r.depthMap.create(disp16.size(), CV_32F);
+    if (wantColor) r.colorDepth.create(disp16.size(), CV_8UC3);
 
-    cv::Mat colored;
-    cv::applyColorMap(norm, colored, cv::COLORMAP_JET);
+    const int        size   = static_cast<int>(depthLut_.size());
+    const int        first  = lutFirstValid_;
+    const int        last   = lutLastValid_;
+    const float*     depth  = depthLut_.data();
+    const cv::Vec3b* color  = colorLut_.data();
 
-    // Make zero disparity pixels black
-    cv::Mat mask = (depthM < 0.01f);
-    colored.setTo(cv::Scalar(0, 0, 0), mask);
+    // Valid raw disparities seen: min → farthest, max → nearest
+    int minValid = size, maxValid = -1, count = 0;
+    std::mutex statsMtx;
 
-    return colored;
+    cv::parallel_for_(cv::Range(0, disp16.rows), [&](const cv::Range& rows) {
+        int lo = size, hi = -1, n = 0;
+        for (int y = rows.start; y < rows.end; ++y) {
+            const int16_t* in   = disp16.ptr<int16_t>(y);
+            float*         outD = wantDepth ? r.depthMap.ptr<float>(y)       : nullptr;
+            cv::Vec3b*     outC = wantColor ? r.colorDepth.ptr<cv::Vec3b>(y) : nullptr;
+            for (int x = 0; x < disp16.cols; ++x) {
+                // Invalid (negative) and out-of-range disparities use entry 0
+                int i = (static_cast<unsigned>(in[x]) < static_cast<unsigned>(size)) ? in[x] : 0;
+                if (outD) outD[x] = depth[i];
+                if (outC) outC[x] = color[i];
+                if (i >= first && i <= last) {
+                    lo = std::min(lo, i);
+                    hi = std::max(hi, i);
+                    ++n;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(statsMtx);
+        minValid = std::min(minValid, lo);
+        maxValid = std::max(maxValid, hi);
+        count   += n;
+    });
+
+    if (wantStats && count > 0) {
+        r.minDepthM   = depth[maxValid];
+        r.maxDepthM   = depth[minValid];
+        r.validPixels = count;
+    }
 }
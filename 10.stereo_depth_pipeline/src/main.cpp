@@ -36,7 +36,9 @@ static void printUsage(const char* name)
         << "  --sgbm               Use StereoSGBM (more accurate, slower)\n"
         << "  --focal  <px>        Focal length in pixels (default: 554)\n"
         << "  --base   <m>         Baseline in meters (default: 0.06)\n"
-        << "  --calib  <yaml>      Calibration file\n\n"
+        << "  --calib  <yaml>      Calibration file\n"
+        << "  --threads <n>        Disparity bands in parallel (default: 0 = all cores,\n"
+        << "                       1 = full frame)\n\n"
         << "Obstacle options:\n"
         << "  --danger  <m>        Danger threshold (default: 1.0 m)\n"
         << "  --caution <m>        Caution threshold (default: 3.0 m)\n\n"
@@ -123,6 +125,7 @@ int main(int argc, char* argv[])
     float danger  = 1.0f;
     float caution = 3.0f;
     bool  useSGBM = false;
+    int   threads = 0;
 
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
@@ -145,6 +148,7 @@ int main(int argc, char* argv[])
         else if (a == "--calib")              calibPath = next();
         else if (a == "--save")               savePath  = next();
         else if (a == "--sgbm")               useSGBM  = true;
+        else if (a == "--threads")            threads  = std::stoi(next());
         else if (a == "-h" || a == "--help") { printUsage(argv[0]); return 0; }
         else std::cerr << "[main] Unknown argument: " << a << "\n";
     }
@@ -163,6 +167,10 @@ int main(int argc, char* argv[])
                                : DepthEstimator::Algorithm::BLOCK_MATCHING);
     depth.setFocalLength(focal);
     depth.setBaseline(base);
+    depth.setThreads(threads);
+    // The float disparity is not displayed or analyzed
+    depth.setOutputs(DepthEstimator::OUT_DEPTH | DepthEstimator::OUT_COLOR |
+                     DepthEstimator::OUT_STATS);
 
     // In simulation mode, generate artificial right image
     if (mode == StereoPipeline::SourceMode::SIMULATION)
@@ -22,6 +22,8 @@ struct CameraCaps {
     int framerate    = 30;
     std::string fmt  = "NV12";   // NV12 | I420 | YUY2 | RGB | BAYER_RGGB8
     bool use_nvmm    = false;    // Jetson zero-copy memory
+    bool native_out  = false;    // end in the sensor's own format: no
+                                 // full-resolution conversion to fmt
 };
 
 struct CameraInfo {
@@ -12,6 +12,7 @@
 #include <gst/app/gstappsink.h>
 
 #include <atomic>
+#include <deque>
 #include <string>
 #include <memory>
 #include <functional>
@@ -22,11 +23,16 @@ struct PipelineConfig {
     std::string camera_type      = "auto";   // usb | csi | gmsl | gige | auto
     std::string camera_node      = "";
     CameraCaps  caps;
+    // Split capture with a tee: the appsink gets frames already scaled to
+    // inference size inside GStreamer; full resolution only flows to a
+    // second appsink when display or recording needs it.
+    bool        dual_branch      = false;
 
     std::string engine_path      = "models/yolov8n_int8.engine";
     std::string onnx_path        = "models/yolov8n.onnx";
     std::string calib_dir        = "models/coco_calib_subset";
     std::string calib_cache      = "models/yolov8n_int8.cache";
+    std::string calib_shard      = "models/coco_calib_subset.shard";
     Precision   precision        = Precision::FP16;
 
     ByteTrackConfig tracker;
@@ -59,6 +65,7 @@ public:
 private:
     bool buildGstPipeline();
     void onFrame(GstSample* sample);
+    bool pullFullFrame(GstClockTime pts, cv::Mat& out);   // dual_branch display/record frame
 
     static GstFlowReturn onNewSample(GstAppSink* sink, gpointer user);
 
@@ -72,11 +79,15 @@ private:
 
     GstElement*  gst_pipeline_ = nullptr;
     GstElement*  gst_sink_     = nullptr;
+    GstElement*  gst_full_sink_ = nullptr;   // dual_branch only
+    std::deque<GstSample*> full_frames_;     // pulled full-res samples, PTS order
 
     std::atomic<bool> stop_{false};
     int  frame_id_  = 0;
     int  width_     = 0;
     int  height_    = 0;
+    int  infer_w_   = 0;     // appsink frame size in dual_branch mode
+    int  infer_h_   = 0;
     DetectionCallback cb_;
 
     // For FPS over a sliding window
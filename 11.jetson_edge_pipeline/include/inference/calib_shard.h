@@ -0,0 +1,109 @@
+#ifndef JETSON_EDGE_CALIB_SHARD_H
+#define JETSON_EDGE_CALIB_SHARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace edge {
+
+// Preprocessed INT8 calibration set in a single memory-mapped file.
+//
+// Decoding + letterboxing a few hundred JPEGs on the TensorRT builder
+// thread dominated INT8 build time and was repeated on every rebuild.
+// buildCalibShard() does it once, on all cores, and the calibrator then
+// streams batches straight out of the mapping.
+//
+// Layout (little-endian, every section 64-byte aligned):
+//   ShardHeader
+//   ShardEntry[count]                       per-image letterbox info
+//   tensor[count][3][height][width]         RGB CHW, float [0,1] or uint8
+enum class ShardDType : uint32_t { F32 = 0, U8 = 1 };
+
+struct ShardHeader {
+    char     magic[8];          // "EDGECAL\0"
+    uint32_t version;
+    uint32_t dtype;             // ShardDType
+    uint32_t count;
+    uint32_t channels, height, width;
+    uint32_t source_count;      // images listed, before dropping unreadable ones
+    uint64_t index_offset;
+    uint64_t data_offset;
+    uint64_t sample_bytes;
+    uint64_t list_hash;         // calibListHash() of the listed images
+};
+
+struct ShardEntry {
+    uint32_t orig_w, orig_h;
+    float    scale;
+    int32_t  dx, dy;
+    char     name[108];         // basename, truncated
+};
+static_assert(sizeof(ShardEntry) == 128, "ShardEntry must stay 128 bytes");
+
+struct CalibShardOptions {
+    int        input_w     = 640;
+    int        input_h     = 640;
+    ShardDType dtype       = ShardDType::F32;
+    int        threads     = 0;   // 0 = hardware_concurrency
+    size_t     max_images  = 0;   // 0 = all
+};
+
+// Sorted .jpg/.jpeg/.png/.bmp files of a flat directory.
+std::vector<std::string> listCalibImages(const std::string& dir);
+
+// FNV-1a over basename + file size of the first `max_images` images
+// (0 = all).  Basenames only, so a shard made on the dev PC still matches
+// the same set copied to another directory on the Jetson.
+uint64_t calibListHash(const std::vector<std::string>& images,
+                       size_t max_images = 0);
+
+// Decodes and letterboxes `images` in parallel into `out_path`.  Workers
+// write directly into their slot of the mapped output; unreadable images
+// are dropped and the file is compacted.  Returns the number of samples
+// written (0 on failure, reason in *err).
+size_t buildCalibShard(const std::vector<std::string>& images,
+                       const std::string& out_path,
+                       const CalibShardOptions& opt,
+                       std::string* err = nullptr);
+
+// Read-only view of a shard file.
+class CalibShard {
+public:
+    CalibShard() = default;
+    ~CalibShard();
+    CalibShard(const CalibShard&) = delete;
+    CalibShard& operator=(const CalibShard&) = delete;
+
+    bool open(const std::string& path, std::string* err = nullptr);
+    void close();
+    bool isOpen() const { return base_ != nullptr; }
+
+    size_t     count()    const { return hdr_ ? hdr_->count : 0; }
+    size_t     sourceCount() const { return hdr_ ? hdr_->source_count : 0; }
+    uint64_t   listHash()    const { return hdr_ ? hdr_->list_hash : 0; }
+    int        width()    const { return hdr_ ? static_cast<int>(hdr_->width)  : 0; }
+    int        height()   const { return hdr_ ? static_cast<int>(hdr_->height) : 0; }
+    int        channels() const { return hdr_ ? static_cast<int>(hdr_->channels) : 0; }
+    ShardDType dtype()    const { return hdr_ ? static_cast<ShardDType>(hdr_->dtype)
+                                              : ShardDType::F32; }
+    size_t sampleElems() const { return size_t(channels()) * height() * width(); }
+
+    const ShardEntry& entry(size_t i) const { return entries_[i]; }
+    const void* sample(size_t i) const;
+
+    // Copies samples [first, first+n) as float CHW into dst
+    // (n * sampleElems() floats), expanding uint8 shards on the fly.
+    void copyFloat(size_t first, size_t n, float* dst) const;
+
+private:
+    uint8_t*           base_    = nullptr;
+    size_t             size_    = 0;
+    const ShardHeader* hdr_     = nullptr;
+    const ShardEntry*  entries_ = nullptr;
+};
+
+}  // namespace edge
+
+#endif
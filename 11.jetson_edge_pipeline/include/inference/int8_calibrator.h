@@ -1,6 +1,8 @@
 #ifndef JETSON_EDGE_INT8_CALIBRATOR_H
 #define JETSON_EDGE_INT8_CALIBRATOR_H
 
+#include "inference/calib_shard.h"
+
 #include <NvInfer.h>
 #include <string>
 #include <vector>
@@ -10,6 +12,13 @@ namespace edge {
 // Entropy calibrator (v2) that feeds the network preprocessed images
 // from a flat directory.  Used during INT8 engine build.
 //
+// Images are letterboxed once into a memory-mapped CalibShard
+// (shard_file, default "<cache_file>.shard"); getBatch() then only
+// copies a contiguous slice of the mapping to the device.  The shard is
+// built lazily on the first getBatch() — i.e. never when TensorRT is
+// satisfied by the calibration cache.  A shard whose input size, image
+// count or image-list hash differs from images_dir is rebuilt.
+//
 // Calibration cache is written/read from cache_file so a second build
 // can skip the image loop entirely.
 class Int8EntropyCalibrator2 : public nvinfer1::IInt8EntropyCalibrator2 {
@@ -17,7 +26,8 @@ public:
     Int8EntropyCalibrator2(int batch_size,
                            int input_w, int input_h,
                            const std::string& images_dir,
-                           const std::string& cache_file);
+                           const std::string& cache_file,
+                           const std::string& shard_file = "");
     ~Int8EntropyCalibrator2() override;
 
     int  getBatchSize() const noexcept override { return batch_size_; }
@@ -26,10 +36,15 @@ public:
     void writeCalibrationCache(const void* cache, size_t length) noexcept override;
 
 private:
+    bool ensureShard();
+
     int  batch_size_;
     int  input_w_, input_h_;
     int  current_idx_  = 0;
-    std::vector<std::string> images_;
+    std::string images_dir_;
+    std::string shard_file_;
+    CalibShard  shard_;
+    std::vector<float> staging_;   // uint8 shards only
     std::string cache_file_;
     std::vector<char> cache_;
     void* device_input_ = nullptr;
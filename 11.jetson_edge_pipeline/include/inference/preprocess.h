@@ -0,0 +1,35 @@
+#ifndef JETSON_EDGE_PREPROCESS_H
+#define JETSON_EDGE_PREPROCESS_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+namespace edge {
+
+// YOLO-style letterbox geometry: the source is scaled by `scale` to
+// new_w x new_h and centred at (dx, dy) inside the network input, the
+// border being filled with kLetterboxPad.  TensorRTEngine::infer and the
+// INT8 calibration shard both go through these helpers so calibration
+// sees exactly the pixels inference will.
+struct Letterbox {
+    float scale = 1.f;
+    int   new_w = 0, new_h = 0;
+    int   dx    = 0, dy    = 0;
+};
+
+constexpr uint8_t kLetterboxPad = 114;
+
+Letterbox computeLetterbox(int src_w, int src_h, int dst_w, int dst_h);
+
+// BGR HWC uint8 -> letterboxed RGB CHW.  `out` must hold 3 * dst_w * dst_h
+// elements.  The float variant scales to [0,1]; the uint8 variant keeps
+// raw values (expand later with chwToFloat).
+Letterbox letterboxToCHW(const cv::Mat& bgr, int dst_w, int dst_h, float* out);
+Letterbox letterboxToCHW(const cv::Mat& bgr, int dst_w, int dst_h, uint8_t* out);
+
+// uint8 CHW -> float CHW in [0,1], bit-identical to the float path above.
+void chwToFloat(const uint8_t* src, size_t count, float* dst);
+
+}  // namespace edge
+
+#endif
@@ -30,6 +30,7 @@ struct EngineConfig {
     std::string engine_path;           // serialized .engine cache
     std::string calib_cache_path;      // INT8 cache
     std::string calib_images_dir;      // INT8 calibration images
+    std::string calib_shard_path;      // preprocessed images (calib_prep)
     Precision   precision     = Precision::FP16;
     int         input_width   = 640;
     int         input_height  = 640;
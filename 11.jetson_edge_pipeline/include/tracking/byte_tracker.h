@@ -6,6 +6,7 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 namespace edge {
 
@@ -16,6 +17,14 @@ struct ByteTrackConfig {
     float match_thresh      = 0.8f;  // IoU distance threshold
     int   track_buffer      = 30;    // frames before a lost track is removed
     int   frame_rate        = 30;
+
+    // Partitioned association: one independent Hungarian problem per class
+    // (or per class group) instead of a single pool.  Rules out
+    // cross-class matches and shrinks the O(n^3) solve; ids stay global.
+    bool  per_class         = false;
+    std::vector<std::vector<int>> class_groups;  // e.g. {{2,5,7}} car/bus/truck;
+                                                 // unlisted classes stand alone
+    int   partition_threads = 1;     // >1: solve partitions concurrently
 };
 
 enum class TrackState { NEW, TRACKED, LOST, REMOVED };
@@ -61,8 +70,27 @@ public:
     int currentFrame() const { return frame_id_; }
     int activeTracks() const { return static_cast<int>(tracked_.size()); }
 
+    // Last update(): number of partitions and total cost-matrix cells
+    // (both association rounds) — for benchmarking partitioned mode.
+    int    lastPartitions() const { return last_partitions_; }
+    size_t lastCostCells()  const { return last_cost_cells_; }
+
 private:
+    // One self-contained association problem (all of it when !per_class).
+    struct Partition {
+        std::vector<STrack*> pool;         // tracked + lost, in that order
+        std::vector<STrack>  hi, lo;       // detection stubs
+        std::vector<bool>    hi_matched;
+        size_t               cost_cells = 0;
+    };
+
+    int  partitionKey(int class_id) const;
+    void associate(Partition& p) const;    // touches only p.pool tracks
+
     ByteTrackConfig cfg_;
+    std::unordered_map<int, int> class_group_;   // class id -> group key
+    int    last_partitions_ = 0;
+    size_t last_cost_cells_ = 0;
     int frame_id_   = 0;
     int next_id_    = 1;
 
@@ -65,7 +65,8 @@ std::string CsiCamera::buildPipelineString() {
     // Convert to plain raw so the rest of the pipeline (non-Jetson code) can
     // still consume it. On Jetson, replace this nvvidconv with the NVMM path
     // (handled by EdgePipeline).
-    ss << "! nvvidconv ! video/x-raw,format=" << caps_.fmt;
+    // native_out: NV12, the cheapest copy out of NVMM.
+    ss << "! nvvidconv ! video/x-raw,format=" << (caps_.native_out ? "NV12" : caps_.fmt);
     return ss.str();
 }
 
@@ -42,11 +42,14 @@ std::string GigeCamera::buildPipelineString() {
         ss << " exposure-time=" << exposure_us_;
 
     // Aravis output is typically Bayer or RGB depending on the sensor.
-    // bayer2rgb / videoconvert normalizes to the requested format.
+    // bayer2rgb / videoconvert normalizes to the requested format
+    // (native_out: bayer2rgb's 32-bit RGB as is).
     ss << " ! video/x-bayer,format=rggb,width=" << caps_.width
        << ",height=" << caps_.height
        << ",framerate=" << caps_.framerate << "/1 "
-       << "! bayer2rgb ! videoconvert ! video/x-raw,format=" << caps_.fmt;
+       << "! bayer2rgb";
+    if (!caps_.native_out)
+        ss << " ! videoconvert ! video/x-raw,format=" << caps_.fmt;
     return ss.str();
 }
 
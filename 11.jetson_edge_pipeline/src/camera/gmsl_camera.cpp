@@ -47,15 +47,18 @@ std::string GmslCamera::buildPipelineString() {
            << " ! video/x-raw(memory:NVMM),width="
            << caps_.width << ",height=" << caps_.height
            << ",framerate=" << caps_.framerate << "/1,format=NV12 "
-           << "! nvvidconv ! video/x-raw,format=" << caps_.fmt;
+           << "! nvvidconv ! video/x-raw,format="
+           << (caps_.native_out ? "NV12" : caps_.fmt);
     } else {
         // YUV-direct GMSL: deserializer presents YUYV/UYVY via v4l2
         ss << "v4l2src device=" << node_ << " io-mode=4 ! "
            << "video/x-raw,width="   << caps_.width
            << ",height="             << caps_.height
            << ",framerate="          << caps_.framerate << "/1"
-           << ",format=UYVY ! "
-           << "videoconvert ! video/x-raw,format=" << caps_.fmt;
+           << ",format=UYVY";
+        // native_out: UYVY as delivered
+        if (!caps_.native_out)
+            ss << " ! videoconvert ! video/x-raw,format=" << caps_.fmt;
     }
     return ss.str();
 }
@@ -37,14 +37,16 @@ std::string UsbCamera::buildPipelineString() {
         ss << "image/jpeg,width=" << caps_.width
            << ",height=" << caps_.height
            << ",framerate=" << caps_.framerate << "/1 ! ";
-        ss << "jpegdec ! ";
+        ss << "jpegdec";
     } else {
         ss << "video/x-raw,width=" << caps_.width
            << ",height=" << caps_.height
-           << ",framerate=" << caps_.framerate << "/1 ! ";
+           << ",framerate=" << caps_.framerate << "/1";
     }
 
-    ss << "videoconvert ! video/x-raw,format=" << caps_.fmt;
+    // native_out: YUY2 (or I420 from jpegdec) as delivered
+    if (!caps_.native_out)
+        ss << " ! videoconvert ! video/x-raw,format=" << caps_.fmt;
     return ss.str();
 }
 
@@ -1,5 +1,6 @@
 #include "edge_pipeline.h"
 #include "camera/camera_factory.h"
+#include "inference/preprocess.h"
 
 #include <gst/video/video.h>
 #include <opencv2/imgproc.hpp>
@@ -7,6 +8,8 @@
 #include <opencv2/videoio.hpp>
 
 #include <iostream>
+#include <iomanip>
+#include <sstream>
 #include <chrono>
 #include <filesystem>
 
@@ -41,6 +44,7 @@ bool EdgePipeline::initialize(const PipelineConfig& cfg) {
     ec.onnx_path        = cfg_.onnx_path;
     ec.calib_images_dir = cfg_.calib_dir;
     ec.calib_cache_path = cfg_.calib_cache;
+    ec.calib_shard_path = cfg_.calib_shard;
     ec.precision        = cfg_.precision;
     ec.input_width      = 640;
     ec.input_height     = 640;
@@ -84,10 +88,50 @@ bool EdgePipeline::buildGstPipeline() {
     height_ = cfg_.caps.height;
 
     std::string src = camera_->buildPipelineString();
-    std::string full =
-        src + " ! appsink name=sink emit-signals=true "
-              "max-buffers=2 drop=true sync=false "
-              "caps=video/x-raw,format=BGR";
+    const std::string appsink =
+        "appsink name=sink emit-signals=true "
+        "max-buffers=2 drop=true sync=false ";
+    std::string full;
+
+    if (!cfg_.dual_branch) {
+        full = src + " ! " + appsink + "caps=video/x-raw,format=BGR";
+    } else {
+        // The camera stops at its native format (NV12/YUY2/UYVY…): the only
+        // full-resolution conversion left is on the display/record branch.
+        CameraCaps native = camera_->getCaps();
+        native.native_out = true;
+        camera_->setCaps(native);
+        src = camera_->buildPipelineString();
+
+        // Largest aspect-preserving size that fits the network input, so
+        // infer() only pads (letterbox scale 1) instead of resizing a
+        // 1080p/4K frame on the CPU.  Even dims keep videoscale happy.
+        Letterbox lb = computeLetterbox(width_, height_,
+                                        engine_->inputWidth(),
+                                        engine_->inputHeight());
+        infer_w_ = lb.new_w & ~1;
+        infer_h_ = lb.new_h & ~1;
+
+        std::ostringstream ss;
+        const bool need_full = cfg_.enable_display || !cfg_.output_video.empty();
+        // Scale first (native format), then convert the small frame to BGR.
+        const std::string infer_branch =
+            "videoscale ! video/x-raw,width=" + std::to_string(infer_w_) +
+            ",height=" + std::to_string(infer_h_) +
+            " ! videoconvert ! video/x-raw,format=BGR ! " + appsink;
+        if (need_full) {
+            ss << src << " ! tee name=t "
+               << "t. ! queue leaky=downstream max-size-buffers=1 ! " << infer_branch
+               << "t. ! queue leaky=downstream max-size-buffers=2 ! "
+                  "videoconvert ! video/x-raw,format=BGR ! "
+                  "appsink name=full_sink emit-signals=false "
+                  "max-buffers=4 drop=true sync=false";
+        } else {
+            // Nothing consumes full resolution — no tee, no second copy.
+            ss << src << " ! " << infer_branch;
+        }
+        full = ss.str();
+    }
 
     std::cout << "[pipeline] GStreamer pipeline:\n  " << full << "\n";
 
@@ -102,6 +146,7 @@ bool EdgePipeline::buildGstPipeline() {
 
     gst_sink_ = gst_bin_get_by_name(GST_BIN(gst_pipeline_), "sink");
     g_signal_connect(gst_sink_, "new-sample", G_CALLBACK(onNewSample), this);
+    gst_full_sink_ = gst_bin_get_by_name(GST_BIN(gst_pipeline_), "full_sink");
 
     return true;
 }
@@ -116,6 +161,55 @@ GstFlowReturn EdgePipeline::onNewSample(GstAppSink* sink, gpointer user) {
     return GST_FLOW_OK;
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// Full-resolution frame matching the inference frame's PTS (both branches
+// carry the tee's timestamps).  Never waits: whatever full_sink already
+// holds is moved into full_frames_, and the frame with the same PTS — or
+// the newest older one, if its twin has not arrived yet — is used.
+static constexpr size_t kMaxFullFrames = 8;
+
+bool EdgePipeline::pullFullFrame(GstClockTime pts, cv::Mat& out) {
+    while (GstSample* pulled = gst_app_sink_try_pull_sample(GST_APP_SINK(gst_full_sink_), 0)) {
+        full_frames_.push_back(pulled);
+        if (full_frames_.size() > kMaxFullFrames) {
+            gst_sample_unref(full_frames_.front());
+            full_frames_.pop_front();
+        }
+    }
+    if (!GST_CLOCK_TIME_IS_VALID(pts)) return false;
+
+    auto ptsOf = [](GstSample* smp) {
+        GstBuffer* b = gst_sample_get_buffer(smp);
+        return b ? GST_BUFFER_PTS(b) : GST_CLOCK_TIME_NONE;
+    };
+    size_t match = full_frames_.size();
+    for (size_t i = 0; i < full_frames_.size(); ++i) {
+        GstClockTime t = ptsOf(full_frames_[i]);
+        if (GST_CLOCK_TIME_IS_VALID(t) && t <= pts) match = i;
+    }
+    if (match == full_frames_.size()) return false;
+
+    // Older frames can no longer match a later inference frame
+    for (size_t i = 0; i < match; ++i) gst_sample_unref(full_frames_[i]);
+    full_frames_.erase(full_frames_.begin(), full_frames_.begin() + match);
+    GstSample* s = full_frames_.front();
+
+    bool ok = false;
+    GstBuffer* buf  = gst_sample_get_buffer(s);
+    GstCaps*   caps = gst_sample_get_caps(s);
+    GstVideoInfo vinfo;
+    GstMapInfo m;
+    if (buf && caps && gst_video_info_from_caps(&vinfo, caps) &&
+        gst_buffer_map(buf, &m, GST_MAP_READ)) {
+        cv::Mat frame(GST_VIDEO_INFO_HEIGHT(&vinfo), GST_VIDEO_INFO_WIDTH(&vinfo),
+                      CV_8UC3, m.data, GST_VIDEO_INFO_PLANE_STRIDE(&vinfo, 0));
+        out = frame.clone();
+        gst_buffer_unmap(buf, &m);
+        ok = true;
+    }
+    return ok;
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 void EdgePipeline::onFrame(GstSample* sample) {
     using clk = std::chrono::high_resolution_clock;
@@ -123,6 +217,7 @@ void EdgePipeline::onFrame(GstSample* sample) {
     GstBuffer* buf  = gst_sample_get_buffer(sample);
     GstCaps*   caps = gst_sample_get_caps(sample);
     if (!buf || !caps) return;
+    const GstClockTime pts = GST_BUFFER_PTS(buf);
 
     GstVideoInfo vinfo;
     gst_video_info_from_caps(&vinfo, caps);
@@ -138,6 +233,18 @@ void EdgePipeline::onFrame(GstSample* sample) {
 
     auto t0 = clk::now();
     auto dets = engine_->infer(frame_copy.data, w, h);
+
+    // dual_branch: detections are in inference-frame pixels — map them to
+    // full resolution so tracks, callbacks and overlays stay in camera
+    // coordinates.
+    if (cfg_.dual_branch && (w != width_ || h != height_)) {
+        const float sx = static_cast<float>(width_)  / w;
+        const float sy = static_cast<float>(height_) / h;
+        for (auto& d : dets) {
+            d.x *= sx; d.w *= sx;
+            d.y *= sy; d.h *= sy;
+        }
+    }
     auto t1 = clk::now();
     auto tracks = tracker_->update(dets);
     auto t2 = clk::now();
@@ -179,7 +286,12 @@ void EdgePipeline::onFrame(GstSample* sample) {
 
     // ── Visualization ────────────────────────────────────────────────────────
     if (cfg_.enable_display || !cfg_.output_video.empty()) {
-        cv::Mat disp = frame_copy.clone();
+        cv::Mat disp;
+        if (!gst_full_sink_ || !pullFullFrame(pts, disp)) {
+            disp = frame_copy.clone();
+            if (disp.cols != width_ || disp.rows != height_)
+                cv::resize(disp, disp, {width_, height_});
+        }
         for (auto& d : tracks) {
             cv::Scalar color(
                 (d.track_id * 67)  % 255,
@@ -253,6 +365,9 @@ void EdgePipeline::stop() {
     if (g_writer.isOpened()) g_writer.release();
     if (cfg_.enable_display) cv::destroyAllWindows();
     if (gst_sink_)     { gst_object_unref(gst_sink_); gst_sink_ = nullptr; }
+    if (gst_full_sink_) { gst_object_unref(gst_full_sink_); gst_full_sink_ = nullptr; }
+    for (GstSample* s : full_frames_) gst_sample_unref(s);
+    full_frames_.clear();
     if (gst_pipeline_) { gst_object_unref(gst_pipeline_); gst_pipeline_ = nullptr; }
 }
 
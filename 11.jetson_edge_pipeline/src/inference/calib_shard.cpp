@@ -0,0 +1,260 @@
+#include "inference/calib_shard.h"
+#include "inference/preprocess.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace edge {
+
+namespace {
+
+constexpr char     kMagic[8] = {'E', 'D', 'G', 'E', 'C', 'A', 'L', '\0'};
+constexpr uint32_t kVersion  = 2;   // 2: source_count + list_hash
+
+uint64_t align64(uint64_t v) { return (v + 63) & ~uint64_t(63); }
+
+void setErr(std::string* err, const std::string& msg) {
+    if (err) *err = msg;
+}
+
+}  // namespace
+
+// ─────────────────────────────────────────────────────────────────────────────
+std::vector<std::string> listCalibImages(const std::string& dir) {
+    std::vector<std::string> out;
+    std::error_code ec;
+    if (!fs::is_directory(dir, ec)) return out;
+    for (auto& e : fs::directory_iterator(dir, ec)) {
+        if (!e.is_regular_file()) continue;
+        auto ext = e.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp")
+            out.push_back(e.path().string());
+    }
+    // Deterministic order → reproducible calibration caches.
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+uint64_t calibListHash(const std::vector<std::string>& images, size_t max_images) {
+    size_t n = images.size();
+    if (max_images > 0) n = std::min(n, max_images);
+
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* p, size_t len) {
+        const auto* b = static_cast<const uint8_t*>(p);
+        for (size_t i = 0; i < len; ++i) { h ^= b[i]; h *= 1099511628211ull; }
+    };
+    for (size_t i = 0; i < n; ++i) {
+        std::error_code ec;
+        std::string name = fs::path(images[i]).filename().string();
+        uint64_t size    = fs::file_size(images[i], ec);
+        if (ec) size = 0;
+        mix(name.c_str(), name.size() + 1);   // NUL separates the names
+        mix(&size, sizeof(size));
+    }
+    return h;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+size_t buildCalibShard(const std::vector<std::string>& images,
+                       const std::string& out_path,
+                       const CalibShardOptions& opt,
+                       std::string* err) {
+    size_t n = images.size();
+    if (opt.max_images > 0) n = std::min(n, opt.max_images);
+    if (n == 0) { setErr(err, "no calibration images"); return 0; }
+    if (opt.input_w <= 0 || opt.input_h <= 0) {
+        setErr(err, "invalid input size");
+        return 0;
+    }
+
+    const size_t elem   = opt.dtype == ShardDType::U8 ? 1 : sizeof(float);
+    const size_t elems  = size_t(3) * opt.input_w * opt.input_h;
+    const uint64_t sample_bytes = elems * elem;
+    const uint64_t index_off    = align64(sizeof(ShardHeader));
+    const uint64_t data_off     = align64(index_off + n * sizeof(ShardEntry));
+    const uint64_t total        = data_off + n * sample_bytes;
+
+    // Write to a temp file and rename, so a crashed run never leaves a
+    // half-filled shard that the calibrator would happily consume.
+    const std::string tmp = out_path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { setErr(err, "cannot create " + tmp); return 0; }
+    if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        ::close(fd); ::unlink(tmp.c_str());
+        setErr(err, "ftruncate failed (disk full?)");
+        return 0;
+    }
+    void* map = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        ::close(fd); ::unlink(tmp.c_str());
+        setErr(err, "mmap failed");
+        return 0;
+    }
+    auto* base    = static_cast<uint8_t*>(map);
+    auto* entries = reinterpret_cast<ShardEntry*>(base + index_off);
+    uint8_t* data = base + data_off;
+
+    // ── Parallel decode + letterbox, each worker writes its own slot ────────
+    std::vector<uint8_t> ok(n, 0);
+    std::atomic<size_t>  next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < n; i = next++) {
+            cv::Mat img = cv::imread(images[i], cv::IMREAD_COLOR);
+            if (img.empty()) continue;
+
+            uint8_t* dst = data + i * sample_bytes;
+            Letterbox lb = opt.dtype == ShardDType::U8
+                ? letterboxToCHW(img, opt.input_w, opt.input_h, dst)
+                : letterboxToCHW(img, opt.input_w, opt.input_h,
+                                 reinterpret_cast<float*>(dst));
+
+            ShardEntry& e = entries[i];
+            std::memset(&e, 0, sizeof(e));
+            e.orig_w = static_cast<uint32_t>(img.cols);
+            e.orig_h = static_cast<uint32_t>(img.rows);
+            e.scale  = lb.scale;
+            e.dx     = lb.dx;
+            e.dy     = lb.dy;
+            auto name = fs::path(images[i]).filename().string();
+            std::strncpy(e.name, name.c_str(), sizeof(e.name) - 1);
+            ok[i] = 1;
+        }
+    };
+
+    int threads = opt.threads > 0
+        ? opt.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(n)));
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    // ── Compact out failed decodes (rare — keep it serial) ──────────────────
+    size_t w = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!ok[i]) continue;
+        if (w != i) {
+            entries[w] = entries[i];
+            std::memmove(data + w * sample_bytes, data + i * sample_bytes,
+                         sample_bytes);
+        }
+        ++w;
+    }
+
+    ShardHeader hdr{};
+    std::memcpy(hdr.magic, kMagic, sizeof(kMagic));
+    hdr.version      = kVersion;
+    hdr.dtype        = static_cast<uint32_t>(opt.dtype);
+    hdr.count        = static_cast<uint32_t>(w);
+    hdr.channels     = 3;
+    hdr.height       = static_cast<uint32_t>(opt.input_h);
+    hdr.width        = static_cast<uint32_t>(opt.input_w);
+    hdr.source_count = static_cast<uint32_t>(n);
+    hdr.index_offset = index_off;
+    hdr.data_offset  = data_off;
+    hdr.sample_bytes = sample_bytes;
+    hdr.list_hash    = calibListHash(images, n);
+    std::memcpy(base, &hdr, sizeof(hdr));
+
+    ::msync(map, total, MS_SYNC);
+    ::munmap(map, total);
+    bool good = ::ftruncate(fd, static_cast<off_t>(data_off + w * sample_bytes)) == 0;
+    ::close(fd);
+
+    if (!good || w == 0) {
+        ::unlink(tmp.c_str());
+        setErr(err, w == 0 ? "no readable calibration images" : "ftruncate failed");
+        return 0;
+    }
+    if (std::rename(tmp.c_str(), out_path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        setErr(err, "cannot rename " + tmp + " -> " + out_path);
+        return 0;
+    }
+    return w;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+CalibShard::~CalibShard() { close(); }
+
+bool CalibShard::open(const std::string& path, std::string* err) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { setErr(err, "cannot open " + path); return false; }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(ShardHeader)) {
+        ::close(fd);
+        setErr(err, "truncated shard " + path);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) { setErr(err, "mmap failed: " + path); return false; }
+
+    auto* base = static_cast<uint8_t*>(map);
+    auto* hdr  = reinterpret_cast<const ShardHeader*>(base);
+    const size_t elem = hdr->dtype == static_cast<uint32_t>(ShardDType::U8)
+                            ? 1 : sizeof(float);
+    bool valid =
+        std::memcmp(hdr->magic, kMagic, sizeof(kMagic)) == 0 &&
+        hdr->version == kVersion &&
+        hdr->dtype <= static_cast<uint32_t>(ShardDType::U8) &&
+        hdr->sample_bytes ==
+            uint64_t(hdr->channels) * hdr->height * hdr->width * elem &&
+        hdr->index_offset + uint64_t(hdr->count) * sizeof(ShardEntry) <= hdr->data_offset &&
+        hdr->data_offset + uint64_t(hdr->count) * hdr->sample_bytes <= size;
+    if (!valid) {
+        ::munmap(map, size);
+        setErr(err, "not a calibration shard (or wrong version): " + path);
+        return false;
+    }
+
+    // Sequential access pattern — let the kernel read ahead aggressively.
+    ::madvise(map, size, MADV_SEQUENTIAL);
+
+    base_    = base;
+    size_    = size;
+    hdr_     = hdr;
+    entries_ = reinterpret_cast<const ShardEntry*>(base + hdr->index_offset);
+    return true;
+}
+
+void CalibShard::close() {
+    if (base_) ::munmap(base_, size_);
+    base_ = nullptr; size_ = 0; hdr_ = nullptr; entries_ = nullptr;
+}
+
+const void* CalibShard::sample(size_t i) const {
+    return base_ + hdr_->data_offset + i * hdr_->sample_bytes;
+}
+
+void CalibShard::copyFloat(size_t first, size_t n, float* dst) const {
+    const size_t elems = sampleElems();
+    if (dtype() == ShardDType::F32) {
+        std::memcpy(dst, sample(first), n * hdr_->sample_bytes);
+        return;
+    }
+    chwToFloat(static_cast<const uint8_t*>(sample(first)), n * elems, dst);
+}
+
+}  // namespace edge
@@ -1,13 +1,10 @@
 #include "inference/int8_calibrator.h"
 
-#include <opencv2/imgcodecs.hpp>
-#include <opencv2/imgproc.hpp>
 #include <cuda_runtime_api.h>
 
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <cstring>
 
 namespace fs = std::filesystem;
 
@@ -15,19 +12,11 @@ namespace edge {
 
 Int8EntropyCalibrator2::Int8EntropyCalibrator2(int bs, int w, int h,
                                                const std::string& dir,
-                                               const std::string& cache_file)
-    : batch_size_(bs), input_w_(w), input_h_(h), cache_file_(cache_file) {
-
-    if (fs::exists(dir)) {
-        for (auto& e : fs::directory_iterator(dir)) {
-            auto ext = e.path().extension().string();
-            if (ext == ".jpg" || ext == ".png" || ext == ".jpeg")
-                images_.push_back(e.path().string());
-        }
-        std::cout << "[INT8] Calibration set: " << images_.size()
-                  << " images from " << dir << "\n";
-    }
-
+                                               const std::string& cache_file,
+                                               const std::string& shard_file)
+    : batch_size_(bs), input_w_(w), input_h_(h), images_dir_(dir),
+      shard_file_(shard_file.empty() ? cache_file + ".shard" : shard_file),
+      cache_file_(cache_file) {
     cudaMalloc(&device_input_, batch_size_ * 3 * w * h * sizeof(float));
 }
 
@@ -35,38 +24,70 @@ Int8EntropyCalibrator2::~Int8EntropyCalibrator2() {
     if (device_input_) cudaFree(device_input_);
 }
 
+bool Int8EntropyCalibrator2::ensureShard() {
+    if (shard_.isOpen()) return true;
+
+    // The shard is reused only for the same input size and the same image
+    // list (count + names/sizes), so adding or replacing images rebuilds it.
+    auto images = listCalibImages(images_dir_);
+    std::string err;
+    if (fs::exists(shard_file_) && shard_.open(shard_file_, &err)) {
+        if (shard_.width() != input_w_ || shard_.height() != input_h_) {
+            std::cout << "[INT8] Shard " << shard_file_ << " is "
+                      << shard_.width() << "x" << shard_.height()
+                      << ", network wants " << input_w_ << "x" << input_h_
+                      << " — rebuilding\n";
+        } else if (shard_.sourceCount() != images.size() ||
+                   shard_.listHash() != calibListHash(images)) {
+            std::cout << "[INT8] Shard " << shard_file_ << " was built from "
+                      << shard_.sourceCount() << " images, " << images_dir_
+                      << " has " << images.size()
+                      << (shard_.sourceCount() == images.size() ? " different ones" : "")
+                      << " — rebuilding\n";
+        } else {
+            std::cout << "[INT8] Calibration shard: " << shard_.count()
+                      << " samples from " << shard_file_ << "\n";
+            return true;
+        }
+        shard_.close();
+    }
+
+    std::cout << "[INT8] Preprocessing " << images.size()
+              << " images from " << images_dir_ << " -> " << shard_file_ << "\n";
+    CalibShardOptions opt;
+    opt.input_w = input_w_;
+    opt.input_h = input_h_;
+    if (buildCalibShard(images, shard_file_, opt, &err) == 0 ||
+        !shard_.open(shard_file_, &err)) {
+        std::cerr << "[INT8] Calibration shard unavailable: " << err << "\n";
+        return false;
+    }
+    std::cout << "[INT8] Calibration shard: " << shard_.count() << " samples\n";
+    return true;
+}
+
 bool Int8EntropyCalibrator2::getBatch(void* bindings[], const char* /*names*/[],
                                       int /*nb*/) noexcept {
-    if (current_idx_ + batch_size_ > static_cast<int>(images_.size()))
+    if (!ensureShard()) return false;
+    if (current_idx_ + batch_size_ > static_cast<int>(shard_.count()))
         return false;
 
-    std::vector<float> batch(batch_size_ * 3 * input_w_ * input_h_);
-    int per_img = 3 * input_w_ * input_h_;
-
-    for (int b = 0; b < batch_size_; ++b) {
-        cv::Mat img = cv::imread(images_[current_idx_ + b]);
-        if (img.empty()) continue;
-        cv::Mat resized;
-        cv::resize(img, resized, {input_w_, input_h_});
-        cv::cvtColor(resized, resized, cv::COLOR_BGR2RGB);
-        resized.convertTo(resized, CV_32FC3, 1.0 / 255.0);
-
-        std::vector<cv::Mat> chans(3);
-        cv::split(resized, chans);
-        for (int c = 0; c < 3; ++c) {
-            std::memcpy(batch.data() + b * per_img + c * input_w_ * input_h_,
-                        chans[c].data, input_w_ * input_h_ * sizeof(float));
-        }
+    const size_t bytes = size_t(batch_size_) * shard_.sampleElems() * sizeof(float);
+    if (shard_.dtype() == ShardDType::F32) {
+        // Samples are contiguous in the mapping — upload without a host copy.
+        cudaMemcpy(device_input_, shard_.sample(current_idx_), bytes,
+                   cudaMemcpyHostToDevice);
+    } else {
+        staging_.resize(size_t(batch_size_) * shard_.sampleElems());
+        shard_.copyFloat(current_idx_, batch_size_, staging_.data());
+        cudaMemcpy(device_input_, staging_.data(), bytes, cudaMemcpyHostToDevice);
     }
-
-    cudaMemcpy(device_input_, batch.data(), batch.size() * sizeof(float),
-               cudaMemcpyHostToDevice);
     bindings[0] = device_input_;
     current_idx_ += batch_size_;
 
     if (current_idx_ % 50 == 0)
         std::cout << "[INT8] Calibrated " << current_idx_ << "/"
-                  << images_.size() << "\n";
+                  << shard_.count() << "\n";
     return true;
 }
 
@@ -0,0 +1,77 @@
+#include "inference/preprocess.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+namespace edge {
+
+namespace {
+
+constexpr float kInv255 = 1.f / 255.f;
+
+// One pass over the letterboxed image: BGR->RGB swap, HWC->CHW split and
+// (for float) normalisation.  Replaces cvtColor + convertTo + split, each
+// of which walked the full frame and allocated a temporary.
+template <typename T, typename Conv>
+void splitRGB(const cv::Mat& letter, T* out, Conv conv) {
+    const int W = letter.cols, H = letter.rows;
+    const size_t plane = static_cast<size_t>(W) * H;
+    T* r = out;
+    T* g = out + plane;
+    T* b = out + 2 * plane;
+    for (int y = 0; y < H; ++y) {
+        const uint8_t* p = letter.ptr<uint8_t>(y);
+        const size_t row = static_cast<size_t>(y) * W;
+        for (int x = 0; x < W; ++x, p += 3) {
+            b[row + x] = conv(p[0]);
+            g[row + x] = conv(p[1]);
+            r[row + x] = conv(p[2]);
+        }
+    }
+}
+
+Letterbox letterbox(const cv::Mat& bgr, int dst_w, int dst_h, cv::Mat& letter) {
+    Letterbox lb = computeLetterbox(bgr.cols, bgr.rows, dst_w, dst_h);
+    letter.create(dst_h, dst_w, CV_8UC3);
+    letter.setTo(cv::Scalar(kLetterboxPad, kLetterboxPad, kLetterboxPad));
+    cv::Mat roi = letter(cv::Rect(lb.dx, lb.dy, lb.new_w, lb.new_h));
+    if (lb.new_w == bgr.cols && lb.new_h == bgr.rows)
+        bgr.copyTo(roi);
+    else
+        cv::resize(bgr, roi, roi.size());   // writes straight into the ROI
+    return lb;
+}
+
+}  // namespace
+
+Letterbox computeLetterbox(int src_w, int src_h, int dst_w, int dst_h) {
+    Letterbox lb;
+    lb.scale = std::min(static_cast<float>(dst_w) / src_w,
+                        static_cast<float>(dst_h) / src_h);
+    lb.new_w = std::max(1, std::min(dst_w, static_cast<int>(src_w * lb.scale)));
+    lb.new_h = std::max(1, std::min(dst_h, static_cast<int>(src_h * lb.scale)));
+    lb.dx = (dst_w - lb.new_w) / 2;
+    lb.dy = (dst_h - lb.new_h) / 2;
+    return lb;
+}
+
+Letterbox letterboxToCHW(const cv::Mat& bgr, int dst_w, int dst_h, float* out) {
+    thread_local cv::Mat letter;
+    Letterbox lb = letterbox(bgr, dst_w, dst_h, letter);
+    splitRGB(letter, out, [](uint8_t v) { return v * kInv255; });
+    return lb;
+}
+
+Letterbox letterboxToCHW(const cv::Mat& bgr, int dst_w, int dst_h, uint8_t* out) {
+    thread_local cv::Mat letter;
+    Letterbox lb = letterbox(bgr, dst_w, dst_h, letter);
+    splitRGB(letter, out, [](uint8_t v) { return v; });
+    return lb;
+}
+
+void chwToFloat(const uint8_t* src, size_t count, float* dst) {
+    for (size_t i = 0; i < count; ++i) dst[i] = src[i] * kInv255;
+}
+
+}  // namespace edge
@@ -1,5 +1,6 @@
 #include "inference/tensorrt_engine.h"
 #include "inference/int8_calibrator.h"
+#include "inference/preprocess.h"
 
 #include <NvInfer.h>
 #include <NvOnnxParser.h>
@@ -86,7 +87,7 @@ bool TensorRTEngine::build(const EngineConfig& cfg) {
         config->setFlag(nvinfer1::BuilderFlag::kINT8);
         calib = std::make_unique<Int8EntropyCalibrator2>(
             1, cfg.input_width, cfg.input_height,
-            cfg.calib_images_dir, cfg.calib_cache_path);
+            cfg.calib_images_dir, cfg.calib_cache_path, cfg.calib_shard_path);
         config->setInt8Calibrator(calib.get());
     }
 
@@ -208,29 +209,12 @@ std::vector<Detection> TensorRTEngine::infer(const uint8_t* bgr,
     cv::Mat src(orig_h, orig_w, CV_8UC3, const_cast<uint8_t*>(bgr));
 
     int Wi = cfg_.input_width, Hi = cfg_.input_height;
-    float r = std::min(static_cast<float>(Wi) / orig_w,
-                       static_cast<float>(Hi) / orig_h);
-    int nw = static_cast<int>(orig_w * r);
-    int nh = static_cast<int>(orig_h * r);
-    int dx = (Wi - nw) / 2;
-    int dy = (Hi - nh) / 2;
-
-    cv::Mat resized;
-    cv::resize(src, resized, {nw, nh});
-    cv::Mat letter(Hi, Wi, CV_8UC3, cv::Scalar(114, 114, 114));
-    resized.copyTo(letter(cv::Rect(dx, dy, nw, nh)));
-
-    cv::Mat rgb;
-    cv::cvtColor(letter, rgb, cv::COLOR_BGR2RGB);
-    rgb.convertTo(rgb, CV_32FC3, 1.0 / 255.0);
-
-    // HWC -> CHW
-    std::vector<cv::Mat> chans(3);
-    cv::split(rgb, chans);
-    std::vector<float> chw(3 * Wi * Hi);
-    std::memcpy(chw.data() + 0 * Wi * Hi, chans[0].data, Wi * Hi * sizeof(float));
-    std::memcpy(chw.data() + 1 * Wi * Hi, chans[1].data, Wi * Hi * sizeof(float));
-    std::memcpy(chw.data() + 2 * Wi * Hi, chans[2].data, Wi * Hi * sizeof(float));
+    thread_local std::vector<float> chw;
+    chw.resize(3 * Wi * Hi);
+    const Letterbox lb = letterboxToCHW(src, Wi, Hi, chw.data());
+    const float r  = lb.scale;
+    const int   dx = lb.dx;
+    const int   dy = lb.dy;
 
     cudaMemcpyAsync(impl_->d_input, chw.data(), impl_->input_size_bytes,
                     cudaMemcpyHostToDevice, stream);
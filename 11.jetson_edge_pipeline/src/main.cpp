@@ -38,6 +38,7 @@ void printUsage(const char* p) {
 "  --fps    <hz>       Camera fps   (default 30)\n"
 "  --power  <mode>     7w | 15w | maxn   (Orin simulation)\n"
 "  --record <path>     Save annotated video\n"
+"  --dual-branch       Scale to inference size in GStreamer (tee)\n"
 "  --headless          Disable OpenCV display\n"
 "  --list              Enumerate cameras and exit\n"
 "  --benchmark         Run 1000-frame benchmark then exit\n"
@@ -71,11 +72,13 @@ bool loadYaml(const std::string& path, edge::PipelineConfig& cfg) {
                 cfg.caps.framerate = y["camera"]["framerate"].as<int>();
             if (y["camera"]["format"])
                 cfg.caps.fmt = y["camera"]["format"].as<std::string>();
+            cfg.dual_branch = y["camera"]["dual_branch"].as<bool>(cfg.dual_branch);
         }
         if (y["model"]) {
             cfg.engine_path = y["model"]["engine"].as<std::string>(cfg.engine_path);
             cfg.onnx_path   = y["model"]["onnx"].as<std::string>(cfg.onnx_path);
             cfg.calib_dir   = y["model"]["calib_dir"].as<std::string>(cfg.calib_dir);
+            cfg.calib_shard = y["model"]["calib_shard"].as<std::string>(cfg.calib_shard);
             cfg.precision   = parsePrecision(y["model"]["precision"].as<std::string>("fp16"));
         }
         if (y["tracker"]) {
@@ -89,6 +92,13 @@ bool loadYaml(const std::string& path, edge::PipelineConfig& cfg) {
                 y["tracker"]["match_thresh"].as<float>(0.8f);
             cfg.tracker.track_buffer =
                 y["tracker"]["track_buffer"].as<int>(30);
+            cfg.tracker.per_class =
+                y["tracker"]["per_class"].as<bool>(false);
+            cfg.tracker.partition_threads =
+                y["tracker"]["partition_threads"].as<int>(1);
+            if (y["tracker"]["class_groups"])
+                cfg.tracker.class_groups =
+                    y["tracker"]["class_groups"].as<std::vector<std::vector<int>>>();
         }
         if (y["output"]) {
             cfg.enable_display = y["output"]["display"].as<bool>(true);
@@ -119,6 +129,12 @@ int main(int argc, char* argv[]) {
     bool list_mode = false, bench_mode = false;
     int  bench_frames = 1000;
 
+    // YAML overrides defaults; CLI overrides YAML — so find --config and
+    // load it before applying the remaining flags.
+    for (int i = 1; i + 1 < argc; ++i)
+        if (std::string(argv[i]) == "--config") yaml_path = argv[i + 1];
+    loadYaml(yaml_path, cfg);
+
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
         auto next = [&]() { return (i + 1 < argc) ? argv[++i] : ""; };
@@ -135,6 +151,7 @@ int main(int argc, char* argv[]) {
         else if (a == "--fps")       cfg.caps.framerate = std::stoi(next());
         else if (a == "--power")     cfg.orin_mode = parsePower(next());
         else if (a == "--record")    cfg.output_video = next();
+        else if (a == "--dual-branch") cfg.dual_branch = true;
         else if (a == "--headless")  cfg.enable_display = false;
         else if (a == "--list")      list_mode  = true;
         else if (a == "--benchmark") bench_mode = true;
@@ -151,9 +168,6 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    // YAML overrides defaults; CLI overrides YAML.
-    loadYaml(yaml_path, cfg);
-
     g_pipeline = new edge::EdgePipeline();
     if (!g_pipeline->initialize(cfg)) {
         delete g_pipeline;
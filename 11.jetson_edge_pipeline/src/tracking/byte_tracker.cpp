@@ -2,11 +2,19 @@
 #include "tracking/hungarian.h"
 
 #include <algorithm>
+#include <atomic>
+#include <future>
 #include <iostream>
+#include <map>
 
 namespace edge {
 
-ByteTracker::ByteTracker(const ByteTrackConfig& cfg) : cfg_(cfg) {}
+ByteTracker::ByteTracker(const ByteTrackConfig& cfg) : cfg_(cfg) {
+    // Group keys are negative so they never collide with a bare class id.
+    for (size_t g = 0; g < cfg_.class_groups.size(); ++g)
+        for (int cls : cfg_.class_groups[g])
+            class_group_[cls] = -static_cast<int>(g) - 1;
+}
 
 // ─────────────────────────────────────────────────────────────────────────────
 float ByteTracker::iouDistance(const STrack& a, const STrack& b) {
@@ -32,60 +40,31 @@ std::vector<float> ByteTracker::buildIouCost(const std::vector<STrack*>& A,
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-std::vector<Detection> ByteTracker::update(const std::vector<Detection>& dets) {
-    ++frame_id_;
-
-    // Split detections by confidence.
-    std::vector<Detection> high_dets, low_dets;
-    for (auto& d : dets) {
-        if (d.confidence >= cfg_.track_high_thresh)      high_dets.push_back(d);
-        else if (d.confidence >= cfg_.track_low_thresh)  low_dets.push_back(d);
-    }
-
-    // ── 1) Predict every existing track ──────────────────────────────────────
-    auto predict_all = [](std::vector<STrack>& tracks) {
-        for (auto& t : tracks) {
-            if (!t.kf_initialized) continue;
-            cv::Vec4f xyah = t.kf.predict();
-            t.xyah_to_tlwh(xyah);
-        }
-    };
-    predict_all(tracked_);
-    predict_all(lost_);
-
-    // Pool: tracked + lost  --> first-stage candidates
-    std::vector<STrack*> pool;
-    for (auto& t : tracked_) pool.push_back(&t);
-    for (auto& t : lost_)    pool.push_back(&t);
-
-    // Convert high detections to STrack stubs
-    auto detToTrack = [&](const Detection& d) {
-        STrack s;
-        s.x = d.x; s.y = d.y; s.w = d.w; s.h = d.h;
-        s.score = d.confidence;
-        s.class_id = d.class_id;
-        return s;
-    };
+int ByteTracker::partitionKey(int class_id) const {
+    if (!cfg_.per_class) return 0;
+    auto it = class_group_.find(class_id);
+    return it != class_group_.end() ? it->second : class_id;
+}
 
-    std::vector<STrack> hi_st;
-    hi_st.reserve(high_dets.size());
-    for (auto& d : high_dets) hi_st.push_back(detToTrack(d));
+// Steps 2–4 of ByteTrack for one partition.  Only tracks referenced by
+// p.pool are modified, so disjoint partitions can run concurrently.
+void ByteTracker::associate(Partition& p) const {
     std::vector<STrack*> hi_ptr;
-    for (auto& s : hi_st) hi_ptr.push_back(&s);
+    for (auto& s : p.hi) hi_ptr.push_back(&s);
 
     // ── 2) First association: tracked+lost vs. high detections ───────────────
-    auto cost1 = buildIouCost(pool, hi_ptr);
+    auto cost1 = buildIouCost(p.pool, hi_ptr);
     for (auto& v : cost1) if (v > cfg_.match_thresh) v = Hungarian::INF_COST;
-    auto assign1 = Hungarian::solve(cost1, pool.size(), hi_ptr.size());
+    auto assign1 = Hungarian::solve(cost1, p.pool.size(), hi_ptr.size());
 
-    std::vector<bool> hi_matched(hi_ptr.size(), false);
-    std::vector<bool> pool_matched(pool.size(), false);
+    p.hi_matched.assign(hi_ptr.size(), false);
+    std::vector<bool> pool_matched(p.pool.size(), false);
 
     for (size_t i = 0; i < assign1.size(); ++i) {
         int j = assign1[i];
         if (j < 0) continue;
-        STrack* track = pool[i];
-        STrack& det   = hi_st[j];
+        STrack* track = p.pool[i];
+        STrack& det   = p.hi[j];
 
         track->x = det.x; track->y = det.y;
         track->w = det.w; track->h = det.h;
@@ -101,22 +80,19 @@ std::vector<Detection> ByteTracker::update(const std::vector<Detection>& dets) {
             track->kf.update(track->tlwh_to_xyah());
         }
         track->state = TrackState::TRACKED;
-        hi_matched[j]    = true;
+        p.hi_matched[j]  = true;
         pool_matched[i]  = true;
     }
 
     // ── 3) Second association: unmatched tracked vs. low-conf detections ─────
     std::vector<STrack*> remain_tracked;
-    for (size_t i = 0; i < pool.size(); ++i) {
-        if (!pool_matched[i] && pool[i]->state == TrackState::TRACKED)
-            remain_tracked.push_back(pool[i]);
+    for (size_t i = 0; i < p.pool.size(); ++i) {
+        if (!pool_matched[i] && p.pool[i]->state == TrackState::TRACKED)
+            remain_tracked.push_back(p.pool[i]);
     }
 
-    std::vector<STrack> lo_st;
-    lo_st.reserve(low_dets.size());
-    for (auto& d : low_dets) lo_st.push_back(detToTrack(d));
     std::vector<STrack*> lo_ptr;
-    for (auto& s : lo_st) lo_ptr.push_back(&s);
+    for (auto& s : p.lo) lo_ptr.push_back(&s);
 
     auto cost2 = buildIouCost(remain_tracked, lo_ptr);
     for (auto& v : cost2) if (v > 0.5f) v = Hungarian::INF_COST;
@@ -126,7 +102,7 @@ std::vector<Detection> ByteTracker::update(const std::vector<Detection>& dets) {
         int j = assign2[i];
         if (j < 0) continue;
         STrack* track = remain_tracked[i];
-        STrack& det   = lo_st[j];
+        STrack& det   = p.lo[j];
         track->x = det.x; track->y = det.y;
         track->w = det.w; track->h = det.h;
         track->score = det.score;
@@ -144,20 +120,90 @@ std::vector<Detection> ByteTracker::update(const std::vector<Detection>& dets) {
         }
     }
 
+    p.cost_cells = cost1.size() + cost2.size();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+std::vector<Detection> ByteTracker::update(const std::vector<Detection>& dets) {
+    ++frame_id_;
+
+    // ── 1) Predict every existing track ──────────────────────────────────────
+    auto predict_all = [](std::vector<STrack>& tracks) {
+        for (auto& t : tracks) {
+            if (!t.kf_initialized) continue;
+            cv::Vec4f xyah = t.kf.predict();
+            t.xyah_to_tlwh(xyah);
+        }
+    };
+    predict_all(tracked_);
+    predict_all(lost_);
+
+    // Partition tracks and detections.  Without per_class everything lands
+    // in key 0, which is exactly the classic single-pool ByteTrack.
+    // std::map keeps partitions (and therefore new ids) in a stable order.
+    std::map<int, Partition> parts;
+    for (auto& t : tracked_) parts[partitionKey(t.class_id)].pool.push_back(&t);
+    for (auto& t : lost_)    parts[partitionKey(t.class_id)].pool.push_back(&t);
+
+    // Convert detections to STrack stubs, split by confidence.
+    auto detToTrack = [&](const Detection& d) {
+        STrack s;
+        s.x = d.x; s.y = d.y; s.w = d.w; s.h = d.h;
+        s.score = d.confidence;
+        s.class_id = d.class_id;
+        return s;
+    };
+    for (auto& d : dets) {
+        if (d.confidence >= cfg_.track_high_thresh)
+            parts[partitionKey(d.class_id)].hi.push_back(detToTrack(d));
+        else if (d.confidence >= cfg_.track_low_thresh)
+            parts[partitionKey(d.class_id)].lo.push_back(detToTrack(d));
+    }
+
+    // ── 2–4) Associate each partition ────────────────────────────────────────
+    std::vector<Partition*> work;
+    work.reserve(parts.size());
+    for (auto& kv : parts) work.push_back(&kv.second);
+
+    const int threads = std::min<int>(cfg_.partition_threads,
+                                      static_cast<int>(work.size()));
+    if (threads > 1) {
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < work.size(); i = next++)
+                associate(*work[i]);
+        };
+        std::vector<std::future<void>> helpers;
+        for (int t = 1; t < threads; ++t)
+            helpers.push_back(std::async(std::launch::async, worker));
+        worker();
+        for (auto& h : helpers) h.get();
+    } else {
+        for (auto* p : work) associate(*p);
+    }
+
+    last_partitions_ = static_cast<int>(work.size());
+    last_cost_cells_ = 0;
+    for (auto* p : work) last_cost_cells_ += p->cost_cells;
+
     // ── 5) New tracks from unmatched high detections ─────────────────────────
-    for (size_t j = 0; j < hi_ptr.size(); ++j) {
-        if (hi_matched[j]) continue;
-        STrack& det = hi_st[j];
-        if (det.score < cfg_.new_track_thresh) continue;
-        STrack new_t = det;
-        new_t.track_id     = next_id_++;
-        new_t.state        = TrackState::TRACKED;
-        new_t.frame_id     = frame_id_;
-        new_t.start_frame  = frame_id_;
-        new_t.tracklet_len = 1;
-        new_t.kf.init(new_t.tlwh_to_xyah());
-        new_t.kf_initialized = true;
-        tracked_.push_back(std::move(new_t));
+    // Serial, after all partitions finished: keeps the id space global and
+    // unique, and the pool pointers are no longer in use when tracked_ grows.
+    for (auto* p : work) {
+        for (size_t j = 0; j < p->hi.size(); ++j) {
+            if (p->hi_matched[j]) continue;
+            STrack& det = p->hi[j];
+            if (det.score < cfg_.new_track_thresh) continue;
+            STrack new_t = det;
+            new_t.track_id     = next_id_++;
+            new_t.state        = TrackState::TRACKED;
+            new_t.frame_id     = frame_id_;
+            new_t.start_frame  = frame_id_;
+            new_t.tracklet_len = 1;
+            new_t.kf.init(new_t.tlwh_to_xyah());
+            new_t.kf_initialized = true;
+            tracked_.push_back(std::move(new_t));
+        }
     }
 
     // ── 6) Move lost->removed, age timers ────────────────────────────────────
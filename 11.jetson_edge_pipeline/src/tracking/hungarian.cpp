@@ -14,30 +14,33 @@ std::vector<int> Hungarian::solve(const std::vector<float>& cost,
     if (rows == 0 || cols == 0) return std::vector<int>(rows, -1);
 
     int n = std::max(rows, cols);
-    const float INF = std::numeric_limits<float>::infinity();
+    const double INF = std::numeric_limits<double>::infinity();
 
-    // Pad to square with INF
-    std::vector<std::vector<float>> a(n, std::vector<float>(n, INF));
+    // Pad to square with the (finite) forbidden cost.  Padding with real
+    // infinity made every reduced cost of a padded row INF - INF = NaN, so
+    // no column was ever picked and the search indexed way[-1].  Potentials
+    // are kept in double so 1e9 forbidden entries don't swamp IoU costs.
+    std::vector<std::vector<double>> a(n, std::vector<double>(n, INF_COST));
     for (int i = 0; i < rows; ++i)
         for (int j = 0; j < cols; ++j)
-            a[i][j] = cost[i * cols + j];
+            a[i][j] = std::min<double>(cost[i * cols + j], INF_COST);
 
-    std::vector<float> u(n + 1, 0), v(n + 1, 0);
+    std::vector<double> u(n + 1, 0), v(n + 1, 0);
     std::vector<int>   p(n + 1, 0), way(n + 1, 0);
 
     for (int i = 1; i <= n; ++i) {
         p[0] = i;
         int j0 = 0;
-        std::vector<float> minv(n + 1, INF);
+        std::vector<double> minv(n + 1, INF);
         std::vector<bool>  used(n + 1, false);
 
         do {
             used[j0] = true;
             int i0 = p[j0];
-            float delta = INF;
+            double delta = INF;
             int j1 = -1;
             for (int j = 1; j <= n; ++j) if (!used[j]) {
-                float cur = a[i0 - 1][j - 1] - u[i0] - v[j];
+                double cur = a[i0 - 1][j - 1] - u[i0] - v[j];
                 if (cur < minv[j]) { minv[j] = cur; way[j] = j0; }
                 if (minv[j] < delta) { delta = minv[j]; j1 = j; }
             }
@@ -2,6 +2,7 @@
 #include <cassert>
 #include <iostream>
 #include <cmath>
+#include <set>
 
 using namespace edge;
 
@@ -15,7 +16,7 @@ static Detection mkdet(float x, float y, float w, float h,
 
 // Bir karakterin sahnede sabit hareket etmesi → aynı track_id korunmalı.
 static void test_persistent_id() {
-    ByteTracker tracker({});
+    ByteTracker tracker{ByteTrackConfig{}};
     int previous_id = -1;
     for (int t = 0; t < 30; ++t) {
         float x = 100.f + t * 5.f;
@@ -28,7 +29,7 @@ static void test_persistent_id() {
 
 // İki ayrı nesne → iki ayrı track_id, swap olmamalı.
 static void test_two_objects_no_swap() {
-    ByteTracker tracker({});
+    ByteTracker tracker{ByteTrackConfig{}};
     int id_a = -1, id_b = -1;
     for (int t = 0; t < 20; ++t) {
         auto tr = tracker.update({
@@ -71,10 +72,77 @@ static void test_track_buffer_survives_missing_frames() {
     assert(tr[0].track_id >= id);
 }
 
+// Tek havuzda aynı yere gelen farklı sınıf eski track'i "çalar";
+// per_class modunda yeni bir id almalı.
+static void test_per_class_blocks_cross_class_match() {
+    ByteTracker pooled{ByteTrackConfig{}};
+    auto a = pooled.update({ mkdet(100, 100, 60, 120, /*cls=*/0) });
+    auto b = pooled.update({ mkdet(100, 100, 60, 120, /*cls=*/2) });
+    assert(b.size() == 1);
+    assert(b[0].track_id == a[0].track_id && b[0].class_id == 2);
+
+    ByteTrackConfig cfg;
+    cfg.per_class = true;
+    ByteTracker split(cfg);
+    a = split.update({ mkdet(100, 100, 60, 120, 0) });
+    b = split.update({ mkdet(100, 100, 60, 120, 2) });
+    bool found_car = false;
+    for (auto& d : b) {
+        if (d.class_id != 2) continue;
+        found_car = true;
+        assert(d.track_id != a[0].track_id);
+    }
+    assert(found_car);
+    assert(split.lastPartitions() == 2);
+}
+
+// Grup içindeki sınıf titremesi (car <-> truck) id'yi bozmamalı.
+static void test_class_group_keeps_id() {
+    ByteTrackConfig cfg;
+    cfg.per_class    = true;
+    cfg.class_groups = {{2, 5, 7}};
+    ByteTracker tracker(cfg);
+    int id = -1;
+    for (int t = 0; t < 10; ++t) {
+        auto tr = tracker.update({ mkdet(200.f + t * 3.f, 50, 80, 60, t % 2 ? 7 : 2) });
+        assert(tr.size() == 1);
+        if (id < 0) id = tr[0].track_id;
+        else assert(tr[0].track_id == id);
+    }
+}
+
+// Paralel bölümleme: id'ler global olarak benzersiz, sonuç seri çözümle aynı.
+static void test_partitions_concurrent_unique_ids() {
+    ByteTrackConfig serial_cfg;
+    serial_cfg.per_class = true;
+    ByteTrackConfig par_cfg = serial_cfg;
+    par_cfg.partition_threads = 4;
+    ByteTracker serial(serial_cfg), par(par_cfg);
+
+    for (int t = 0; t < 15; ++t) {
+        std::vector<Detection> dets;
+        for (int k = 0; k < 12; ++k)
+            dets.push_back(mkdet(40.f * k + t * 2.f, 30.f * (k % 3), 30, 60, k % 4));
+        auto a = serial.update(dets);
+        auto b = par.update(dets);
+        assert(a.size() == b.size());
+        std::set<int> ids;
+        for (size_t i = 0; i < a.size(); ++i) {
+            assert(a[i].track_id == b[i].track_id);
+            bool unique = ids.insert(a[i].track_id).second;
+            assert(unique);
+        }
+    }
+    assert(par.lastPartitions() == 4);
+}
+
 int main() {
     test_persistent_id();
     test_two_objects_no_swap();
     test_track_buffer_survives_missing_frames();
+    test_per_class_blocks_cross_class_match();
+    test_class_group_keeps_id();
+    test_partitions_concurrent_unique_ids();
     std::cout << "test_byte_tracker: OK\n";
     return 0;
 }
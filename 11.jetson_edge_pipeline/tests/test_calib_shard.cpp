@@ -0,0 +1,131 @@
+#include "inference/calib_shard.h"
+#include "inference/preprocess.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace edge;
+namespace fs = std::filesystem;
+
+static constexpr int W = 64, H = 48;
+
+static fs::path makeCalibDir() {
+    fs::path dir = fs::temp_directory_path() / "edge_test_calib_shard";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    // Farklı en-boy oranları → farklı letterbox dx/dy.
+    cv::Mat wide(30, 90, CV_8UC3), tall(120, 40, CV_8UC3), same(H, W, CV_8UC3);
+    cv::randu(wide, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::randu(tall, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::randu(same, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::imwrite((dir / "a_wide.png").string(), wide);
+    cv::imwrite((dir / "b_tall.png").string(), tall);
+    cv::imwrite((dir / "d_same.png").string(), same);
+
+    // Bozuk dosya — shard'dan düşürülmeli.
+    std::ofstream(dir / "c_broken.jpg") << "not a jpeg";
+    return dir;
+}
+
+static void test_letterbox_geometry() {
+    Letterbox lb = computeLetterbox(1920, 1080, 640, 640);
+    assert(std::fabs(lb.scale - 1.f / 3.f) < 1e-6f);
+    assert(lb.new_w == 640 && lb.new_h == 360);
+    assert(lb.dx == 0 && lb.dy == 140);
+
+    // Padding rengi 114 olmalı, içerik RGB sırasında.
+    cv::Mat red(10, 20, CV_8UC3, cv::Scalar(0, 0, 255));   // BGR
+    std::vector<uint8_t> chw(3 * 20 * 20);
+    letterboxToCHW(red, 20, 20, chw.data());
+    const size_t plane = 20 * 20;
+    assert(chw[0] == kLetterboxPad);                  // top-left: padding
+    assert(chw[10 * 20 + 10] == 255);                 // R plane, centre
+    assert(chw[plane + 10 * 20 + 10] == 0);           // G plane
+    assert(chw[2 * plane + 10 * 20 + 10] == 0);       // B plane
+}
+
+static void test_build_and_read(const fs::path& dir) {
+    auto images = listCalibImages(dir.string());
+    assert(images.size() == 4);
+
+    CalibShardOptions opt;
+    opt.input_w = W;
+    opt.input_h = H;
+    opt.threads = 3;
+    std::string shard_path = (dir / "calib.shard").string();
+    std::string err;
+    size_t n = buildCalibShard(images, shard_path, opt, &err);
+    assert(n == 3);                                    // broken one skipped
+    assert(!fs::exists(shard_path + ".tmp"));
+
+    CalibShard shard;
+    bool opened = shard.open(shard_path, &err);
+    assert(opened);
+    assert(shard.count() == 3);
+    assert(shard.width() == W && shard.height() == H && shard.channels() == 3);
+    assert(shard.dtype() == ShardDType::F32);
+    assert(shard.sourceCount() == 4);                   // broken one still listed
+    assert(shard.listHash() == calibListHash(images));
+    assert(calibListHash(images, 3) != calibListHash(images));
+    assert(std::string(shard.entry(0).name) == "a_wide.png");
+    assert(std::string(shard.entry(1).name) == "b_tall.png");
+    assert(std::string(shard.entry(2).name) == "d_same.png");
+
+    // Her örnek, inference yolunun ürettiğiyle birebir aynı olmalı.
+    const size_t elems = shard.sampleElems();
+    std::vector<float> ref(elems);
+    const char* names[] = {"a_wide.png", "b_tall.png", "d_same.png"};
+    for (size_t i = 0; i < 3; ++i) {
+        cv::Mat img = cv::imread((dir / names[i]).string());
+        Letterbox lb = letterboxToCHW(img, W, H, ref.data());
+        const ShardEntry& e = shard.entry(i);
+        assert(e.orig_w == static_cast<uint32_t>(img.cols));
+        assert(e.orig_h == static_cast<uint32_t>(img.rows));
+        assert(e.dx == lb.dx && e.dy == lb.dy);
+        assert(std::memcmp(shard.sample(i), ref.data(), elems * sizeof(float)) == 0);
+    }
+
+    // uint8 shard, float'a açıldığında float shard ile bit-bit aynı.
+    opt.dtype = ShardDType::U8;
+    std::string u8_path = (dir / "calib_u8.shard").string();
+    size_t n_u8 = buildCalibShard(images, u8_path, opt, &err);
+    assert(n_u8 == 3);
+    CalibShard u8;
+    bool u8_opened = u8.open(u8_path, &err);
+    assert(u8_opened);
+    assert(u8.dtype() == ShardDType::U8);
+
+    std::vector<float> a(3 * elems), b(3 * elems);
+    shard.copyFloat(0, 3, a.data());
+    u8.copyFloat(0, 3, b.data());
+    assert(std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0);
+}
+
+static void test_rejects_garbage(const fs::path& dir) {
+    std::string bad = (dir / "c_broken.jpg").string();
+    CalibShard shard;
+    std::string err;
+    bool opened = shard.open(bad, &err);
+    assert(!opened);
+    assert(!err.empty());
+    assert(!shard.isOpen());
+}
+
+int main() {
+    fs::path dir = makeCalibDir();
+    test_letterbox_geometry();
+    test_build_and_read(dir);
+    test_rejects_garbage(dir);
+    fs::remove_all(dir);
+    std::cout << "test_calib_shard: OK\n";
+    return 0;
+}
@@ -0,0 +1,82 @@
+// calib_prep — preprocess an INT8 calibration directory into a CalibShard.
+//
+//   calib_prep models/coco_calib_subset models/coco_calib_subset.shard
+//   calib_prep <dir> <out.shard> --width 640 --height 640 --u8 --threads 8
+//
+// CPU only (OpenCV), so it runs on the dev PC without CUDA; copy the shard
+// to the Jetson next to the ONNX and the INT8 build skips image decoding.
+
+#include "inference/calib_shard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+void printUsage(const char* p) {
+    std::cout <<
+"Usage: " << p << " <images_dir> <out.shard> [OPTIONS]\n\n"
+"Options:\n"
+"  --width  <px>       Network input width  (default 640)\n"
+"  --height <px>       Network input height (default 640)\n"
+"  --u8                Store uint8 CHW (4x smaller, expanded at calibration)\n"
+"  --threads <n>       Worker threads (default: all cores)\n"
+"  --max <n>           Use at most n images (sorted by name)\n"
+"  -h, --help\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) { printUsage(argv[0]); return 1; }
+
+    std::string images_dir = argv[1];
+    std::string out_path   = argv[2];
+    edge::CalibShardOptions opt;
+
+    for (int i = 3; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() { return (i + 1 < argc) ? argv[++i] : "0"; };
+
+        if (a == "-h" || a == "--help") { printUsage(argv[0]); return 0; }
+        else if (a == "--width")   opt.input_w    = std::stoi(next());
+        else if (a == "--height")  opt.input_h    = std::stoi(next());
+        else if (a == "--u8")      opt.dtype      = edge::ShardDType::U8;
+        else if (a == "--threads") opt.threads    = std::stoi(next());
+        else if (a == "--max")     opt.max_images = std::stoul(next());
+        else std::cerr << "[calib_prep] Unknown arg: " << a << "\n";
+    }
+
+    auto images = edge::listCalibImages(images_dir);
+    if (images.empty()) {
+        std::cerr << "[calib_prep] No images in " << images_dir << "\n";
+        return 1;
+    }
+    int threads = opt.threads > 0
+        ? opt.threads : static_cast<int>(std::thread::hardware_concurrency());
+    std::cout << "[calib_prep] " << images.size() << " images, "
+              << opt.input_w << "x" << opt.input_h << " "
+              << (opt.dtype == edge::ShardDType::U8 ? "uint8" : "float32")
+              << ", " << threads << " threads\n";
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::string err;
+    size_t n = edge::buildCalibShard(images, out_path, opt, &err);
+    if (n == 0) {
+        std::cerr << "[calib_prep] Failed: " << err << "\n";
+        return 1;
+    }
+    double s = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "[calib_prep] Wrote " << n << " samples -> " << out_path
+              << "  (" << s << " s, " << n / s << " img/s)\n";
+    size_t wanted = opt.max_images ? std::min(opt.max_images, images.size())
+                                   : images.size();
+    if (n < wanted)
+        std::cout << "[calib_prep] Skipped " << wanted - n << " unreadable images\n";
+    return 0;
+}